@@ -18,11 +18,14 @@
 
 #include <array>
 #include <cstdint>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <span>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <android-base/result.h>
 #include <android-base/thread_annotations.h>
@@ -75,6 +78,9 @@ private:
  * predictor.record(MOVE_MOTION_EVENT);
  * prediction = predictor.predict(futureTime);
  *
+ * When predictions for several target times are needed for the same input (for example, one per
+ * upcoming frame), pass all of them to a single predict() call so that the model is only run once.
+ *
  * The resulting motion event will have eventTime <= (futureTime + MY_OFFSET). It might contain
  * historical data, which are additional samples from the latest recorded MotionEvent's eventTime
  * to the futureTime + MY_OFFSET.
@@ -103,6 +109,8 @@ public:
                     std::function<bool()> checkEnableMotionPrediction = isMotionPredictionEnabled,
                     ReportAtomFunction reportAtomFunction = {});
 
+    ~MotionPredictor();
+
     /**
      * Record the actual motion received by the view. This event will be used for calculating the
      * predictions.
@@ -114,6 +122,14 @@ public:
 
     std::unique_ptr<MotionEvent> predict(nsecs_t timestamp);
 
+    /**
+     * Predict the motion for each of the given target times, running the model at most once.
+     *
+     * @return a prediction for each timestamp, in the same order. An entry is nullptr if no
+     * prediction could be made for that timestamp.
+     */
+    std::vector<std::unique_ptr<MotionEvent>> predict(std::span<const nsecs_t> timestamps);
+
     bool isPredictionAvailable(int32_t deviceId, int32_t source);
 
 private:
@@ -121,6 +137,10 @@ private:
     const std::function<bool()> mCheckMotionPredictionEnabled;
 
     std::unique_ptr<TfLiteMotionPredictorModel> mModel;
+    // The model being loaded in the background, if it was requested before it is needed.
+    std::future<std::unique_ptr<TfLiteMotionPredictorModel>> mPendingModel;
+    // Whether the model's outputs reflect the samples currently in mBuffers.
+    bool mModelOutputValid = false;
 
     std::unique_ptr<TfLiteMotionPredictorBuffers> mBuffers;
     std::optional<MotionEvent> mLastEvent;
@@ -133,6 +153,12 @@ private:
     std::optional<MotionPredictorMetricsManager> mMetricsManager;
 
     const ReportAtomFunction mReportAtomFunction;
+
+    TfLiteMotionPredictorModel& getModel();
+    // Runs the model on the recorded samples, unless its outputs are already up to date.
+    // Returns false if there's not enough data to predict.
+    bool runModel();
+    std::unique_ptr<MotionEvent> buildPrediction(nsecs_t timestamp);
 };
 
 } // namespace android
@@ -23,7 +23,6 @@
 #include <optional>
 #include <span>
 
-#include <android-base/mapped_file.h>
 #include <input/RingBuffer.h>
 #include <utils/Timers.h>
 
@@ -113,8 +112,14 @@ public:
     };
 
     // Creates a model from an encoded Flatbuffer model.
+    // The model file is only loaded and verified once per process, and a model previously handed
+    // back through recycle() is reused if one is available.
     static std::unique_ptr<TfLiteMotionPredictorModel> create();
 
+    // Returns a model that is no longer needed to a process-wide pool, so that a later call to
+    // create() can skip building and warming up a new interpreter.
+    static void recycle(std::unique_ptr<TfLiteMotionPredictorModel> model);
+
     ~TfLiteMotionPredictorModel();
 
     // Returns the length of the model's input buffers.
@@ -143,10 +148,15 @@ public:
     std::span<const float> outputPressure() const;
 
 private:
-    explicit TfLiteMotionPredictorModel(std::unique_ptr<android::base::MappedFile> model,
-                                        Config config);
+    // The immutable parts of a model, shared by every interpreter created in the process.
+    struct SharedModel;
+
+    explicit TfLiteMotionPredictorModel(std::shared_ptr<const SharedModel> model);
+
+    static std::shared_ptr<const SharedModel> loadSharedModel();
 
     void allocateTensors();
+    void warmUp();
     void attachInputTensors();
     void attachOutputTensors();
 
@@ -160,9 +170,7 @@ private:
     const TfLiteTensor* mOutputPhi = nullptr;
     const TfLiteTensor* mOutputPressure = nullptr;
 
-    std::unique_ptr<android::base::MappedFile> mFlatBuffer;
-    std::unique_ptr<tflite::ErrorReporter> mErrorReporter;
-    std::unique_ptr<tflite::FlatBufferModel> mModel;
+    const std::shared_ptr<const SharedModel> mSharedModel;
     std::unique_ptr<tflite::Interpreter> mInterpreter;
     tflite::SignatureRunner* mRunner = nullptr;
 
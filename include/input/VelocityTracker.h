@@ -21,6 +21,7 @@
 #include <input/RingBuffer.h>
 #include <utils/BitSet.h>
 #include <utils/Timers.h>
+#include <array>
 #include <map>
 #include <set>
 
@@ -220,7 +221,34 @@ private:
     // changes in direction.
     static const nsecs_t HORIZON = 100 * 1000000; // 100 ms
 
-    float chooseWeight(int32_t pointerId, uint32_t index) const;
+    /**
+     * The QR decomposition of the weighted polynomial design matrix built from a set of sample
+     * times. It only depends on the sample times and weights, not on the positions, so it can be
+     * shared by every fit over the same sample times.
+     */
+    struct Decomposition {
+        static constexpr size_t MAX_SAMPLES = HISTORY_SIZE;
+        static constexpr size_t MAX_COEFFICIENTS = VelocityTracker::MAX_DEGREE + 1;
+
+        uint32_t m = 0; // number of samples
+        uint32_t n = 0; // number of polynomial coefficients
+        std::array<float, MAX_SAMPLES> x;
+        std::array<float, MAX_SAMPLES> w;
+        // Orthonormal basis, column-major order.
+        std::array<std::array<float, MAX_SAMPLES>, MAX_COEFFICIENTS> q;
+        // Upper triangular matrix, row-major order.
+        std::array<std::array<float, MAX_COEFFICIENTS>, MAX_COEFFICIENTS> r;
+
+        // Returns false if the design matrix is rank deficient, in which case there is no
+        // solution.
+        bool compute(uint32_t samples, uint32_t coefficients);
+        float solveForVelocity(const std::array<float, MAX_SAMPLES>& y) const;
+        bool matches(uint32_t samples, uint32_t coefficients,
+                     const std::array<float, MAX_SAMPLES>& sampleX,
+                     const std::array<float, MAX_SAMPLES>& sampleW) const;
+    };
+
+    float chooseWeight(const RingBuffer<Movement>& movements, uint32_t index) const;
     /**
      * An optimized least-squares solver for degree 2 and no weight (i.e. `Weighting.NONE`).
      * The provided container of movements shall NOT be empty, and shall have the movements in
@@ -231,6 +259,14 @@ private:
 
     const uint32_t mDegree;
     const Weighting mWeighting;
+
+    // The decomposition used by the last general least-squares fit. Input that is sampled at a
+    // fixed rate, and the pointers of a multi-touch gesture, produce the same relative sample
+    // times on every call, so the decomposition can be reused and only the cheap back
+    // substitution has to run.
+    mutable Decomposition mLastDecomposition;
+    // Whether mLastDecomposition holds a usable (full rank) decomposition.
+    mutable bool mLastDecompositionValid = false;
 };
 
 /*
@@ -423,6 +423,16 @@ static void releaseBufferCallbackThunk(wp<BLASTBufferQueue> context, const Relea
     }
 }
 
+static void releaseBuffersCallbackThunk(wp<BLASTBufferQueue> context,
+                                        const std::vector<BufferRelease>& releases) {
+    sp<BLASTBufferQueue> blastBufferQueue = context.promote();
+    if (blastBufferQueue) {
+        blastBufferQueue->releaseBuffersCallback(releases);
+    } else {
+        ALOGV("releaseBuffersCallbackThunk blastBufferQueue is dead");
+    }
+}
+
 void BLASTBufferQueue::flushShadowQueue() {
     BQA_LOGV("flushShadowQueue");
     int numFramesToFlush = mNumFrameAvailable;
@@ -441,6 +451,16 @@ void BLASTBufferQueue::releaseBufferCallback(
                                 false /* fakeRelease */);
 }
 
+void BLASTBufferQueue::releaseBuffersCallback(const std::vector<BufferRelease>& releases) {
+    std::lock_guard _lock{mMutex};
+    BBQ_TRACE("count=%zu", releases.size());
+    for (const BufferRelease& release : releases) {
+        releaseBufferCallbackLocked(release.callbackId, release.releaseFence,
+                                    release.currentMaxAcquiredBufferCount,
+                                    false /* fakeRelease */);
+    }
+}
+
 void BLASTBufferQueue::releaseBufferCallbackLocked(
         const ReleaseCallbackId& id, const sp<Fence>& releaseFence,
         std::optional<uint32_t> currentMaxAcquiredBufferCount, bool fakeRelease) {
@@ -542,12 +562,17 @@ status_t BLASTBufferQueue::acquireNextBufferLocked(
         return NAME_NOT_FOUND;
     }
 
-    SurfaceComposerClient::Transaction localTransaction;
+    // Every frame builds a transaction for the same layer, so take one from the pool that already
+    // has the layer state allocated.
+    SurfaceComposerClient::Transaction::Pooled localTransaction;
     bool applyTransaction = true;
-    SurfaceComposerClient::Transaction* t = &localTransaction;
+    SurfaceComposerClient::Transaction* t = nullptr;
     if (transaction) {
         t = *transaction;
         applyTransaction = false;
+    } else {
+        localTransaction = SurfaceComposerClient::Transaction::obtain();
+        t = localTransaction.get();
     }
 
     BufferItem bufferItem;
@@ -626,6 +651,12 @@ status_t BLASTBufferQueue::acquireNextBufferLocked(
 
     t->setBuffer(mSurfaceControl, buffer, fence, bufferItem.mFrameNumber, mProducerId,
                  releaseBufferCallback, dequeueTime);
+    if (!mReleaseBuffersCallback) {
+        mReleaseBuffersCallback = std::make_shared<const ReleaseBuffersCallback>(
+                std::bind(releaseBuffersCallbackThunk, wp<BLASTBufferQueue>(this),
+                          std::placeholders::_1));
+    }
+    t->setReleaseBuffersCallback(mSurfaceControl, mReleaseBuffersCallback);
     t->setDataspace(mSurfaceControl, static_cast<ui::Dataspace>(bufferItem.mDataSpace));
     t->setHdrMetadata(mSurfaceControl, bufferItem.mHdrMetadata);
     t->setSurfaceDamageRegion(mSurfaceControl, bufferItem.mSurfaceDamage);
@@ -81,6 +81,10 @@ status_t BufferQueueConsumer::acquireBuffer(BufferItem* outBuffer,
 
     int numDroppedBuffers = 0;
     sp<IProducerListener> listener;
+    // The queue depth is traced once mMutex is released, so that a producer waiting on the lock
+    // isn't held up by the trace marker write.
+    String8 consumerName;
+    int32_t queueSize = 0;
     {
         std::unique_lock<std::mutex> lock(mCore->mMutex);
 
@@ -262,7 +266,9 @@ status_t BufferQueueConsumer::acquireBuffer(BufferItem* outBuffer,
             return NO_BUFFER_AVAILABLE;
         } else {
             slot = front->mSlot;
-            *outBuffer = *front;
+            // The front item is erased below, so move it out rather than copying its
+            // references and damage region while holding the lock.
+            *outBuffer = std::move(*front);
         }
 
         ATRACE_BUFFER_INDEX(slot);
@@ -292,18 +298,21 @@ status_t BufferQueueConsumer::acquireBuffer(BufferItem* outBuffer,
 
         mCore->mQueue.erase(front);
 
-        // We might have freed a slot while dropping old buffers, or the producer
-        // may be blocked waiting for the number of buffers in the queue to
-        // decrease.
-        mCore->mDequeueCondition.notify_all();
-
-        ATRACE_INT(mCore->mConsumerName.c_str(), static_cast<int32_t>(mCore->mQueue.size()));
+        consumerName = mCore->mConsumerName;
+        queueSize = static_cast<int32_t>(mCore->mQueue.size());
 #ifndef NO_BINDER
         mCore->mOccupancyTracker.registerOccupancyChange(mCore->mQueue.size());
 #endif
         VALIDATE_CONSISTENCY();
     }
 
+    // We might have freed a slot while dropping old buffers, or the producer
+    // may be blocked waiting for the number of buffers in the queue to
+    // decrease. Wake it up after releasing mMutex, so that it doesn't block
+    // on the lock straight away.
+    mCore->mDequeueCondition.notify_all();
+    ATRACE_INT(consumerName.c_str(), queueSize);
+
     if (listener != nullptr) {
         for (int i = 0; i < numDroppedBuffers; ++i) {
             listener->onBufferReleased();
@@ -494,10 +503,12 @@ status_t BufferQueueConsumer::releaseBuffer(int slot, uint64_t frameNumber,
         }
         BQ_LOGV("releaseBuffer: releasing slot %d", slot);
 
-        mCore->mDequeueCondition.notify_all();
         VALIDATE_CONSISTENCY();
     } // Autolock scope
 
+    // Wake up a producer waiting for a free slot once it can take mMutex.
+    mCore->mDequeueCondition.notify_all();
+
     // Call back without lock held
     if (listener != nullptr) {
         listener->onBufferReleased();
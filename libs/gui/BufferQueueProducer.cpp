@@ -926,6 +926,8 @@ status_t BufferQueueProducer::queueBuffer(int slot,
     BufferItem item;
     int connectedApi;
     sp<Fence> lastQueuedFence;
+    String8 consumerName;
+    int32_t queueSize = 0;
 
     { // Autolock scope
         std::lock_guard<std::mutex> lock(mCore->mMutex);
@@ -1079,7 +1081,6 @@ status_t BufferQueueProducer::queueBuffer(int slot,
         }
 
         mCore->mBufferHasBeenQueued = true;
-        mCore->mDequeueCondition.notify_all();
         mCore->mLastQueuedSlot = slot;
 
         output->width = mCore->mDefaultWidth;
@@ -1088,7 +1089,8 @@ status_t BufferQueueProducer::queueBuffer(int slot,
         output->numPendingBuffers = static_cast<uint32_t>(mCore->mQueue.size());
         output->nextFrameNumber = mCore->mFrameCounter + 1;
 
-        ATRACE_INT(mCore->mConsumerName.c_str(), static_cast<int32_t>(mCore->mQueue.size()));
+        consumerName = mCore->mConsumerName;
+        queueSize = static_cast<int32_t>(mCore->mQueue.size());
 #ifndef NO_BINDER
         mCore->mOccupancyTracker.registerOccupancyChange(mCore->mQueue.size());
 #endif
@@ -1105,6 +1107,11 @@ status_t BufferQueueProducer::queueBuffer(int slot,
         mLastQueuedTransform = item.mTransform;
     } // Autolock scope
 
+    // Wake up dequeueBuffer callers and trace the queue depth once mMutex is
+    // released, so that the consumer isn't held up waiting for the lock.
+    mCore->mDequeueCondition.notify_all();
+    ATRACE_INT(consumerName.c_str(), queueSize);
+
     // It is okay not to clear the GraphicBuffer when the consumer is SurfaceFlinger because
     // it is guaranteed that the BufferQueue is inside SurfaceFlinger's process and
     // there will be no Binder call
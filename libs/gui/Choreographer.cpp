@@ -21,6 +21,8 @@
 #include <gui/TraceUtils.h>
 #include <jni.h>
 
+#include <com_android_graphics_libgui_flags.h>
+
 #undef LOG_TAG
 #define LOG_TAG "AChoreographer"
 
@@ -66,6 +68,7 @@ inline const char* toString(bool value) {
 } // namespace
 
 namespace android {
+using namespace com::android::graphics::libgui;
 
 Choreographer::Context Choreographer::gChoreographers;
 
@@ -104,7 +107,12 @@ Choreographer* Choreographer::getForThread() {
 }
 
 Choreographer::Choreographer(const sp<Looper>& looper, const sp<IBinder>& layerHandle)
-      : DisplayEventDispatcher(looper, gui::ISurfaceComposer::VsyncSource::eVsyncSourceApp, {},
+      : DisplayEventDispatcher(looper, gui::ISurfaceComposer::VsyncSource::eVsyncSourceApp,
+                               flags::vsync_broadcast()
+                                       ? EventRegistrationFlags(
+                                                 gui::ISurfaceComposer::EventRegistration::
+                                                         vsyncBroadcast)
+                                       : EventRegistrationFlags(),
                                layerHandle),
         mLooper(looper),
         mThreadId(std::this_thread::get_id()) {
@@ -63,6 +63,13 @@ status_t DisplayEventDispatcher::initialize() {
         if (rc < 0) {
             return UNKNOWN_ERROR;
         }
+        if (const int broadcastFd = mReceiver.getVsyncBroadcastFd(); broadcastFd >= 0) {
+            rc = mLooper->addFd(broadcastFd, 0, Looper::EVENT_INPUT, this, NULL);
+            if (rc < 0) {
+                mLooper->removeFd(mReceiver.getFd());
+                return UNKNOWN_ERROR;
+            }
+        }
     }
 
     return OK;
@@ -73,6 +80,9 @@ void DisplayEventDispatcher::dispose() {
 
     if (!mReceiver.initCheck() && mLooper != nullptr) {
         mLooper->removeFd(mReceiver.getFd());
+        if (const int broadcastFd = mReceiver.getVsyncBroadcastFd(); broadcastFd >= 0) {
+            mLooper->removeFd(broadcastFd);
+        }
     }
 }
 
@@ -220,6 +230,16 @@ bool DisplayEventDispatcher::processPendingEvents(nsecs_t* outTimestamp,
     if (n < 0) {
         ALOGW("Failed to get events from display event dispatcher, status=%d", status_t(n));
     }
+
+    // A broadcast vsync is at least as recent as any vsync read above.
+    DisplayEventReceiver::Event ev;
+    if (mReceiver.getBroadcastVsync(&ev)) {
+        gotVsync = true;
+        *outTimestamp = ev.header.timestamp;
+        *outDisplayId = ev.header.displayId;
+        *outCount = ev.vsync.count;
+        *outVsyncEventData = ev.vsync.vsyncData;
+    }
     return gotVsync;
 }
 
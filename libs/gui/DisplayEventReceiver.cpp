@@ -16,6 +16,7 @@
 
 #define LOG_TAG "DisplayEventReceiver"
 
+#include <errno.h>
 #include <string.h>
 
 #include <utils/Errors.h>
@@ -26,6 +27,7 @@
 #include <private/gui/ComposerServiceAIDL.h>
 
 #include <private/gui/BitTube.h>
+#include <private/gui/VsyncBroadcastChannel.h>
 
 // ---------------------------------------------------------------------------
 
@@ -53,6 +55,9 @@ DisplayEventReceiver::DisplayEventReceiver(gui::ISurfaceComposer::VsyncSource vs
                 mInitError = std::make_optional<status_t>(status.transactionError());
                 mDataChannel.reset();
                 mEventConnection.clear();
+            } else if (eventRegistration.test(
+                               gui::ISurfaceComposer::EventRegistration::vsyncBroadcast)) {
+                initVsyncBroadcast();
             }
         } else {
             ALOGE("DisplayEventConnection creation failed: status=%s", status.toString8().c_str());
@@ -80,6 +85,9 @@ status_t DisplayEventReceiver::setVsyncRate(uint32_t count) {
         return BAD_VALUE;
 
     if (mEventConnection != nullptr) {
+        if (mBroadcastReceiver != nullptr) {
+            mBroadcastReceiver->setVsyncRate(count);
+        }
         mEventConnection->setVsyncRate(count);
         return NO_ERROR;
     }
@@ -88,6 +96,9 @@ status_t DisplayEventReceiver::setVsyncRate(uint32_t count) {
 
 status_t DisplayEventReceiver::requestNextVsync() {
     if (mEventConnection != nullptr) {
+        if (mBroadcastReceiver != nullptr) {
+            mBroadcastReceiver->requestNextVsync();
+        }
         mEventConnection->requestNextVsync();
         return NO_ERROR;
     }
@@ -107,9 +118,41 @@ status_t DisplayEventReceiver::getLatestVsyncEventData(
     return NO_INIT;
 }
 
+int DisplayEventReceiver::getVsyncBroadcastFd() const {
+    return mBroadcastReceiver != nullptr ? mBroadcastReceiver->getFd() : -1;
+}
+
+bool DisplayEventReceiver::getBroadcastVsync(Event* outEvent) {
+    return mBroadcastReceiver != nullptr && mBroadcastReceiver->getVsync(outEvent);
+}
+
+void DisplayEventReceiver::initVsyncBroadcast() {
+    auto channel = std::make_unique<gui::VsyncBroadcastChannel>();
+    binder::Status status = mEventConnection->getVsyncBroadcastChannel(channel.get());
+    if (!status.isOk() || channel->initCheck() != NO_ERROR) {
+        ALOGW("Vsync broadcast unavailable: %s", status.toString8().c_str());
+        return;
+    }
+    status = mEventConnection->enableVsyncBroadcast();
+    if (!status.isOk()) {
+        ALOGW("enableVsyncBroadcast failed: %s", status.toString8().c_str());
+        return;
+    }
+
+    mBroadcastReceiver = std::make_unique<gui::VsyncBroadcastReceiver>(std::move(channel));
+}
+
 ssize_t DisplayEventReceiver::getEvents(DisplayEventReceiver::Event* events,
         size_t count) {
-    return DisplayEventReceiver::getEvents(mDataChannel.get(), events, count);
+    const ssize_t n = DisplayEventReceiver::getEvents(mDataChannel.get(), events, count);
+    if (mBroadcastReceiver != nullptr) {
+        for (ssize_t i = 0; i < n; i++) {
+            if (events[i].header.type == DISPLAY_EVENT_VSYNC) {
+                mBroadcastReceiver->onVsyncPosted(events[i]);
+            }
+        }
+    }
+    return n;
 }
 
 ssize_t DisplayEventReceiver::getEvents(gui::BitTube* dataChannel,
@@ -38,7 +38,8 @@ enum class Tag : uint32_t {
     ON_RELEASE_BUFFER,
     ON_TRANSACTION_QUEUE_STALLED,
     ON_TRUSTED_PRESENTATION_CHANGED,
-    LAST = ON_TRUSTED_PRESENTATION_CHANGED,
+    ON_RELEASE_BUFFERS,
+    LAST = ON_RELEASE_BUFFERS,
 };
 
 } // Anonymous namespace
@@ -319,6 +320,12 @@ public:
                                                            currentMaxAcquiredBufferCount);
     }
 
+    void onReleaseBuffers(std::vector<ReleasedBufferStats> releasedBuffers) override {
+        callRemoteAsync<decltype(&ITransactionCompletedListener::
+                                         onReleaseBuffers)>(Tag::ON_RELEASE_BUFFERS,
+                                                            releasedBuffers);
+    }
+
     void onTransactionQueueStalled(const String8& reason) override {
         callRemoteAsync<
                 decltype(&ITransactionCompletedListener::
@@ -356,6 +363,8 @@ status_t BnTransactionCompletedListener::onTransact(uint32_t code, const Parcel&
         case Tag::ON_TRUSTED_PRESENTATION_CHANGED:
             return callLocalAsync(data, reply,
                                   &ITransactionCompletedListener::onTrustedPresentationChanged);
+        case Tag::ON_RELEASE_BUFFERS:
+            return callLocalAsync(data, reply, &ITransactionCompletedListener::onReleaseBuffers);
     }
 }
 
@@ -407,4 +416,19 @@ status_t ReleaseCallbackId::readFromParcel(const Parcel* input) {
 
 const ReleaseCallbackId ReleaseCallbackId::INVALID_ID = ReleaseCallbackId(0, 0);
 
+status_t ReleasedBufferStats::writeToParcel(Parcel* output) const {
+    SAFE_PARCEL(output->writeParcelable, callbackId);
+    SAFE_PARCEL(output->write, *releaseFence);
+    SAFE_PARCEL(output->writeUint32, currentMaxAcquiredBufferCount);
+    return NO_ERROR;
+}
+
+status_t ReleasedBufferStats::readFromParcel(const Parcel* input) {
+    SAFE_PARCEL(input->readParcelable, &callbackId);
+    releaseFence = sp<Fence>::make();
+    SAFE_PARCEL(input->read, *releaseFence);
+    SAFE_PARCEL(input->readUint32, &currentMaxAcquiredBufferCount);
+    return NO_ERROR;
+}
+
 }; // namespace android
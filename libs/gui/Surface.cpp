@@ -802,7 +802,8 @@ int Surface::dequeueBuffers(std::vector<BatchBuffer>* buffers) {
     for (const auto& output : dequeueOutput) {
         // Collect slots that needs requesting buffer
         sp<GraphicBuffer>& gbuf(mSlots[output.slot].buffer);
-        if ((result & IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION) || gbuf == nullptr) {
+        if ((output.result & IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION) ||
+            gbuf == nullptr) {
             if (mReportRemovedBuffers && (gbuf != nullptr)) {
                 mRemovedBuffers.push_back(gbuf);
             }
@@ -903,6 +904,7 @@ int Surface::cancelBuffers(const std::vector<BatchBuffer>& buffers) {
     using CancelBufferInput = IGraphicBufferProducer::CancelBufferInput;
     ATRACE_CALL();
     ALOGV("Surface::cancelBuffers");
+    Mutex::Autolock lock(mMutex);
 
     if (mSharedBufferMode) {
         ALOGE("%s: batch operation is not supported in shared buffer mode!",
@@ -1174,8 +1176,11 @@ int Surface::queueBuffers(const std::vector<BatchQueuedBuffer>& buffers) {
     for (size_t batchIdx = 0; batchIdx < numBuffers; batchIdx++) {
         int i = getSlotFromBufferLocked(buffers[batchIdx].buffer);
         if (i < 0) {
-            if (buffers[batchIdx].fenceFd >= 0) {
-                close(buffers[batchIdx].fenceFd);
+            // Nothing is queued, but the fences are ours to close either way.
+            for (size_t j = batchIdx; j < numBuffers; j++) {
+                if (buffers[j].fenceFd >= 0) {
+                    close(buffers[j].fenceFd);
+                }
             }
             return i;
         }
@@ -1185,6 +1190,7 @@ int Surface::queueBuffers(const std::vector<BatchQueuedBuffer>& buffers) {
         getQueueBufferInputLocked(
                 buffers[batchIdx].buffer, buffers[batchIdx].fenceFd, buffers[batchIdx].timestamp,
                 &input);
+        applyGrallocMetadataLocked(buffers[batchIdx].buffer, input);
         bufferFences[batchIdx] = input.fence;
         queueBufferInputs[batchIdx] = input;
     }
@@ -1195,11 +1201,23 @@ int Surface::queueBuffers(const std::vector<BatchQueuedBuffer>& buffers) {
     if (err != OK)  {
         ALOGE("%s: error queuing buffer, %d", __FUNCTION__, err);
     }
+    if (queueBufferOutputs.size() != numBuffers) {
+        // No per-buffer results came back, e.g. on a binder error, so it is unknown which buffers,
+        // if any, were queued.
+        return err != OK ? err : FAILED_TRANSACTION;
+    }
 
-
+    // Each buffer succeeds or fails on its own. Report the first failure.
     for (size_t batchIdx = 0; batchIdx < numBuffers; batchIdx++) {
-        onBufferQueuedLocked(bufferSlots[batchIdx], bufferFences[batchIdx],
-                queueBufferOutputs[batchIdx]);
+        const IGraphicBufferProducer::QueueBufferOutput& output = queueBufferOutputs[batchIdx];
+        if (output.result != OK) {
+            ALOGE("%s: error queuing buffer %zu, %d", __FUNCTION__, batchIdx, output.result);
+            if (err == OK) {
+                err = output.result;
+            }
+            continue;
+        }
+        onBufferQueuedLocked(bufferSlots[batchIdx], bufferFences[batchIdx], output);
     }
 
     return err;
@@ -1478,6 +1496,15 @@ int Surface::perform(int operation, va_list args)
     case NATIVE_WINDOW_SET_BUFFERS_ADDITIONAL_OPTIONS:
         res = dispatchSetAdditionalOptions(args);
         break;
+    case NATIVE_WINDOW_DEQUEUE_BUFFERS:
+        res = dispatchDequeueBuffers(args);
+        break;
+    case NATIVE_WINDOW_QUEUE_BUFFERS:
+        res = dispatchQueueBuffers(args);
+        break;
+    case NATIVE_WINDOW_CANCEL_BUFFERS:
+        res = dispatchCancelBuffers(args);
+        break;
     default:
         res = NAME_NOT_FOUND;
         break;
@@ -1854,6 +1881,62 @@ int Surface::dispatchSetAdditionalOptions(va_list args) {
 #endif
 }
 
+int Surface::dispatchDequeueBuffers(va_list args) {
+    size_t count = va_arg(args, size_t);
+    ANativeWindowBuffer** outBuffers = va_arg(args, ANativeWindowBuffer**);
+    int* outFenceFds = va_arg(args, int*);
+    if (outBuffers == nullptr || outFenceFds == nullptr) {
+        return BAD_VALUE;
+    }
+
+    std::vector<BatchBuffer> buffers(count);
+    int result = dequeueBuffers(&buffers);
+    if (result != OK) {
+        return result;
+    }
+    for (size_t i = 0; i < count; i++) {
+        outBuffers[i] = buffers[i].buffer;
+        outFenceFds[i] = buffers[i].fenceFd;
+    }
+    return OK;
+}
+
+int Surface::dispatchQueueBuffers(va_list args) {
+    size_t count = va_arg(args, size_t);
+    ANativeWindowBuffer* const* inBuffers = va_arg(args, ANativeWindowBuffer* const*);
+    const int* fenceFds = va_arg(args, const int*);
+    const int64_t* timestamps = va_arg(args, const int64_t*);
+    if (inBuffers == nullptr || fenceFds == nullptr) {
+        return BAD_VALUE;
+    }
+
+    std::vector<BatchQueuedBuffer> buffers(count);
+    for (size_t i = 0; i < count; i++) {
+        buffers[i].buffer = inBuffers[i];
+        buffers[i].fenceFd = fenceFds[i];
+        if (timestamps != nullptr) {
+            buffers[i].timestamp = timestamps[i];
+        }
+    }
+    return queueBuffers(buffers);
+}
+
+int Surface::dispatchCancelBuffers(va_list args) {
+    size_t count = va_arg(args, size_t);
+    ANativeWindowBuffer* const* inBuffers = va_arg(args, ANativeWindowBuffer* const*);
+    const int* fenceFds = va_arg(args, const int*);
+    if (inBuffers == nullptr || fenceFds == nullptr) {
+        return BAD_VALUE;
+    }
+
+    std::vector<BatchBuffer> buffers(count);
+    for (size_t i = 0; i < count; i++) {
+        buffers[i].buffer = inBuffers[i];
+        buffers[i].fenceFd = fenceFds[i];
+    }
+    return cancelBuffers(buffers);
+}
+
 bool Surface::transformToDisplayInverse() const {
     return (mTransform & NATIVE_WINDOW_TRANSFORM_INVERSE_DISPLAY) ==
             NATIVE_WINDOW_TRANSFORM_INVERSE_DISPLAY;
@@ -20,6 +20,8 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <algorithm>
+
 #include <android/gui/BnWindowInfosReportedListener.h>
 #include <android/gui/DisplayState.h>
 #include <android/gui/ISurfaceComposerClient.h>
@@ -87,6 +89,18 @@ int64_t generateId() {
 }
 
 void emptyCallback(nsecs_t, const sp<Fence>&, const std::vector<SurfaceControlStats>&) {}
+
+// Returns the state to the default layer state, dropping the references it holds. Its input
+// window handle is kept unless it was set by a change, as it may then be shared with a transaction
+// that was applied, and SurfaceFlinger edits the handle in place.
+void resetLayerState(layer_state_t& state) {
+    static const layer_state_t kDefaultState;
+    sp<WindowInfoHandle> windowInfoHandle = (state.what & layer_state_t::eInputInfoChanged)
+            ? sp<WindowInfoHandle>::make()
+            : std::move(state.windowInfoHandle);
+    state = kDefaultState;
+    state.windowInfoHandle = std::move(windowInfoHandle);
+}
 } // namespace
 
 const std::string SurfaceComposerClient::kEmpty{};
@@ -305,6 +319,13 @@ void TransactionCompletedListener::setReleaseBufferCallback(const ReleaseCallbac
     mReleaseBufferCallbacks[callbackId] = listener;
 }
 
+void TransactionCompletedListener::setReleaseBuffersCallback(
+        const ReleaseCallbackId& callbackId,
+        std::shared_ptr<const ReleaseBuffersCallback> callback) {
+    std::scoped_lock<std::mutex> lock(mMutex);
+    mReleaseBuffersCallbacks[callbackId] = std::move(callback);
+}
+
 void TransactionCompletedListener::addSurfaceStatsListener(void* context, void* cookie,
         sp<SurfaceControl> surfaceControl, SurfaceStatsCallback listener) {
     std::scoped_lock<std::recursive_mutex> lock(mSurfaceStatsListenerMutex);
@@ -538,9 +559,66 @@ void TransactionCompletedListener::onReleaseBuffer(ReleaseCallbackId callbackId,
     callback(callbackId, releaseFence, optionalMaxAcquiredBufferCount);
 }
 
+void TransactionCompletedListener::onReleaseBuffers(
+        std::vector<ReleasedBufferStats> releasedBuffers) {
+    // Look up all the callbacks in one go, and call them in release order without the lock held.
+    // Buffers that share a ReleaseBuffersCallback are released by a single call to it.
+    std::vector<ReleaseBufferCallback> callbacks(releasedBuffers.size());
+    std::vector<bool> batched(releasedBuffers.size(), false);
+    std::vector<std::pair<std::shared_ptr<const ReleaseBuffersCallback>, std::vector<BufferRelease>>>
+            batches;
+    {
+        std::scoped_lock<std::mutex> lock(mMutex);
+        for (size_t i = 0; i < releasedBuffers.size(); i++) {
+            const ReleasedBufferStats& releasedBuffer = releasedBuffers[i];
+            auto batchCallback = popReleaseBuffersCallbackLocked(releasedBuffer.callbackId);
+            callbacks[i] = popReleaseBufferCallbackLocked(releasedBuffer.callbackId);
+            if (!callbacks[i] || !batchCallback) {
+                continue;
+            }
+
+            auto batch = std::find_if(batches.begin(), batches.end(), [&](const auto& entry) {
+                return entry.first == batchCallback;
+            });
+            if (batch == batches.end()) {
+                batch = batches.emplace(batches.end(), std::move(batchCallback),
+                                        std::vector<BufferRelease>());
+            }
+            batch->second.push_back(
+                    {releasedBuffer.callbackId, releasedBuffer.releaseFence,
+                     releasedBuffer.currentMaxAcquiredBufferCount == UINT_MAX
+                             ? std::nullopt
+                             : std::make_optional<uint32_t>(
+                                       releasedBuffer.currentMaxAcquiredBufferCount)});
+            batched[i] = true;
+        }
+    }
+    for (const auto& [batchCallback, releases] : batches) {
+        (*batchCallback)(releases);
+    }
+    for (size_t i = 0; i < releasedBuffers.size(); i++) {
+        if (batched[i]) {
+            continue;
+        }
+        const ReleasedBufferStats& releasedBuffer = releasedBuffers[i];
+        if (!callbacks[i]) {
+            ALOGE("Could not call release buffer callback, buffer not found %s",
+                  releasedBuffer.callbackId.to_string().c_str());
+            continue;
+        }
+        std::optional<uint32_t> optionalMaxAcquiredBufferCount =
+                releasedBuffer.currentMaxAcquiredBufferCount == UINT_MAX
+                ? std::nullopt
+                : std::make_optional<uint32_t>(releasedBuffer.currentMaxAcquiredBufferCount);
+        callbacks[i](releasedBuffer.callbackId, releasedBuffer.releaseFence,
+                     optionalMaxAcquiredBufferCount);
+    }
+}
+
 ReleaseBufferCallback TransactionCompletedListener::popReleaseBufferCallbackLocked(
         const ReleaseCallbackId& callbackId) {
     ReleaseBufferCallback callback;
+    mReleaseBuffersCallbacks.erase(callbackId);
     auto itr = mReleaseBufferCallbacks.find(callbackId);
     if (itr == mReleaseBufferCallbacks.end()) {
         return nullptr;
@@ -550,6 +628,17 @@ ReleaseBufferCallback TransactionCompletedListener::popReleaseBufferCallbackLock
     return callback;
 }
 
+std::shared_ptr<const ReleaseBuffersCallback>
+TransactionCompletedListener::popReleaseBuffersCallbackLocked(const ReleaseCallbackId& callbackId) {
+    auto itr = mReleaseBuffersCallbacks.find(callbackId);
+    if (itr == mReleaseBuffersCallbacks.end()) {
+        return nullptr;
+    }
+    auto callback = std::move(itr->second);
+    mReleaseBuffersCallbacks.erase(itr);
+    return callback;
+}
+
 void TransactionCompletedListener::removeReleaseBufferCallback(
         const ReleaseCallbackId& callbackId) {
     {
@@ -723,7 +812,10 @@ SurfaceComposerClient::Transaction::Transaction(const Transaction& other)
         mFrameTimelineInfo(other.mFrameTimelineInfo),
         mApplyToken(other.mApplyToken) {
     mDisplayStates = other.mDisplayStates;
-    mComposerStates = other.mComposerStates;
+    const auto otherComposerStates = other.composerStates();
+    mComposerStates.assign(otherComposerStates.begin(), otherComposerStates.end());
+    mComposerStateCount = other.mComposerStateCount;
+    mComposerStateIndex = other.mComposerStateIndex;
     mInputWindowCommands = other.mInputWindowCommands;
     mListenerCallbacks = other.mListenerCallbacks;
     mTransactionCompletedListener = TransactionCompletedListener::getInstance();
@@ -731,7 +823,7 @@ SurfaceComposerClient::Transaction::Transaction(const Transaction& other)
 
 void SurfaceComposerClient::Transaction::sanitize(int pid, int uid) {
     uint32_t permissions = LayerStatePermissions::getTransactionPermissions(pid, uid);
-    for (auto & [handle, composerState] : mComposerStates) {
+    for (auto& [handle, composerState] : composerStates()) {
         composerState.state.sanitize(permissions);
     }
     if (!mInputWindowCommands.empty() &&
@@ -811,17 +903,12 @@ status_t SurfaceComposerClient::Transaction::readFromParcel(const Parcel* parcel
     if (count > parcel->dataSize()) {
         return BAD_VALUE;
     }
-    std::unordered_map<sp<IBinder>, ComposerState, IBinderHash> composerStates;
-    composerStates.reserve(count);
-    for (size_t i = 0; i < count; i++) {
-        sp<IBinder> surfaceControlHandle;
+    std::vector<std::pair<sp<IBinder>, ComposerState>> composerStates(count);
+    for (auto& [surfaceControlHandle, composerState] : composerStates) {
         SAFE_PARCEL(parcel->readStrongBinder, &surfaceControlHandle);
-
-        ComposerState composerState;
         if (composerState.read(*parcel) == BAD_VALUE) {
             return BAD_VALUE;
         }
-        composerStates[surfaceControlHandle] = composerState;
     }
 
     InputWindowCommands inputWindowCommands;
@@ -859,7 +946,10 @@ status_t SurfaceComposerClient::Transaction::readFromParcel(const Parcel* parcel
     mFrameTimelineInfo = frameTimelineInfo;
     mDisplayStates = displayStates;
     mListenerCallbacks = listenerCallbacks;
-    mComposerStates = composerStates;
+    clearComposerStates();
+    for (auto& [surfaceControlHandle, composerState] : composerStates) {
+        getComposerState(surfaceControlHandle) = std::move(composerState);
+    }
     mInputWindowCommands = inputWindowCommands;
     mApplyToken = applyToken;
     mUncacheBuffers = std::move(uncacheBuffers);
@@ -908,8 +998,8 @@ status_t SurfaceComposerClient::Transaction::writeToParcel(Parcel* parcel) const
         }
     }
 
-    parcel->writeUint32(static_cast<uint32_t>(mComposerStates.size()));
-    for (auto const& [handle, composerState] : mComposerStates) {
+    parcel->writeUint32(static_cast<uint32_t>(mComposerStateCount));
+    for (auto const& [handle, composerState] : composerStates()) {
         SAFE_PARCEL(parcel->writeStrongBinder, handle);
         composerState.write(*parcel);
     }
@@ -967,14 +1057,16 @@ SurfaceComposerClient::Transaction& SurfaceComposerClient::Transaction::merge(Tr
     }
     mMergedTransactionIds.insert(mMergedTransactionIds.begin(), other.mId);
 
-    for (auto const& [handle, composerState] : other.mComposerStates) {
-        if (mComposerStates.count(handle) == 0) {
-            mComposerStates[handle] = composerState;
+    for (auto const& [handle, composerState] : other.composerStates()) {
+        const size_t count = mComposerStateCount;
+        ComposerState& current = getComposerState(handle);
+        if (mComposerStateCount > count) {
+            current = composerState;
         } else {
             if (composerState.state.what & layer_state_t::eBufferChanged) {
-                releaseBufferIfOverwriting(mComposerStates[handle].state);
+                releaseBufferIfOverwriting(current.state);
             }
-            mComposerStates[handle].state.merge(composerState.state);
+            current.state.merge(composerState.state);
         }
     }
 
@@ -1027,7 +1119,7 @@ SurfaceComposerClient::Transaction& SurfaceComposerClient::Transaction::merge(Tr
 }
 
 void SurfaceComposerClient::Transaction::clear() {
-    mComposerStates.clear();
+    clearComposerStates();
     mDisplayStates.clear();
     mListenerCallbacks.clear();
     mInputWindowCommands.clear();
@@ -1076,8 +1168,8 @@ void SurfaceComposerClient::Transaction::cacheBuffers() {
     }
 
     size_t count = 0;
-    for (auto& [handle, cs] : mComposerStates) {
-        layer_state_t* s = &(mComposerStates[handle].state);
+    for (auto& [handle, cs] : composerStates()) {
+        layer_state_t* s = &cs.state;
         if (!(s->what & layer_state_t::eBufferChanged)) {
             continue;
         } else if (s->bufferData &&
@@ -1166,8 +1258,9 @@ status_t SurfaceComposerClient::Transaction::apply(bool synchronous, bool oneWay
         return mStatus;
     }
 
-    std::shared_ptr<SyncCallback> syncCallback = std::make_shared<SyncCallback>();
+    std::shared_ptr<SyncCallback> syncCallback;
     if (synchronous) {
+        syncCallback = std::make_shared<SyncCallback>();
         syncCallback->init();
         addTransactionCommittedCallback(SyncCallback::getCallback(syncCallback),
                                         /*callbackContext=*/nullptr);
@@ -1206,8 +1299,9 @@ status_t SurfaceComposerClient::Transaction::apply(bool synchronous, bool oneWay
     Vector<DisplayState> displayStates;
     uint32_t flags = 0;
 
-    for (auto const& kv : mComposerStates) {
-        composerStates.add(kv.second);
+    composerStates.setCapacity(mComposerStateCount);
+    for (auto const& [handle, composerState] : this->composerStates()) {
+        composerStates.add(composerState);
     }
 
     displayStates = std::move(mDisplayStates);
@@ -1257,6 +1351,11 @@ sp<IBinder> SurfaceComposerClient::Transaction::sApplyToken = new BBinder();
 
 std::mutex SurfaceComposerClient::Transaction::sApplyTokenMutex;
 
+std::mutex SurfaceComposerClient::Transaction::sPoolMutex;
+
+std::vector<std::unique_ptr<SurfaceComposerClient::Transaction>>
+        SurfaceComposerClient::Transaction::sPool;
+
 sp<IBinder> SurfaceComposerClient::Transaction::getDefaultApplyToken() {
     std::scoped_lock lock{sApplyTokenMutex};
     return sApplyToken;
@@ -1352,18 +1451,81 @@ void SurfaceComposerClient::Transaction::setEarlyWakeupEnd() {
 
 layer_state_t* SurfaceComposerClient::Transaction::getLayerState(const sp<SurfaceControl>& sc) {
     auto handle = sc->getLayerStateHandle();
+    const size_t count = mComposerStateCount;
+    layer_state_t& state = getComposerState(handle).state;
+    if (mComposerStateCount > count) {
+        // we didn't have it, initialize the new layer_state
+        state.surface = handle;
+        state.layerId = sc->getLayerId();
+    }
+    return &state;
+}
 
-    if (mComposerStates.count(handle) == 0) {
-        // we don't have it, add an initialized layer_state to our list
-        ComposerState s;
+SurfaceComposerClient::Transaction::Pooled SurfaceComposerClient::Transaction::obtain() {
+    std::unique_ptr<Transaction> transaction;
+    {
+        std::scoped_lock lock{sPoolMutex};
+        if (!sPool.empty()) {
+            transaction = std::move(sPool.back());
+            sPool.pop_back();
+        }
+    }
+    if (!transaction) {
+        return Pooled(new Transaction());
+    }
+    transaction->mId = generateId();
+    transaction->mStatus = NO_ERROR;
+    return Pooled(transaction.release());
+}
 
-        s.state.surface = handle;
-        s.state.layerId = sc->getLayerId();
+void SurfaceComposerClient::Transaction::Recycler::operator()(Transaction* transaction) const {
+    // Clearing drops the references the transaction holds, e.g. to buffers, before it is pooled.
+    transaction->clear();
+    std::scoped_lock lock{sPoolMutex};
+    if (sPool.size() < MAX_POOLED_TRANSACTIONS) {
+        sPool.emplace_back(transaction);
+    } else {
+        delete transaction;
+    }
+}
+
+ComposerState& SurfaceComposerClient::Transaction::getComposerState(const sp<IBinder>& handle) {
+    const auto it = std::lower_bound(mComposerStateIndex.begin(), mComposerStateIndex.end(),
+                                     handle.get(),
+                                     [](const auto& entry, const IBinder* binder) {
+                                         return entry.first < binder;
+                                     });
+    if (it != mComposerStateIndex.end() && it->first == handle.get()) {
+        return mComposerStates[it->second].second;
+    }
 
-        mComposerStates[handle] = s;
+    // Reuse a state that was reset by clear() if there's one.
+    const size_t index = mComposerStateCount++;
+    if (index == mComposerStates.size()) {
+        mComposerStates.emplace_back();
     }
+    mComposerStates[index].first = handle;
+    mComposerStateIndex.insert(it, {handle.get(), index});
+    return mComposerStates[index].second;
+}
+
+std::span<std::pair<sp<IBinder>, ComposerState>>
+SurfaceComposerClient::Transaction::composerStates() {
+    return {mComposerStates.data(), mComposerStateCount};
+}
 
-    return &(mComposerStates[handle].state);
+std::span<const std::pair<sp<IBinder>, ComposerState>>
+SurfaceComposerClient::Transaction::composerStates() const {
+    return {mComposerStates.data(), mComposerStateCount};
+}
+
+void SurfaceComposerClient::Transaction::clearComposerStates() {
+    for (auto& [handle, composerState] : composerStates()) {
+        handle = nullptr;
+        resetLayerState(composerState.state);
+    }
+    mComposerStateCount = 0;
+    mComposerStateIndex.clear();
 }
 
 void SurfaceComposerClient::Transaction::registerSurfaceControlForCallback(
@@ -1760,6 +1922,25 @@ SurfaceComposerClient::Transaction& SurfaceComposerClient::Transaction::setBuffe
     return *this;
 }
 
+SurfaceComposerClient::Transaction& SurfaceComposerClient::Transaction::setReleaseBuffersCallback(
+        const sp<SurfaceControl>& sc,
+        const std::shared_ptr<const ReleaseBuffersCallback>& callback) {
+    layer_state_t* s = getLayerState(sc);
+    if (!s) {
+        mStatus = BAD_INDEX;
+        return *this;
+    }
+    // Only buffers with a ReleaseBufferCallback are released through this process' listener
+    if (!callback || !(s->what & layer_state_t::eBufferChanged) || !s->bufferData ||
+        !s->bufferData->releaseBufferListener) {
+        return *this;
+    }
+
+    mTransactionCompletedListener->setReleaseBuffersCallback(
+            s->bufferData->generateReleaseCallbackId(), callback);
+    return *this;
+}
+
 SurfaceComposerClient::Transaction& SurfaceComposerClient::Transaction::unsetBuffer(
         const sp<SurfaceControl>& sc) {
     layer_state_t* s = getLayerState(sc);
@@ -0,0 +1,353 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "VsyncBroadcastChannel"
+
+#include <private/gui/VsyncBroadcastChannel.h>
+
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <thread>
+
+#include <android-base/thread_annotations.h>
+#include <binder/Parcel.h>
+#include <utils/Log.h>
+
+namespace android {
+namespace gui {
+
+// The sequence number is odd while the publisher is writing the event, and receivers retry any read
+// that overlapped a publish. This is a sequence lock, so the event itself is copied without
+// synchronization and only trusted once the sequence number is confirmed unchanged.
+struct VsyncBroadcastChannel::Page {
+    std::atomic<uint32_t> sequence{0};
+    DisplayEventReceiver::Event event;
+};
+static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+// Receivers in other processes wait on the same sequence number, so the futex must not be private.
+static long futex(const std::atomic<uint32_t>* address, int op, uint32_t value) {
+    return syscall(SYS_futex, address, op, value, nullptr, nullptr, 0);
+}
+
+// A receiver that keeps losing the race against the publisher gives up instead of spinning, e.g. if
+// the publisher died in the middle of a publish. It will try again on the next wake up.
+static constexpr int MAX_READ_ATTEMPTS = 16;
+
+VsyncBroadcastChannel::VsyncBroadcastChannel(PublisherType) {
+    base::unique_fd memoryFd(memfd_create("VsyncBroadcastChannel", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+    if (memoryFd < 0) {
+        ALOGE("VsyncBroadcastChannel: memfd_create failed (%s)", strerror(errno));
+        return;
+    }
+    if (ftruncate(memoryFd, sizeof(Page)) < 0) {
+        ALOGE("VsyncBroadcastChannel: ftruncate failed (%s)", strerror(errno));
+        return;
+    }
+
+    mMemoryFd = std::move(memoryFd);
+    mIsPublisher = true;
+    if (map(PROT_READ | PROT_WRITE) != NO_ERROR) {
+        return;
+    }
+    new (mPage) Page();
+
+    // Existing mappings, i.e. the publisher's, stay writable, but receivers can only map the page
+    // read-only from now on.
+    if (fcntl(mMemoryFd, F_ADD_SEALS,
+              F_SEAL_SEAL | F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_FUTURE_WRITE) < 0) {
+        ALOGE("VsyncBroadcastChannel: sealing failed (%s)", strerror(errno));
+        unmap();
+    }
+}
+
+VsyncBroadcastChannel::~VsyncBroadcastChannel() {
+    unmap();
+}
+
+status_t VsyncBroadcastChannel::initCheck() const {
+    return mPage != nullptr ? NO_ERROR : NO_INIT;
+}
+
+status_t VsyncBroadcastChannel::addReceiver(VsyncBroadcastChannel* outChannel) const {
+    if (!mIsPublisher || mMemoryFd < 0) return NO_INIT;
+
+    base::unique_fd memoryFd(fcntl(mMemoryFd, F_DUPFD_CLOEXEC, 0));
+    if (memoryFd < 0) {
+        int error = errno;
+        ALOGE("VsyncBroadcastChannel::addReceiver: can't dup file descriptor (%s)",
+              strerror(error));
+        return -error;
+    }
+
+    outChannel->unmap();
+    outChannel->mIsPublisher = false;
+    outChannel->mMemoryFd = std::move(memoryFd);
+    return NO_ERROR;
+}
+
+void VsyncBroadcastChannel::publish(const DisplayEventReceiver::Event& event) {
+    LOG_ALWAYS_FATAL_IF(!mIsPublisher || mPage == nullptr,
+                        "VsyncBroadcastChannel::publish called on a receiving end");
+
+    const uint32_t sequence = mPage->sequence.load(std::memory_order_relaxed);
+    mPage->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&mPage->event, &event, sizeof(event));
+    mPage->sequence.store(sequence + 2, std::memory_order_release);
+
+    // One wake up for all the receivers, however many there are.
+    wakeWaiters();
+}
+
+uint32_t VsyncBroadcastChannel::getSequence() const {
+    if (mPage == nullptr) return 0;
+    return (mPage->sequence.load(std::memory_order_acquire) + 1) & ~1u;
+}
+
+bool VsyncBroadcastChannel::read(uint32_t* inOutSequence,
+                                 DisplayEventReceiver::Event* outEvent) const {
+    if (mPage == nullptr) return false;
+
+    for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++) {
+        const uint32_t sequence = mPage->sequence.load(std::memory_order_acquire);
+        if (sequence == *inOutSequence) {
+            return false;
+        }
+        if (sequence & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        memcpy(outEvent, &mPage->event, sizeof(*outEvent));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (mPage->sequence.load(std::memory_order_relaxed) == sequence) {
+            *inOutSequence = sequence;
+            return true;
+        }
+    }
+
+    ALOGW("VsyncBroadcastChannel::read: gave up after %d attempts", MAX_READ_ATTEMPTS);
+    return false;
+}
+
+bool VsyncBroadcastChannel::waitForPublish(uint32_t sequence) const {
+    if (mPage == nullptr) return false;
+
+    // A publish in progress is only seen once it completes, as in getSequence().
+    const uint32_t current = mPage->sequence.load(std::memory_order_acquire);
+    if (((current + 1) & ~1u) != sequence) {
+        return true;
+    }
+    // Fails right away if the sequence number changed since it was loaded, so that a publish can't
+    // slip in before the wait.
+    if (futex(&mPage->sequence, FUTEX_WAIT, current) < 0 && errno != EAGAIN && errno != EINTR) {
+        ALOGW("VsyncBroadcastChannel::waitForPublish: futex failed (%s)", strerror(errno));
+    }
+    return getSequence() != sequence;
+}
+
+void VsyncBroadcastChannel::wakeWaiters() const {
+    if (mPage == nullptr) return;
+
+    if (futex(&mPage->sequence, FUTEX_WAKE, INT_MAX) < 0) {
+        ALOGW("VsyncBroadcastChannel::wakeWaiters: futex failed (%s)", strerror(errno));
+    }
+}
+
+status_t VsyncBroadcastChannel::writeToParcel(Parcel* reply) const {
+    if (mMemoryFd < 0) return -EINVAL;
+
+    return reply->writeDupFileDescriptor(mMemoryFd);
+}
+
+status_t VsyncBroadcastChannel::readFromParcel(const Parcel* parcel) {
+    unmap();
+    mIsPublisher = false;
+
+    mMemoryFd.reset(fcntl(parcel->readFileDescriptor(), F_DUPFD_CLOEXEC, 0));
+    if (mMemoryFd < 0) {
+        int error = errno;
+        ALOGE("VsyncBroadcastChannel::readFromParcel: can't dup file descriptor (%s)",
+              strerror(error));
+        return -error;
+    }
+
+    struct stat stats;
+    if (fstat(mMemoryFd, &stats) < 0 || stats.st_size < static_cast<off_t>(sizeof(Page))) {
+        ALOGE("VsyncBroadcastChannel::readFromParcel: invalid shared memory");
+        return BAD_VALUE;
+    }
+    return map(PROT_READ);
+}
+
+status_t VsyncBroadcastChannel::map(int prot) {
+    void* address = mmap(nullptr, sizeof(Page), prot, MAP_SHARED, mMemoryFd, 0);
+    if (address == MAP_FAILED) {
+        int error = errno;
+        ALOGE("VsyncBroadcastChannel: mmap failed (%s)", strerror(error));
+        return -error;
+    }
+    mPage = static_cast<Page*>(address);
+    return NO_ERROR;
+}
+
+void VsyncBroadcastChannel::unmap() {
+    if (mPage != nullptr) {
+        munmap(mPage, sizeof(Page));
+        mPage = nullptr;
+    }
+}
+
+VsyncBroadcastReceiver::VsyncBroadcastReceiver(std::unique_ptr<VsyncBroadcastChannel> channel)
+      : mChannel(std::move(channel)), mEventFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {
+    LOG_ALWAYS_FATAL_IF(mEventFd < 0, "VsyncBroadcastReceiver: eventfd failed (%s)",
+                        strerror(errno));
+    mThread = std::thread(&VsyncBroadcastReceiver::threadMain, this);
+    pthread_setname_np(mThread.native_handle(), "VsyncBroadcast");
+}
+
+VsyncBroadcastReceiver::~VsyncBroadcastReceiver() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQuit = true;
+    }
+    mCondition.notify_all();
+    // The thread may be about to wait for a publish, so keep waking it up until it quits. The
+    // receivers in other processes just go back to waiting.
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mThreadExited) break;
+        }
+        mChannel->wakeWaiters();
+        std::this_thread::yield();
+    }
+    mThread.join();
+}
+
+int VsyncBroadcastReceiver::getFd() const {
+    return mEventFd;
+}
+
+void VsyncBroadcastReceiver::setVsyncRate(uint32_t count) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mVsyncRate = count;
+    if (count > 0) {
+        arm();
+    }
+}
+
+void VsyncBroadcastReceiver::requestNextVsync() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    arm();
+}
+
+void VsyncBroadcastReceiver::onVsyncPosted(const DisplayEventReceiver::Event& event) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    onVsyncDeliveredLocked(event);
+}
+
+bool VsyncBroadcastReceiver::getVsync(DisplayEventReceiver::Event* outEvent) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mWakePending) {
+        return false;
+    }
+    uint64_t wakeUps;
+    if (TEMP_FAILURE_RETRY(::read(mEventFd, &wakeUps, sizeof(wakeUps))) < 0) {
+        ALOGW("VsyncBroadcastReceiver::getVsync: read failed (%s)", strerror(errno));
+    }
+    mWakePending = false;
+    mCondition.notify_all();
+
+    // The request may have been answered by a posted vsync since the wake up.
+    if (!mArmed) {
+        return false;
+    }
+    if (!mChannel->read(&mSequence, outEvent)) {
+        return false;
+    }
+    // An event published before the one last posted may still be pending, e.g. if both were
+    // delivered while the client was busy. It must not be delivered after the posted one.
+    if (outEvent->header.timestamp <= mLastVsyncTimestamp) {
+        return false;
+    }
+    onVsyncDeliveredLocked(*outEvent);
+    return true;
+}
+
+void VsyncBroadcastReceiver::arm() {
+    if (mArmed) {
+        return;
+    }
+    // Only events published from now on can answer the request.
+    mSequence = mChannel->getSequence();
+    mArmed = true;
+    mCondition.notify_all();
+}
+
+void VsyncBroadcastReceiver::onVsyncDeliveredLocked(const DisplayEventReceiver::Event& event) {
+    mLastVsyncTimestamp = std::max(mLastVsyncTimestamp, event.header.timestamp);
+    if (mVsyncRate == 0) {
+        mArmed = false;
+    }
+}
+
+void VsyncBroadcastReceiver::threadMain() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    base::ScopedLockAssertion assumeLocked(mMutex);
+    while (true) {
+        // Only wait for publishes while a request is pending, and until the client consumes the
+        // wake up.
+        mCondition.wait(lock, [this]() REQUIRES(mMutex) {
+            return mQuit || (mArmed && !mWakePending);
+        });
+        if (mQuit) {
+            break;
+        }
+
+        const uint32_t sequence = mSequence;
+        lock.unlock();
+        mChannel->waitForPublish(sequence);
+        lock.lock();
+
+        // The client may have been re-armed while waiting, in which case it is only woken up for a
+        // publish since.
+        if (mArmed && !mWakePending && mChannel->getSequence() != mSequence) {
+            const uint64_t wakeUp = 1;
+            if (TEMP_FAILURE_RETRY(write(mEventFd, &wakeUp, sizeof(wakeUp))) < 0) {
+                ALOGW("VsyncBroadcastReceiver: write failed (%s)", strerror(errno));
+            }
+            mWakePending = true;
+        }
+    }
+    mThreadExited = true;
+}
+
+} // namespace gui
+} // namespace android
@@ -104,6 +104,8 @@ public:
     void releaseBufferCallbackLocked(const ReleaseCallbackId& id, const sp<Fence>& releaseFence,
                                      std::optional<uint32_t> currentMaxAcquiredBufferCount,
                                      bool fakeRelease) REQUIRES(mMutex);
+    // Releases buffers that SurfaceFlinger released together, taking the lock once.
+    void releaseBuffersCallback(const std::vector<BufferRelease>& releases);
     bool syncNextTransaction(std::function<void(SurfaceComposerClient::Transaction*)> callback,
                              bool acquireSingleBuffer = true);
     void stopContinuousSyncTransaction();
@@ -200,6 +202,9 @@ private:
     };
     std::deque<ReleasedBuffer> mPendingRelease GUARDED_BY(mMutex);
 
+    // Shared by all the buffers we submit, so that the ones released together are batched
+    std::shared_ptr<const ReleaseBuffersCallback> mReleaseBuffersCallback GUARDED_BY(mMutex);
+
     ui::Size mSize GUARDED_BY(mMutex);
     ui::Size mRequestedSize GUARDED_BY(mMutex);
     int32_t mFormat GUARDED_BY(mMutex);
@@ -48,6 +48,8 @@ class BufferItem : public Flattenable<BufferItem> {
     ~BufferItem();
     BufferItem(const BufferItem&) = default;
     BufferItem& operator=(const BufferItem&) = default;
+    BufferItem(BufferItem&&) = default;
+    BufferItem& operator=(BufferItem&&) = default;
 
     static const char* scalingModeName(uint32_t scalingMode);
 
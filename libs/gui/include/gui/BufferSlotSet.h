@@ -0,0 +1,191 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_GUI_BUFFERSLOTSET_H
+#define ANDROID_GUI_BUFFERSLOTSET_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <bit>
+#include <iterator>
+
+#include <gui/BufferQueueDefs.h>
+
+namespace android {
+
+// BufferSlotSet is a set of buffer slots, kept in a bitmap so that it never allocates. Like the
+// std::set<int> it replaces, it iterates over the slots in increasing order.
+class BufferSlotSet {
+public:
+    static_assert(BufferQueueDefs::NUM_BUFFER_SLOTS <= 64, "slots don't fit in the bitmap");
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = int;
+        using difference_type = ptrdiff_t;
+        using pointer = const int*;
+        using reference = int;
+
+        const_iterator() = default;
+        explicit const_iterator(uint64_t bits) : mBits(bits) {}
+
+        int operator*() const { return std::countr_zero(mBits); }
+        const_iterator& operator++() {
+            mBits &= mBits - 1;
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+        bool operator==(const const_iterator& other) const { return mBits == other.mBits; }
+        bool operator!=(const const_iterator& other) const { return mBits != other.mBits; }
+
+    private:
+        // The slots that are left to visit.
+        uint64_t mBits = 0;
+    };
+
+    const_iterator begin() const { return const_iterator(mBits); }
+    const_iterator end() const { return const_iterator(); }
+
+    bool empty() const { return mBits == 0; }
+    size_t size() const { return static_cast<size_t>(std::popcount(mBits)); }
+    size_t count(int slot) const { return (mBits & bit(slot)) != 0 ? 1 : 0; }
+
+    void insert(int slot) { mBits |= bit(slot); }
+    void erase(int slot) { mBits &= ~bit(slot); }
+    void erase(const_iterator it) { erase(*it); }
+    void clear() { mBits = 0; }
+
+private:
+    static uint64_t bit(int slot) { return uint64_t{1} << slot; }
+
+    uint64_t mBits = 0;
+};
+
+// BufferSlotList is an ordered list of distinct buffer slots, which replaces a std::list<int>
+// without allocating. It may hold every slot (mUnusedSlots holds most of them when few buffers are
+// in use), so rather than searching, it links each slot to its neighbours through arrays indexed by
+// slot: the ends, pushes, pops and removals are O(1), and iterating is linear.
+class BufferSlotList {
+public:
+    // Iterates over the slots from front to back.
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = int;
+        using difference_type = ptrdiff_t;
+        using pointer = const int*;
+        using reference = int;
+
+        const_iterator() = default;
+        const_iterator(const BufferSlotList* list, int slot) : mList(list), mSlot(slot) {}
+
+        int operator*() const { return mSlot; }
+        const_iterator& operator++() {
+            mSlot = mList->mNext[mSlot];
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+        bool operator==(const const_iterator& other) const { return mSlot == other.mSlot; }
+        bool operator!=(const const_iterator& other) const { return mSlot != other.mSlot; }
+
+    private:
+        const BufferSlotList* mList = nullptr;
+        int mSlot = kNoSlot;
+    };
+
+    const_iterator begin() const { return const_iterator(this, mFront); }
+    const_iterator end() const { return const_iterator(this, kNoSlot); }
+
+    bool empty() const { return mSlots.empty(); }
+    size_t size() const { return mSlots.size(); }
+    size_t count(int slot) const { return mSlots.count(slot); }
+
+    // The front and back of an empty list are undefined, as with std::list.
+    int front() const { return mFront; }
+    int back() const { return mBack; }
+
+    // The slot must not be in the list already.
+    void push_front(int slot) {
+        mPrevious[slot] = kNoSlot;
+        mNext[slot] = static_cast<int8_t>(mFront);
+        if (mFront == kNoSlot) {
+            mBack = slot;
+        } else {
+            mPrevious[mFront] = static_cast<int8_t>(slot);
+        }
+        mFront = slot;
+        mSlots.insert(slot);
+    }
+    void push_back(int slot) {
+        mNext[slot] = kNoSlot;
+        mPrevious[slot] = static_cast<int8_t>(mBack);
+        if (mBack == kNoSlot) {
+            mFront = slot;
+        } else {
+            mNext[mBack] = static_cast<int8_t>(slot);
+        }
+        mBack = slot;
+        mSlots.insert(slot);
+    }
+    void pop_front() { remove(mFront); }
+    void pop_back() { remove(mBack); }
+    void remove(int slot) {
+        if (!mSlots.count(slot)) return;
+        const int previous = mPrevious[slot];
+        const int next = mNext[slot];
+        if (previous == kNoSlot) {
+            mFront = next;
+        } else {
+            mNext[previous] = static_cast<int8_t>(next);
+        }
+        if (next == kNoSlot) {
+            mBack = previous;
+        } else {
+            mPrevious[next] = static_cast<int8_t>(previous);
+        }
+        mSlots.erase(slot);
+    }
+    void clear() {
+        mSlots.clear();
+        mFront = kNoSlot;
+        mBack = kNoSlot;
+    }
+
+private:
+    static constexpr int kNoSlot = -1;
+
+    BufferSlotSet mSlots;
+    // The neighbours of the slots in the list; the entries of other slots are stale.
+    std::array<int8_t, BufferQueueDefs::NUM_BUFFER_SLOTS> mPrevious{};
+    std::array<int8_t, BufferQueueDefs::NUM_BUFFER_SLOTS> mNext{};
+    int mFront = kNoSlot;
+    int mBack = kNoSlot;
+};
+
+} // namespace android
+
+#endif // ANDROID_GUI_BUFFERSLOTSET_H
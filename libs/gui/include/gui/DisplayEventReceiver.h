@@ -46,6 +46,7 @@ using gui::VsyncEventData;
 
 namespace gui {
 class BitTube;
+class VsyncBroadcastReceiver;
 } // namespace gui
 
 static inline constexpr uint32_t fourcc(char c1, char c2, char c3, char c4) {
@@ -188,10 +189,29 @@ public:
      */
     status_t getLatestVsyncEventData(ParcelableVsyncEventData* outVsyncEventData) const;
 
+    /*
+     * getVsyncBroadcastFd returns a file descriptor that becomes readable when a vsync event has
+     * been broadcast to this receiver, or -1 if vsync events are only delivered through getFd().
+     * Broadcasts are only used when requested with EventRegistration::vsyncBroadcast.
+     * OWNERSHIP IS RETAINED by DisplayEventReceiver. DO NOT CLOSE this
+     * file-descriptor.
+     */
+    int getVsyncBroadcastFd() const;
+
+    /*
+     * getBroadcastVsync reads the latest vsync event broadcast since vsync events were last
+     * requested with requestNextVsync() or setVsyncRate(). Returns false if there is none.
+     */
+    bool getBroadcastVsync(Event* outEvent);
+
 private:
+    void initVsyncBroadcast();
+
     sp<IDisplayEventConnection> mEventConnection;
     std::unique_ptr<gui::BitTube> mDataChannel;
     std::optional<status_t> mInitError;
+
+    std::unique_ptr<gui::VsyncBroadcastReceiver> mBroadcastReceiver;
 };
 
 inline bool operator==(DisplayEventReceiver::Event::FrameRateOverride lhs,
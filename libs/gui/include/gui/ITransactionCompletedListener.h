@@ -89,6 +89,24 @@ struct ReleaseBufferCallbackIdHash {
     }
 };
 
+// A buffer released by SurfaceFlinger, as sent in a batch through onReleaseBuffers.
+class ReleasedBufferStats : public Parcelable {
+public:
+    status_t writeToParcel(Parcel* output) const override;
+    status_t readFromParcel(const Parcel* input) override;
+
+    ReleasedBufferStats() = default;
+    ReleasedBufferStats(const ReleaseCallbackId& callbackId, const sp<Fence>& releaseFence,
+                        uint32_t currentMaxAcquiredBufferCount)
+          : callbackId(callbackId),
+            releaseFence(releaseFence),
+            currentMaxAcquiredBufferCount(currentMaxAcquiredBufferCount) {}
+
+    ReleaseCallbackId callbackId;
+    sp<Fence> releaseFence = Fence::NO_FENCE;
+    uint32_t currentMaxAcquiredBufferCount = 0;
+};
+
 class FrameEventHistoryStats : public Parcelable {
 public:
     status_t writeToParcel(Parcel* output) const override;
@@ -206,6 +224,10 @@ public:
     virtual void onReleaseBuffer(ReleaseCallbackId callbackId, sp<Fence> releaseFence,
                                  uint32_t currentMaxAcquiredBufferCount) = 0;
 
+    // Releases several buffers at once, in order, e.g. all the buffers of a process that were
+    // dropped in one SurfaceFlinger commit.
+    virtual void onReleaseBuffers(std::vector<ReleasedBufferStats> releasedBuffers) = 0;
+
     virtual void onTransactionQueueStalled(const String8& name) = 0;
 
     virtual void onTrustedPresentationChanged(int id, bool inTrustedPresentationState) = 0;
@@ -223,6 +223,8 @@ struct layer_state_t {
     layer_state_t();
 
     void merge(const layer_state_t& other);
+    // Only the fields of the changes set in |what| are parceled. Fields of other changes are left
+    // untouched by read.
     status_t write(Parcel& output) const;
     status_t read(const Parcel& input);
     // Compares two layer_state_t structs and returns a set of change flags describing all the
@@ -286,6 +288,10 @@ struct layer_state_t {
     static constexpr uint64_t VISIBLE_REGION_CHANGES = layer_state_t::GEOMETRY_CHANGES |
             layer_state_t::HIERARCHY_CHANGES | layer_state_t::eAlphaChanged;
 
+    // Version of the parcel written by write. Increment it when the encoding changes, so that a
+    // mismatched reader fails instead of misreading the fields.
+    static constexpr uint32_t PARCEL_VERSION = 2;
+
     bool hasValidBuffer() const;
     void sanitize(int32_t permissions);
 
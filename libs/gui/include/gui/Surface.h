@@ -318,6 +318,9 @@ private:
     int dispatchGetLastQueuedBuffer2(va_list args);
     int dispatchSetFrameTimelineInfo(va_list args);
     int dispatchSetAdditionalOptions(va_list args);
+    int dispatchDequeueBuffers(va_list args);
+    int dispatchQueueBuffers(va_list args);
+    int dispatchCancelBuffers(va_list args);
 
     std::mutex mNameMutex;
     std::string mName;
@@ -19,10 +19,14 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <memory>
 #include <set>
+#include <span>
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include <binder/IBinder.h>
 
@@ -103,6 +107,16 @@ using ReleaseBufferCallback =
         std::function<void(const ReleaseCallbackId&, const sp<Fence>& /*releaseFence*/,
                            std::optional<uint32_t> currentMaxAcquiredBufferCount)>;
 
+// A buffer released by SurfaceFlinger, as passed to a ReleaseBuffersCallback.
+struct BufferRelease {
+    ReleaseCallbackId callbackId;
+    sp<Fence> releaseFence;
+    std::optional<uint32_t> currentMaxAcquiredBufferCount;
+};
+
+// Releases several buffers at once, in release order.
+using ReleaseBuffersCallback = std::function<void(const std::vector<BufferRelease>&)>;
+
 using SurfaceStatsCallback =
         std::function<void(void* /*context*/, nsecs_t /*latchTime*/,
                            const sp<Fence>& /*presentFence*/,
@@ -433,13 +447,24 @@ public:
     private:
         static sp<IBinder> sApplyToken;
         static std::mutex sApplyTokenMutex;
+        // Cleared transactions handed out by obtain().
+        static constexpr size_t MAX_POOLED_TRANSACTIONS = 4;
+        static std::mutex sPoolMutex;
+        static std::vector<std::unique_ptr<Transaction>> sPool GUARDED_BY(sPoolMutex);
         void releaseBufferIfOverwriting(const layer_state_t& state);
         static void mergeFrameTimelineInfo(FrameTimelineInfo& t, const FrameTimelineInfo& other);
         // Tracks registered callbacks
         sp<TransactionCompletedListener> mTransactionCompletedListener = nullptr;
 
     protected:
-        std::unordered_map<sp<IBinder>, ComposerState, IBinderHash> mComposerStates;
+        // The layer states, in the order the layers were first changed, with the handle of each
+        // layer. Only the first mComposerStateCount states are in use. The others were reset by
+        // clear() and are reused for the next layers, so that a transaction that is built and
+        // applied every frame stops allocating once it has seen its largest frame.
+        std::vector<std::pair<sp<IBinder>, ComposerState>> mComposerStates;
+        size_t mComposerStateCount = 0;
+        // Indices into mComposerStates of the layer states in use, sorted by layer handle.
+        std::vector<std::pair<const IBinder*, size_t>> mComposerStateIndex;
         SortedVector<DisplayState> mDisplayStates;
         std::unordered_map<sp<ITransactionCompletedListener>, CallbackInfo, TCLHash>
                 mListenerCallbacks;
@@ -489,6 +514,13 @@ public:
         int mStatus = NO_ERROR;
 
         layer_state_t* getLayerState(const sp<SurfaceControl>& sc);
+        // Returns the state of the layer with the given handle, adding it if the layer wasn't
+        // changed yet by this transaction.
+        ComposerState& getComposerState(const sp<IBinder>& handle);
+        // Returns the layer states in use.
+        std::span<std::pair<sp<IBinder>, ComposerState>> composerStates();
+        std::span<const std::pair<sp<IBinder>, ComposerState>> composerStates() const;
+        void clearComposerStates();
         DisplayState& getDisplayState(const sp<IBinder>& token);
 
         void cacheBuffers();
@@ -500,6 +532,17 @@ public:
         virtual ~Transaction() = default;
         Transaction(Transaction const& other);
 
+        struct Recycler {
+            void operator()(Transaction* transaction) const;
+        };
+        using Pooled = std::unique_ptr<Transaction, Recycler>;
+
+        // Returns a cleared transaction with a new id, taken from a process-wide pool. It keeps the
+        // layer states it allocated in previous uses, so that a caller building a transaction
+        // every frame doesn't allocate them again. The transaction is cleared and returned to the
+        // pool when released.
+        static Pooled obtain();
+
         // Factory method that creates a new Transaction instance from the parcel.
         static std::unique_ptr<Transaction> createFromParcel(const Parcel* parcel);
 
@@ -575,6 +618,13 @@ public:
                                const std::optional<uint64_t>& frameNumber = std::nullopt,
                                uint32_t producerId = 0, ReleaseBufferCallback callback = nullptr,
                                nsecs_t dequeueTime = -1);
+        // Lets the buffer set by setBuffer be released along with the other buffers that share
+        // the callback, when SurfaceFlinger releases them together, so that their owner handles
+        // them in a single call. Buffers that are released on their own still go to the
+        // ReleaseBufferCallback passed to setBuffer. Has to be called after setBuffer.
+        Transaction& setReleaseBuffersCallback(
+                const sp<SurfaceControl>& sc,
+                const std::shared_ptr<const ReleaseBuffersCallback>& callback);
         Transaction& unsetBuffer(const sp<SurfaceControl>& sc);
         std::shared_ptr<BufferData> getAndClearBuffer(const sp<SurfaceControl>& sc);
 
@@ -912,6 +962,10 @@ protected:
     std::multimap<int32_t, sp<JankDataListener>> mJankListeners GUARDED_BY(mMutex);
     std::unordered_map<ReleaseCallbackId, ReleaseBufferCallback, ReleaseBufferCallbackIdHash>
             mReleaseBufferCallbacks GUARDED_BY(mMutex);
+    // Buffers are batched by the identity of their callback
+    std::unordered_map<ReleaseCallbackId, std::shared_ptr<const ReleaseBuffersCallback>,
+                       ReleaseBufferCallbackIdHash>
+            mReleaseBuffersCallbacks GUARDED_BY(mMutex);
 
     // This is protected by mSurfaceStatsListenerMutex, but GUARDED_BY isn't supported for
     // std::recursive_mutex
@@ -965,11 +1019,14 @@ public:
     void removeSurfaceStatsListener(void* context, void* cookie);
 
     void setReleaseBufferCallback(const ReleaseCallbackId&, ReleaseBufferCallback);
+    void setReleaseBuffersCallback(const ReleaseCallbackId&,
+                                   std::shared_ptr<const ReleaseBuffersCallback>);
 
     // BnTransactionCompletedListener overrides
     void onTransactionCompleted(ListenerStats stats) override;
     void onReleaseBuffer(ReleaseCallbackId, sp<Fence> releaseFence,
                          uint32_t currentMaxAcquiredBufferCount) override;
+    void onReleaseBuffers(std::vector<ReleasedBufferStats> releasedBuffers) override;
 
     void removeReleaseBufferCallback(const ReleaseCallbackId& callbackId);
 
@@ -981,7 +1038,10 @@ public:
     void onTrustedPresentationChanged(int id, bool presentedWithinThresholds) override;
 
 private:
+    // Also forgets the buffer's ReleaseBuffersCallback, if any.
     ReleaseBufferCallback popReleaseBufferCallbackLocked(const ReleaseCallbackId&) REQUIRES(mMutex);
+    std::shared_ptr<const ReleaseBuffersCallback> popReleaseBuffersCallbackLocked(
+            const ReleaseCallbackId&) REQUIRES(mMutex);
     static sp<TransactionCompletedListener> sInstance;
 };
 
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+#include <android-base/unique_fd.h>
+#include <binder/Parcelable.h>
+#include <gui/DisplayEventReceiver.h>
+#include <utils/Errors.h>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace android {
+
+class Parcel;
+
+namespace gui {
+
+/*
+ * VsyncBroadcastChannel carries vsync events from SurfaceFlinger to any number of receivers
+ * without writing the event to each of them. The latest event lives in a shared memory page guarded
+ * by a sequence lock, and the publisher wakes up every receiver waiting on the page with a single
+ * futex wake of its sequence number.
+ *
+ * Receivers map the page read-only, and the page is sealed against new writable mappings. A
+ * receiver can issue futex wakes on the page, as any process that maps it can, but can't change
+ * the sequence number, so waiters treat such wakes as spurious and go back to sleep.
+ */
+class VsyncBroadcastChannel : public Parcelable {
+public:
+    // creates an uninitialized channel (to unparcel into)
+    VsyncBroadcastChannel() = default;
+
+    // creates the publishing end of a new channel
+    struct PublisherType {};
+    static constexpr PublisherType Publisher{};
+    explicit VsyncBroadcastChannel(PublisherType);
+
+    virtual ~VsyncBroadcastChannel();
+
+    // check state after construction
+    status_t initCheck() const;
+
+    // sets up outChannel as a new receiving end of this channel, to be parceled to a receiver. Must
+    // only be called on the publishing end.
+    status_t addReceiver(VsyncBroadcastChannel* outChannel) const;
+
+    // publishes an event and wakes up all the receivers waiting for one. Must only be called on the
+    // publishing end.
+    void publish(const DisplayEventReceiver::Event& event);
+
+    // returns the sequence number of the latest publish, including one that is in progress. The
+    // sequence number changes with every publish.
+    uint32_t getSequence() const;
+
+    // copies the latest event to outEvent if its sequence number differs from *inOutSequence, in
+    // which case *inOutSequence is updated. Returns whether an event was read.
+    bool read(uint32_t* inOutSequence, DisplayEventReceiver::Event* outEvent) const;
+
+    // blocks until an event is published after the given sequence number, or until woken up
+    // otherwise, e.g. by wakeWaiters(). Returns whether an event was published.
+    bool waitForPublish(uint32_t sequence) const;
+
+    // wakes up everyone blocked in waitForPublish(), e.g. to stop waiting. Those in other processes
+    // go back to waiting.
+    void wakeWaiters() const;
+
+    // implement the Parcelable protocol. Only parcels the file descriptor; the receiving end maps
+    // the page read-only.
+    status_t writeToParcel(Parcel* reply) const override;
+    status_t readFromParcel(const Parcel* parcel) override;
+
+private:
+    struct Page;
+
+    status_t map(int prot);
+    void unmap();
+
+    base::unique_fd mMemoryFd;
+    Page* mPage = nullptr;
+    bool mIsPublisher = false;
+};
+
+/*
+ * VsyncBroadcastReceiver keeps track of the vsync events a client asked for, so that it only takes
+ * events published on its VsyncBroadcastChannel while it is waiting for one. Vsync events that
+ * SurfaceFlinger posts through the BitTube instead, e.g. while another connection on the channel is
+ * throttled, answer the request just the same and must be reported with onVsyncPosted().
+ *
+ * While armed, a thread waits for publishes on the channel and turns them into wake ups of an
+ * eventfd private to the receiver, which the client can poll.
+ */
+class VsyncBroadcastReceiver {
+public:
+    explicit VsyncBroadcastReceiver(std::unique_ptr<VsyncBroadcastChannel> channel);
+    ~VsyncBroadcastReceiver();
+
+    // get the file descriptor that becomes readable when a vsync event is published for us
+    int getFd() const;
+
+    // must be called before the request is sent to SurfaceFlinger
+    void setVsyncRate(uint32_t count);
+    void requestNextVsync();
+
+    // must be called for every vsync event read from the BitTube
+    void onVsyncPosted(const DisplayEventReceiver::Event& event);
+
+    // reads the vsync event published for us since the last request, if any. Also consumes the
+    // wake up, so this must be called every time getFd() is readable.
+    bool getVsync(DisplayEventReceiver::Event* outEvent);
+
+private:
+    void arm() REQUIRES(mMutex);
+    void onVsyncDeliveredLocked(const DisplayEventReceiver::Event& event) REQUIRES(mMutex);
+    void threadMain();
+
+    const std::unique_ptr<VsyncBroadcastChannel> mChannel;
+    const base::unique_fd mEventFd;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    // Only events published after this sequence number can answer the request.
+    uint32_t mSequence GUARDED_BY(mMutex) = 0;
+    // Timestamp of the latest vsync event delivered either way. Older events are never delivered.
+    nsecs_t mLastVsyncTimestamp GUARDED_BY(mMutex) = 0;
+    uint32_t mVsyncRate GUARDED_BY(mMutex) = 0;
+    bool mArmed GUARDED_BY(mMutex) = false;
+    // Whether mEventFd was signaled and getVsync() hasn't consumed it yet
+    bool mWakePending GUARDED_BY(mMutex) = false;
+    bool mQuit GUARDED_BY(mMutex) = false;
+    bool mThreadExited GUARDED_BY(mMutex) = false;
+
+    std::thread mThread;
+};
+
+} // namespace gui
+} // namespace android
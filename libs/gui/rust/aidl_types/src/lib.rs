@@ -50,6 +50,7 @@ stub_unstructured_parcelable!(LayerDebugInfo);
 stub_unstructured_parcelable!(LayerMetadata);
 stub_unstructured_parcelable!(ParcelableVsyncEventData);
 stub_unstructured_parcelable!(ScreenCaptureResults);
+stub_unstructured_parcelable!(VsyncBroadcastChannel);
 stub_unstructured_parcelable!(VsyncEventData);
 stub_unstructured_parcelable!(WindowInfo);
 stub_unstructured_parcelable!(WindowInfosUpdate);
@@ -18,6 +18,7 @@
 
 #include <gui/BLASTBufferQueue.h>
 
+#include <android-base/scopeguard.h>
 #include <android-base/thread_annotations.h>
 #include <android/hardware/graphics/common/1.2/types.h>
 #include <gui/AidlStatusUtil.h>
@@ -77,6 +78,80 @@ private:
     int32_t mNumReleased GUARDED_BY(mMutex) = 0;
 };
 
+// Counts the buffers SurfaceFlinger releases to this process, and the calls that release them.
+// Buffers are released either by release callbacks, or along with the transaction callback of
+// the frame that replaced them.
+class CountReleasesListener : public TransactionCompletedListener {
+public:
+    void onTransactionCompleted(ListenerStats stats) override {
+        std::vector<ReleaseCallbackId> released;
+        for (const auto& transactionStats : stats.transactionStats) {
+            for (const auto& surfaceStats : transactionStats.surfaceStats) {
+                if (surfaceStats.previousReleaseCallbackId != ReleaseCallbackId::INVALID_ID) {
+                    released.push_back(surfaceStats.previousReleaseCallbackId);
+                }
+            }
+        }
+        TransactionCompletedListener::onTransactionCompleted(std::move(stats));
+        onReleased(released);
+    }
+
+    void onReleaseBuffer(ReleaseCallbackId callbackId, sp<Fence> releaseFence,
+                         uint32_t currentMaxAcquiredBufferCount) override {
+        TransactionCompletedListener::onReleaseBuffer(callbackId, releaseFence,
+                                                      currentMaxAcquiredBufferCount);
+        onReleased({callbackId});
+    }
+
+    void onReleaseBuffers(std::vector<ReleasedBufferStats> releasedBuffers) override {
+        std::vector<ReleaseCallbackId> released;
+        for (const auto& releasedBuffer : releasedBuffers) {
+            released.push_back(releasedBuffer.callbackId);
+        }
+        TransactionCompletedListener::onReleaseBuffers(std::move(releasedBuffers));
+        onReleased(released);
+    }
+
+    void waitOnNumberReleased(size_t expectedNumReleased) {
+        std::unique_lock lock{mCountMutex};
+        base::ScopedLockAssertion assumeLocked(mCountMutex);
+        while (mReleased.size() < expectedNumReleased) {
+            ASSERT_NE(mReleaseCallback.wait_for(lock, std::chrono::seconds(3)),
+                      std::cv_status::timeout)
+                    << "received " << mReleased.size() << " of " << expectedNumReleased
+                    << " releases";
+        }
+    }
+
+    size_t getNumReleased() {
+        std::scoped_lock<std::mutex> lock(mCountMutex);
+        return mReleased.size();
+    }
+
+    // The number of calls that released at least one buffer
+    size_t getNumReleasingCalls() {
+        std::scoped_lock<std::mutex> lock(mCountMutex);
+        return mNumReleasingCalls;
+    }
+
+private:
+    void onReleased(const std::vector<ReleaseCallbackId>& released) {
+        if (released.empty()) {
+            return;
+        }
+        std::scoped_lock<std::mutex> lock(mCountMutex);
+        mReleased.insert(released.begin(), released.end());
+        mNumReleasingCalls++;
+        mReleaseCallback.notify_one();
+    }
+
+    std::mutex mCountMutex;
+    std::condition_variable mReleaseCallback;
+    std::unordered_set<ReleaseCallbackId, ReleaseBufferCallbackIdHash> mReleased
+            GUARDED_BY(mCountMutex);
+    size_t mNumReleasingCalls GUARDED_BY(mCountMutex) = 0;
+};
+
 class TestBLASTBufferQueue : public BLASTBufferQueue {
 public:
     TestBLASTBufferQueue(const std::string& name, const sp<SurfaceControl>& surface, int width,
@@ -510,6 +585,69 @@ TEST_F(BLASTBufferQueueTest, TripleBuffering) {
     adapter.waitForCallbacks();
 }
 
+// Several surfaces of one process queue frames as fast as they can, so that SurfaceFlinger releases
+// buffers of all of them in the same commit and sends their releases back together.
+TEST_F(BLASTBufferQueueTest, TripleBufferingManySurfaces) {
+    constexpr int kSurfaceCount = 4;
+    constexpr int kFrameCount = 100;
+    constexpr uint32_t kBufferSize = 64;
+
+    // The surfaces' transactions, and so their releases, go through the process' listener
+    const sp<TransactionCompletedListener> previousListener =
+            TransactionCompletedListener::getInstance();
+    const sp<CountReleasesListener> listener = sp<CountReleasesListener>::make();
+    TransactionCompletedListener::setInstance(listener);
+    auto restoreListener = base::make_scope_guard(
+            [&] { TransactionCompletedListener::setInstance(previousListener); });
+
+    std::vector<std::unique_ptr<BLASTBufferQueueHelper>> adapters;
+    std::vector<sp<IGraphicBufferProducer>> producers(kSurfaceCount);
+    for (int i = 0; i < kSurfaceCount; i++) {
+        sp<SurfaceControl> surfaceControl =
+                mClient->createSurface(String8::format("TestSurface%d", i), kBufferSize,
+                                       kBufferSize, PIXEL_FORMAT_RGBA_8888,
+                                       ISurfaceComposerClient::eFXSurfaceBufferState,
+                                       /*parent*/ mRootSurfaceControl->getHandle());
+        adapters.push_back(
+                std::make_unique<BLASTBufferQueueHelper>(surfaceControl, kBufferSize, kBufferSize));
+        setUpProducer(*adapters.back(), producers[i], 3);
+    }
+
+    for (int frame = 0; frame < kFrameCount; frame++) {
+        for (const auto& producer : producers) {
+            int slot;
+            sp<Fence> fence;
+            sp<GraphicBuffer> buf;
+            auto ret = producer->dequeueBuffer(&slot, &fence, kBufferSize, kBufferSize,
+                                               PIXEL_FORMAT_RGBA_8888,
+                                               GRALLOC_USAGE_SW_WRITE_OFTEN, nullptr, nullptr);
+            ASSERT_TRUE(ret == IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION ||
+                        ret == NO_ERROR);
+            if (ret == IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION) {
+                ASSERT_EQ(OK, producer->requestBuffer(slot, &buf));
+            }
+            IGraphicBufferProducer::QueueBufferOutput qbOutput;
+            IGraphicBufferProducer::QueueBufferInput input(systemTime(), true /* autotimestamp */,
+                                                           HAL_DATASPACE_UNKNOWN,
+                                                           Rect(kBufferSize, kBufferSize),
+                                                           NATIVE_WINDOW_SCALING_MODE_FREEZE, 0,
+                                                           Fence::NO_FENCE);
+            ASSERT_EQ(NO_ERROR, producer->queueBuffer(slot, input, &qbOutput));
+        }
+    }
+    for (const auto& adapter : adapters) {
+        adapter->waitForCallbacks();
+    }
+
+    // Every buffer but the one each surface still shows is released...
+    const size_t expectedNumReleased = kSurfaceCount * (kFrameCount - 1);
+    ASSERT_NO_FATAL_FAILURE(listener->waitOnNumberReleased(expectedNumReleased));
+    EXPECT_EQ(expectedNumReleased, listener->getNumReleased());
+    // ...and the releases of surfaces that were latched or dropped together arrive in a single
+    // call, rather than in one call per buffer.
+    EXPECT_LT(listener->getNumReleasingCalls(), expectedNumReleased);
+}
+
 TEST_F(BLASTBufferQueueTest, SetCrop_Item) {
     uint8_t r = 255;
     uint8_t g = 0;
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <list>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <gui/BufferSlotSet.h>
+
+namespace android {
+
+namespace test {
+
+TEST(BufferSlotSetTest, iteratesInIncreasingOrder) {
+    BufferSlotSet slots;
+    slots.insert(63);
+    slots.insert(0);
+    slots.insert(17);
+    EXPECT_EQ((std::vector<int>{0, 17, 63}), std::vector<int>(slots.begin(), slots.end()));
+    EXPECT_EQ(3u, slots.size());
+
+    slots.erase(slots.begin());
+    EXPECT_EQ(17, *slots.begin());
+    EXPECT_EQ(0u, slots.count(0));
+    EXPECT_EQ(1u, slots.count(63));
+}
+
+TEST(BufferSlotListTest, keepsOrderOfBothEnds) {
+    BufferSlotList slots;
+    slots.push_back(5);
+    slots.push_front(40);
+    slots.push_back(2);
+    EXPECT_EQ((std::vector<int>{40, 5, 2}), std::vector<int>(slots.begin(), slots.end()));
+    EXPECT_EQ(40, slots.front());
+    EXPECT_EQ(2, slots.back());
+
+    slots.remove(5);
+    slots.pop_front();
+    EXPECT_EQ(1u, slots.size());
+    EXPECT_EQ(2, slots.front());
+}
+
+TEST(BufferSlotListTest, holdsEverySlot) {
+    BufferSlotList slots;
+    std::vector<int> expected;
+    for (int slot = 0; slot < BufferQueueDefs::NUM_BUFFER_SLOTS; slot++) {
+        slots.push_front(slot);
+        expected.insert(expected.begin(), slot);
+    }
+    EXPECT_EQ(expected, std::vector<int>(slots.begin(), slots.end()));
+    EXPECT_EQ(BufferQueueDefs::NUM_BUFFER_SLOTS - 1, slots.front());
+    EXPECT_EQ(0, slots.back());
+
+    slots.clear();
+    EXPECT_TRUE(slots.empty());
+    EXPECT_EQ(slots.end(), slots.begin());
+    slots.push_back(7);
+    EXPECT_EQ(7, slots.front());
+    EXPECT_EQ(7, slots.back());
+}
+
+// BufferQueueCore relies on the slot containers to pick slots like the std containers they
+// replaced, so compare them over random operations.
+TEST(BufferSlotListTest, matchesStdContainers) {
+    std::mt19937 generator(0);
+    std::uniform_int_distribution<int> slotDistribution(0, BufferQueueDefs::NUM_BUFFER_SLOTS - 1);
+    std::uniform_int_distribution<int> opDistribution(0, 6);
+
+    std::list<int> list;
+    BufferSlotList slotList;
+    std::set<int> set;
+    BufferSlotSet slotSet;
+    for (int i = 0; i < 10000; i++) {
+        const int slot = slotDistribution(generator);
+        const bool inList = std::find(list.begin(), list.end(), slot) != list.end();
+        switch (opDistribution(generator)) {
+            case 0:
+                if (!inList) {
+                    list.push_back(slot);
+                    slotList.push_back(slot);
+                }
+                break;
+            case 1:
+                if (!inList) {
+                    list.push_front(slot);
+                    slotList.push_front(slot);
+                }
+                break;
+            case 2:
+                if (!list.empty()) {
+                    ASSERT_EQ(list.front(), slotList.front());
+                    list.pop_front();
+                    slotList.pop_front();
+                }
+                break;
+            case 3:
+                if (!list.empty()) {
+                    ASSERT_EQ(list.back(), slotList.back());
+                    list.pop_back();
+                    slotList.pop_back();
+                }
+                break;
+            case 4:
+                list.remove(slot);
+                slotList.remove(slot);
+                break;
+            case 5:
+                set.insert(slot);
+                slotSet.insert(slot);
+                break;
+            case 6:
+                set.erase(slot);
+                slotSet.erase(slot);
+                break;
+        }
+        ASSERT_EQ(std::vector<int>(list.begin(), list.end()),
+                  std::vector<int>(slotList.begin(), slotList.end()));
+        ASSERT_EQ(std::vector<int>(set.begin(), set.end()),
+                  std::vector<int>(slotSet.begin(), slotSet.end()));
+    }
+}
+
+} // namespace test
+} // namespace android
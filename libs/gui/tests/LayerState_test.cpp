@@ -0,0 +1,210 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <fuzzer/FuzzedDataProvider.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <binder/Binder.h>
+#include <binder/Parcel.h>
+
+#include <gui/LayerState.h>
+
+namespace android {
+
+namespace test {
+
+namespace {
+
+// Changes whose fields diff() doesn't compare, i.e. that always count as different.
+constexpr uint64_t kAlwaysDifferentChanges = layer_state_t::eBlurRegionsChanged |
+        layer_state_t::eRelativeLayerChanged | layer_state_t::eBufferChanged |
+        layer_state_t::eSidebandStreamChanged | layer_state_t::eHasListenerCallbacksChanged |
+        layer_state_t::eInputInfoChanged | layer_state_t::eMetadataChanged |
+        layer_state_t::eProducerDisconnect | layer_state_t::eLayerChanged |
+        layer_state_t::eReparent;
+
+float consumeFloat(FuzzedDataProvider& fdp) {
+    return fdp.ConsumeFloatingPointInRange<float>(-1000.f, 1000.f);
+}
+
+Rect consumeRect(FuzzedDataProvider& fdp) {
+    return Rect(fdp.ConsumeIntegral<int16_t>(), fdp.ConsumeIntegral<int16_t>(),
+                fdp.ConsumeIntegral<int16_t>(), fdp.ConsumeIntegral<int16_t>());
+}
+
+// Fills every field, flagged in |what| or not, so that a field parceled for the wrong change
+// shows up as a mismatch.
+void fillLayerState(FuzzedDataProvider& fdp, layer_state_t& state) {
+    state.surface = sp<BBinder>::make();
+    state.layerId = fdp.ConsumeIntegral<int32_t>();
+    state.what = fdp.ConsumeIntegral<uint64_t>();
+    state.x = consumeFloat(fdp);
+    state.y = consumeFloat(fdp);
+    state.z = fdp.ConsumeIntegral<int32_t>();
+    state.layerStack.id = fdp.ConsumeIntegral<uint32_t>();
+    state.flags = fdp.ConsumeIntegral<uint32_t>();
+    state.mask = fdp.ConsumeIntegral<uint32_t>();
+    state.matrix = {consumeFloat(fdp), consumeFloat(fdp), consumeFloat(fdp), consumeFloat(fdp)};
+    state.crop = consumeRect(fdp);
+    state.color = half4(consumeFloat(fdp), consumeFloat(fdp), consumeFloat(fdp),
+                        consumeFloat(fdp));
+    state.windowInfoHandle->editInfo()->name = fdp.ConsumeRandomLengthString(32);
+    state.transparentRegion = Region(consumeRect(fdp));
+    state.bufferTransform = fdp.ConsumeIntegral<uint32_t>();
+    state.transformToDisplayInverse = fdp.ConsumeBool();
+    state.dataspace = static_cast<ui::Dataspace>(fdp.ConsumeIntegral<int32_t>());
+    state.surfaceDamageRegion = Region(consumeRect(fdp));
+    state.api = fdp.ConsumeIntegral<int32_t>();
+    state.colorTransform = mat4(consumeFloat(fdp));
+    state.cornerRadius = consumeFloat(fdp);
+    state.backgroundBlurRadius = fdp.ConsumeIntegral<uint32_t>();
+    state.metadata.setInt32(fdp.ConsumeIntegral<uint32_t>(), fdp.ConsumeIntegral<int32_t>());
+    state.bgColor = half4(consumeFloat(fdp), consumeFloat(fdp), consumeFloat(fdp),
+                          consumeFloat(fdp));
+    state.bgColorDataspace = static_cast<ui::Dataspace>(fdp.ConsumeIntegral<int32_t>());
+    state.colorSpaceAgnostic = fdp.ConsumeBool();
+    state.shadowRadius = consumeFloat(fdp);
+    state.frameRateSelectionPriority = fdp.ConsumeIntegral<int32_t>();
+    state.frameRate = consumeFloat(fdp);
+    state.frameRateCompatibility = fdp.ConsumeIntegral<int8_t>();
+    state.changeFrameRateStrategy = fdp.ConsumeIntegral<int8_t>();
+    state.defaultFrameRateCompatibility = fdp.ConsumeIntegral<int8_t>();
+    state.frameRateCategory = fdp.ConsumeIntegral<int8_t>();
+    state.frameRateCategorySmoothSwitchOnly = fdp.ConsumeBool();
+    state.frameRateSelectionStrategy = fdp.ConsumeIntegral<int8_t>();
+    state.fixedTransformHint = fdp.ConsumeIntegral<uint32_t>();
+    state.autoRefresh = fdp.ConsumeBool();
+    state.dimmingEnabled = fdp.ConsumeBool();
+    BlurRegion blurRegion{};
+    blurRegion.blurRadius = fdp.ConsumeIntegral<uint32_t>();
+    blurRegion.alpha = consumeFloat(fdp);
+    blurRegion.left = fdp.ConsumeIntegral<int16_t>();
+    blurRegion.top = fdp.ConsumeIntegral<int16_t>();
+    state.blurRegions.push_back(blurRegion);
+    state.bufferCrop = consumeRect(fdp);
+    state.destinationFrame = consumeRect(fdp);
+    state.trustedOverlay = fdp.ConsumeBool() ? gui::TrustedOverlay::ENABLED
+                                             : gui::TrustedOverlay::DISABLED;
+    state.dropInputMode = fdp.ConsumeBool() ? gui::DropInputMode::ALL : gui::DropInputMode::NONE;
+    if (fdp.ConsumeBool()) {
+        state.bufferData = std::make_shared<BufferData>();
+        state.bufferData->frameNumber = fdp.ConsumeIntegral<uint64_t>();
+        state.bufferData->producerId = fdp.ConsumeIntegral<uint32_t>();
+    }
+    state.currentHdrSdrRatio = consumeFloat(fdp);
+    state.desiredHdrSdrRatio = consumeFloat(fdp);
+    state.cachingHint = fdp.ConsumeBool() ? gui::CachingHint::Enabled : gui::CachingHint::Disabled;
+}
+
+std::vector<uint8_t> parcelBytes(const Parcel& parcel) {
+    return std::vector<uint8_t>(parcel.data(), parcel.data() + parcel.dataSize());
+}
+
+} // namespace
+
+TEST(LayerStateTest, parcelRoundTripOfRandomStates) {
+    std::mt19937 generator(0);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    for (int i = 0; i < 500; i++) {
+        SCOPED_TRACE(i);
+        std::vector<uint8_t> data(1024);
+        std::generate(data.begin(), data.end(),
+                      [&] { return static_cast<uint8_t>(byte(generator)); });
+        FuzzedDataProvider fdp(data.data(), data.size());
+
+        layer_state_t state;
+        fillLayerState(fdp, state);
+
+        Parcel parcel;
+        ASSERT_EQ(NO_ERROR, state.write(parcel));
+        parcel.setDataPosition(0);
+        layer_state_t decoded;
+        ASSERT_EQ(NO_ERROR, decoded.read(parcel));
+        EXPECT_EQ(parcel.dataSize(), parcel.dataPosition());
+
+        EXPECT_EQ(state.surface, decoded.surface);
+        EXPECT_EQ(state.layerId, decoded.layerId);
+        EXPECT_EQ(state.what, decoded.what);
+        EXPECT_EQ(0u, decoded.diff(state) & ~kAlwaysDifferentChanges);
+
+        Parcel reparceled;
+        ASSERT_EQ(NO_ERROR, decoded.write(reparceled));
+        EXPECT_EQ(parcelBytes(parcel), parcelBytes(reparceled));
+    }
+}
+
+TEST(LayerStateTest, readLeavesUnflaggedFieldsUntouched) {
+    layer_state_t state;
+    state.what = layer_state_t::ePositionChanged;
+    state.x = 10.f;
+    state.y = 20.f;
+    state.cornerRadius = 5.f;
+
+    Parcel parcel;
+    ASSERT_EQ(NO_ERROR, state.write(parcel));
+    parcel.setDataPosition(0);
+
+    layer_state_t decoded;
+    decoded.cornerRadius = 7.f;
+    ASSERT_EQ(NO_ERROR, decoded.read(parcel));
+    EXPECT_EQ(10.f, decoded.x);
+    EXPECT_EQ(20.f, decoded.y);
+    EXPECT_EQ(7.f, decoded.cornerRadius);
+}
+
+TEST(LayerStateTest, parcelSizeFollowsChanges) {
+    layer_state_t position;
+    position.what = layer_state_t::ePositionChanged;
+    Parcel positionParcel;
+    ASSERT_EQ(NO_ERROR, position.write(positionParcel));
+
+    layer_state_t geometry;
+    geometry.what = layer_state_t::ePositionChanged | layer_state_t::eMatrixChanged |
+            layer_state_t::eCropChanged | layer_state_t::eAlphaChanged |
+            layer_state_t::eCornerRadiusChanged;
+    Parcel geometryParcel;
+    ASSERT_EQ(NO_ERROR, geometry.write(geometryParcel));
+
+    layer_state_t empty;
+    Parcel emptyParcel;
+    ASSERT_EQ(NO_ERROR, empty.write(emptyParcel));
+
+    EXPECT_LT(emptyParcel.dataSize(), positionParcel.dataSize());
+    EXPECT_LT(positionParcel.dataSize(), geometryParcel.dataSize());
+    EXPECT_LT(positionParcel.dataSize(), 64u);
+}
+
+TEST(LayerStateTest, readRejectsOtherVersions) {
+    layer_state_t state;
+    state.what = layer_state_t::ePositionChanged;
+    Parcel parcel;
+    ASSERT_EQ(NO_ERROR, state.write(parcel));
+
+    parcel.setDataPosition(0);
+    parcel.writeUint32(layer_state_t::PARCEL_VERSION + 1);
+    parcel.setDataPosition(0);
+    layer_state_t decoded;
+    EXPECT_EQ(BAD_VALUE, decoded.read(parcel));
+}
+
+} // namespace test
+} // namespace android
@@ -2183,6 +2183,94 @@ TEST_F(SurfaceTest, BatchOperations) {
     ASSERT_EQ(NO_ERROR, surface->disconnect(NATIVE_WINDOW_API_CPU));
 }
 
+TEST_F(SurfaceTest, BatchOperationsThroughPerform) {
+    const int BUFFER_COUNT = 16;
+    const int BATCH_SIZE = 8;
+    sp<IGraphicBufferProducer> producer;
+    sp<IGraphicBufferConsumer> consumer;
+    BufferQueue::createBufferQueue(&producer, &consumer);
+
+    sp<CpuConsumer> cpuConsumer = new CpuConsumer(consumer, BATCH_SIZE);
+    sp<Surface> surface = new Surface(producer);
+    sp<ANativeWindow> window(surface);
+    sp<StubProducerListener> listener = new StubProducerListener();
+
+    ASSERT_EQ(OK, surface->connect(NATIVE_WINDOW_API_CPU, /*listener*/listener,
+            /*reportBufferRemoval*/false));
+
+    ASSERT_EQ(NO_ERROR, native_window_set_buffer_count(window.get(), BUFFER_COUNT));
+
+    std::vector<ANativeWindowBuffer*> buffers(BATCH_SIZE);
+    std::vector<int> fences(BATCH_SIZE);
+
+    ASSERT_EQ(NO_ERROR,
+              native_window_dequeue_buffers(window.get(), BATCH_SIZE, buffers.data(),
+                                            fences.data()));
+    ASSERT_EQ(NO_ERROR,
+              native_window_cancel_buffers(window.get(), BATCH_SIZE, buffers.data(),
+                                           fences.data()));
+
+    ASSERT_EQ(NO_ERROR,
+              native_window_dequeue_buffers(window.get(), BATCH_SIZE, buffers.data(),
+                                            fences.data()));
+    std::vector<int64_t> timestamps(BATCH_SIZE);
+    for (size_t i = 0; i < BATCH_SIZE; i++) {
+        timestamps[i] = 1000 + static_cast<int64_t>(i);
+    }
+    ASSERT_EQ(NO_ERROR,
+              native_window_queue_buffers(window.get(), BATCH_SIZE, buffers.data(),
+                                          fences.data(), timestamps.data()));
+
+    // The buffers reach the consumer in order, with their own timestamps.
+    for (size_t i = 0; i < BATCH_SIZE; i++) {
+        CpuConsumer::LockedBuffer locked;
+        ASSERT_EQ(NO_ERROR, cpuConsumer->lockNextBuffer(&locked));
+        EXPECT_EQ(timestamps[i], locked.timestamp);
+        ASSERT_EQ(NO_ERROR, cpuConsumer->unlockBuffer(locked));
+    }
+
+    ASSERT_EQ(NO_ERROR, surface->disconnect(NATIVE_WINDOW_API_CPU));
+}
+
+TEST_F(SurfaceTest, BatchQueueReportsPerBufferFailure) {
+    const int BUFFER_COUNT = 16;
+    const int BATCH_SIZE = 2;
+    sp<IGraphicBufferProducer> producer;
+    sp<IGraphicBufferConsumer> consumer;
+    BufferQueue::createBufferQueue(&producer, &consumer);
+
+    sp<CpuConsumer> cpuConsumer = new CpuConsumer(consumer, BATCH_SIZE);
+    sp<Surface> surface = new Surface(producer);
+    sp<ANativeWindow> window(surface);
+    sp<StubProducerListener> listener = new StubProducerListener();
+
+    ASSERT_EQ(OK, surface->connect(NATIVE_WINDOW_API_CPU, /*listener*/listener,
+            /*reportBufferRemoval*/false));
+
+    ASSERT_EQ(NO_ERROR, native_window_set_buffer_count(window.get(), BUFFER_COUNT));
+
+    std::vector<ANativeWindowBuffer*> buffers(BATCH_SIZE);
+    std::vector<int> fences(BATCH_SIZE);
+    ASSERT_EQ(NO_ERROR,
+              native_window_dequeue_buffers(window.get(), BATCH_SIZE, buffers.data(),
+                                            fences.data()));
+
+    // Queuing the first buffer a second time fails, but only for that buffer.
+    buffers.push_back(buffers[0]);
+    fences.push_back(-1);
+    EXPECT_EQ(BAD_VALUE,
+              native_window_queue_buffers(window.get(), buffers.size(), buffers.data(),
+                                          fences.data(), nullptr));
+
+    for (size_t i = 0; i < BATCH_SIZE; i++) {
+        CpuConsumer::LockedBuffer locked;
+        ASSERT_EQ(NO_ERROR, cpuConsumer->lockNextBuffer(&locked));
+        ASSERT_EQ(NO_ERROR, cpuConsumer->unlockBuffer(locked));
+    }
+
+    ASSERT_EQ(NO_ERROR, surface->disconnect(NATIVE_WINDOW_API_CPU));
+}
+
 TEST_F(SurfaceTest, BatchIllegalOperations) {
     const int BUFFER_COUNT = 16;
     const int BATCH_SIZE = 8;
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <binder/Binder.h>
+#include <binder/Parcel.h>
+
+#include <gui/SurfaceComposerClient.h>
+#include <gui/SurfaceControl.h>
+
+namespace android {
+
+namespace test {
+
+using Transaction = SurfaceComposerClient::Transaction;
+
+class TransactionHelper : public Transaction {
+public:
+    std::vector<std::pair<sp<IBinder>, ComposerState>> getComposerStates() {
+        const auto states = composerStates();
+        return {states.begin(), states.end()};
+    }
+};
+
+class TransactionTest : public ::testing::Test {
+protected:
+    sp<SurfaceControl> makeSurfaceControl() {
+        const int32_t layerId = mNextLayerId++;
+        return sp<SurfaceControl>::make(nullptr, sp<BBinder>::make(), layerId,
+                                        "layer" + std::to_string(layerId));
+    }
+
+private:
+    int32_t mNextLayerId = 1;
+};
+
+TEST_F(TransactionTest, mergeKeepsOneStatePerLayer) {
+    const auto sc1 = makeSurfaceControl();
+    const auto sc2 = makeSurfaceControl();
+
+    TransactionHelper t;
+    t.setPosition(sc1, 1.f, 2.f);
+    Transaction other;
+    other.setAlpha(sc1, 0.5f);
+    other.setPosition(sc2, 3.f, 4.f);
+    t.merge(std::move(other));
+
+    const auto states = t.getComposerStates();
+    ASSERT_EQ(2u, states.size());
+    EXPECT_EQ(sc1->getLayerStateHandle(), states[0].first);
+    EXPECT_EQ(layer_state_t::ePositionChanged | layer_state_t::eAlphaChanged,
+              states[0].second.state.what);
+    EXPECT_EQ(1.f, states[0].second.state.x);
+    EXPECT_EQ(0.5f, states[0].second.state.color.a);
+    EXPECT_EQ(sc2->getLayerStateHandle(), states[1].first);
+    EXPECT_EQ(sc2->getLayerId(), states[1].second.state.layerId);
+    EXPECT_EQ(3.f, states[1].second.state.x);
+}
+
+TEST_F(TransactionTest, clearResetsReusedStates) {
+    const auto sc1 = makeSurfaceControl();
+    const auto sc2 = makeSurfaceControl();
+
+    TransactionHelper t;
+    t.setPosition(sc1, 1.f, 2.f);
+    t.setFlags(sc1, layer_state_t::eLayerHidden, layer_state_t::eLayerHidden);
+    t.clear();
+    EXPECT_TRUE(t.getComposerStates().empty());
+
+    t.setFlags(sc2, 0, layer_state_t::eLayerOpaque);
+    const auto states = t.getComposerStates();
+    ASSERT_EQ(1u, states.size());
+    const layer_state_t& state = states[0].second.state;
+    EXPECT_EQ(sc2->getLayerStateHandle(), state.surface);
+    EXPECT_EQ(layer_state_t::eFlagsChanged, state.what);
+    EXPECT_EQ(0u, state.flags);
+    EXPECT_EQ(static_cast<uint32_t>(layer_state_t::eLayerOpaque), state.mask);
+    EXPECT_EQ(0.f, state.x);
+}
+
+TEST_F(TransactionTest, obtainReusesReleasedTransactions) {
+    const auto sc = makeSurfaceControl();
+
+    auto t = Transaction::obtain();
+    t->setPosition(sc, 1.f, 2.f);
+    const Transaction* pooled = t.get();
+    const uint64_t id = t->getId();
+    t.reset();
+
+    t = Transaction::obtain();
+    EXPECT_EQ(pooled, t.get());
+    EXPECT_NE(id, t->getId());
+
+    // The reused transaction parcels like a new one.
+    Parcel parcel;
+    ASSERT_EQ(NO_ERROR, t->writeToParcel(&parcel));
+    Parcel emptyParcel;
+    ASSERT_EQ(NO_ERROR, Transaction().writeToParcel(&emptyParcel));
+    EXPECT_EQ(emptyParcel.dataSize(), parcel.dataSize());
+}
+
+} // namespace test
+} // namespace android
@@ -0,0 +1,239 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <poll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <future>
+#include <thread>
+
+#include <binder/Parcel.h>
+
+#include <private/gui/VsyncBroadcastChannel.h>
+
+namespace android {
+
+using gui::VsyncBroadcastChannel;
+using gui::VsyncBroadcastReceiver;
+
+namespace test {
+
+namespace {
+
+DisplayEventReceiver::Event makeVsync(nsecs_t timestamp, uint32_t count) {
+    DisplayEventReceiver::Event event{};
+    event.header.type = DisplayEventReceiver::DISPLAY_EVENT_VSYNC;
+    event.header.timestamp = timestamp;
+    event.vsync.count = count;
+    event.vsync.vsyncData.frameInterval = 16'666'667;
+    event.vsync.vsyncData.frameTimelinesLength = 1;
+    event.vsync.vsyncData.frameTimelines[0] = {.vsyncId = count,
+                                               .deadlineTimestamp = timestamp + 10,
+                                               .expectedPresentationTime = timestamp + 20};
+    return event;
+}
+
+void receive(const VsyncBroadcastChannel& publisher, VsyncBroadcastChannel* outReceiver) {
+    VsyncBroadcastChannel parcelable;
+    ASSERT_EQ(NO_ERROR, publisher.addReceiver(&parcelable));
+
+    Parcel parcel;
+    ASSERT_EQ(NO_ERROR, parcelable.writeToParcel(&parcel));
+    parcel.setDataPosition(0);
+    ASSERT_EQ(NO_ERROR, outReceiver->readFromParcel(&parcel));
+    ASSERT_EQ(NO_ERROR, outReceiver->initCheck());
+}
+
+// Receivers are woken up asynchronously, so give them some time.
+bool isReadable(int fd, int timeoutMs = 100) {
+    pollfd pfd{.fd = fd, .events = POLLIN};
+    return poll(&pfd, 1, timeoutMs) == 1;
+}
+
+} // namespace
+
+TEST(VsyncBroadcastChannelTest, ReceiverReadsLatestEvent) {
+    VsyncBroadcastChannel publisher(VsyncBroadcastChannel::Publisher);
+    ASSERT_EQ(NO_ERROR, publisher.initCheck());
+    VsyncBroadcastChannel receiver;
+    ASSERT_NO_FATAL_FAILURE(receive(publisher, &receiver));
+
+    uint32_t sequence = receiver.getSequence();
+    DisplayEventReceiver::Event event;
+    EXPECT_FALSE(receiver.read(&sequence, &event));
+
+    publisher.publish(makeVsync(100, 1));
+    publisher.publish(makeVsync(200, 2));
+    ASSERT_TRUE(receiver.read(&sequence, &event));
+    EXPECT_EQ(publisher.getSequence(), sequence);
+    EXPECT_EQ(DisplayEventReceiver::DISPLAY_EVENT_VSYNC, event.header.type);
+    EXPECT_EQ(200, event.header.timestamp);
+    EXPECT_EQ(2u, event.vsync.count);
+    EXPECT_EQ(2, event.vsync.vsyncData.preferredVsyncId());
+    EXPECT_EQ(220, event.vsync.vsyncData.preferredExpectedPresentationTime());
+
+    // The same event is not read twice.
+    EXPECT_FALSE(receiver.read(&sequence, &event));
+}
+
+TEST(VsyncBroadcastChannelTest, PublishWakesUpAllWaiters) {
+    VsyncBroadcastChannel publisher(VsyncBroadcastChannel::Publisher);
+    ASSERT_EQ(NO_ERROR, publisher.initCheck());
+
+    constexpr size_t kReceiverCount = 3;
+    VsyncBroadcastChannel receivers[kReceiverCount];
+    std::future<bool> published[kReceiverCount];
+    for (size_t i = 0; i < kReceiverCount; i++) {
+        ASSERT_NO_FATAL_FAILURE(receive(publisher, &receivers[i]));
+        published[i] = std::async(std::launch::async,
+                                  [&receiver = receivers[i], sequence = receivers[i].getSequence()] {
+                                      return receiver.waitForPublish(sequence);
+                                  });
+    }
+
+    publisher.publish(makeVsync(100, 1));
+    for (size_t i = 0; i < kReceiverCount; i++) {
+        EXPECT_TRUE(published[i].get()) << "receiver " << i;
+    }
+
+    // A publish that already happened does not block.
+    VsyncBroadcastChannel receiver;
+    ASSERT_NO_FATAL_FAILURE(receive(publisher, &receiver));
+    const uint32_t sequence = receiver.getSequence();
+    publisher.publish(makeVsync(200, 2));
+    EXPECT_TRUE(receiver.waitForPublish(sequence));
+}
+
+TEST(VsyncBroadcastChannelTest, WakeWaitersIsNotAPublish) {
+    VsyncBroadcastChannel publisher(VsyncBroadcastChannel::Publisher);
+    ASSERT_EQ(NO_ERROR, publisher.initCheck());
+    VsyncBroadcastChannel receiver;
+    ASSERT_NO_FATAL_FAILURE(receive(publisher, &receiver));
+
+    std::atomic<bool> done = false;
+    auto published = std::async(std::launch::async, [&] {
+        const bool result = receiver.waitForPublish(receiver.getSequence());
+        done = true;
+        return result;
+    });
+    // The waiter may not be waiting yet.
+    while (!done) {
+        receiver.wakeWaiters();
+        std::this_thread::yield();
+    }
+    EXPECT_FALSE(published.get());
+}
+
+TEST(VsyncBroadcastChannelTest, ReceiverCannotMapPageWritable) {
+    VsyncBroadcastChannel publisher(VsyncBroadcastChannel::Publisher);
+    ASSERT_EQ(NO_ERROR, publisher.initCheck());
+    VsyncBroadcastChannel parcelable;
+    ASSERT_EQ(NO_ERROR, publisher.addReceiver(&parcelable));
+
+    Parcel parcel;
+    ASSERT_EQ(NO_ERROR, parcelable.writeToParcel(&parcel));
+    parcel.setDataPosition(0);
+    const int memoryFd = parcel.readFileDescriptor();
+    ASSERT_GE(memoryFd, 0);
+
+    void* address = mmap(nullptr, getpagesize(), PROT_READ | PROT_WRITE, MAP_SHARED, memoryFd, 0);
+    EXPECT_EQ(MAP_FAILED, address);
+    if (address != MAP_FAILED) {
+        munmap(address, getpagesize());
+    }
+}
+
+TEST(VsyncBroadcastReceiverTest, OnlyWokenUpByPublishWhileArmed) {
+    VsyncBroadcastChannel publisher(VsyncBroadcastChannel::Publisher);
+    ASSERT_EQ(NO_ERROR, publisher.initCheck());
+    auto channel = std::make_unique<VsyncBroadcastChannel>();
+    ASSERT_NO_FATAL_FAILURE(receive(publisher, channel.get()));
+    const VsyncBroadcastChannel& receiverChannel = *channel;
+    VsyncBroadcastReceiver receiver(std::move(channel));
+
+    publisher.publish(makeVsync(100, 1));
+    EXPECT_FALSE(isReadable(receiver.getFd()));
+
+    // Other receivers can wake up the waiters, but that is not a publish.
+    receiver.requestNextVsync();
+    receiverChannel.wakeWaiters();
+    EXPECT_FALSE(isReadable(receiver.getFd()));
+
+    publisher.publish(makeVsync(200, 2));
+    ASSERT_TRUE(isReadable(receiver.getFd()));
+    DisplayEventReceiver::Event event;
+    ASSERT_TRUE(receiver.getVsync(&event));
+    EXPECT_EQ(200, event.header.timestamp);
+    EXPECT_FALSE(isReadable(receiver.getFd(), 0));
+}
+
+TEST(VsyncBroadcastReceiverTest, PostedVsyncAnswersTheRequest) {
+    VsyncBroadcastChannel publisher(VsyncBroadcastChannel::Publisher);
+    ASSERT_EQ(NO_ERROR, publisher.initCheck());
+    auto channel = std::make_unique<VsyncBroadcastChannel>();
+    ASSERT_NO_FATAL_FAILURE(receive(publisher, channel.get()));
+    VsyncBroadcastReceiver receiver(std::move(channel));
+
+    // The first vsync is posted through the BitTube, which answers the request.
+    receiver.requestNextVsync();
+    receiver.onVsyncPosted(makeVsync(100, 1));
+
+    // A vsync published for someone else does not wake the receiver up.
+    DisplayEventReceiver::Event event;
+    publisher.publish(makeVsync(200, 2));
+    EXPECT_FALSE(isReadable(receiver.getFd()));
+    EXPECT_FALSE(receiver.getVsync(&event));
+
+    // The next request is answered by the next publish, once.
+    receiver.requestNextVsync();
+    publisher.publish(makeVsync(300, 3));
+    ASSERT_TRUE(isReadable(receiver.getFd()));
+    ASSERT_TRUE(receiver.getVsync(&event));
+    EXPECT_EQ(300, event.header.timestamp);
+    publisher.publish(makeVsync(400, 4));
+    EXPECT_FALSE(isReadable(receiver.getFd()));
+    EXPECT_FALSE(receiver.getVsync(&event));
+}
+
+TEST(VsyncBroadcastReceiverTest, PublishedVsyncOlderThanPostedOneIsDropped) {
+    VsyncBroadcastChannel publisher(VsyncBroadcastChannel::Publisher);
+    ASSERT_EQ(NO_ERROR, publisher.initCheck());
+    auto channel = std::make_unique<VsyncBroadcastChannel>();
+    ASSERT_NO_FATAL_FAILURE(receive(publisher, channel.get()));
+    VsyncBroadcastReceiver receiver(std::move(channel));
+    receiver.setVsyncRate(1);
+
+    // A published vsync is pending when a later one is posted.
+    publisher.publish(makeVsync(100, 1));
+    ASSERT_TRUE(isReadable(receiver.getFd()));
+    receiver.onVsyncPosted(makeVsync(200, 2));
+
+    DisplayEventReceiver::Event event;
+    EXPECT_FALSE(receiver.getVsync(&event));
+
+    // Still armed, since the rate is not zero.
+    publisher.publish(makeVsync(300, 3));
+    ASSERT_TRUE(isReadable(receiver.getFd()));
+    ASSERT_TRUE(receiver.getVsync(&event));
+    EXPECT_EQ(300, event.header.timestamp);
+}
+
+} // namespace test
+} // namespace android
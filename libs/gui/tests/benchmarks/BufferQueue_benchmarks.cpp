@@ -0,0 +1,166 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gui/BufferItem.h>
+#include <gui/BufferQueue.h>
+#include <gui/IConsumerListener.h>
+#include <gui/IProducerListener.h>
+#include <system/window.h>
+#include <ui/GraphicBuffer.h>
+#include <utils/Timers.h>
+
+namespace android {
+
+namespace {
+
+constexpr std::chrono::nanoseconds FRAME_PERIOD_240HZ(1'000'000'000 / 240);
+
+struct StubConsumerListener : public BnConsumerListener {
+    void onFrameAvailable(const BufferItem&) override {}
+    void onBuffersReleased() override {}
+    void onSidebandStreamChanged() override {}
+};
+
+// Arguments: buffer count. Every iteration dequeues, queues, acquires and releases that many
+// buffers, which are only allocated in the first iteration.
+void benchmarkBufferCycle(benchmark::State& state) {
+    const auto bufferCount = static_cast<int>(state.range(0));
+
+    sp<IGraphicBufferProducer> producer;
+    sp<IGraphicBufferConsumer> consumer;
+    BufferQueue::createBufferQueue(&producer, &consumer);
+    consumer->consumerConnect(sp<StubConsumerListener>::make(), false);
+    consumer->setMaxAcquiredBufferCount(bufferCount);
+    IGraphicBufferProducer::QueueBufferOutput output;
+    producer->connect(sp<StubProducerListener>::make(), NATIVE_WINDOW_API_CPU, false, &output);
+    producer->setMaxDequeuedBufferCount(bufferCount);
+
+    const IGraphicBufferProducer::QueueBufferInput input(0, false, HAL_DATASPACE_UNKNOWN,
+                                                         Rect(0, 0, 1, 1),
+                                                         NATIVE_WINDOW_SCALING_MODE_FREEZE, 0,
+                                                         Fence::NO_FENCE);
+    std::vector<int> slots(static_cast<size_t>(bufferCount));
+    for (auto _ : state) {
+        for (int& slot : slots) {
+            sp<Fence> fence;
+            const status_t result =
+                    producer->dequeueBuffer(&slot, &fence, 1, 1, 0, GRALLOC_USAGE_SW_READ_OFTEN,
+                                            nullptr, nullptr);
+            if (result & IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION) {
+                sp<GraphicBuffer> buffer;
+                producer->requestBuffer(slot, &buffer);
+            }
+        }
+        for (const int slot : slots) {
+            producer->queueBuffer(slot, input, &output);
+        }
+        for (size_t i = 0; i < slots.size(); i++) {
+            BufferItem item;
+            consumer->acquireBuffer(&item, 0);
+            consumer->releaseBuffer(item.mSlot, item.mFrameNumber, EGL_NO_DISPLAY,
+                                    EGL_NO_SYNC_KHR, Fence::NO_FENCE);
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * bufferCount);
+
+    producer->disconnect(NATIVE_WINDOW_API_CPU);
+    consumer->consumerDisconnect();
+}
+
+// Arguments: dequeued buffer count. A producer thread dequeues and queues a buffer every frame at
+// 240Hz, while a consumer thread keeps trying to acquire with an expected present time, so that
+// the two contend on the BufferQueue. Only the producer's dequeueBuffer and queueBuffer are timed.
+void benchmarkProducerUnderContention(benchmark::State& state) {
+    const auto dequeuedBufferCount = static_cast<int>(state.range(0));
+
+    sp<IGraphicBufferProducer> producer;
+    sp<IGraphicBufferConsumer> consumer;
+    BufferQueue::createBufferQueue(&producer, &consumer);
+    consumer->consumerConnect(sp<StubConsumerListener>::make(), false);
+    IGraphicBufferProducer::QueueBufferOutput output;
+    producer->connect(sp<StubProducerListener>::make(), NATIVE_WINDOW_API_CPU, false, &output);
+    producer->setMaxDequeuedBufferCount(dequeuedBufferCount);
+
+    std::atomic<bool> done = false;
+    std::atomic<int64_t> acquiredCount = 0;
+    std::thread consumerThread([&] {
+        while (!done.load(std::memory_order_relaxed)) {
+            BufferItem item;
+            if (consumer->acquireBuffer(&item, systemTime()) != NO_ERROR) {
+                std::this_thread::yield();
+                continue;
+            }
+            consumer->releaseBuffer(item.mSlot, item.mFrameNumber, EGL_NO_DISPLAY,
+                                    EGL_NO_SYNC_KHR, Fence::NO_FENCE);
+            acquiredCount++;
+        }
+    });
+
+    const IGraphicBufferProducer::QueueBufferInput input(0, false, HAL_DATASPACE_UNKNOWN,
+                                                         Rect(0, 0, 1, 1),
+                                                         NATIVE_WINDOW_SCALING_MODE_FREEZE, 0,
+                                                         Fence::NO_FENCE);
+    std::chrono::nanoseconds worstFrameTime(0);
+    auto frameStart = std::chrono::steady_clock::now();
+    for (auto _ : state) {
+        frameStart += FRAME_PERIOD_240HZ;
+        std::this_thread::sleep_until(frameStart);
+
+        const auto start = std::chrono::steady_clock::now();
+        int slot;
+        sp<Fence> fence;
+        const status_t result =
+                producer->dequeueBuffer(&slot, &fence, 1, 1, 0, GRALLOC_USAGE_SW_READ_OFTEN,
+                                        nullptr, nullptr);
+        if (result & IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION) {
+            sp<GraphicBuffer> buffer;
+            producer->requestBuffer(slot, &buffer);
+        }
+        producer->queueBuffer(slot, input, &output);
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+
+        state.SetIterationTime(std::chrono::duration<double>(elapsed).count());
+        worstFrameTime = std::max(worstFrameTime, elapsed);
+    }
+
+    done = true;
+    consumerThread.join();
+    state.counters["worst_us"] =
+            std::chrono::duration<double, std::micro>(worstFrameTime).count();
+    state.counters["acquired"] = static_cast<double>(acquiredCount.load());
+
+    producer->disconnect(NATIVE_WINDOW_API_CPU);
+    consumer->consumerDisconnect();
+}
+
+} // namespace
+
+BENCHMARK(benchmarkBufferCycle)->ArgNames({"buffers"})->Arg(1)->Arg(3);
+BENCHMARK(benchmarkProducerUnderContention)
+        ->ArgNames({"dequeued"})
+        ->Arg(1)
+        ->Arg(2)
+        ->UseManualTime();
+
+} // namespace android
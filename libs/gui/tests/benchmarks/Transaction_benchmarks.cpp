@@ -0,0 +1,159 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <binder/Binder.h>
+#include <binder/Parcel.h>
+#include <gui/SurfaceComposerClient.h>
+#include <gui/SurfaceControl.h>
+
+namespace android {
+
+namespace {
+
+using Transaction = SurfaceComposerClient::Transaction;
+
+enum class Changes { Typical, WorstCase };
+
+std::vector<sp<SurfaceControl>> makeSurfaceControls(int count) {
+    std::vector<sp<SurfaceControl>> surfaceControls;
+    for (int i = 0; i < count; i++) {
+        surfaceControls.push_back(sp<SurfaceControl>::make(nullptr, sp<BBinder>::make(), i,
+                                                           "layer" + std::to_string(i)));
+    }
+    return surfaceControls;
+}
+
+// A typical transaction moves and fades layers, as in an animation. The worst case sets most of
+// the geometry, color and frame rate properties of every layer, as when a window is first shown.
+Transaction makeTransaction(const std::vector<sp<SurfaceControl>>& surfaceControls,
+                            Changes changes) {
+    Transaction t;
+    for (const auto& sc : surfaceControls) {
+        t.setPosition(sc, 10.f, 20.f);
+        t.setAlpha(sc, 0.5f);
+        if (changes == Changes::Typical) {
+            continue;
+        }
+        t.setLayer(sc, 1);
+        t.setLayerStack(sc, ui::DEFAULT_LAYER_STACK);
+        t.setFlags(sc, layer_state_t::eLayerOpaque, layer_state_t::eLayerOpaque);
+        t.setMatrix(sc, 1.f, 0.f, 0.f, 1.f);
+        t.setCrop(sc, Rect(0, 0, 100, 100));
+        t.setCornerRadius(sc, 8.f);
+        t.setBackgroundBlurRadius(sc, 10);
+        t.setColor(sc, half3(1.f, 0.f, 0.f));
+        t.setBackgroundColor(sc, half3(0.f, 0.f, 1.f), 1.f, ui::Dataspace::SRGB);
+        t.setTransparentRegionHint(sc, Region(Rect(0, 0, 10, 10)));
+        t.setTransform(sc, 0);
+        t.setDataspace(sc, ui::Dataspace::DISPLAY_P3);
+        t.setSurfaceDamageRegion(sc, Region(Rect(0, 0, 100, 100)));
+        t.setColorSpaceAgnostic(sc, true);
+        t.setShadowRadius(sc, 4.f);
+        t.setFrameRateSelectionPriority(sc, 1);
+        t.setFrameRate(sc, 60.f, ANATIVEWINDOW_FRAME_RATE_COMPATIBILITY_DEFAULT,
+                       ANATIVEWINDOW_CHANGE_FRAME_RATE_ONLY_IF_SEAMLESS);
+        t.setBufferCrop(sc, Rect(0, 0, 100, 100));
+        t.setDestinationFrame(sc, Rect(0, 0, 100, 100));
+        t.setTrustedOverlay(sc, gui::TrustedOverlay::ENABLED);
+        t.setDropInputMode(sc, gui::DropInputMode::NONE);
+        t.setDimmingEnabled(sc, false);
+    }
+    return t;
+}
+
+// Arguments: layer count, and which changes are made to every layer.
+void benchmarkWriteToParcel(benchmark::State& state) {
+    const auto surfaceControls = makeSurfaceControls(static_cast<int>(state.range(0)));
+    const Transaction t = makeTransaction(surfaceControls, static_cast<Changes>(state.range(1)));
+
+    size_t bytes = 0;
+    for (auto _ : state) {
+        Parcel parcel;
+        t.writeToParcel(&parcel);
+        bytes = parcel.dataSize();
+        benchmark::DoNotOptimize(parcel.data());
+    }
+    state.counters["bytes"] = static_cast<double>(bytes);
+}
+
+// Arguments: layer count, and which changes are made to every layer.
+void benchmarkReadFromParcel(benchmark::State& state) {
+    const auto surfaceControls = makeSurfaceControls(static_cast<int>(state.range(0)));
+    const Transaction t = makeTransaction(surfaceControls, static_cast<Changes>(state.range(1)));
+    Parcel parcel;
+    t.writeToParcel(&parcel);
+
+    for (auto _ : state) {
+        parcel.setDataPosition(0);
+        Transaction decoded;
+        benchmark::DoNotOptimize(decoded.readFromParcel(&parcel));
+    }
+    state.counters["bytes"] = static_cast<double>(parcel.dataSize());
+}
+
+// Every layer is moved in its own transaction, as by an animation, and those are merged into a
+// frame transaction. Applying it is stood in for by parceling it, which is what apply() sends to
+// SurfaceFlinger, and clearing it.
+template <typename Obtain>
+void buildMergeApply(benchmark::State& state, Obtain obtain) {
+    const auto surfaceControls = makeSurfaceControls(static_cast<int>(state.range(0)));
+
+    Parcel parcel;
+    for (auto _ : state) {
+        auto frame = obtain();
+        float offset = 0.f;
+        for (const auto& sc : surfaceControls) {
+            auto t = obtain();
+            t->setPosition(sc, offset, offset);
+            t->setAlpha(sc, 0.5f);
+            frame->merge(std::move(*t));
+            offset += 1.f;
+        }
+        parcel.setDataSize(0);
+        frame->writeToParcel(&parcel);
+        frame->clear();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+// Arguments: layer count. Transactions are created for every frame.
+void benchmarkBuildMergeApplyNew(benchmark::State& state) {
+    buildMergeApply(state, [] { return std::make_unique<Transaction>(); });
+}
+
+// Arguments: layer count. Transactions are taken from the pool.
+void benchmarkBuildMergeApplyPooled(benchmark::State& state) {
+    buildMergeApply(state, [] { return Transaction::obtain(); });
+}
+
+} // namespace
+
+BENCHMARK(benchmarkWriteToParcel)
+        ->ArgNames({"layers", "changes"})
+        ->ArgsProduct({{1, 10, 50}, {0, 1}});
+BENCHMARK(benchmarkReadFromParcel)
+        ->ArgNames({"layers", "changes"})
+        ->ArgsProduct({{1, 10, 50}, {0, 1}});
+BENCHMARK(benchmarkBuildMergeApplyNew)->ArgNames({"layers"})->Arg(1)->Arg(10)->Arg(100);
+BENCHMARK(benchmarkBuildMergeApplyPooled)->ArgNames({"layers"})->Arg(1)->Arg(10)->Arg(100);
+
+} // namespace android
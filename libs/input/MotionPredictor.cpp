@@ -24,6 +24,7 @@
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <future>
 #include <limits>
 #include <optional>
 #include <string>
@@ -137,7 +138,27 @@ MotionPredictor::MotionPredictor(nsecs_t predictionTimestampOffsetNanos,
                                  ReportAtomFunction reportAtomFunction)
       : mPredictionTimestampOffsetNanos(predictionTimestampOffsetNanos),
         mCheckMotionPredictionEnabled(std::move(checkMotionPredictionEnabled)),
-        mReportAtomFunction(reportAtomFunction) {}
+        mReportAtomFunction(reportAtomFunction) {
+    if (input_flags::eager_motion_predictor_model_load() && mCheckMotionPredictionEnabled()) {
+        // Start loading the model now, so that the first stroke doesn't have to wait for it.
+        mPendingModel = std::async(std::launch::async, TfLiteMotionPredictorModel::create);
+    }
+}
+
+MotionPredictor::~MotionPredictor() {
+    if (mPendingModel.valid()) {
+        mModel = mPendingModel.get();
+    }
+    TfLiteMotionPredictorModel::recycle(std::move(mModel));
+}
+
+TfLiteMotionPredictorModel& MotionPredictor::getModel() {
+    if (!mModel) {
+        mModel = mPendingModel.valid() ? mPendingModel.get() : TfLiteMotionPredictorModel::create();
+        LOG_ALWAYS_FATAL_IF(!mModel);
+    }
+    return *mModel;
+}
 
 android::base::Result<void> MotionPredictor::record(const MotionEvent& event) {
     if (mLastEvent && mLastEvent->getDeviceId() != event.getDeviceId()) {
@@ -156,18 +177,15 @@ android::base::Result<void> MotionPredictor::record(const MotionEvent& event) {
     }
 
     // Initialise the model now that it's likely to be used.
-    if (!mModel) {
-        mModel = TfLiteMotionPredictorModel::create();
-        LOG_ALWAYS_FATAL_IF(!mModel);
-    }
+    const TfLiteMotionPredictorModel& model = getModel();
 
     if (!mBuffers) {
-        mBuffers = std::make_unique<TfLiteMotionPredictorBuffers>(mModel->inputLength());
+        mBuffers = std::make_unique<TfLiteMotionPredictorBuffers>(model.inputLength());
     }
 
     // Pass input event to the MetricsManager.
     if (!mMetricsManager) {
-        mMetricsManager.emplace(mModel->config().predictionInterval, mModel->outputLength(),
+        mMetricsManager.emplace(model.config().predictionInterval, model.outputLength(),
                                 mReportAtomFunction);
     }
     mMetricsManager->onRecord(event);
@@ -176,6 +194,7 @@ android::base::Result<void> MotionPredictor::record(const MotionEvent& event) {
     if (action == AMOTION_EVENT_ACTION_UP || action == AMOTION_EVENT_ACTION_CANCEL) {
         ALOGD_IF(isDebug(), "End of event stream");
         mBuffers->reset();
+        mModelOutputValid = false;
         mJerkTracker.reset();
         mLastEvent.reset();
         return {};
@@ -214,6 +233,7 @@ android::base::Result<void> MotionPredictor::record(const MotionEvent& event) {
         mJerkTracker.pushSample(event.getHistoricalEventTime(i),
                                 coords->getAxisValue(AMOTION_EVENT_AXIS_X),
                                 coords->getAxisValue(AMOTION_EVENT_AXIS_Y));
+        mModelOutputValid = false;
     }
 
     if (!mLastEvent) {
@@ -225,14 +245,61 @@ android::base::Result<void> MotionPredictor::record(const MotionEvent& event) {
 }
 
 std::unique_ptr<MotionEvent> MotionPredictor::predict(nsecs_t timestamp) {
-    if (mBuffers == nullptr || !mBuffers->isReady()) {
+    if (!runModel()) {
         return nullptr;
     }
 
+    std::unique_ptr<MotionEvent> prediction = buildPrediction(timestamp);
+    if (prediction) {
+        // Pass predictions to the MetricsManager.
+        LOG_ALWAYS_FATAL_IF(!mMetricsManager);
+        mMetricsManager->onPredict(*prediction);
+    }
+    return prediction;
+}
+
+std::vector<std::unique_ptr<MotionEvent>> MotionPredictor::predict(
+        std::span<const nsecs_t> timestamps) {
+    std::vector<std::unique_ptr<MotionEvent>> predictions(timestamps.size());
+    if (!runModel()) {
+        return predictions;
+    }
+
+    const MotionEvent* longestPrediction = nullptr;
+    for (size_t i = 0; i < timestamps.size(); i++) {
+        predictions[i] = buildPrediction(timestamps[i]);
+        if (predictions[i] &&
+            (!longestPrediction ||
+             predictions[i]->getHistorySize() > longestPrediction->getHistorySize())) {
+            longestPrediction = predictions[i].get();
+        }
+    }
+
+    // All predictions are built from the same model output, so the longest one contains the
+    // samples of all the others. Only report that one, so that no sample is counted twice.
+    if (longestPrediction) {
+        LOG_ALWAYS_FATAL_IF(!mMetricsManager);
+        mMetricsManager->onPredict(*longestPrediction);
+    }
+    return predictions;
+}
+
+bool MotionPredictor::runModel() {
+    if (mBuffers == nullptr || !mBuffers->isReady()) {
+        return false;
+    }
+    if (mModelOutputValid) {
+        return true;
+    }
+
     LOG_ALWAYS_FATAL_IF(!mModel);
     mBuffers->copyTo(*mModel);
     LOG_ALWAYS_FATAL_IF(!mModel->invoke());
+    mModelOutputValid = true;
+    return true;
+}
 
+std::unique_ptr<MotionEvent> MotionPredictor::buildPrediction(nsecs_t timestamp) {
     // Read out the predictions.
     const std::span<const float> predictedR = mModel->outputR();
     const std::span<const float> predictedPhi = mModel->outputPhi();
@@ -333,11 +400,6 @@ std::unique_ptr<MotionEvent> MotionPredictor::predict(nsecs_t timestamp) {
     if (!hasPredictions) {
         return nullptr;
     }
-
-    // Pass predictions to the MetricsManager.
-    LOG_ALWAYS_FATAL_IF(!mMetricsManager);
-    mMetricsManager->onPredict(*prediction);
-
     return prediction;
 }
 
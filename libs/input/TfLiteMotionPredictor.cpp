@@ -26,13 +26,16 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <span>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include <android-base/file.h>
 #include <android-base/logging.h>
 #include <android-base/mapped_file.h>
+#include <android-base/thread_annotations.h>
 #define ATRACE_TAG ATRACE_TAG_INPUT
 #include <cutils/trace.h>
 #include <log/log.h>
@@ -52,6 +55,9 @@ namespace {
 
 constexpr char SIGNATURE_KEY[] = "serving_default";
 
+// The number of idle models kept around for reuse. Usually there's only one predictor per window.
+constexpr size_t MAX_POOLED_MODELS = 2;
+
 // Input tensor names.
 constexpr char INPUT_R[] = "r";
 constexpr char INPUT_PHI[] = "phi";
@@ -155,6 +161,18 @@ void checkTensor(const TfLiteTensor* tensor) {
     LOG_ALWAYS_FATAL_IF(buffer.empty(), "No buffer for tensor '%s'", tensor->name);
 }
 
+// Idle models that can be handed out by TfLiteMotionPredictorModel::create().
+struct ModelPool {
+    std::mutex lock;
+    std::vector<std::unique_ptr<TfLiteMotionPredictorModel>> models GUARDED_BY(lock);
+};
+
+ModelPool& getModelPool() {
+    // Intentionally leaked, so that the pool is never destroyed while another thread uses it.
+    static ModelPool& pool = *new ModelPool();
+    return pool;
+}
+
 std::unique_ptr<tflite::OpResolver> createOpResolver() {
     auto resolver = std::make_unique<tflite::MutableOpResolver>();
     resolver->AddBuiltin(::tflite::BuiltinOperator_CONCATENATION,
@@ -252,7 +270,15 @@ void TfLiteMotionPredictorBuffers::pushSample(int64_t timestamp,
     mInputOrientation.pushBack(orientation);
 }
 
-std::unique_ptr<TfLiteMotionPredictorModel> TfLiteMotionPredictorModel::create() {
+struct TfLiteMotionPredictorModel::SharedModel {
+    std::unique_ptr<android::base::MappedFile> flatBuffer;
+    std::unique_ptr<tflite::ErrorReporter> errorReporter;
+    std::unique_ptr<tflite::FlatBufferModel> model;
+    Config config;
+};
+
+std::shared_ptr<const TfLiteMotionPredictorModel::SharedModel>
+TfLiteMotionPredictorModel::loadSharedModel() {
     const std::string modelPath = getModelPath();
     android::base::unique_fd fd(open(modelPath.c_str(), O_RDONLY));
     if (fd == -1) {
@@ -264,9 +290,10 @@ std::unique_ptr<TfLiteMotionPredictorModel> TfLiteMotionPredictorModel::create()
         PLOG(FATAL) << "Failed to determine file size";
     }
 
-    std::unique_ptr<android::base::MappedFile> modelBuffer =
+    auto sharedModel = std::make_shared<SharedModel>();
+    sharedModel->flatBuffer =
             android::base::MappedFile::FromFd(fd, /*offset=*/0, fdSize, PROT_READ);
-    if (!modelBuffer) {
+    if (!sharedModel->flatBuffer) {
         PLOG(FATAL) << "Failed to mmap model";
     }
 
@@ -278,30 +305,56 @@ std::unique_ptr<TfLiteMotionPredictorModel> TfLiteMotionPredictorModel::create()
     // Parse configuration file.
     const tinyxml2::XMLElement* configRoot = configDocument.FirstChildElement("motion-predictor");
     LOG_ALWAYS_FATAL_IF(!configRoot);
-    Config config{
+    sharedModel->config = Config{
             .predictionInterval = parseXMLInt64(*configRoot, "prediction-interval"),
             .distanceNoiseFloor = parseXMLFloat(*configRoot, "distance-noise-floor"),
             .lowJerk = parseXMLFloat(*configRoot, "low-jerk"),
             .highJerk = parseXMLFloat(*configRoot, "high-jerk"),
     };
 
-    return std::unique_ptr<TfLiteMotionPredictorModel>(
-            new TfLiteMotionPredictorModel(std::move(modelBuffer), std::move(config)));
+    sharedModel->errorReporter = std::make_unique<LoggingErrorReporter>();
+    sharedModel->model =
+            tflite::FlatBufferModel::VerifyAndBuildFromBuffer(sharedModel->flatBuffer->data(),
+                                                              sharedModel->flatBuffer->size(),
+                                                              /*extra_verifier=*/nullptr,
+                                                              sharedModel->errorReporter.get());
+    LOG_ALWAYS_FATAL_IF(!sharedModel->model);
+
+    return sharedModel;
 }
 
-TfLiteMotionPredictorModel::TfLiteMotionPredictorModel(
-        std::unique_ptr<android::base::MappedFile> model, Config config)
-      : mFlatBuffer(std::move(model)), mConfig(std::move(config)) {
-    CHECK(mFlatBuffer);
-    mErrorReporter = std::make_unique<LoggingErrorReporter>();
-    mModel = tflite::FlatBufferModel::VerifyAndBuildFromBuffer(mFlatBuffer->data(),
-                                                               mFlatBuffer->size(),
-                                                               /*extra_verifier=*/nullptr,
-                                                               mErrorReporter.get());
-    LOG_ALWAYS_FATAL_IF(!mModel);
+std::unique_ptr<TfLiteMotionPredictorModel> TfLiteMotionPredictorModel::create() {
+    ModelPool& pool = getModelPool();
+    {
+        std::scoped_lock lock(pool.lock);
+        if (!pool.models.empty()) {
+            std::unique_ptr<TfLiteMotionPredictorModel> model = std::move(pool.models.back());
+            pool.models.pop_back();
+            return model;
+        }
+    }
+
+    // The model file never changes while the process is running, so it is only mapped, parsed
+    // and verified once. Static initialization is thread-safe.
+    static const std::shared_ptr<const SharedModel> sharedModel = loadSharedModel();
+    return std::unique_ptr<TfLiteMotionPredictorModel>(new TfLiteMotionPredictorModel(sharedModel));
+}
+
+void TfLiteMotionPredictorModel::recycle(std::unique_ptr<TfLiteMotionPredictorModel> model) {
+    if (!model) {
+        return;
+    }
+    ModelPool& pool = getModelPool();
+    std::scoped_lock lock(pool.lock);
+    if (pool.models.size() < MAX_POOLED_MODELS) {
+        pool.models.push_back(std::move(model));
+    }
+}
 
+TfLiteMotionPredictorModel::TfLiteMotionPredictorModel(std::shared_ptr<const SharedModel> model)
+      : mSharedModel(std::move(model)), mConfig(mSharedModel->config) {
     auto resolver = createOpResolver();
-    tflite::InterpreterBuilder builder(*mModel, *resolver);
+    tflite::InterpreterBuilder builder(*mSharedModel->model, *resolver);
 
     if (builder(&mInterpreter) != kTfLiteOk || !mInterpreter) {
         LOG_ALWAYS_FATAL("Failed to build interpreter");
@@ -311,6 +364,7 @@ TfLiteMotionPredictorModel::TfLiteMotionPredictorModel(
     LOG_ALWAYS_FATAL_IF(!mRunner, "Failed to find runner for signature '%s'", SIGNATURE_KEY);
 
     allocateTensors();
+    warmUp();
 }
 
 TfLiteMotionPredictorModel::~TfLiteMotionPredictorModel() {}
@@ -360,6 +414,17 @@ void TfLiteMotionPredictorModel::attachOutputTensors() {
     mOutputPressure = findOutputTensor(OUTPUT_PRESSURE, mRunner);
 }
 
+void TfLiteMotionPredictorModel::warmUp() {
+    // The first invocation of an interpreter pays for one-time kernel preparation. Do it now with
+    // neutral inputs, so that it doesn't delay the first prediction of a stroke.
+    std::ranges::fill(inputR(), 0);
+    std::ranges::fill(inputPhi(), 0);
+    std::ranges::fill(inputPressure(), 0);
+    std::ranges::fill(inputTilt(), 0);
+    std::ranges::fill(inputOrientation(), 0);
+    LOG_ALWAYS_FATAL_IF(!invoke(), "Failed to warm up the model");
+}
+
 bool TfLiteMotionPredictorModel::invoke() {
     ATRACE_BEGIN("TfLiteMotionPredictorModel::invoke");
     TfLiteStatus result = mRunner->Invoke();
@@ -21,6 +21,7 @@
 #include <inttypes.h>
 #include <limits.h>
 #include <math.h>
+#include <algorithm>
 #include <array>
 #include <optional>
 
@@ -119,31 +120,6 @@ static std::string vectorToString(const float* a, uint32_t m) {
     return str;
 }
 
-static std::string vectorToString(const std::vector<float>& v) {
-    return vectorToString(v.data(), v.size());
-}
-
-static std::string matrixToString(const float* a, uint32_t m, uint32_t n, bool rowMajor) {
-    std::string str;
-    str = "[";
-    for (size_t i = 0; i < m; i++) {
-        if (i) {
-            str += ",";
-        }
-        str += " [";
-        for (size_t j = 0; j < n; j++) {
-            if (j) {
-                str += ",";
-            }
-            str += android::base::StringPrintf(" %f", a[rowMajor ? i * n + j : j * m + i]);
-        }
-        str += " ]";
-    }
-    str += " ]";
-    return str;
-}
-
-
 // --- VelocityTracker ---
 
 VelocityTracker::VelocityTracker(const Strategy strategy)
@@ -479,18 +455,18 @@ LeastSquaresVelocityTrackerStrategy::~LeastSquaresVelocityTrackerStrategy() {}
  * http://en.wikipedia.org/wiki/Numerical_methods_for_linear_least_squares
  * http://en.wikipedia.org/wiki/Gram-Schmidt
  */
-static std::optional<float> solveLeastSquares(const std::vector<float>& x,
-                                              const std::vector<float>& y,
-                                              const std::vector<float>& w, uint32_t n) {
-    const size_t m = x.size();
+bool LeastSquaresVelocityTrackerStrategy::Decomposition::compute(uint32_t samples,
+                                                                 uint32_t coefficients) {
+    m = samples;
+    n = coefficients;
+    LOG_ALWAYS_FATAL_IF(m > MAX_SAMPLES || n > MAX_COEFFICIENTS,
+                        "Too many samples (%d) or coefficients (%d)", int(m), int(n));
 
-    ALOGD_IF(DEBUG_STRATEGY, "solveLeastSquares: m=%d, n=%d, x=%s, y=%s, w=%s", int(m), int(n),
-             vectorToString(x).c_str(), vectorToString(y).c_str(), vectorToString(w).c_str());
-
-    LOG_ALWAYS_FATAL_IF(m != y.size() || m != w.size(), "Mismatched vector sizes");
+    ALOGD_IF(DEBUG_STRATEGY, "solveLeastSquares: m=%d, n=%d, x=%s, w=%s", int(m), int(n),
+             vectorToString(x.data(), m).c_str(), vectorToString(w.data(), m).c_str());
 
     // Expand the X vector to a matrix A, pre-multiplied by the weights.
-    float a[n][m]; // column-major order
+    std::array<std::array<float, MAX_SAMPLES>, MAX_COEFFICIENTS> a; // column-major order
     for (uint32_t h = 0; h < m; h++) {
         a[0][h] = w[h];
         for (uint32_t i = 1; i < n; i++) {
@@ -498,28 +474,23 @@ static std::optional<float> solveLeastSquares(const std::vector<float>& x,
         }
     }
 
-    ALOGD_IF(DEBUG_STRATEGY, "  - a=%s",
-             matrixToString(&a[0][0], m, n, /*rowMajor=*/false).c_str());
-
     // Apply the Gram-Schmidt process to A to obtain its QR decomposition.
-    float q[n][m]; // orthonormal basis, column-major order
-    float r[n][n]; // upper triangular matrix, row-major order
     for (uint32_t j = 0; j < n; j++) {
         for (uint32_t h = 0; h < m; h++) {
             q[j][h] = a[j][h];
         }
         for (uint32_t i = 0; i < j; i++) {
-            float dot = vectorDot(&q[j][0], &q[i][0], m);
+            float dot = vectorDot(q[j].data(), q[i].data(), m);
             for (uint32_t h = 0; h < m; h++) {
                 q[j][h] -= dot * q[i][h];
             }
         }
 
-        float norm = vectorNorm(&q[j][0], m);
+        float norm = vectorNorm(q[j].data(), m);
         if (norm < 0.000001f) {
             // vectors are linearly dependent or zero so no solution
             ALOGD_IF(DEBUG_STRATEGY, "  - no solution, norm=%f", norm);
-            return {};
+            return false;
         }
 
         float invNorm = 1.0f / norm;
@@ -527,75 +498,50 @@ static std::optional<float> solveLeastSquares(const std::vector<float>& x,
             q[j][h] *= invNorm;
         }
         for (uint32_t i = 0; i < n; i++) {
-            r[j][i] = i < j ? 0 : vectorDot(&q[j][0], &a[i][0], m);
+            r[j][i] = i < j ? 0 : vectorDot(q[j].data(), a[i].data(), m);
         }
     }
     if (DEBUG_STRATEGY) {
-        ALOGD("  - q=%s", matrixToString(&q[0][0], m, n, /*rowMajor=*/false).c_str());
-        ALOGD("  - r=%s", matrixToString(&r[0][0], n, n, /*rowMajor=*/true).c_str());
-
-        // calculate QR, if we factored A correctly then QR should equal A
-        float qr[n][m];
-        for (uint32_t h = 0; h < m; h++) {
-            for (uint32_t i = 0; i < n; i++) {
-                qr[i][h] = 0;
-                for (uint32_t j = 0; j < n; j++) {
-                    qr[i][h] += q[j][h] * r[j][i];
-                }
-            }
+        for (uint32_t j = 0; j < n; j++) {
+            ALOGD("  - q[%d]=%s", int(j), vectorToString(q[j].data(), m).c_str());
+            ALOGD("  - r[%d]=%s", int(j), vectorToString(r[j].data(), n).c_str());
         }
-        ALOGD("  - qr=%s", matrixToString(&qr[0][0], m, n, /*rowMajor=*/false).c_str());
     }
+    return true;
+}
 
+float LeastSquaresVelocityTrackerStrategy::Decomposition::solveForVelocity(
+        const std::array<float, MAX_SAMPLES>& y) const {
     // Solve R B = Qt W Y to find B.  This is easy because R is upper triangular.
     // We just work from bottom-right to top-left calculating B's coefficients.
-    float wy[m];
+    std::array<float, MAX_SAMPLES> wy;
     for (uint32_t h = 0; h < m; h++) {
         wy[h] = y[h] * w[h];
     }
-    std::array<float, VelocityTracker::MAX_DEGREE + 1> outB;
+    std::array<float, MAX_COEFFICIENTS> outB;
     for (uint32_t i = n; i != 0; ) {
         i--;
-        outB[i] = vectorDot(&q[i][0], wy, m);
+        outB[i] = vectorDot(q[i].data(), wy.data(), m);
         for (uint32_t j = n - 1; j > i; j--) {
             outB[i] -= r[i][j] * outB[j];
         }
         outB[i] /= r[i][i];
     }
 
-    ALOGD_IF(DEBUG_STRATEGY, "  - b=%s", vectorToString(outB.data(), n).c_str());
-
-    // Calculate the coefficient of determination as 1 - (SSerr / SStot) where
-    // SSerr is the residual sum of squares (variance of the error),
-    // and SStot is the total sum of squares (variance of the data) where each
-    // has been weighted.
-    float ymean = 0;
-    for (uint32_t h = 0; h < m; h++) {
-        ymean += y[h];
-    }
-    ymean /= m;
-
-    if (DEBUG_STRATEGY) {
-        float sserr = 0;
-        float sstot = 0;
-        for (uint32_t h = 0; h < m; h++) {
-            float err = y[h] - outB[0];
-            float term = 1;
-            for (uint32_t i = 1; i < n; i++) {
-                term *= x[h];
-                err -= term * outB[i];
-            }
-            sserr += w[h] * w[h] * err * err;
-            float var = y[h] - ymean;
-            sstot += w[h] * w[h] * var * var;
-        }
-        ALOGD("  - sserr=%f", sserr);
-        ALOGD("  - sstot=%f", sstot);
-    }
+    ALOGD_IF(DEBUG_STRATEGY, "  - y=%s, b=%s", vectorToString(y.data(), m).c_str(),
+             vectorToString(outB.data(), n).c_str());
 
     return outB[1];
 }
 
+bool LeastSquaresVelocityTrackerStrategy::Decomposition::matches(
+        uint32_t samples, uint32_t coefficients, const std::array<float, MAX_SAMPLES>& sampleX,
+        const std::array<float, MAX_SAMPLES>& sampleW) const {
+    return m == samples && n == coefficients &&
+            std::equal(sampleX.begin(), sampleX.begin() + samples, x.begin()) &&
+            std::equal(sampleW.begin(), sampleW.begin() + samples, w.begin());
+}
+
 /*
  * Optimized unweighted second-order least squares fit. About 2x speed improvement compared to
  * the default implementation
@@ -672,25 +618,34 @@ std::optional<float> LeastSquaresVelocityTrackerStrategy::getVelocity(int32_t po
     }
 
     // Iterate over movement samples in reverse time order and collect samples.
-    std::vector<float> positions;
-    std::vector<float> w;
-    std::vector<float> time;
+    std::array<float, Decomposition::MAX_SAMPLES> positions;
+    std::array<float, Decomposition::MAX_SAMPLES> w;
+    std::array<float, Decomposition::MAX_SAMPLES> time;
 
     const Movement& newestMovement = movements[size - 1];
-    for (ssize_t i = size - 1; i >= 0; i--) {
+    for (ssize_t i = size - 1, h = 0; i >= 0; i--, h++) {
         const Movement& movement = movements[i];
         nsecs_t age = newestMovement.eventTime - movement.eventTime;
-        positions.push_back(movement.position);
-        w.push_back(chooseWeight(pointerId, i));
-        time.push_back(-age * 0.000000001f);
+        positions[h] = movement.position;
+        w[h] = chooseWeight(movements, i);
+        time[h] = -age * 0.000000001f;
     }
 
     // General case for an Nth degree polynomial fit
-    return solveLeastSquares(time, positions, w, degree + 1);
+    const uint32_t n = degree + 1;
+    if (!mLastDecomposition.matches(size, n, time, w)) {
+        mLastDecomposition.x = time;
+        mLastDecomposition.w = w;
+        mLastDecompositionValid = mLastDecomposition.compute(size, n);
+    }
+    if (!mLastDecompositionValid) {
+        return std::nullopt;
+    }
+    return mLastDecomposition.solveForVelocity(positions);
 }
 
-float LeastSquaresVelocityTrackerStrategy::chooseWeight(int32_t pointerId, uint32_t index) const {
-    const RingBuffer<Movement>& movements = mMovements.at(pointerId);
+float LeastSquaresVelocityTrackerStrategy::chooseWeight(const RingBuffer<Movement>& movements,
+                                                        uint32_t index) const {
     const size_t size = movements.size();
     switch (mWeighting) {
         case Weighting::DELTA: {
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <input/Input.h>
+#include <input/MotionPredictor.h>
+
+using namespace std::literals::chrono_literals;
+
+namespace android {
+
+namespace {
+
+constexpr nsecs_t FRAME_INTERVAL = 8'333'333; // 120Hz
+constexpr size_t FRAMES_TO_PREDICT = 3;
+
+MotionEvent getStylusEvent(int32_t action, float x, float y, nsecs_t eventTime) {
+    PointerProperties properties;
+    properties.clear();
+    properties.id = 0;
+    properties.toolType = ToolType::STYLUS;
+    PointerCoords coords;
+    coords.clear();
+    coords.setAxisValue(AMOTION_EVENT_AXIS_X, x);
+    coords.setAxisValue(AMOTION_EVENT_AXIS_Y, y);
+    coords.setAxisValue(AMOTION_EVENT_AXIS_PRESSURE, 0.5);
+
+    MotionEvent event;
+    ui::Transform identityTransform;
+    event.initialize(InputEvent::nextId(), /*deviceId=*/1, AINPUT_SOURCE_STYLUS,
+                     ui::LogicalDisplayId::DEFAULT, {0}, action, /*actionButton=*/0, /*flags=*/0,
+                     AMOTION_EVENT_EDGE_FLAG_NONE, AMETA_NONE, /*buttonState=*/0,
+                     MotionClassification::NONE, identityTransform, /*xPrecision=*/0,
+                     /*yPrecision=*/0, AMOTION_EVENT_INVALID_CURSOR_POSITION,
+                     AMOTION_EVENT_INVALID_CURSOR_POSITION, identityTransform, /*downTime=*/0,
+                     eventTime, /*pointerCount=*/1, &properties, &coords);
+    return event;
+}
+
+std::unique_ptr<MotionPredictor> createPredictor() {
+    return std::make_unique<MotionPredictor>(/*predictionTimestampOffsetNanos=*/0,
+                                             []() { return true /*enable prediction*/; });
+}
+
+// Measures the time from the creation of a predictor to its first prediction. Destroyed predictors
+// return their model to the process-wide pool, so only the first iteration builds a model.
+void benchmarkFirstPrediction(benchmark::State& state) {
+    for (auto _ : state) {
+        std::unique_ptr<MotionPredictor> predictor = createPredictor();
+        predictor->record(getStylusEvent(AMOTION_EVENT_ACTION_DOWN, 10, 10, 0));
+        predictor->record(getStylusEvent(AMOTION_EVENT_ACTION_MOVE, 20, 15, 4'000'000));
+        predictor->record(getStylusEvent(AMOTION_EVENT_ACTION_MOVE, 30, 20, 8'000'000));
+        benchmark::DoNotOptimize(predictor->predict(8'000'000 + FRAME_INTERVAL));
+
+        state.PauseTiming();
+        predictor.reset();
+        state.ResumeTiming();
+    }
+}
+BENCHMARK(benchmarkFirstPrediction);
+
+// Measures predictions for the next few frames after every new sample of a stroke.
+// Argument: whether all frames are predicted with a single batched call.
+void benchmarkSteadyStatePrediction(benchmark::State& state) {
+    const bool batched = state.range(0) != 0;
+    std::unique_ptr<MotionPredictor> predictor = createPredictor();
+    nsecs_t eventTime = 0;
+    float x = 0;
+    predictor->record(getStylusEvent(AMOTION_EVENT_ACTION_DOWN, x, x, eventTime));
+
+    std::array<nsecs_t, FRAMES_TO_PREDICT> targetTimes;
+    for (auto _ : state) {
+        eventTime += 4'000'000;
+        x += 10;
+        predictor->record(getStylusEvent(AMOTION_EVENT_ACTION_MOVE, x, x / 2, eventTime));
+        for (size_t i = 0; i < FRAMES_TO_PREDICT; i++) {
+            targetTimes[i] = eventTime + static_cast<nsecs_t>(i + 1) * FRAME_INTERVAL;
+        }
+
+        if (batched) {
+            benchmark::DoNotOptimize(predictor->predict(targetTimes));
+        } else {
+            for (nsecs_t targetTime : targetTimes) {
+                benchmark::DoNotOptimize(predictor->predict(targetTime));
+            }
+        }
+    }
+}
+BENCHMARK(benchmarkSteadyStatePrediction)->ArgName("batched")->Arg(0)->Arg(1);
+
+} // namespace
+
+} // namespace android
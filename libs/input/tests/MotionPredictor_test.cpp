@@ -15,6 +15,7 @@
  */
 
 // TODO(b/331815574): Decouple this test from assumed config values.
+#include <array>
 #include <chrono>
 #include <cmath>
 
@@ -210,6 +211,48 @@ TEST(MotionPredictorTest, FollowsGesture) {
     EXPECT_EQ(nullptr, predictor.predict(100 * NSEC_PER_MSEC));
 }
 
+TEST(MotionPredictorTest, BatchedPredictionsMatchIndividualPredictions) {
+    MotionPredictor predictor(/*predictionTimestampOffsetNanos=*/0,
+                              []() { return true /*enable prediction*/; });
+    predictor.record(getMotionEvent(DOWN, 3.75, 3, 20ms));
+    predictor.record(getMotionEvent(MOVE, 4.8, 3, 30ms));
+    predictor.record(getMotionEvent(MOVE, 6.2, 3, 40ms));
+    predictor.record(getMotionEvent(MOVE, 8, 3, 50ms));
+
+    const std::array<nsecs_t, 3> timestamps{60 * NSEC_PER_MSEC, 75 * NSEC_PER_MSEC,
+                                            90 * NSEC_PER_MSEC};
+    std::vector<std::unique_ptr<MotionEvent>> predictions = predictor.predict(timestamps);
+    ASSERT_THAT(predictions, SizeIs(timestamps.size()));
+
+    for (size_t i = 0; i < timestamps.size(); i++) {
+        SCOPED_TRACE(i);
+        std::unique_ptr<MotionEvent> expected = predictor.predict(timestamps[i]);
+        ASSERT_NE(nullptr, expected);
+        ASSERT_NE(nullptr, predictions[i]);
+        ASSERT_EQ(expected->getHistorySize(), predictions[i]->getHistorySize());
+        for (size_t h = 0; h <= expected->getHistorySize(); h++) {
+            EXPECT_EQ(expected->getHistoricalEventTime(h),
+                      predictions[i]->getHistoricalEventTime(h));
+            EXPECT_EQ(expected->getHistoricalX(0, h), predictions[i]->getHistoricalX(0, h));
+            EXPECT_EQ(expected->getHistoricalY(0, h), predictions[i]->getHistoricalY(0, h));
+        }
+    }
+    // Later target times can only extend the prediction.
+    EXPECT_LE(predictions[0]->getHistorySize(), predictions[2]->getHistorySize());
+}
+
+TEST(MotionPredictorTest, BatchedPredictionWithoutEnoughData) {
+    MotionPredictor predictor(/*predictionTimestampOffsetNanos=*/0,
+                              []() { return true /*enable prediction*/; });
+    predictor.record(getMotionEvent(DOWN, 3.75, 3, 20ms));
+
+    const std::array<nsecs_t, 2> timestamps{30 * NSEC_PER_MSEC, 40 * NSEC_PER_MSEC};
+    std::vector<std::unique_ptr<MotionEvent>> predictions = predictor.predict(timestamps);
+    ASSERT_THAT(predictions, SizeIs(timestamps.size()));
+    EXPECT_EQ(nullptr, predictions[0]);
+    EXPECT_EQ(nullptr, predictions[1]);
+}
+
 TEST(MotionPredictorTest, MultipleDevicesNotSupported) {
     MotionPredictor predictor(/*predictionTimestampOffsetNanos=*/0,
                               []() { return true /*enable prediction*/; });
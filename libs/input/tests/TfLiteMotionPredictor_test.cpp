@@ -20,6 +20,7 @@
 #include <ios>
 #include <iterator>
 #include <string>
+#include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -30,6 +31,7 @@ namespace {
 
 using ::testing::Each;
 using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
 using ::testing::FloatNear;
 
 TEST(TfLiteMotionPredictorTest, BuffersReadiness) {
@@ -165,5 +167,43 @@ TEST(TfLiteMotionPredictorTest, ModelOutput) {
             std::all_of(model->outputPressure().begin(), model->outputPressure().end(), is_valid));
 }
 
+TEST(TfLiteMotionPredictorTest, RecycledModelIsReused) {
+    // Take any models that other tests left in the pool.
+    std::unique_ptr<TfLiteMotionPredictorModel> model = TfLiteMotionPredictorModel::create();
+    std::unique_ptr<TfLiteMotionPredictorModel> otherModel = TfLiteMotionPredictorModel::create();
+    const TfLiteMotionPredictorModel* const recycledModel = model.get();
+
+    TfLiteMotionPredictorModel::recycle(std::move(model));
+    model = TfLiteMotionPredictorModel::create();
+    EXPECT_EQ(recycledModel, model.get());
+}
+
+TEST(TfLiteMotionPredictorTest, RecycledModelProducesSameOutput) {
+    std::unique_ptr<TfLiteMotionPredictorModel> model = TfLiteMotionPredictorModel::create();
+    TfLiteMotionPredictorBuffers buffers(model->inputLength());
+    buffers.pushSample(/*timestamp=*/1, {.position = {.x = 100, .y = 200}, .pressure = 0.2});
+    buffers.pushSample(/*timestamp=*/2, {.position = {.x = 150, .y = 250}, .pressure = 0.4});
+    buffers.pushSample(/*timestamp=*/3, {.position = {.x = 180, .y = 280}, .pressure = 0.6});
+
+    buffers.copyTo(*model);
+    ASSERT_TRUE(model->invoke());
+    const std::vector<float> outputR(model->outputR().begin(), model->outputR().end());
+    const std::vector<float> outputPhi(model->outputPhi().begin(), model->outputPhi().end());
+
+    // Leave the model in a different state before it is reused.
+    TfLiteMotionPredictorBuffers otherBuffers(model->inputLength());
+    otherBuffers.pushSample(/*timestamp=*/1, {.position = {.x = 0, .y = 0}, .pressure = 1});
+    otherBuffers.pushSample(/*timestamp=*/2, {.position = {.x = 10, .y = 0}, .pressure = 1});
+    otherBuffers.copyTo(*model);
+    ASSERT_TRUE(model->invoke());
+    TfLiteMotionPredictorModel::recycle(std::move(model));
+
+    model = TfLiteMotionPredictorModel::create();
+    buffers.copyTo(*model);
+    ASSERT_TRUE(model->invoke());
+    EXPECT_THAT(model->outputR(), ElementsAreArray(outputR));
+    EXPECT_THAT(model->outputPhi(), ElementsAreArray(outputPhi));
+}
+
 } // namespace
 } // namespace android
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <input/VelocityTracker.h>
+
+namespace android {
+
+namespace {
+
+using Weighting = LeastSquaresVelocityTrackerStrategy::Weighting;
+
+constexpr int32_t POINTER_COUNT = 2;
+constexpr int SAMPLE_COUNT = 12;
+
+/**
+ * Measures the cost of a least-squares velocity computation for every pointer of a gesture.
+ *
+ * Arguments: degree, weighting, and whether the samples are evenly spaced in time. Evenly spaced
+ * samples let the strategy reuse the decomposition across calls.
+ */
+void benchmarkLeastSquaresGetVelocity(benchmark::State& state) {
+    const uint32_t degree = static_cast<uint32_t>(state.range(0));
+    const Weighting weighting = static_cast<Weighting>(state.range(1));
+    const bool uniform = state.range(2) != 0;
+
+    LeastSquaresVelocityTrackerStrategy strategy(degree, weighting);
+    nsecs_t eventTime = 0;
+    for (int i = 0; i < SAMPLE_COUNT; i++) {
+        eventTime += uniform ? 8'000'000 : 7'000'000 + (i % 3) * 1'000'000;
+        for (int32_t pointerId = 0; pointerId < POINTER_COUNT; pointerId++) {
+            strategy.addMovement(eventTime, pointerId, 10.f * i + pointerId * i * i);
+        }
+    }
+
+    for (auto _ : state) {
+        for (int32_t pointerId = 0; pointerId < POINTER_COUNT; pointerId++) {
+            benchmark::DoNotOptimize(strategy.getVelocity(pointerId));
+        }
+    }
+}
+
+BENCHMARK(benchmarkLeastSquaresGetVelocity)
+        ->ArgNames({"degree", "weighting", "uniform"})
+        ->Args({2, static_cast<int64_t>(Weighting::NONE), 1})
+        ->Args({3, static_cast<int64_t>(Weighting::NONE), 0})
+        ->Args({3, static_cast<int64_t>(Weighting::NONE), 1})
+        ->Args({2, static_cast<int64_t>(Weighting::DELTA), 0})
+        ->Args({2, static_cast<int64_t>(Weighting::DELTA), 1})
+        ->Args({2, static_cast<int64_t>(Weighting::RECENT), 0})
+        ->Args({2, static_cast<int64_t>(Weighting::RECENT), 1});
+
+} // namespace
+
+} // namespace android
+
+BENCHMARK_MAIN();
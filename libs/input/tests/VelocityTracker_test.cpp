@@ -1445,4 +1445,71 @@ TEST_F(VelocityTrackerTest, AxisScrollVelocity_NoData) {
     computeAndCheckAxisScrollVelocity(VelocityTracker::Strategy::IMPULSE, motions, std::nullopt);
 }
 
+/*
+ *================== Least-squares decomposition reuse ==============================================
+ *
+ * The least-squares strategy reuses the decomposition of the last fit when the relative sample
+ * times and weights have not changed. The reused results must match a fresh computation exactly.
+ */
+static std::optional<float> computeLeastSquaresVelocity(
+        uint32_t degree, LeastSquaresVelocityTrackerStrategy::Weighting weighting,
+        const std::vector<std::pair<nsecs_t, float>>& samples) {
+    LeastSquaresVelocityTrackerStrategy strategy(degree, weighting);
+    for (const auto& [eventTime, position] : samples) {
+        strategy.addMovement(eventTime, DEFAULT_POINTER_ID, position);
+    }
+    return strategy.getVelocity(DEFAULT_POINTER_ID);
+}
+
+TEST(LeastSquaresVelocityTrackerStrategyTest, ReusedDecompositionMatchesFreshComputation) {
+    using Weighting = LeastSquaresVelocityTrackerStrategy::Weighting;
+    for (const auto& [degree, weighting] :
+         std::vector<std::pair<uint32_t, Weighting>>{{1, Weighting::NONE},
+                                                     {3, Weighting::NONE},
+                                                     {2, Weighting::DELTA},
+                                                     {2, Weighting::CENTRAL},
+                                                     {2, Weighting::RECENT}}) {
+        SCOPED_TRACE(StringPrintf("degree=%d, weighting=%d", degree, static_cast<int>(weighting)));
+        LeastSquaresVelocityTrackerStrategy strategy(degree, weighting);
+        // Two pointers of the same gesture, sampled at the same uniform rate.
+        std::vector<std::pair<nsecs_t, float>> firstPointer;
+        std::vector<std::pair<nsecs_t, float>> secondPointer;
+        for (int i = 0; i < 12; i++) {
+            const nsecs_t eventTime = 8'000'000LL * i;
+            firstPointer.emplace_back(eventTime, 3.f * i + 0.25f * i * i);
+            secondPointer.emplace_back(eventTime, 500.f - 7.f * i - 0.5f * i * i * i / 10.f);
+            strategy.addMovement(eventTime, /*pointerId=*/0, firstPointer.back().second);
+            strategy.addMovement(eventTime, /*pointerId=*/1, secondPointer.back().second);
+        }
+
+        std::optional<float> first = strategy.getVelocity(/*pointerId=*/0);
+        // This call has the same sample times as the previous one.
+        std::optional<float> second = strategy.getVelocity(/*pointerId=*/1);
+        ASSERT_TRUE(first);
+        ASSERT_TRUE(second);
+        EXPECT_EQ(*first, *computeLeastSquaresVelocity(degree, weighting, firstPointer));
+        EXPECT_EQ(*second, *computeLeastSquaresVelocity(degree, weighting, secondPointer));
+
+        // A sample at an irregular time invalidates the decomposition.
+        const nsecs_t lateTime = firstPointer.back().first + 11'000'000;
+        firstPointer.emplace_back(lateTime, firstPointer.back().second + 10.f);
+        strategy.addMovement(lateTime, /*pointerId=*/0, firstPointer.back().second);
+        first = strategy.getVelocity(/*pointerId=*/0);
+        ASSERT_TRUE(first);
+        EXPECT_EQ(*first, *computeLeastSquaresVelocity(degree, weighting, firstPointer));
+    }
+}
+
+TEST(LeastSquaresVelocityTrackerStrategyTest, ReusedDecompositionOfDegenerateSamples) {
+    // Samples that are too close together in time cannot be fit. The reused decomposition must
+    // still report that.
+    LeastSquaresVelocityTrackerStrategy strategy(3);
+    for (int i = 0; i < 5; i++) {
+        strategy.addMovement(/*eventTime=*/1000 + i, /*pointerId=*/0, i);
+        strategy.addMovement(/*eventTime=*/1000 + i, /*pointerId=*/1, 2 * i);
+    }
+    EXPECT_FALSE(strategy.getVelocity(/*pointerId=*/0));
+    EXPECT_FALSE(strategy.getVelocity(/*pointerId=*/1));
+}
+
 } // namespace android
@@ -260,6 +260,9 @@ enum {
     NATIVE_WINDOW_SET_FRAME_TIMELINE_INFO         = 48,    /* private */
     NATIVE_WINDOW_GET_LAST_QUEUED_BUFFER2         = 49,    /* private */
     NATIVE_WINDOW_SET_BUFFERS_ADDITIONAL_OPTIONS  = 50,
+    NATIVE_WINDOW_DEQUEUE_BUFFERS                 = 51,    /* private */
+    NATIVE_WINDOW_QUEUE_BUFFERS                   = 52,    /* private */
+    NATIVE_WINDOW_CANCEL_BUFFERS                  = 53,    /* private */
     // clang-format on
 };
 
@@ -1205,6 +1208,47 @@ static inline int native_window_set_buffers_additional_options(
                            additionalOptionsSize);
 }
 
+/*
+ * native_window_dequeue_buffers(..., size_t count, ANativeWindowBuffer** outBuffers,
+ *         int* outFenceFds)
+ * Dequeues count buffers at once, with a single call into the buffer queue instead of one per
+ * buffer. On success, outBuffers[i] and outFenceFds[i] are set as by dequeueBuffer for each of the
+ * buffers. On failure, no buffer is dequeued.
+ *
+ * Batched operations are not supported in shared buffer mode.
+ */
+static inline int native_window_dequeue_buffers(struct ANativeWindow* window, size_t count,
+                                                struct ANativeWindowBuffer** outBuffers,
+                                                int* outFenceFds) {
+    return window->perform(window, NATIVE_WINDOW_DEQUEUE_BUFFERS, count, outBuffers, outFenceFds);
+}
+
+/*
+ * native_window_queue_buffers(..., size_t count, ANativeWindowBuffer* const* buffers,
+ *         const int* fenceFds, const int64_t* timestamps)
+ * Queues count buffers at once, in order, with a single call into the buffer queue. The window
+ * takes ownership of all the fences, as with queueBuffer. timestamps holds the presentation time
+ * of each buffer, or NATIVE_WINDOW_TIMESTAMP_AUTO, and may be NULL if all of them are automatic.
+ */
+static inline int native_window_queue_buffers(struct ANativeWindow* window, size_t count,
+                                              struct ANativeWindowBuffer* const* buffers,
+                                              const int* fenceFds, const int64_t* timestamps) {
+    return window->perform(window, NATIVE_WINDOW_QUEUE_BUFFERS, count, buffers, fenceFds,
+                           timestamps);
+}
+
+/*
+ * native_window_cancel_buffers(..., size_t count, ANativeWindowBuffer* const* buffers,
+ *         const int* fenceFds)
+ * Cancels count dequeued buffers at once, with a single call into the buffer queue. The window
+ * takes ownership of all the fences, as with cancelBuffer.
+ */
+static inline int native_window_cancel_buffers(struct ANativeWindow* window, size_t count,
+                                               struct ANativeWindowBuffer* const* buffers,
+                                               const int* fenceFds) {
+    return window->perform(window, NATIVE_WINDOW_CANCEL_BUFFERS, count, buffers, fenceFds);
+}
+
 // ------------------------------------------------------------------------------------------------
 // Candidates for APEX visibility
 // These functions are planned to be made stable for APEX modules, but have not
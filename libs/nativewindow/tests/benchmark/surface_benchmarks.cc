@@ -0,0 +1,171 @@
+// Copyright (C) 2024 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <signal.h>
+#include <sys/prctl.h>
+#include <unistd.h>
+
+#include <android/hardware_buffer.h>
+#include <android-base/macros.h>
+#include <android-base/unique_fd.h>
+#include <benchmark/benchmark.h>
+#include <binder/IPCThreadState.h>
+#include <binder/IServiceManager.h>
+#include <binder/ProcessState.h>
+#include <gui/BufferItem.h>
+#include <gui/BufferQueue.h>
+#include <gui/IConsumerListener.h>
+#include <gui/Surface.h>
+#include <system/window.h>
+
+using namespace android;
+
+constexpr size_t kMaxBatchSize = 8;
+constexpr int kBufferSize = 64;
+
+// Acquires and releases every buffer as soon as it's queued, so that the producer never waits for
+// a free buffer.
+class DrainingConsumer : public BnConsumerListener {
+public:
+    explicit DrainingConsumer(const sp<IGraphicBufferConsumer>& consumer) : mConsumer(consumer) {}
+
+    void onFrameAvailable(const BufferItem&) override {
+        BufferItem item;
+        if (mConsumer->acquireBuffer(&item, 0) == NO_ERROR) {
+            mConsumer->releaseBuffer(item.mSlot, item.mFrameNumber, Fence::NO_FENCE);
+        }
+    }
+    void onBuffersReleased() override {}
+    void onSidebandStreamChanged() override {}
+
+private:
+    sp<IGraphicBufferConsumer> mConsumer;
+};
+
+// Returns a producer that lives in a child process, so that every call into the buffer queue is a
+// binder transaction like it is for a real app. Returns null if the child couldn't publish it.
+static sp<IGraphicBufferProducer> getRemoteProducer() {
+    static const sp<IGraphicBufferProducer> sProducer = []() -> sp<IGraphicBufferProducer> {
+        const String16 kProducerName("NativeWindowBenchmarkProducer");
+
+        int fds[2];
+        if (pipe(fds) < 0) return nullptr;
+        base::unique_fd readFd(fds[0]);
+        base::unique_fd writeFd(fds[1]);
+
+        pid_t pid = fork();
+        if (pid < 0) return nullptr;
+        if (pid == 0) {
+            prctl(PR_SET_PDEATHSIG, SIGKILL);
+            sp<IGraphicBufferProducer> producer;
+            sp<IGraphicBufferConsumer> consumer;
+            BufferQueue::createBufferQueue(&producer, &consumer);
+            consumer->consumerConnect(sp<DrainingConsumer>::make(consumer), false);
+            status_t status = defaultServiceManager()->addService(kProducerName,
+                                                                   IInterface::asBinder(producer));
+            write(writeFd, &status, sizeof(status));
+            ProcessState::self()->startThreadPool();
+            IPCThreadState::self()->joinThreadPool();
+            _exit(0);
+        }
+
+        status_t status = UNKNOWN_ERROR;
+        if (read(readFd, &status, sizeof(status)) != sizeof(status) || status != NO_ERROR) {
+            return nullptr;
+        }
+        ProcessState::self()->startThreadPool();
+        return interface_cast<IGraphicBufferProducer>(
+                defaultServiceManager()->waitForService(kProducerName));
+    }();
+    return sProducer;
+}
+
+// Connects a Surface to the remote producer, with room for a whole batch of dequeued buffers.
+// Returns null, after skipping the benchmark, on failure.
+static sp<Surface> createSurface(benchmark::State& state) {
+    sp<IGraphicBufferProducer> producer = getRemoteProducer();
+    if (producer == nullptr) {
+        state.SkipWithError("Unable to create a buffer queue in another process.");
+        return nullptr;
+    }
+    sp<Surface> surface = sp<Surface>::make(producer);
+    ANativeWindow* window = surface.get();
+    if (native_window_api_connect(window, NATIVE_WINDOW_API_CPU) != NO_ERROR ||
+        native_window_set_buffer_count(window, kMaxBatchSize + 2) != NO_ERROR ||
+        native_window_set_buffers_dimensions(window, kBufferSize, kBufferSize) != NO_ERROR ||
+        native_window_set_usage(window, AHARDWAREBUFFER_USAGE_CPU_WRITE_OFTEN) != NO_ERROR) {
+        state.SkipWithError("Unable to set up the surface.");
+        return nullptr;
+    }
+    return surface;
+}
+
+// Arguments: buffers per frame. Dequeues and queues the buffers one at a time.
+static void BM_Surface_DequeueQueue(benchmark::State& state) {
+    const auto count = static_cast<size_t>(state.range(0));
+    sp<Surface> surface = createSurface(state);
+    if (surface == nullptr) return;
+    ANativeWindow* window = surface.get();
+
+    for (auto _ : state) {
+        ANativeWindowBuffer* buffers[kMaxBatchSize];
+        int fences[kMaxBatchSize];
+        for (size_t i = 0; i < count; i++) {
+            if (UNLIKELY(window->dequeueBuffer(window, &buffers[i], &fences[i]) != NO_ERROR)) {
+                state.SkipWithError("Unable to dequeue buffer.");
+                return;
+            }
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (UNLIKELY(window->queueBuffer(window, buffers[i], fences[i]) != NO_ERROR)) {
+                state.SkipWithError("Unable to queue buffer.");
+                return;
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+    native_window_api_disconnect(window, NATIVE_WINDOW_API_CPU);
+}
+BENCHMARK(BM_Surface_DequeueQueue)->ArgNames({"buffers"})->Arg(1)->Arg(4)->Arg(kMaxBatchSize);
+
+// Arguments: buffers per frame. Dequeues and queues the buffers in one batch each.
+static void BM_Surface_DequeueQueueBatched(benchmark::State& state) {
+    const auto count = static_cast<size_t>(state.range(0));
+    sp<Surface> surface = createSurface(state);
+    if (surface == nullptr) return;
+    ANativeWindow* window = surface.get();
+
+    for (auto _ : state) {
+        ANativeWindowBuffer* buffers[kMaxBatchSize];
+        int fences[kMaxBatchSize];
+        if (UNLIKELY(native_window_dequeue_buffers(window, count, buffers, fences) != NO_ERROR)) {
+            state.SkipWithError("Unable to dequeue buffers.");
+            return;
+        }
+        if (UNLIKELY(native_window_queue_buffers(window, count, buffers, fences, nullptr) !=
+                     NO_ERROR)) {
+            state.SkipWithError("Unable to queue buffers.");
+            return;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+    native_window_api_disconnect(window, NATIVE_WINDOW_API_CPU);
+}
+BENCHMARK(BM_Surface_DequeueQueueBatched)
+        ->ArgNames({"buffers"})
+        ->Arg(1)
+        ->Arg(4)
+        ->Arg(kMaxBatchSize);
+
+BENCHMARK_MAIN();
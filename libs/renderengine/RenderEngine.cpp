@@ -20,6 +20,7 @@
 #include "skia/GaneshVkRenderEngine.h"
 #include "skia/GraphiteVkRenderEngine.h"
 #include "skia/SkiaGLRenderEngine.h"
+#include "skia/SkiaRasterRenderEngine.h"
 #include "threaded/RenderEngineThreaded.h"
 
 #include <com_android_graphics_surfaceflinger_flags.h>
@@ -44,18 +45,30 @@ std::unique_ptr<RenderEngine> RenderEngine::create(const RenderEngineCreationArg
 #if COMPILE_GRAPHITE_RENDERENGINE
     const RenderEngine::SkiaBackend actualSkiaBackend = args.skiaBackend;
 #else
+    RenderEngine::SkiaBackend actualSkiaBackend = args.skiaBackend;
     if (args.skiaBackend == RenderEngine::SkiaBackend::GRAPHITE) {
         ALOGE("RenderEngine with Graphite Skia backend was requested, but Graphite was not "
               "included in the build. Falling back to Ganesh (%s)",
               args.graphicsApi == RenderEngine::GraphicsApi::GL ? "GL" : "Vulkan");
+        actualSkiaBackend = RenderEngine::SkiaBackend::GANESH;
     }
-    const RenderEngine::SkiaBackend actualSkiaBackend = RenderEngine::SkiaBackend::GANESH;
 #endif
 
-    ALOGD("%sRenderEngine with %s Backend (%s)", args.threaded == Threaded::YES ? "Threaded " : "",
-          args.graphicsApi == GraphicsApi::GL ? "SkiaGL" : "SkiaVK",
-          actualSkiaBackend == SkiaBackend::GANESH ? "Ganesh" : "Graphite");
+    if (actualSkiaBackend == SkiaBackend::RASTER) {
+        ALOGD("%sRenderEngine with SkiaRaster Backend",
+              args.threaded == Threaded::YES ? "Threaded " : "");
+    } else {
+        ALOGD("%sRenderEngine with %s Backend (%s)",
+              args.threaded == Threaded::YES ? "Threaded " : "",
+              args.graphicsApi == GraphicsApi::GL ? "SkiaGL" : "SkiaVK",
+              actualSkiaBackend == SkiaBackend::GANESH ? "Ganesh" : "Graphite");
+    }
 
+    if (actualSkiaBackend == SkiaBackend::RASTER) {
+        createInstanceFactory = [args]() {
+            return android::renderengine::skia::SkiaRasterRenderEngine::create(args);
+        };
+    } else
 // TODO: b/341728634 - Clean up conditional compilation.
 #if COMPILE_GRAPHITE_RENDERENGINE
     if (actualSkiaBackend == SkiaBackend::GRAPHITE) {
@@ -65,7 +65,8 @@ std::pair<uint32_t, uint32_t> getDisplaySize() {
 }
 
 static std::unique_ptr<RenderEngine> createRenderEngine(RenderEngine::Threaded threaded,
-                                                        RenderEngine::GraphicsApi graphicsApi) {
+                                                        RenderEngine::GraphicsApi graphicsApi,
+                                                        RenderEngine::SkiaBackend skiaBackend) {
     auto args = RenderEngineCreationArgs::Builder()
                         .setPixelFormat(static_cast<int>(ui::PixelFormat::RGBA_8888))
                         .setImageCacheSize(1)
@@ -75,10 +76,18 @@ static std::unique_ptr<RenderEngine> createRenderEngine(RenderEngine::Threaded t
                         .setContextPriority(RenderEngine::ContextPriority::REALTIME)
                         .setThreaded(threaded)
                         .setGraphicsApi(graphicsApi)
+                        .setSkiaBackend(skiaBackend)
                         .build();
     return RenderEngine::create(args);
 }
 
+// The raster backend draws from and into buffers through the CPU.
+static uint64_t backendUsageFlags(RenderEngine::SkiaBackend skiaBackend) {
+    return skiaBackend == RenderEngine::SkiaBackend::RASTER
+            ? GRALLOC_USAGE_SW_READ_OFTEN | GRALLOC_USAGE_SW_WRITE_OFTEN
+            : 0;
+}
+
 static std::shared_ptr<ExternalTexture> allocateBuffer(RenderEngine& re, uint32_t width,
                                                        uint32_t height,
                                                        uint64_t extraUsageFlags = 0,
@@ -131,6 +140,25 @@ static std::shared_ptr<ExternalTexture> copyBuffer(RenderEngine& re,
     return texture;
 }
 
+/**
+ * Decodes the homescreen image into a display-sized buffer that is only accessible to the backend,
+ * for more realistic timing.
+ */
+static std::shared_ptr<ExternalTexture> decodeHomescreen(RenderEngine& re,
+                                                         uint64_t extraUsageFlags) {
+    // Initially use cpu access so we can decode into it with AImageDecoder.
+    auto [width, height] = getDisplaySize();
+    auto srcBuffer = allocateBuffer(re, width, height,
+                                    GRALLOC_USAGE_SW_WRITE_OFTEN | extraUsageFlags,
+                                    "decoded_source");
+    std::string srcImage = base::GetExecutableDirectory();
+    srcImage.append("/resources/homescreen.png");
+    renderenginebench::decode(srcImage.c_str(), srcBuffer->getBuffer());
+
+    // Now copy into GPU-only buffer for more realistic timing.
+    return copyBuffer(re, srcBuffer, extraUsageFlags, "source");
+}
+
 /**
  * Helper for timing calls to drawLayers.
  *
@@ -142,9 +170,10 @@ static std::shared_ptr<ExternalTexture> copyBuffer(RenderEngine& re,
  * outside of the for loop is excluded from the timing measurements.
  */
 static void benchDrawLayers(RenderEngine& re, const std::vector<LayerSettings>& layers,
-                            benchmark::State& benchState, const char* saveFileName) {
+                            benchmark::State& benchState, const char* saveFileName,
+                            uint64_t extraUsageFlags = 0) {
     auto [width, height] = getDisplaySize();
-    auto outputBuffer = allocateBuffer(re, width, height);
+    auto outputBuffer = allocateBuffer(re, width, height, extraUsageFlags);
 
     const Rect displayRect(0, 0, static_cast<int32_t>(width), static_cast<int32_t>(height));
     DisplaySettings display{
@@ -162,7 +191,8 @@ static void benchDrawLayers(RenderEngine& re, const std::vector<LayerSettings>&
 
     if (renderenginebench::save() && saveFileName) {
         // Copy to a CPU-accessible buffer so we can encode it.
-        outputBuffer = copyBuffer(re, outputBuffer, GRALLOC_USAGE_SW_READ_OFTEN, "to_encode");
+        outputBuffer = copyBuffer(re, outputBuffer, GRALLOC_USAGE_SW_READ_OFTEN | extraUsageFlags,
+                                  "to_encode");
 
         std::string outFile = base::GetExecutableDirectory();
         outFile.append("/");
@@ -179,22 +209,14 @@ static void benchDrawLayers(RenderEngine& re, const std::vector<LayerSettings>&
 template <class... Args>
 void BM_blur(benchmark::State& benchState, Args&&... args) {
     auto args_tuple = std::make_tuple(std::move(args)...);
+    const auto skiaBackend = static_cast<RenderEngine::SkiaBackend>(std::get<2>(args_tuple));
     auto re = createRenderEngine(static_cast<RenderEngine::Threaded>(std::get<0>(args_tuple)),
-                                 static_cast<RenderEngine::GraphicsApi>(std::get<1>(args_tuple)));
+                                 static_cast<RenderEngine::GraphicsApi>(std::get<1>(args_tuple)),
+                                 skiaBackend);
+    const uint64_t usageFlags = backendUsageFlags(skiaBackend);
+    auto srcBuffer = decodeHomescreen(*re, usageFlags);
 
-    // Initially use cpu access so we can decode into it with AImageDecoder.
     auto [width, height] = getDisplaySize();
-    auto srcBuffer =
-            allocateBuffer(*re, width, height, GRALLOC_USAGE_SW_WRITE_OFTEN, "decoded_source");
-    {
-        std::string srcImage = base::GetExecutableDirectory();
-        srcImage.append("/resources/homescreen.png");
-        renderenginebench::decode(srcImage.c_str(), srcBuffer->getBuffer());
-
-        // Now copy into GPU-only buffer for more realistic timing.
-        srcBuffer = copyBuffer(*re, srcBuffer, 0, "source");
-    }
-
     const FloatRect layerRect(0, 0, width, height);
     LayerSettings layer{
             .geometry =
@@ -221,8 +243,65 @@ void BM_blur(benchmark::State& benchState, Args&&... args) {
     };
 
     auto layers = std::vector<LayerSettings>{layer, blurLayer};
-    benchDrawLayers(*re, layers, benchState, "blurred");
+    benchDrawLayers(*re, layers, benchState, "blurred", usageFlags);
 }
 
 BENCHMARK_CAPTURE(BM_blur, SkiaGLThreaded, RenderEngine::Threaded::YES,
-                  RenderEngine::GraphicsApi::GL);
+                  RenderEngine::GraphicsApi::GL, RenderEngine::SkiaBackend::GANESH);
+BENCHMARK_CAPTURE(BM_blur, SkiaRasterThreaded, RenderEngine::Threaded::YES,
+                  RenderEngine::GraphicsApi::GL, RenderEngine::SkiaBackend::RASTER);
+
+// Composition without any effect that reads back the output, which the raster backend can split
+// between threads.
+template <class... Args>
+void BM_composite(benchmark::State& benchState, Args&&... args) {
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    const auto skiaBackend = static_cast<RenderEngine::SkiaBackend>(std::get<2>(args_tuple));
+    auto re = createRenderEngine(static_cast<RenderEngine::Threaded>(std::get<0>(args_tuple)),
+                                 static_cast<RenderEngine::GraphicsApi>(std::get<1>(args_tuple)),
+                                 skiaBackend);
+    const uint64_t usageFlags = backendUsageFlags(skiaBackend);
+    auto srcBuffer = decodeHomescreen(*re, usageFlags);
+
+    auto [width, height] = getDisplaySize();
+    const FloatRect layerRect(0, 0, width, height);
+    LayerSettings layer{
+            .geometry =
+                    Geometry{
+                            .boundaries = layerRect,
+                    },
+            .source =
+                    PixelSource{
+                            .buffer =
+                                    Buffer{
+                                            .buffer = srcBuffer,
+                                    },
+                    },
+            .alpha = half(1.0f),
+    };
+    const FloatRect windowRect(width / 8.f, height / 4.f, width * 7.f / 8.f, height * 3.f / 4.f);
+    LayerSettings window{
+            .geometry =
+                    Geometry{
+                            .boundaries = windowRect,
+                            .roundedCornersRadius = vec2(40.f, 40.f),
+                            .roundedCornersCrop = windowRect,
+                    },
+            .source =
+                    PixelSource{
+                            .buffer =
+                                    Buffer{
+                                            .buffer = srcBuffer,
+                                    },
+                    },
+            .alpha = half(0.8f),
+    };
+
+    auto layers = std::vector<LayerSettings>{layer, window};
+    benchDrawLayers(*re, layers, benchState, "composited", usageFlags);
+}
+
+BENCHMARK_CAPTURE(BM_composite, SkiaGLThreaded, RenderEngine::Threaded::YES,
+                  RenderEngine::GraphicsApi::GL, RenderEngine::SkiaBackend::GANESH);
+BENCHMARK_CAPTURE(BM_composite, SkiaRasterThreaded, RenderEngine::Threaded::YES,
+                  RenderEngine::GraphicsApi::GL, RenderEngine::SkiaBackend::RASTER);
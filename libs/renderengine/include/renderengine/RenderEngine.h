@@ -54,6 +54,12 @@
  */
 #define PROPERTY_DEBUG_RENDERENGINE_BLUR_ALGORITHM "debug.renderengine.blur_algorithm"
 
+/**
+ * Number of threads that SkiaBackend::RASTER draws each frame with, including the RenderEngine
+ * thread. Defaults to the number of cores, up to 4.
+ */
+#define PROPERTY_DEBUG_RENDERENGINE_RASTER_THREADS "debug.renderengine.raster_threads"
+
 /**
  * Allows recording of Skia drawing commands with systrace.
  */
@@ -125,6 +131,9 @@ public:
     enum class SkiaBackend {
         GANESH,
         GRAPHITE,
+        // Skia's CPU backend, for headless composition and devices without a usable GPU. The
+        // GraphicsApi is ignored, and buffers must be CPU accessible.
+        RASTER,
     };
 
     enum class BlurAlgorithm {
@@ -0,0 +1,250 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "SkiaRasterRenderEngine.h"
+
+#undef LOG_TAG
+#define LOG_TAG "RenderEngine"
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+
+#include <include/core/SkCanvas.h>
+#include <include/core/SkPicture.h>
+#include <include/core/SkPixmap.h>
+#include <include/core/SkSurface.h>
+
+#include "compat/RasterBackendTexture.h"
+#include "compat/RasterGpuContext.h"
+
+#include <android-base/properties.h>
+#include <android-base/stringprintf.h>
+#include <android/hardware_buffer.h>
+#include <gui/TraceUtils.h>
+#include <log/log_main.h>
+#include <pthread.h>
+#include <sync/sync.h>
+#include <sys/resource.h>
+#include <system/thread_defs.h>
+#include <ui/GraphicBuffer.h>
+#include <utils/Trace.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+
+namespace android::renderengine::skia {
+
+using base::StringAppendF;
+
+namespace {
+
+constexpr int kMaxThreads = 16;
+// Bands shorter than this cost more to set up than they save
+constexpr int kMinBandHeight = 64;
+
+int getThreadCount() {
+    const int defaultThreadCount =
+            std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1, 4);
+    return std::clamp(base::GetIntProperty(PROPERTY_DEBUG_RENDERENGINE_RASTER_THREADS,
+                                           defaultThreadCount),
+                      1, kMaxThreads);
+}
+
+} // namespace
+
+std::unique_ptr<SkiaRasterRenderEngine> SkiaRasterRenderEngine::create(
+        const RenderEngineCreationArgs& args) {
+    std::unique_ptr<SkiaRasterRenderEngine> engine(
+            new SkiaRasterRenderEngine(args, getThreadCount()));
+    engine->ensureContextsCreated();
+    ALOGD("SkiaRasterRenderEngine::%s: drawing with %zu threads", __func__,
+          engine->mWorkers.size() + 1);
+    return engine;
+}
+
+SkiaRasterRenderEngine::SkiaRasterRenderEngine(const RenderEngineCreationArgs& args,
+                                               int threadCount)
+      : SkiaRenderEngine(args.threaded, static_cast<PixelFormat>(args.pixelFormat),
+                         args.blurAlgorithm) {
+    // The RenderEngine thread draws too, so it needs one less worker
+    for (int i = 0; i < threadCount - 1; i++) {
+        mWorkers.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+SkiaRasterRenderEngine::~SkiaRasterRenderEngine() {
+    finishRenderingAndAbandonContexts();
+    {
+        std::lock_guard lock(mWorkMutex);
+        mStopWorkers = true;
+    }
+    mWorkCondition.notify_all();
+    for (auto& worker : mWorkers) {
+        worker.join();
+    }
+}
+
+SkiaRenderEngine::Contexts SkiaRasterRenderEngine::createContexts() {
+    return {SkiaGpuContext::MakeRaster(), nullptr};
+}
+
+void SkiaRasterRenderEngine::waitFence(SkiaGpuContext*, base::borrowed_fd fenceFd) {
+    if (fenceFd.get() < 0) return;
+
+    // Buffers are read and written by the CPU as soon as they're needed, so wait right away
+    ATRACE_NAME("waitFence");
+    sync_wait(fenceFd.get(), -1);
+}
+
+void SkiaRasterRenderEngine::validateInputBuffer(const sp<GraphicBuffer>& buffer) {
+    LOG_ALWAYS_FATAL_IF(!(buffer->getUsage() & GraphicBuffer::USAGE_SW_READ_MASK),
+                        "input buffer not cpu readable");
+}
+
+void SkiaRasterRenderEngine::validateOutputBuffer(const sp<GraphicBuffer>& buffer) {
+    LOG_ALWAYS_FATAL_IF(!(buffer->getUsage() & GraphicBuffer::USAGE_SW_WRITE_MASK),
+                        "output buffer not cpu writeable");
+}
+
+SkCanvas* SkiaRasterRenderEngine::beginRecording(const sk_sp<SkSurface>& dstSurface) {
+    if (mWorkers.empty()) {
+        // Nothing to gain from replaying a recording on a single thread
+        return nullptr;
+    }
+    return mRecorder.beginRecording(SkRect::MakeIWH(dstSurface->width(), dstSurface->height()));
+}
+
+base::unique_fd SkiaRasterRenderEngine::flushAndSubmit(SkiaGpuContext* context,
+                                                       sk_sp<SkSurface> dstSurface) {
+    ATRACE_CALL();
+    sk_sp<SkPicture> picture;
+    if (mRecorder.getRecordingCanvas() != nullptr) {
+        picture = mRecorder.finishRecordingAsPicture();
+    }
+
+    // Only SkiaGpuContext::MakeRaster is ever used by this engine
+    AHardwareBuffer* buffer =
+            static_cast<RasterGpuContext*>(context)->getOutputBuffer(dstSurface.get());
+    LOG_ALWAYS_FATAL_IF(buffer == nullptr, "No output buffer for surface %p", dstSurface.get());
+
+    AHardwareBuffer_Desc desc;
+    AHardwareBuffer_describe(buffer, &desc);
+    void* pixels = nullptr;
+    if (const int result = AHardwareBuffer_lock(buffer, AHARDWAREBUFFER_USAGE_CPU_WRITE_OFTEN, -1,
+                                                nullptr, &pixels);
+        result != 0) {
+        ALOGE("Failed to lock output buffer for writing: %d", result);
+        return {};
+    }
+
+    const SkImageInfo& info = dstSurface->imageInfo();
+    const SkPixmap dst(info, pixels, desc.stride * info.bytesPerPixel());
+    if (picture) {
+        drawBands(*picture, dst);
+        mTiledFrames++;
+    } else {
+        ATRACE_NAME("copy to output buffer");
+        ALOGE_IF(!dstSurface->readPixels(dst, 0, 0), "Failed to copy frame to output buffer");
+        // The next frame starts over, so don't hold on to this one's pages in the meantime
+        if (SkPixmap surfacePixels; dstSurface->peekPixels(&surfacePixels)) {
+            RasterBackendTexture::releaseSurfacePixels(surfacePixels);
+        }
+        mDirectFrames++;
+    }
+    AHardwareBuffer_unlock(buffer, nullptr);
+
+    // All the work is done by now
+    return {};
+}
+
+void SkiaRasterRenderEngine::drawBands(const SkPicture& picture, const SkPixmap& dst) {
+    const int bandCount =
+            std::clamp(dst.height() / kMinBandHeight, 1, static_cast<int>(mWorkers.size()) + 1);
+    ATRACE_FORMAT("%s: %d bands", __func__, bandCount);
+
+    std::atomic<int> nextBand = 0;
+    runOnAllThreads([&] {
+        for (int band = nextBand++; band < bandCount; band = nextBand++) {
+            const int top = dst.height() * band / bandCount;
+            const int bottom = dst.height() * (band + 1) / bandCount;
+            SkPixmap bandPixels;
+            if (!dst.extractSubset(&bandPixels, SkIRect::MakeLTRB(0, top, dst.width(), bottom))) {
+                continue;
+            }
+            std::unique_ptr<SkCanvas> canvas =
+                    SkCanvas::MakeRasterDirect(bandPixels.info(), bandPixels.writable_addr(),
+                                               bandPixels.rowBytes());
+            LOG_ALWAYS_FATAL_IF(!canvas, "Failed to wrap output buffer band [%d, %d)", top,
+                                bottom);
+            canvas->translate(0, -top);
+            picture.playback(canvas.get());
+        }
+    });
+}
+
+void SkiaRasterRenderEngine::runOnAllThreads(const std::function<void()>& work) {
+    {
+        std::lock_guard lock(mWorkMutex);
+        mWork = &work;
+        mWorkGeneration++;
+        mBusyWorkers = mWorkers.size();
+    }
+    mWorkCondition.notify_all();
+
+    work();
+
+    std::unique_lock lock(mWorkMutex);
+    mWorkDoneCondition.wait(lock, [this] { return mBusyWorkers == 0; });
+    mWork = nullptr;
+}
+
+void SkiaRasterRenderEngine::workerLoop(int index) {
+    std::array<char, 16> name;
+    snprintf(name.data(), name.size(), "reRaster%d", index);
+    pthread_setname_np(pthread_self(), name.data());
+    setpriority(PRIO_PROCESS, 0, ANDROID_PRIORITY_URGENT_DISPLAY);
+
+    uint64_t generation = 0;
+    std::unique_lock lock(mWorkMutex);
+    while (true) {
+        mWorkCondition.wait(lock,
+                            [&] { return mStopWorkers || mWorkGeneration != generation; });
+        if (mStopWorkers) {
+            return;
+        }
+        generation = mWorkGeneration;
+        const std::function<void()>& work = *mWork;
+
+        lock.unlock();
+        work();
+        lock.lock();
+
+        if (--mBusyWorkers == 0) {
+            mWorkDoneCondition.notify_one();
+        }
+    }
+}
+
+void SkiaRasterRenderEngine::appendBackendSpecificInfoToDump(std::string& result) {
+    StringAppendF(&result, "\n ------------RE Raster----------\n");
+    StringAppendF(&result, "\n Threads: %zu\n", mWorkers.size() + 1);
+    StringAppendF(&result, "\n Frames drawn in bands: %" PRIu64 ", directly: %" PRIu64 "\n",
+                  mTiledFrames, mDirectFrames);
+}
+
+} // namespace android::renderengine::skia
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <include/core/SkPictureRecorder.h>
+
+#include "SkiaRenderEngine.h"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class SkPicture;
+class SkPixmap;
+
+namespace android::renderengine::skia {
+
+/**
+ * RenderEngine drawing with Skia's CPU backend, for headless composition and screen capture on
+ * devices without a usable GPU. Input and output buffers must be CPU accessible.
+ *
+ * Frames are recorded into an SkPicture, which flushAndSubmit plays back into horizontal bands of
+ * the output buffer on several threads at once. Frames that read back what they drew, such as
+ * frames with blurs, are drawn directly on the RenderEngine thread instead.
+ */
+class SkiaRasterRenderEngine : public SkiaRenderEngine {
+public:
+    static std::unique_ptr<SkiaRasterRenderEngine> create(const RenderEngineCreationArgs& args);
+    ~SkiaRasterRenderEngine() override;
+
+    // There are no GPU shaders or pipelines to compile ahead of time.
+    std::future<void> primeCache(PrimeCacheConfig config) override { return {}; }
+    int getContextPriority() override { return 0; }
+
+protected:
+    Contexts createContexts() override;
+    bool supportsProtectedContentImpl() const override { return false; }
+    bool useProtectedContextImpl(GrProtected isProtected) override {
+        return isProtected == GrProtected::kNo;
+    }
+    void waitFence(SkiaGpuContext* context, base::borrowed_fd fenceFd) override;
+    base::unique_fd flushAndSubmit(SkiaGpuContext* context, sk_sp<SkSurface> dstSurface) override;
+    void appendBackendSpecificInfoToDump(std::string& result) override;
+
+    void validateInputBuffer(const sp<GraphicBuffer>& buffer) override;
+    void validateOutputBuffer(const sp<GraphicBuffer>& buffer) override;
+    SkCanvas* beginRecording(const sk_sp<SkSurface>& dstSurface) override;
+
+private:
+    SkiaRasterRenderEngine(const RenderEngineCreationArgs& args, int threadCount);
+
+    // Plays the picture back into dst, one band at a time on each thread.
+    void drawBands(const SkPicture& picture, const SkPixmap& dst);
+    // Runs work on every worker and on the calling thread, and waits for all of them to finish.
+    void runOnAllThreads(const std::function<void()>& work);
+    void workerLoop(int index);
+
+    SkPictureRecorder mRecorder;
+
+    std::vector<std::thread> mWorkers;
+    std::mutex mWorkMutex;
+    std::condition_variable mWorkCondition;
+    std::condition_variable mWorkDoneCondition;
+    // Guarded by mWorkMutex
+    const std::function<void()>* mWork = nullptr;
+    uint64_t mWorkGeneration = 0;
+    size_t mBusyWorkers = 0;
+    bool mStopWorkers = false;
+
+    uint64_t mTiledFrames = 0;
+    uint64_t mDirectFrames = 0;
+};
+
+} // namespace android::renderengine::skia
@@ -66,6 +66,7 @@
 #include <ui/HdrRenderTypeUtils.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <deque>
@@ -693,7 +694,7 @@ void SkiaRenderEngine::drawLayersInternal(
         return;
     }
 
-    validateOutputBufferUsage(buffer->getBuffer());
+    validateOutputBuffer(buffer->getBuffer());
 
     auto context = getActiveContext();
     LOG_ALWAYS_FATAL_IF(context->isAbandonedOrDeviceLost(),
@@ -716,6 +717,16 @@ void SkiaRenderEngine::drawLayersInternal(
         return;
     }
 
+    const bool readsBackDstSurface = mBlurFilter &&
+            std::any_of(layers.cbegin(), layers.cend(), [](const LayerSettings& layer) {
+                return layer.backgroundBlurRadius > 0 || !layer.blurRegions.empty();
+            });
+    if (!readsBackDstSurface && !mCapture->isCaptureRunning()) {
+        if (SkCanvas* recordingCanvas = beginRecording(dstSurface)) {
+            dstCanvas = recordingCanvas;
+        }
+    }
+
     // setup color filter if necessary
     sk_sp<SkColorFilter> displayColorTransform;
     if (display.colorTransform != mat4() && !display.deviceHandlesColorTransform) {
@@ -966,7 +977,7 @@ void SkiaRenderEngine::drawLayersInternal(
         SkPaint paint;
         if (layer.source.buffer.buffer) {
             ATRACE_NAME("DrawImage");
-            validateInputBufferUsage(layer.source.buffer.buffer->getBuffer());
+            validateInputBuffer(layer.source.buffer.buffer->getBuffer());
             const auto& item = layer.source.buffer;
             auto imageTextureRef = getOrCreateBackendTexture(item.buffer->getBuffer(), false);
 
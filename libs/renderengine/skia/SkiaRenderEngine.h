@@ -62,7 +62,7 @@ public:
     SkiaRenderEngine(Threaded, PixelFormat pixelFormat, BlurAlgorithm);
     ~SkiaRenderEngine() override;
 
-    std::future<void> primeCache(PrimeCacheConfig config) override final;
+    std::future<void> primeCache(PrimeCacheConfig config) override;
     void cleanupPostRender() override final;
     bool supportsBackgroundBlur() override final {
         return mBlurFilter != nullptr;
@@ -93,6 +93,20 @@ protected:
                                            sk_sp<SkSurface> dstSurface) = 0;
     virtual void appendBackendSpecificInfoToDump(std::string& result) = 0;
 
+    // Backends that don't sample or render through the GPU may accept other buffer usages.
+    virtual void validateInputBuffer(const sp<GraphicBuffer>& buffer) {
+        validateInputBufferUsage(buffer);
+    }
+    virtual void validateOutputBuffer(const sp<GraphicBuffer>& buffer) {
+        validateOutputBufferUsage(buffer);
+    }
+
+    // Lets a backend record the frame instead of drawing it into dstSurface directly, and replay
+    // the recording from flushAndSubmit. Returns the canvas to record into, or nullptr to draw
+    // directly. Not called for frames that read back from dstSurface, such as blurs, nor while a
+    // capture is running.
+    virtual SkCanvas* beginRecording(const sk_sp<SkSurface>& dstSurface) { return nullptr; }
+
     size_t getMaxTextureSize() const override final;
     size_t getMaxViewportDims() const override final;
     // TODO: b/293371537 - Return reference instead of pointer? (Cleanup)
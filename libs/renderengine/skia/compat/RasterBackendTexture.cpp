@@ -0,0 +1,183 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "RasterBackendTexture.h"
+
+#undef LOG_TAG
+#define LOG_TAG "RenderEngine"
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+
+#include <include/core/SkImage.h>
+#include <include/core/SkPixmap.h>
+#include <include/core/SkSurface.h>
+
+#include "RasterGpuContext.h"
+#include "skia/ColorSpaces.h"
+
+#include <log/log_main.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utils/Trace.h>
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstring>
+
+namespace android::renderengine::skia {
+
+struct RasterBackendTexture::ImageRelease {
+    std::unique_ptr<uint8_t[]> pixels;
+    TextureReleaseProc releaseProc;
+    ReleaseContext releaseContext;
+};
+
+struct RasterBackendTexture::SurfaceRelease {
+    RasterGpuContext& context;
+    const SkSurface* surface;
+    TextureReleaseProc releaseProc;
+    ReleaseContext releaseContext;
+};
+
+RasterBackendTexture::RasterBackendTexture(RasterGpuContext& context, AHardwareBuffer* buffer,
+                                           bool isOutputBuffer)
+      : SkiaBackendTexture(buffer, isOutputBuffer), mContext(context), mBuffer(buffer) {
+    // The buffer is locked whenever an image or a frame is copied, so it must outlive us
+    AHardwareBuffer_acquire(mBuffer);
+    AHardwareBuffer_describe(mBuffer, &mDesc);
+}
+
+RasterBackendTexture::~RasterBackendTexture() {
+    if (mSurfacePixels != nullptr) {
+        munmap(mSurfacePixels, mSurfacePixelsSize);
+    }
+    AHardwareBuffer_release(mBuffer);
+}
+
+bool RasterBackendTexture::isSupportedFormat(uint32_t format) {
+    // Formats whose memory layout matches the SkColorType that GrAHardwareBufferUtils maps them
+    // to. Others, such as YUV formats, can only be sampled through the GPU.
+    switch (format) {
+        case AHARDWAREBUFFER_FORMAT_R8G8B8A8_UNORM:
+        case AHARDWAREBUFFER_FORMAT_R8G8B8X8_UNORM:
+        case AHARDWAREBUFFER_FORMAT_R16G16B16A16_FLOAT:
+        case AHARDWAREBUFFER_FORMAT_R5G6B5_UNORM:
+        case AHARDWAREBUFFER_FORMAT_R10G10B10A2_UNORM:
+        case AHARDWAREBUFFER_FORMAT_R8_UNORM:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void RasterBackendTexture::releaseSurfacePixels(const SkPixmap& pixels) {
+    ATRACE_CALL();
+    // Surface pixels are page aligned, as they're mapped by makeSurface
+    if (madvise(pixels.writable_addr(), pixels.computeByteSize(), MADV_DONTNEED) != 0) {
+        ALOGW("Failed to release output surface pixels: %s", strerror(errno));
+    }
+}
+
+SkImageInfo RasterBackendTexture::makeInfo(SkColorType colorType, SkAlphaType alphaType,
+                                           ui::Dataspace dataspace) const {
+    return SkImageInfo::Make(static_cast<int>(mDesc.width), static_cast<int>(mDesc.height),
+                             colorType, alphaType, toSkColorSpace(dataspace));
+}
+
+void RasterBackendTexture::releaseImage(const void*, void* context) {
+    ImageRelease* release = static_cast<ImageRelease*>(context);
+    release->releaseProc(release->releaseContext);
+    delete release;
+}
+
+void RasterBackendTexture::releaseSurface(void*, void* context) {
+    SurfaceRelease* release = static_cast<SurfaceRelease*>(context);
+    release->context.unregisterOutputSurface(release->surface);
+    release->releaseProc(release->releaseContext);
+    delete release;
+}
+
+sk_sp<SkImage> RasterBackendTexture::makeImage(SkAlphaType alphaType, ui::Dataspace dataspace,
+                                               TextureReleaseProc releaseImageProc,
+                                               ReleaseContext releaseContext) {
+    ATRACE_CALL();
+    const SkImageInfo info = makeInfo(colorTypeForImage(alphaType), alphaType, dataspace);
+    const size_t rowBytes = info.minRowBytes();
+    const size_t size = info.computeByteSize(rowBytes);
+    auto* release = new ImageRelease{std::unique_ptr<uint8_t[]>(new uint8_t[size]),
+                                     releaseImageProc, releaseContext};
+
+    void* bufferPixels = nullptr;
+    int result = -1;
+    if (isSupportedFormat(mDesc.format)) {
+        result = AHardwareBuffer_lock(mBuffer, AHARDWAREBUFFER_USAGE_CPU_READ_OFTEN, -1, nullptr,
+                                      &bufferPixels);
+    }
+    if (result == 0) {
+        const size_t bufferRowBytes = mDesc.stride * info.bytesPerPixel();
+        for (int y = 0; y < info.height(); y++) {
+            std::memcpy(release->pixels.get() + y * rowBytes,
+                        static_cast<const uint8_t*>(bufferPixels) + y * bufferRowBytes, rowBytes);
+        }
+        AHardwareBuffer_unlock(mBuffer, nullptr);
+    } else {
+        // Draw nothing rather than garbage
+        ALOGE("Unable to read buffer of format %u, usage %#" PRIx64 " from the CPU: %d",
+              mDesc.format, mDesc.usage, result);
+        std::memset(release->pixels.get(), 0, size);
+    }
+
+    const SkPixmap pixmap(info, release->pixels.get(), rowBytes);
+    sk_sp<SkImage> image = SkImages::RasterFromPixmap(pixmap, releaseImage, release);
+    LOG_ALWAYS_FATAL_IF(!image, "Unable to generate SkImage. [%p]:[%u,%u] dataspace:%d colorType:%d",
+                        this, mDesc.width, mDesc.height, static_cast<int32_t>(dataspace),
+                        info.colorType());
+    return image;
+}
+
+sk_sp<SkSurface> RasterBackendTexture::makeSurface(ui::Dataspace dataspace,
+                                                   TextureReleaseProc releaseSurfaceProc,
+                                                   ReleaseContext releaseContext) {
+    ATRACE_CALL();
+    LOG_ALWAYS_FATAL_IF(!isSupportedFormat(mDesc.format),
+                        "Unable to render to buffer of format %u from the CPU", mDesc.format);
+
+    const SkImageInfo info = makeInfo(internalColorType(), kPremul_SkAlphaType, dataspace);
+    if (mSurfacePixels == nullptr) {
+        // Pages are only committed when a frame is drawn into the surface directly. Frames that
+        // SkiaRasterRenderEngine plays back straight into the buffer never write to them.
+        mSurfacePixelsSize = info.computeMinByteSize();
+        mSurfacePixels = mmap(nullptr, mSurfacePixelsSize, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        LOG_ALWAYS_FATAL_IF(mSurfacePixels == MAP_FAILED,
+                            "Unable to map %zu bytes for SkSurface [%p]:[%u,%u]: %s",
+                            mSurfacePixelsSize, this, mDesc.width, mDesc.height, strerror(errno));
+    }
+
+    auto* release = new SurfaceRelease{mContext, nullptr, releaseSurfaceProc, releaseContext};
+    sk_sp<SkSurface> surface = SkSurfaces::WrapPixels(info, mSurfacePixels, info.minRowBytes(),
+                                                      releaseSurface, release);
+    LOG_ALWAYS_FATAL_IF(!surface,
+                        "Unable to generate SkSurface. [%p]:[%u,%u] dataspace:%d colorType:%d",
+                        this, mDesc.width, mDesc.height, static_cast<int32_t>(dataspace),
+                        info.colorType());
+
+    release->surface = surface.get();
+    mContext.registerOutputSurface(surface.get(), mBuffer);
+    return surface;
+}
+
+} // namespace android::renderengine::skia
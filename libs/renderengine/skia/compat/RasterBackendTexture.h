@@ -0,0 +1,86 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "SkiaBackendTexture.h"
+#include "ui/GraphicTypes.h"
+
+#include <include/core/SkImageInfo.h>
+
+#include <android-base/macros.h>
+#include <android/hardware_buffer.h>
+
+#include <memory>
+
+class SkPixmap;
+
+namespace android::renderengine::skia {
+
+class RasterGpuContext;
+
+/**
+ * SkiaBackendTexture for Skia's CPU backend.
+ *
+ * Buffers are only locked for as long as it takes to copy them: images are drawn from a copy of
+ * the buffer made when they are created, and surfaces are backed by anonymous memory that
+ * SkiaRasterRenderEngine copies into the buffer when flushing. This keeps producers and the
+ * display from ever waiting on a buffer that is locked for a whole frame.
+ *
+ * Most frames are played back straight into the buffer and never touch the surface's pixels, so
+ * that memory is mapped without being committed: it only takes up pages while a frame is drawn
+ * into it directly, and releaseSurfacePixels gives them back once the frame is copied out.
+ */
+class RasterBackendTexture : public SkiaBackendTexture {
+public:
+    RasterBackendTexture(RasterGpuContext& context, AHardwareBuffer* buffer, bool isOutputBuffer);
+    ~RasterBackendTexture() override;
+
+    sk_sp<SkImage> makeImage(SkAlphaType alphaType, ui::Dataspace dataspace,
+                             TextureReleaseProc releaseImageProc,
+                             ReleaseContext releaseContext) override;
+
+    sk_sp<SkSurface> makeSurface(ui::Dataspace dataspace, TextureReleaseProc releaseSurfaceProc,
+                                 ReleaseContext releaseContext) override;
+
+    // Whether Skia's CPU backend can read and write buffers of this format in place.
+    static bool isSupportedFormat(uint32_t format);
+
+    // Returns the pages of an output surface's pixels to the system. They read as zeroes after.
+    static void releaseSurfacePixels(const SkPixmap& pixels);
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(RasterBackendTexture);
+
+    struct ImageRelease;
+    struct SurfaceRelease;
+    static void releaseImage(const void* pixels, void* context);
+    static void releaseSurface(void* pixels, void* context);
+
+    SkImageInfo makeInfo(SkColorType colorType, SkAlphaType alphaType,
+                         ui::Dataspace dataspace) const;
+
+    RasterGpuContext& mContext;
+    AHardwareBuffer* const mBuffer;
+    AHardwareBuffer_Desc mDesc;
+    // Drawn into by output surfaces. AutoBackendTexture only keeps the latest one, so they share it.
+    // Mapped on the first makeSurface, and only committed by the frames that write into it.
+    void* mSurfacePixels = nullptr;
+    size_t mSurfacePixelsSize = 0;
+};
+
+} // namespace android::renderengine::skia
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "RasterGpuContext.h"
+
+#include <include/core/SkGraphics.h>
+#include <include/core/SkImageInfo.h>
+#include <include/core/SkSurface.h>
+
+#include "RasterBackendTexture.h"
+
+#include <log/log_main.h>
+
+namespace android::renderengine::skia {
+
+std::unique_ptr<SkiaGpuContext> SkiaGpuContext::MakeRaster() {
+    return std::make_unique<RasterGpuContext>();
+}
+
+RasterGpuContext::~RasterGpuContext() {
+    ALOGW_IF(!mOutputBuffers.empty(), "%zu output surfaces outlived their RasterGpuContext",
+             mOutputBuffers.size());
+}
+
+std::unique_ptr<SkiaBackendTexture> RasterGpuContext::makeBackendTexture(AHardwareBuffer* buffer,
+                                                                         bool isOutputBuffer) {
+    return std::make_unique<RasterBackendTexture>(*this, buffer, isOutputBuffer);
+}
+
+sk_sp<SkSurface> RasterGpuContext::createRenderTarget(SkImageInfo imageInfo) {
+    return SkSurfaces::Raster(imageInfo);
+}
+
+void RasterGpuContext::dumpMemoryStatistics(SkTraceMemoryDump* traceMemoryDump) const {
+    // Raster surfaces and images aren't cached, so only Skia's global caches hold memory
+    SkGraphics::DumpMemoryStatistics(traceMemoryDump);
+}
+
+void RasterGpuContext::registerOutputSurface(const SkSurface* surface, AHardwareBuffer* buffer) {
+    mOutputBuffers[surface] = buffer;
+}
+
+void RasterGpuContext::unregisterOutputSurface(const SkSurface* surface) {
+    mOutputBuffers.erase(surface);
+}
+
+AHardwareBuffer* RasterGpuContext::getOutputBuffer(const SkSurface* surface) const {
+    const auto it = mOutputBuffers.find(surface);
+    return it == mOutputBuffers.end() ? nullptr : it->second;
+}
+
+} // namespace android::renderengine::skia
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "SkiaGpuContext.h"
+
+#include <android-base/macros.h>
+#include <android/hardware_buffer.h>
+
+#include <unordered_map>
+
+namespace android::renderengine::skia {
+
+/**
+ * SkiaGpuContext for Skia's CPU backend. There is no GPU state to manage, so this mostly keeps
+ * track of which AHardwareBuffer each output SkSurface stands for: output surfaces are backed by
+ * anonymous memory, which SkiaRasterRenderEngine copies into the buffer once the frame is drawn.
+ */
+class RasterGpuContext : public SkiaGpuContext {
+public:
+    // Generous for CPU rendering, which is bounded by memory rather than by a device limit.
+    static constexpr size_t kMaxSize = 16384;
+
+    RasterGpuContext() = default;
+    ~RasterGpuContext() override;
+
+    std::unique_ptr<SkiaBackendTexture> makeBackendTexture(AHardwareBuffer* buffer,
+                                                           bool isOutputBuffer) override;
+
+    sk_sp<SkSurface> createRenderTarget(SkImageInfo imageInfo) override;
+
+    size_t getMaxRenderTargetSize() const override { return kMaxSize; }
+    size_t getMaxTextureSize() const override { return kMaxSize; }
+    bool isAbandonedOrDeviceLost() override { return false; }
+    void setResourceCacheLimit(size_t maxResourceBytes) override {}
+
+    void purgeUnlockedScratchResources() override {}
+    void resetContextIfApplicable() override {}
+
+    void dumpMemoryStatistics(SkTraceMemoryDump* traceMemoryDump) const override;
+
+    void registerOutputSurface(const SkSurface* surface, AHardwareBuffer* buffer);
+    void unregisterOutputSurface(const SkSurface* surface);
+
+    // Returns the buffer that the output surface's pixels must be copied to, or nullptr if the
+    // surface wasn't created for an output buffer.
+    AHardwareBuffer* getOutputBuffer(const SkSurface* surface) const;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(RasterGpuContext);
+
+    std::unordered_map<const SkSurface*, AHardwareBuffer*> mOutputBuffers;
+};
+
+} // namespace android::renderengine::skia
@@ -65,6 +65,11 @@ public:
     static std::unique_ptr<SkiaGpuContext> MakeVulkan_Graphite(
             const skgpu::VulkanBackendContext& vulkanBackendContext);
 
+    /**
+     * Draws with Skia's CPU backend, into and out of CPU-accessible buffers.
+     */
+    static std::unique_ptr<SkiaGpuContext> MakeRaster();
+
     virtual ~SkiaGpuContext() = default;
 
     /**
@@ -117,7 +117,9 @@ public:
     virtual std::string name() = 0;
     virtual renderengine::RenderEngine::GraphicsApi graphicsApi() = 0;
     virtual renderengine::RenderEngine::SkiaBackend skiaBackend() = 0;
-    bool apiSupported() { return renderengine::RenderEngine::canSupport(graphicsApi()); }
+    virtual bool apiSupported() {
+        return renderengine::RenderEngine::canSupport(graphicsApi());
+    }
     std::unique_ptr<renderengine::RenderEngine> createRenderEngine() {
         renderengine::RenderEngineCreationArgs reCreationArgs =
                 renderengine::RenderEngineCreationArgs::Builder()
@@ -177,6 +179,22 @@ public:
 };
 #endif
 
+class SkiaRasterRenderEngineFactory : public RenderEngineFactory {
+public:
+    std::string name() override { return "SkiaRasterRenderEngineFactory"; }
+
+    // Ignored by the raster backend
+    renderengine::RenderEngine::GraphicsApi graphicsApi() override {
+        return renderengine::RenderEngine::GraphicsApi::GL;
+    }
+
+    renderengine::RenderEngine::SkiaBackend skiaBackend() override {
+        return renderengine::RenderEngine::SkiaBackend::RASTER;
+    }
+
+    bool apiSupported() override { return true; }
+};
+
 class RenderEngineTest : public ::testing::TestWithParam<std::shared_ptr<RenderEngineFactory>> {
 public:
     std::shared_ptr<renderengine::ExternalTexture> allocateDefaultBuffer() {
@@ -1512,12 +1530,11 @@ void RenderEngineTest::tonemap(ui::Dataspace sourceDataspace, std::function<vec3
 // TODO: b/341728634 - Clean up conditional compilation.
 INSTANTIATE_TEST_SUITE_P(PerRenderEngineType, RenderEngineTest,
                          testing::Values(std::make_shared<SkiaGLESRenderEngineFactory>(),
-                                         std::make_shared<GaneshVkRenderEngineFactory>()
+                                         std::make_shared<GaneshVkRenderEngineFactory>(),
 #if COMPILE_GRAPHITE_RENDERENGINE
-                                                 ,
-                                         std::make_shared<GraphiteVkRenderEngineFactory>()
+                                         std::make_shared<GraphiteVkRenderEngineFactory>(),
 #endif
-                                                 ));
+                                         std::make_shared<SkiaRasterRenderEngineFactory>()));
 
 TEST_P(RenderEngineTest, drawLayers_noLayersToDraw) {
     if (!GetParam()->apiSupported()) {
@@ -3152,6 +3169,10 @@ TEST_P(RenderEngineTest, primeShaderCache) {
     if (GetParam()->skiaBackend() == renderengine::RenderEngine::SkiaBackend::GRAPHITE) {
         GTEST_SKIP();
     }
+    // The raster backend has no shaders to compile.
+    if (GetParam()->skiaBackend() == renderengine::RenderEngine::SkiaBackend::RASTER) {
+        GTEST_SKIP();
+    }
 
     if (!GetParam()->apiSupported()) {
         GTEST_SKIP();
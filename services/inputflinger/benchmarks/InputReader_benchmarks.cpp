@@ -0,0 +1,129 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <com_android_input_flags.h>
+#include <linux/input-event-codes.h>
+
+#include <InputDevice.h>
+#include <InputMapper.h>
+#include <NotifyArgsBuilders.h>
+#include "../tests/FakeEventHub.h"
+#include "../tests/FakeInputReaderPolicy.h"
+#include "../tests/InstrumentedInputReader.h"
+
+namespace android {
+
+namespace input_flags = com::android::input::flags;
+
+namespace {
+
+constexpr int32_t FIRST_DEVICE_ID = END_RESERVED_ID + 1000;
+
+// Number of raw events reported by each device between two consecutive SYN_REPORTs.
+constexpr int32_t EVENTS_PER_FRAME = 8;
+
+/**
+ * A mapper that burns a fixed amount of CPU for every raw event, standing in for the work done by
+ * a real mapper such as the touchpad gesture stack, and produces one motion event per SYN_REPORT.
+ */
+class BusyInputMapper : public InputMapper {
+public:
+    BusyInputMapper(InputDeviceContext& deviceContext, const InputReaderConfiguration& readerConfig,
+                    int64_t workPerEvent)
+          : InputMapper(deviceContext, readerConfig), mWorkPerEvent(workPerEvent) {}
+
+    uint32_t getSources() const override { return AINPUT_SOURCE_TOUCHSCREEN; }
+
+    std::list<NotifyArgs> process(const RawEvent& rawEvent) override {
+        for (int64_t i = 0; i < mWorkPerEvent; i++) {
+            mAccumulator = mAccumulator * 31 + rawEvent.value + i;
+            benchmark::DoNotOptimize(mAccumulator);
+        }
+        if (rawEvent.type != EV_SYN || rawEvent.code != SYN_REPORT) {
+            return {};
+        }
+        return {MotionArgsBuilder(AMOTION_EVENT_ACTION_MOVE, AINPUT_SOURCE_TOUCHSCREEN)
+                        .deviceId(getDeviceId())
+                        .eventTime(rawEvent.when)
+                        .pointer(PointerBuilder(/*id=*/0, ToolType::FINGER).x(rawEvent.value))
+                        .build()};
+    }
+
+private:
+    const int64_t mWorkPerEvent;
+    int64_t mAccumulator{0};
+};
+
+class NullListener : public InputListenerInterface {
+    void notify(const NotifyArgs&) override {}
+};
+
+// Arguments: device count, work per raw event, and whether parallel processing is enabled.
+void benchmarkLoopOnce(benchmark::State& state) {
+    const int32_t deviceCount = static_cast<int32_t>(state.range(0));
+    const int64_t workPerEvent = state.range(1);
+    input_flags::parallel_input_reader_device_processing(state.range(2) != 0);
+
+    std::shared_ptr<FakeEventHub> eventHub = std::make_shared<FakeEventHub>();
+    sp<FakeInputReaderPolicy> policy = sp<FakeInputReaderPolicy>::make();
+    NullListener listener;
+    InstrumentedInputReader reader(eventHub, policy, listener);
+
+    for (int32_t i = 0; i < deviceCount; i++) {
+        const int32_t deviceId = FIRST_DEVICE_ID + i;
+        std::shared_ptr<InputDevice> device =
+                reader.newDevice(deviceId, "busy" + std::to_string(i), std::to_string(i));
+        device->addMapper<BusyInputMapper>(deviceId, policy->getReaderConfiguration(),
+                                           workPerEvent);
+        reader.pushNextDevice(device);
+        eventHub->addDevice(deviceId, "busy" + std::to_string(i), InputDeviceClass::TOUCH_MT);
+    }
+    eventHub->finishDeviceScan();
+    reader.loopOnce();
+    reader.loopOnce();
+
+    nsecs_t when = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        // Interleave the devices the way EventHub does when several of them are ready at once.
+        for (int32_t i = 0; i < deviceCount; i++) {
+            const int32_t deviceId = FIRST_DEVICE_ID + i;
+            for (int32_t e = 0; e < EVENTS_PER_FRAME - 1; e++) {
+                eventHub->enqueueEvent(when, when, deviceId, EV_ABS, ABS_MT_POSITION_X, e);
+            }
+            eventHub->enqueueEvent(when + i, when + i, deviceId, EV_SYN, SYN_REPORT, 0);
+        }
+        when += 4'000'000; // 250Hz
+        state.ResumeTiming();
+
+        reader.loopOnce();
+    }
+    state.SetItemsProcessed(state.iterations() * deviceCount * EVENTS_PER_FRAME);
+
+    input_flags::parallel_input_reader_device_processing(false);
+}
+
+} // namespace
+
+BENCHMARK(benchmarkLoopOnce)
+        ->ArgNames({"devices", "work", "parallel"})
+        ->ArgsProduct({{1, 2, 4}, {0, 1000, 10000}, {0, 1}});
+
+} // namespace android
+
+BENCHMARK_MAIN();
@@ -0,0 +1,210 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "BackgroundLatencyProcessor"
+#define ATRACE_TAG ATRACE_TAG_INPUT
+
+#include "BackgroundLatencyProcessor.h"
+
+#include <android-base/stringprintf.h>
+#include <utils/Trace.h>
+
+#include <chrono>
+#include <thread>
+
+using android::base::StringPrintf;
+using std::chrono_literals::operator""ms;
+
+namespace android::inputdispatcher {
+
+namespace {
+
+// How long the background thread waits between two passes over the queue. Timelines are only
+// reported once they are mature, several seconds after the event, so there's no need to hurry.
+constexpr std::chrono::milliseconds DRAIN_INTERVAL = 500ms;
+
+const char* stageToString(size_t stage) {
+    switch (stage) {
+        case SketchIndex::EVENT_TO_READ:
+            return "EVENT_TO_READ";
+        case SketchIndex::READ_TO_DELIVER:
+            return "READ_TO_DELIVER";
+        case SketchIndex::DELIVER_TO_CONSUME:
+            return "DELIVER_TO_CONSUME";
+        case SketchIndex::CONSUME_TO_FINISH:
+            return "CONSUME_TO_FINISH";
+        case SketchIndex::CONSUME_TO_GPU_COMPLETE:
+            return "CONSUME_TO_GPU_COMPLETE";
+        case SketchIndex::GPU_COMPLETE_TO_PRESENT:
+            return "GPU_COMPLETE_TO_PRESENT";
+        case SketchIndex::END_TO_END:
+            return "END_TO_END";
+    }
+    return "UNKNOWN";
+}
+
+} // namespace
+
+BackgroundLatencyProcessor::BackgroundLatencyProcessor(InputEventTimelineProcessor& processor)
+      : mProcessor(processor) {
+    mThread = std::make_unique<InputThread>(
+            "InputLatency", [this]() { threadLoop(); }, [this]() { mWakeCondition.notify_all(); });
+}
+
+BackgroundLatencyProcessor::~BackgroundLatencyProcessor() {
+    {
+        std::scoped_lock lock(mLock);
+        mExiting = true;
+    }
+    // Destroying the InputThread invokes its wake function and joins it.
+    mThread.reset();
+    // Now that the background thread is gone, process whatever was queued after its last pass.
+    drainQueue();
+}
+
+void BackgroundLatencyProcessor::processTimeline(const InputEventTimeline& timeline) {
+    const size_t tail = mTail.load(std::memory_order_relaxed);
+    if (tail - mHead.load(std::memory_order_acquire) == QUEUE_CAPACITY) {
+        mDroppedTimelines.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    mQueue[tail % QUEUE_CAPACITY].emplace(timeline);
+    mTail.store(tail + 1, std::memory_order_release);
+}
+
+void BackgroundLatencyProcessor::flush() {
+    const size_t tail = mTail.load(std::memory_order_relaxed);
+    {
+        std::scoped_lock lock(mLock);
+        mWakeRequested = true;
+    }
+    mWakeCondition.notify_all();
+    while (mHead.load(std::memory_order_acquire) < tail) {
+        std::this_thread::sleep_for(1ms);
+    }
+}
+
+void BackgroundLatencyProcessor::threadLoop() {
+    drainQueue();
+
+    std::unique_lock lock(mLock);
+    base::ScopedLockAssertion assumeLocked(mLock);
+    mWakeCondition.wait_for(lock, DRAIN_INTERVAL,
+                            [this]() REQUIRES(mLock) { return mExiting || mWakeRequested; });
+    mWakeRequested = false;
+}
+
+void BackgroundLatencyProcessor::drainQueue() {
+    size_t head = mHead.load(std::memory_order_relaxed);
+    const size_t tail = mTail.load(std::memory_order_acquire);
+    if (head == tail) {
+        return;
+    }
+
+    for (; head != tail; head++) {
+        std::optional<InputEventTimeline>& timeline = mQueue[head % QUEUE_CAPACITY];
+        mProcessor.processTimeline(*timeline);
+        {
+            std::scoped_lock lock(mLock);
+            recordLatenciesLocked(*timeline);
+        }
+        timeline.reset();
+        // Hand the slot back to the producer.
+        mHead.store(head + 1, std::memory_order_release);
+    }
+
+    if (ATRACE_ENABLED()) {
+        std::scoped_lock lock(mLock);
+        traceLatenciesLocked();
+    }
+}
+
+void BackgroundLatencyProcessor::recordLatenciesLocked(const InputEventTimeline& timeline) {
+    mProcessedTimelines++;
+    StageHistograms& displayHistograms = mHistogramsByDisplay[timeline.displayId];
+    StageHistograms& deviceHistograms =
+            mHistogramsByDevice[DeviceKey{timeline.vendorId, timeline.productId}];
+    const auto record = [&](SketchIndex stage, nsecs_t latency) {
+        displayHistograms[stage].record(latency);
+        deviceHistograms[stage].record(latency);
+    };
+
+    record(SketchIndex::EVENT_TO_READ, timeline.readTime - timeline.eventTime);
+    for (const auto& [token, connectionTimeline] : timeline.connectionTimelines) {
+        if (!connectionTimeline.isComplete()) {
+            continue;
+        }
+        const nsecs_t gpuCompletedTime =
+                connectionTimeline.graphicsTimeline[GraphicsTimeline::GPU_COMPLETED_TIME];
+        const nsecs_t presentTime =
+                connectionTimeline.graphicsTimeline[GraphicsTimeline::PRESENT_TIME];
+        record(SketchIndex::READ_TO_DELIVER, connectionTimeline.deliveryTime - timeline.readTime);
+        record(SketchIndex::DELIVER_TO_CONSUME,
+               connectionTimeline.consumeTime - connectionTimeline.deliveryTime);
+        record(SketchIndex::CONSUME_TO_FINISH,
+               connectionTimeline.finishTime - connectionTimeline.consumeTime);
+        record(SketchIndex::CONSUME_TO_GPU_COMPLETE,
+               gpuCompletedTime - connectionTimeline.consumeTime);
+        record(SketchIndex::GPU_COMPLETE_TO_PRESENT, presentTime - gpuCompletedTime);
+        record(SketchIndex::END_TO_END, presentTime - timeline.eventTime);
+    }
+}
+
+void BackgroundLatencyProcessor::traceLatenciesLocked() const {
+    for (const auto& [displayId, histograms] : mHistogramsByDisplay) {
+        const LatencyHistogram& endToEnd = histograms[SketchIndex::END_TO_END];
+        if (endToEnd.count() == 0) {
+            continue;
+        }
+        const std::string display = displayId.toString();
+        ATRACE_INT64(StringPrintf("InputLatency p50 display %s (us)", display.c_str()).c_str(),
+                     ns2us(endToEnd.getPercentile(50)));
+        ATRACE_INT64(StringPrintf("InputLatency p99 display %s (us)", display.c_str()).c_str(),
+                     ns2us(endToEnd.getPercentile(99)));
+    }
+}
+
+std::string BackgroundLatencyProcessor::dump(const char* prefix) const {
+    std::scoped_lock lock(mLock);
+    std::string dump = StringPrintf("%sBackgroundLatencyProcessor:\n", prefix);
+    dump += StringPrintf("%s  mProcessedTimelines = %zu\n", prefix, mProcessedTimelines);
+    dump += StringPrintf("%s  mDroppedTimelines = %zu\n", prefix,
+                         mDroppedTimelines.load(std::memory_order_relaxed));
+
+    const auto dumpHistograms = [&](const std::string& name, const StageHistograms& histograms) {
+        dump += StringPrintf("%s  %s:\n", prefix, name.c_str());
+        for (size_t stage = 0; stage < SketchIndex::SIZE; stage++) {
+            const LatencyHistogram& histogram = histograms[stage];
+            if (histogram.count() == 0) {
+                continue;
+            }
+            dump += StringPrintf("%s    %s: count=%zu p50=%.1fms p90=%.1fms p99=%.1fms\n", prefix,
+                                 stageToString(stage), histogram.count(),
+                                 histogram.getPercentile(50) * 1E-6,
+                                 histogram.getPercentile(90) * 1E-6,
+                                 histogram.getPercentile(99) * 1E-6);
+        }
+    };
+    for (const auto& [displayId, histograms] : mHistogramsByDisplay) {
+        dumpHistograms("Display " + displayId.toString(), histograms);
+    }
+    for (const auto& [device, histograms] : mHistogramsByDevice) {
+        dumpHistograms(StringPrintf("Device %04x:%04x", device.first, device.second), histograms);
+    }
+    return dump;
+}
+
+} // namespace android::inputdispatcher
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "InputEventTimeline.h"
+#include "InputThread.h"
+#include "LatencyAggregator.h"
+#include "LatencyHistogram.h"
+
+namespace android::inputdispatcher {
+
+/**
+ * Processes the timelines reported by LatencyTracker on a dedicated thread, so that aggregating
+ * them does not happen on the dispatcher thread while it holds the dispatcher lock.
+ *
+ * processTimeline() must always be called from the same thread. It only copies the timeline into
+ * a fixed-size lock-free queue; if the queue is full, the timeline is dropped. The background
+ * thread drains the queue, forwards every timeline to the wrapped processor, and keeps per-stage
+ * latency histograms for every display and every device (identified by its vendor and product
+ * ids). The resulting percentiles are available through dump() and as trace counters.
+ */
+class BackgroundLatencyProcessor final : public InputEventTimelineProcessor {
+public:
+    /**
+     * The provided processor must outlive this object. Its processTimeline() will only be called
+     * from the background thread.
+     */
+    explicit BackgroundLatencyProcessor(InputEventTimelineProcessor& processor);
+    ~BackgroundLatencyProcessor() override;
+
+    void processTimeline(const InputEventTimeline& timeline) override;
+
+    std::string dump(const char* prefix) const;
+
+    /**
+     * Wait until every timeline that was passed to processTimeline() so far has been processed.
+     * Must be called from the thread that calls processTimeline().
+     */
+    void flush();
+
+private:
+    static constexpr size_t QUEUE_CAPACITY = 512;
+
+    using StageHistograms = std::array<LatencyHistogram, SketchIndex::SIZE>;
+    using DeviceKey = std::pair<uint16_t /*vendorId*/, uint16_t /*productId*/>;
+
+    InputEventTimelineProcessor& mProcessor;
+
+    // Single-producer, single-consumer ring buffer. The producer only writes mTail and the slot at
+    // mTail, and the consumer only writes mHead and the slot at mHead, so no lock is needed.
+    std::array<std::optional<InputEventTimeline>, QUEUE_CAPACITY> mQueue;
+    std::atomic<size_t> mHead{0};
+    std::atomic<size_t> mTail{0};
+    std::atomic<size_t> mDroppedTimelines{0};
+
+    mutable std::mutex mLock;
+    std::condition_variable mWakeCondition;
+    bool mWakeRequested GUARDED_BY(mLock){false};
+    bool mExiting GUARDED_BY(mLock){false};
+
+    size_t mProcessedTimelines GUARDED_BY(mLock){0};
+    std::map<ui::LogicalDisplayId, StageHistograms> mHistogramsByDisplay GUARDED_BY(mLock);
+    std::map<DeviceKey, StageHistograms> mHistogramsByDevice GUARDED_BY(mLock);
+
+    std::unique_ptr<InputThread> mThread;
+
+    void threadLoop();
+    // Processes everything that is currently in the queue. Only called on the background thread.
+    void drainQueue();
+    void recordLatenciesLocked(const InputEventTimeline& timeline) REQUIRES(mLock);
+    void traceLatenciesLocked() const REQUIRES(mLock);
+};
+
+} // namespace android::inputdispatcher
@@ -925,7 +925,14 @@ InputDispatcher::InputDispatcher(InputDispatcherPolicyInterface& policy,
         mWindowTokenWithPointerCapture(nullptr),
         mAwaitedApplicationDisplayId(ui::LogicalDisplayId::INVALID),
         mLatencyAggregator(),
-        mLatencyTracker(&mLatencyAggregator) {
+        mBackgroundLatencyProcessor(
+                input_flags::process_input_latency_in_background()
+                        ? std::make_unique<BackgroundLatencyProcessor>(mLatencyAggregator)
+                        : nullptr),
+        mLatencyTracker(mBackgroundLatencyProcessor
+                                ? static_cast<InputEventTimelineProcessor*>(
+                                          mBackgroundLatencyProcessor.get())
+                                : &mLatencyAggregator) {
     mLooper = sp<Looper>::make(false);
     mReporter = createInputReporter();
 
@@ -4667,7 +4674,7 @@ void InputDispatcher::notifyMotion(const NotifyMotionArgs& args) {
             const bool isDown = args.action == AMOTION_EVENT_ACTION_DOWN;
             std::set<InputDeviceUsageSource> sources = getUsageSourcesForMotionArgs(args);
             mLatencyTracker.trackListener(args.id, isDown, args.eventTime, args.readTime,
-                                          args.deviceId, sources);
+                                          args.deviceId, args.displayId, sources);
         }
 
         needWake = enqueueInboundEventLocked(std::move(newEntry));
@@ -6063,6 +6070,9 @@ void InputDispatcher::dumpDispatchStateLocked(std::string& dump) const {
                          ns2ms(mConfig.keyRepeatTimeout));
     dump += mLatencyTracker.dump(INDENT2);
     dump += mLatencyAggregator.dump(INDENT2);
+    if (mBackgroundLatencyProcessor) {
+        dump += mBackgroundLatencyProcessor->dump(INDENT2);
+    }
     dump += INDENT "InputTracer: ";
     dump += mTracer == nullptr ? "Disabled" : "Enabled";
 }
@@ -17,6 +17,7 @@
 #pragma once
 
 #include "AnrTracker.h"
+#include "BackgroundLatencyProcessor.h"
 #include "CancelationOptions.h"
 #include "DragState.h"
 #include "Entry.h"
@@ -695,7 +696,11 @@ private:
     findTouchStateWindowAndDisplayLocked(const sp<IBinder>& token) REQUIRES(mLock);
 
     // Statistics gathering.
-    LatencyAggregator mLatencyAggregator GUARDED_BY(mLock);
+    // Not guarded by mLock: when mBackgroundLatencyProcessor exists, the aggregator is fed from its
+    // thread instead of the dispatcher thread. It guards its own state with a lock of its own, so
+    // dumping it from any thread is safe.
+    LatencyAggregator mLatencyAggregator;
+    const std::unique_ptr<BackgroundLatencyProcessor> mBackgroundLatencyProcessor;
     LatencyTracker mLatencyTracker GUARDED_BY(mLock);
     void traceInboundQueueLengthLocked() REQUIRES(mLock);
     void traceOutboundQueueLength(const Connection& connection);
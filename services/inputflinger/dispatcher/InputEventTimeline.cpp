@@ -67,11 +67,12 @@ bool ConnectionTimeline::operator!=(const ConnectionTimeline& rhs) const {
 }
 
 InputEventTimeline::InputEventTimeline(bool isDown, nsecs_t eventTime, nsecs_t readTime,
-                                       uint16_t vendorId, uint16_t productId,
-                                       std::set<InputDeviceUsageSource> sources)
+                                       ui::LogicalDisplayId displayId, uint16_t vendorId,
+                                       uint16_t productId, std::set<InputDeviceUsageSource> sources)
       : isDown(isDown),
         eventTime(eventTime),
         readTime(readTime),
+        displayId(displayId),
         vendorId(vendorId),
         productId(productId),
         sources(sources) {}
@@ -90,7 +91,8 @@ bool InputEventTimeline::operator==(const InputEventTimeline& rhs) const {
         }
     }
     return isDown == rhs.isDown && eventTime == rhs.eventTime && readTime == rhs.readTime &&
-            vendorId == rhs.vendorId && productId == rhs.productId && sources == rhs.sources;
+            displayId == rhs.displayId && vendorId == rhs.vendorId && productId == rhs.productId &&
+            sources == rhs.sources;
 }
 
 } // namespace android::inputdispatcher
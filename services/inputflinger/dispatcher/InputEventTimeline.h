@@ -75,11 +75,13 @@ private:
 };
 
 struct InputEventTimeline {
-    InputEventTimeline(bool isDown, nsecs_t eventTime, nsecs_t readTime, uint16_t vendorId,
-                       uint16_t productId, std::set<InputDeviceUsageSource> sources);
+    InputEventTimeline(bool isDown, nsecs_t eventTime, nsecs_t readTime,
+                       ui::LogicalDisplayId displayId, uint16_t vendorId, uint16_t productId,
+                       std::set<InputDeviceUsageSource> sources);
     const bool isDown; // True if this is an ACTION_DOWN event
     const nsecs_t eventTime;
     const nsecs_t readTime;
+    const ui::LogicalDisplayId displayId;
     const uint16_t vendorId;
     const uint16_t productId;
     const std::set<InputDeviceUsageSource> sources;
@@ -215,21 +215,31 @@ void LatencyAggregator::processSlowEvent(const InputEventTimeline& timeline) {
         if (!connectionTimeline.isComplete()) {
             continue;
         }
-        mNumEventsSinceLastSlowEventReport++;
         const nsecs_t presentTime =
                 connectionTimeline.graphicsTimeline[GraphicsTimeline::PRESENT_TIME];
         const std::chrono::nanoseconds endToEndLatency =
                 std::chrono::nanoseconds(presentTime - timeline.eventTime);
-        if (endToEndLatency < sSlowEventThreshold) {
-            continue;
-        }
-        // This is a slow event. Before we report it, check if we are reporting too often
-        const std::chrono::duration elapsedSinceLastReport =
-                std::chrono::nanoseconds(timeline.eventTime - mLastSlowEventTime);
-        if (elapsedSinceLastReport < sSlowEventReportingInterval) {
-            mNumSkippedSlowEvents++;
-            continue;
-        }
+        size_t numEventsSinceLastSlowEventReport;
+        size_t numSkippedSlowEvents;
+        { // acquire lock
+            std::scoped_lock lock(mLock);
+            mNumEventsSinceLastSlowEventReport++;
+            if (endToEndLatency < sSlowEventThreshold) {
+                continue;
+            }
+            // This is a slow event. Before we report it, check if we are reporting too often
+            const std::chrono::duration elapsedSinceLastReport =
+                    std::chrono::nanoseconds(timeline.eventTime - mLastSlowEventTime);
+            if (elapsedSinceLastReport < sSlowEventReportingInterval) {
+                mNumSkippedSlowEvents++;
+                continue;
+            }
+            numEventsSinceLastSlowEventReport = mNumEventsSinceLastSlowEventReport;
+            numSkippedSlowEvents = mNumSkippedSlowEvents;
+            mNumEventsSinceLastSlowEventReport = 0;
+            mNumSkippedSlowEvents = 0;
+            mLastSlowEventTime = timeline.readTime;
+        } // release lock
 
         const nsecs_t eventToRead = timeline.readTime - timeline.eventTime;
         const nsecs_t readToDeliver = connectionTimeline.deliveryTime - timeline.readTime;
@@ -250,11 +260,8 @@ void LatencyAggregator::processSlowEvent(const InputEventTimeline& timeline) {
                                    static_cast<int32_t>(ns2us(consumeToGpuComplete)),
                                    static_cast<int32_t>(ns2us(gpuCompleteToPresent)),
                                    static_cast<int32_t>(ns2us(endToEndLatency.count())),
-                                   static_cast<int32_t>(mNumEventsSinceLastSlowEventReport),
-                                   static_cast<int32_t>(mNumSkippedSlowEvents));
-        mNumEventsSinceLastSlowEventReport = 0;
-        mNumSkippedSlowEvents = 0;
-        mLastSlowEventTime = timeline.readTime;
+                                   static_cast<int32_t>(numEventsSinceLastSlowEventReport),
+                                   static_cast<int32_t>(numSkippedSlowEvents));
     }
 }
 
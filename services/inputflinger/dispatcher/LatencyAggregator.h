@@ -69,18 +69,20 @@ private:
                                                                  void* cookie);
     AStatsManager_PullAtomCallbackReturn pullData(AStatsEventList* data);
 
+    // Statistics is pulled rather than pushed. It's pulled on a binder thread, and therefore will
+    // be accessed by two different threads. The lock is needed to protect the pulled data, and the
+    // slow event state, which dump() reads from yet another thread.
+    mutable std::mutex mLock;
+
     // ---------- Slow event handling ----------
     void processSlowEvent(const InputEventTimeline& timeline);
-    nsecs_t mLastSlowEventTime = 0;
+    nsecs_t mLastSlowEventTime GUARDED_BY(mLock) = 0;
     // How many slow events have been skipped due to rate limiting
-    size_t mNumSkippedSlowEvents = 0;
+    size_t mNumSkippedSlowEvents GUARDED_BY(mLock) = 0;
     // How many events have been received since the last time we reported a slow event
-    size_t mNumEventsSinceLastSlowEventReport = 0;
+    size_t mNumEventsSinceLastSlowEventReport GUARDED_BY(mLock) = 0;
 
     // ---------- Statistics handling ----------
-    // Statistics is pulled rather than pushed. It's pulled on a binder thread, and therefore will
-    // be accessed by two different threads. The lock is needed to protect the pulled data.
-    mutable std::mutex mLock;
     void processStatistics(const InputEventTimeline& timeline);
     // Sketches
     std::array<std::unique_ptr<dist_proc::aggregation::KllQuantile>, SketchIndex::SIZE>
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace android::inputdispatcher {
+
+namespace {
+
+// The upper bound of the first bucket. Every latency below it is counted in the first bucket.
+constexpr nsecs_t MIN_LATENCY = 100'000; // 100 us
+
+// Each bucket covers latencies that are up to 2^(1/BUCKETS_PER_DOUBLING) times larger than the
+// previous bucket. With 64 buckets, the last regular bucket ends at about 5.5 seconds.
+constexpr float BUCKETS_PER_DOUBLING = 4;
+
+} // namespace
+
+size_t LatencyHistogram::getBucket(nsecs_t latency) {
+    if (latency <= MIN_LATENCY) {
+        return 0;
+    }
+    const float bucket =
+            std::ceil(BUCKETS_PER_DOUBLING * std::log2(static_cast<float>(latency) / MIN_LATENCY));
+    return std::min(static_cast<size_t>(bucket), NUM_BUCKETS - 1);
+}
+
+nsecs_t LatencyHistogram::getBucketUpperBound(size_t bucket) {
+    return static_cast<nsecs_t>(MIN_LATENCY * std::exp2(bucket / BUCKETS_PER_DOUBLING));
+}
+
+void LatencyHistogram::record(nsecs_t latency) {
+    mBuckets[getBucket(latency)]++;
+    mCount++;
+}
+
+nsecs_t LatencyHistogram::getPercentile(float percentile) const {
+    if (mCount == 0) {
+        return 0;
+    }
+    const size_t rank = std::max(static_cast<size_t>(std::ceil(percentile / 100 * mCount)),
+                                 static_cast<size_t>(1));
+    size_t seen = 0;
+    for (size_t bucket = 0; bucket < NUM_BUCKETS; bucket++) {
+        seen += mBuckets[bucket];
+        if (seen >= rank) {
+            return getBucketUpperBound(bucket);
+        }
+    }
+    return getBucketUpperBound(NUM_BUCKETS - 1);
+}
+
+} // namespace android::inputdispatcher
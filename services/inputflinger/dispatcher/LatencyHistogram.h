@@ -0,0 +1,55 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <utils/Timers.h>
+
+namespace android::inputdispatcher {
+
+/**
+ * A fixed-size histogram of latencies, used to estimate percentiles without keeping the samples.
+ *
+ * The buckets are spaced logarithmically, so that the relative error of a percentile is the same
+ * (about 19%) for short and long latencies. Recording a sample does not allocate.
+ */
+class LatencyHistogram {
+public:
+    void record(nsecs_t latency);
+
+    size_t count() const { return mCount; }
+
+    /**
+     * Returns an upper bound for the given percentile (in the range [0, 100]) of the recorded
+     * latencies, or 0 if nothing was recorded.
+     */
+    nsecs_t getPercentile(float percentile) const;
+
+private:
+    static constexpr size_t NUM_BUCKETS = 64;
+
+    static size_t getBucket(nsecs_t latency);
+    static nsecs_t getBucketUpperBound(size_t bucket);
+
+    std::array<uint32_t, NUM_BUCKETS> mBuckets{};
+    size_t mCount = 0;
+};
+
+} // namespace android::inputdispatcher
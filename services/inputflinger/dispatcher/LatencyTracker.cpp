@@ -69,6 +69,7 @@ LatencyTracker::LatencyTracker(InputEventTimelineProcessor* processor)
 
 void LatencyTracker::trackListener(int32_t inputEventId, bool isDown, nsecs_t eventTime,
                                    nsecs_t readTime, DeviceId deviceId,
+                                   ui::LogicalDisplayId displayId,
                                    const std::set<InputDeviceUsageSource>& sources) {
     reportAndPruneMatureRecords(eventTime);
     const auto it = mTimelines.find(inputEventId);
@@ -102,8 +103,8 @@ void LatencyTracker::trackListener(int32_t inputEventId, bool isDown, nsecs_t ev
     }
 
     mTimelines.emplace(inputEventId,
-                       InputEventTimeline(isDown, eventTime, readTime, identifier->vendor,
-                                          identifier->product, sources));
+                       InputEventTimeline(isDown, eventTime, readTime, displayId,
+                                          identifier->vendor, identifier->product, sources));
     mEventTimes.emplace(eventTime, inputEventId);
 }
 
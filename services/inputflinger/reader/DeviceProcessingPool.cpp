@@ -0,0 +1,81 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DeviceProcessingPool.h"
+
+#include <android-base/stringprintf.h>
+
+namespace android {
+
+DeviceProcessingPool::DeviceProcessingPool(size_t workerCount) {
+    mWorkers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; i++) {
+        mWorkers.emplace_back(std::make_unique<InputThread>(
+                base::StringPrintf("InputReader:%zu", i), [this]() { workerLoop(); },
+                [this]() { mTasksAvailable.notify_all(); }));
+    }
+}
+
+DeviceProcessingPool::~DeviceProcessingPool() {
+    {
+        std::scoped_lock lock(mLock);
+        mExiting = true;
+    }
+    // Destroying each InputThread invokes its wake function and joins it.
+    mWorkers.clear();
+}
+
+void DeviceProcessingPool::runAll(std::vector<std::function<void()>>& tasks) {
+    if (tasks.empty()) {
+        return;
+    }
+    std::unique_lock lock(mLock);
+    mTasks = &tasks;
+    mNextTask = 0;
+    mRemainingTasks = tasks.size();
+    mTasksAvailable.notify_all();
+
+    base::ScopedLockAssertion assumeLocked(mLock);
+    drainTasksLocked(lock);
+    mTasksFinished.wait(lock, [this]() REQUIRES(mLock) { return mRemainingTasks == 0; });
+    mTasks = nullptr;
+}
+
+void DeviceProcessingPool::workerLoop() {
+    std::unique_lock lock(mLock);
+    base::ScopedLockAssertion assumeLocked(mLock);
+    mTasksAvailable.wait(lock, [this]() REQUIRES(mLock) {
+        return mExiting || (mTasks != nullptr && mNextTask < mTasks->size());
+    });
+    if (mExiting) {
+        return;
+    }
+    drainTasksLocked(lock);
+}
+
+void DeviceProcessingPool::drainTasksLocked(std::unique_lock<std::mutex>& lock) {
+    while (mTasks != nullptr && mNextTask < mTasks->size()) {
+        std::function<void()>& task = (*mTasks)[mNextTask++];
+        lock.unlock();
+        task();
+        lock.lock();
+        if (--mRemainingTasks == 0) {
+            mTasksFinished.notify_all();
+        }
+    }
+}
+
+} // namespace android
@@ -51,6 +51,7 @@
 #include <utils/Log.h>
 #include <utils/Timers.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <optional>
 #include <regex>
@@ -79,8 +80,6 @@ static constexpr size_t OBFUSCATED_LENGTH = 8;
 static constexpr int32_t FF_STRONG_MAGNITUDE_CHANNEL_IDX = 0;
 static constexpr int32_t FF_WEAK_MAGNITUDE_CHANNEL_IDX = 1;
 
-static constexpr size_t EVENT_BUFFER_SIZE = 256;
-
 // Mapping for input battery class node IDs lookup.
 // https://www.kernel.org/doc/Documentation/power/power_supply_class.txt
 static const std::unordered_map<std::string, InputBatteryClass> BATTERY_CLASSES =
@@ -540,12 +539,31 @@ EventHub::Device::Device(int fd, int32_t id, std::string path, InputDeviceIdenti
         controllerNumber(0),
         enabled(true),
         isVirtual(fd < 0),
+        readBufferHead(0),
+        readBufferCount(0),
+        readBufferReadTime(0),
         currentFrameDropped(false) {}
 
 EventHub::Device::~Device() {
     close();
 }
 
+ssize_t EventHub::Device::fillReadBuffer() {
+    if (readBuffer.empty()) {
+        readBuffer.resize(EVENT_BUFFER_SIZE);
+    }
+    readBufferHead = 0;
+    readBufferCount = 0;
+    const ssize_t readSize =
+            read(fd, readBuffer.data(), sizeof(struct input_event) * readBuffer.size());
+    if (readSize > 0 && (readSize % sizeof(struct input_event)) == 0) {
+        readBufferCount = size_t(readSize) / sizeof(struct input_event);
+        // All of the events in a batch were read at the same time.
+        readBufferReadTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    }
+    return readSize;
+}
+
 void EventHub::Device::close() {
     if (fd >= 0) {
         ::close(fd);
@@ -1845,12 +1863,11 @@ std::optional<int32_t> EventHub::getBatteryStatus(int32_t deviceId, int32_t batt
     return std::nullopt;
 }
 
-std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
+size_t EventHub::getEvents(int timeoutMillis, std::span<RawEvent> outEvents) {
     std::scoped_lock _l(mLock);
 
-    std::array<input_event, EVENT_BUFFER_SIZE> readBuffer;
-
-    std::vector<RawEvent> events;
+    const size_t capacity = outEvents.size();
+    size_t count = 0;
     bool awoken = false;
     for (;;) {
         nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
@@ -1867,22 +1884,19 @@ std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
         }
 
         // Report any devices that had last been added/removed.
-        for (auto it = mClosingDevices.begin(); it != mClosingDevices.end();) {
+        for (auto it = mClosingDevices.begin(); it != mClosingDevices.end() && count < capacity;) {
             std::unique_ptr<Device> device = std::move(*it);
             ALOGV("Reporting device closed: id=%d, name=%s\n", device->id, device->path.c_str());
             const int32_t deviceId = (device->id == mBuiltInKeyboardId)
                     ? ReservedInputDeviceId::BUILT_IN_KEYBOARD_ID
                     : device->id;
-            events.push_back({
+            outEvents[count++] = {
                     .when = now,
                     .deviceId = deviceId,
                     .type = DEVICE_REMOVED,
-            });
+            };
             it = mClosingDevices.erase(it);
             mNeedToSendFinishedDeviceScan = true;
-            if (events.size() == EVENT_BUFFER_SIZE) {
-                break;
-            }
         }
 
         if (mNeedToScanDevices) {
@@ -1891,16 +1905,16 @@ std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
             mNeedToSendFinishedDeviceScan = true;
         }
 
-        while (!mOpeningDevices.empty()) {
+        while (!mOpeningDevices.empty() && count < capacity) {
             std::unique_ptr<Device> device = std::move(*mOpeningDevices.rbegin());
             mOpeningDevices.pop_back();
             ALOGV("Reporting device opened: id=%d, name=%s\n", device->id, device->path.c_str());
             const int32_t deviceId = device->id == mBuiltInKeyboardId ? 0 : device->id;
-            events.push_back({
+            outEvents[count++] = {
                     .when = now,
                     .deviceId = deviceId,
                     .type = DEVICE_ADDED,
-            });
+            };
 
             // Try to find a matching video device by comparing device names
             for (auto it = mUnattachedVideoDevices.begin(); it != mUnattachedVideoDevices.end();
@@ -1918,25 +1932,22 @@ std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
                 ALOGW("Device id %d exists, replaced.", device->id);
             }
             mNeedToSendFinishedDeviceScan = true;
-            if (events.size() == EVENT_BUFFER_SIZE) {
-                break;
-            }
         }
 
-        if (mNeedToSendFinishedDeviceScan) {
+        if (mNeedToSendFinishedDeviceScan && count < capacity) {
             mNeedToSendFinishedDeviceScan = false;
-            events.push_back({
+            outEvents[count++] = {
                     .when = now,
                     .type = FINISHED_DEVICE_SCAN,
-            });
-            if (events.size() == EVENT_BUFFER_SIZE) {
-                break;
-            }
+            };
+        }
+        if (count == capacity) {
+            break;
         }
 
         // Grab the next input event.
         bool deviceChanged = false;
-        while (mPendingEventIndex < mPendingEventCount) {
+        while (mPendingEventIndex < mPendingEventCount && count < capacity) {
             const struct epoll_event& eventItem = mPendingEventItems[mPendingEventIndex++];
             if (eventItem.data.fd == mINotifyFd) {
                 if (eventItem.events & EPOLLIN) {
@@ -1992,45 +2003,51 @@ std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
             }
             // This must be an input event
             if (eventItem.events & EPOLLIN) {
-                int32_t readSize =
-                        read(device->fd, readBuffer.data(),
-                             sizeof(decltype(readBuffer)::value_type) * readBuffer.size());
-                if (readSize == 0 || (readSize < 0 && errno == ENODEV)) {
-                    // Device was removed before INotify noticed.
-                    ALOGW("could not get event, removed? (fd: %d size: %" PRId32
-                          " capacity: %zu errno: %d)\n",
-                          device->fd, readSize, readBuffer.size(), errno);
-                    deviceChanged = true;
-                    closeDeviceLocked(*device);
-                } else if (readSize < 0) {
-                    if (errno != EAGAIN && errno != EINTR) {
-                        ALOGW("could not get event (errno=%d)", errno);
-                    }
-                } else if ((readSize % sizeof(struct input_event)) != 0) {
-                    ALOGE("could not get event (wrong size: %d)", readSize);
-                } else {
-                    const int32_t deviceId = device->id == mBuiltInKeyboardId ? 0 : device->id;
-
-                    const size_t count = size_t(readSize) / sizeof(struct input_event);
-                    for (size_t i = 0; i < count; i++) {
-                        struct input_event& iev = readBuffer[i];
-                        device->trackInputEvent(iev);
-                        events.push_back({
-                                .when = processEventTimestamp(iev),
-                                .readTime = systemTime(SYSTEM_TIME_MONOTONIC),
-                                .deviceId = deviceId,
-                                .type = iev.type,
-                                .code = iev.code,
-                                .value = iev.value,
-                        });
-                    }
-                    if (events.size() >= EVENT_BUFFER_SIZE) {
-                        // The result buffer is full.  Reset the pending event index
-                        // so we will try to read the device again on the next iteration.
-                        mPendingEventIndex -= 1;
-                        break;
+                // Return the events left over from the previous read before reading again.
+                if (!device->hasBufferedEvents()) {
+                    const ssize_t readSize = device->fillReadBuffer();
+                    if (readSize == 0 || (readSize < 0 && errno == ENODEV)) {
+                        // Device was removed before INotify noticed.
+                        ALOGW("could not get event, removed? (fd: %d size: %zd"
+                              " capacity: %zu errno: %d)\n",
+                              device->fd, readSize, device->readBuffer.size(), errno);
+                        deviceChanged = true;
+                        closeDeviceLocked(*device);
+                        continue;
+                    } else if (readSize < 0) {
+                        if (errno != EAGAIN && errno != EINTR) {
+                            ALOGW("could not get event (errno=%d)", errno);
+                        }
+                        continue;
+                    } else if ((readSize % sizeof(struct input_event)) != 0) {
+                        ALOGE("could not get event (wrong size: %zd)", readSize);
+                        continue;
                     }
                 }
+
+                const int32_t deviceId = device->id == mBuiltInKeyboardId ? 0 : device->id;
+                const size_t available = device->readBufferCount - device->readBufferHead;
+                const size_t batchSize = std::min(available, capacity - count);
+                for (size_t i = 0; i < batchSize; i++) {
+                    const struct input_event& iev =
+                            device->readBuffer[device->readBufferHead + i];
+                    device->trackInputEvent(iev);
+                    outEvents[count++] = {
+                            .when = processEventTimestamp(iev),
+                            .readTime = device->readBufferReadTime,
+                            .deviceId = deviceId,
+                            .type = iev.type,
+                            .code = iev.code,
+                            .value = iev.value,
+                    };
+                }
+                device->readBufferHead += batchSize;
+                if (device->hasBufferedEvents()) {
+                    // The result buffer is full.  Reset the pending event index
+                    // so we will return the rest of the events on the next iteration.
+                    mPendingEventIndex -= 1;
+                    break;
+                }
             } else if (eventItem.events & EPOLLHUP) {
                 ALOGI("Removing device %s due to epoll hang-up event.",
                       device->identifier.name.c_str());
@@ -2060,7 +2077,7 @@ std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
         }
 
         // Return now if we have collected any events or if we were explicitly awoken.
-        if (!events.empty() || awoken) {
+        if (count > 0 || awoken) {
             break;
         }
 
@@ -2106,7 +2123,7 @@ std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
     }
 
     // All done, return the number of events we read.
-    return events;
+    return count;
 }
 
 std::vector<TouchVideoFrame> EventHub::getVideoFrames(int32_t deviceId) {
@@ -19,6 +19,7 @@
 #include "InputReader.h"
 
 #include <android-base/stringprintf.h>
+#include <com_android_input_flags.h>
 #include <errno.h>
 #include <input/Keyboard.h>
 #include <input/VirtualKeyMap.h>
@@ -36,10 +37,16 @@
 
 using android::base::StringPrintf;
 
+namespace input_flags = com::android::input::flags;
+
 namespace android {
 
 namespace {
 
+// Number of worker threads used to process independent devices in parallel. The reader thread
+// itself also participates, so this is one less than the maximum concurrency.
+constexpr size_t DEVICE_PROCESSING_WORKER_COUNT = 2;
+
 /**
  * Determines if the identifiers passed are a sub-devices. Sub-devices are physical devices
  * that expose multiple input device paths such a keyboard that also has a touchpad input.
@@ -91,6 +98,47 @@ std::optional<DeviceId> getDeviceIdOfNewGesture(const NotifyArgs& args) {
     return std::nullopt;
 }
 
+// Return the time of the event, or std::nullopt if the args do not carry a timestamp.
+std::optional<nsecs_t> getEventTime(const NotifyArgs& args) {
+    return std::visit(
+            [](const auto& a) -> std::optional<nsecs_t> {
+                if constexpr (std::is_same_v<std::decay_t<decltype(a)>,
+                                             NotifyInputDevicesChangedArgs>) {
+                    return std::nullopt;
+                } else {
+                    return a.eventTime;
+                }
+            },
+            args);
+}
+
+/**
+ * Merge the per-device outputs into a single list ordered by event time. Each input list must
+ * already be in order. Ties are broken by the position of the list in 'lists', and args without
+ * a timestamp stay attached to the args that precede them, so the result is deterministic
+ * regardless of the order in which the devices finished processing.
+ */
+std::list<NotifyArgs> mergeByEventTime(std::vector<std::list<NotifyArgs>>& lists) {
+    std::list<NotifyArgs> out;
+    std::vector<nsecs_t> headTimes(lists.size(), LLONG_MIN);
+    while (true) {
+        std::optional<size_t> next;
+        for (size_t i = 0; i < lists.size(); i++) {
+            if (lists[i].empty()) {
+                continue;
+            }
+            headTimes[i] = getEventTime(lists[i].front()).value_or(headTimes[i]);
+            if (!next || headTimes[i] < headTimes[*next]) {
+                next = i;
+            }
+        }
+        if (!next) {
+            return out;
+        }
+        out.splice(out.end(), lists[*next], lists[*next].begin());
+    }
+}
+
 } // namespace
 
 // --- InputReader ---
@@ -103,6 +151,11 @@ InputReader::InputReader(std::shared_ptr<EventHubInterface> eventHub,
         mPolicy(policy),
         mNextListener(listener),
         mKeyboardClassifier(std::make_unique<KeyboardClassifier>()),
+        mDeviceProcessingPool(input_flags::parallel_input_reader_device_processing()
+                                      ? std::make_unique<DeviceProcessingPool>(
+                                                DEVICE_PROCESSING_WORKER_COUNT)
+                                      : nullptr),
+        mEventBuffer(EventHubInterface::EVENT_BUFFER_SIZE),
         mGlobalMetaState(AMETA_NONE),
         mLedMetaState(AMETA_NONE),
         mGeneration(1),
@@ -158,14 +211,14 @@ void InputReader::loopOnce() {
         }
     } // release lock
 
-    std::vector<RawEvent> events = mEventHub->getEvents(timeoutMillis);
+    const size_t eventCount = mEventHub->getEvents(timeoutMillis, mEventBuffer);
 
     { // acquire lock
         std::scoped_lock _l(mLock);
         mReaderIsAliveCondition.notify_all();
 
-        if (!events.empty()) {
-            mPendingArgs += processEventsLocked(events.data(), events.size());
+        if (eventCount != 0) {
+            mPendingArgs += processEventsLocked(mEventBuffer.data(), eventCount);
         }
 
         if (mNextTimeout != LLONG_MAX) {
@@ -226,7 +279,15 @@ std::list<NotifyArgs> InputReader::processEventsLocked(const RawEvent* rawEvents
     for (const RawEvent* rawEvent = rawEvents; count;) {
         int32_t type = rawEvent->type;
         size_t batchSize = 1;
-        if (type < EventHubInterface::FIRST_SYNTHETIC_EVENT) {
+        if (type < EventHubInterface::FIRST_SYNTHETIC_EVENT && mDeviceProcessingPool != nullptr) {
+            // Take every device event up to the next synthetic event, so that the devices
+            // contained in this window can be processed independently of each other.
+            while (batchSize < count &&
+                   rawEvent[batchSize].type < EventHubInterface::FIRST_SYNTHETIC_EVENT) {
+                batchSize += 1;
+            }
+            out += processEventsForDevicesInParallelLocked(rawEvent, batchSize);
+        } else if (type < EventHubInterface::FIRST_SYNTHETIC_EVENT) {
             int32_t deviceId = rawEvent->deviceId;
             while (batchSize < count) {
                 if (rawEvent[batchSize].type >= EventHubInterface::FIRST_SYNTHETIC_EVENT ||
@@ -388,6 +449,96 @@ std::list<NotifyArgs> InputReader::processEventsForDeviceLocked(int32_t eventHub
     return device->process(rawEvents, count);
 }
 
+std::list<NotifyArgs> InputReader::processEventsForDevicesInParallelLocked(
+        const RawEvent* rawEvents, size_t count) {
+    // A group of devices whose events are processed sequentially by a single task.
+    struct DeviceGroup {
+        // Runs of consecutive events that belong to a single EventHub device, in order.
+        std::vector<std::tuple<InputDevice*, const RawEvent*, size_t>> batches;
+        std::list<NotifyArgs> out;
+    };
+    std::vector<DeviceGroup> groups;
+    std::unordered_map<InputDevice*, size_t> groupIndexByDevice;
+    // Keyboards update the global meta state by querying every keyboard, so they cannot run
+    // concurrently with each other. They all share one group.
+    std::optional<size_t> keyboardGroupIndex;
+    bool hasExternalStylus = false;
+
+    for (const RawEvent* rawEvent = rawEvents; rawEvent < rawEvents + count;) {
+        const int32_t eventHubId = rawEvent->deviceId;
+        size_t batchSize = 1;
+        while (rawEvent + batchSize < rawEvents + count &&
+               rawEvent[batchSize].deviceId == eventHubId) {
+            batchSize += 1;
+        }
+
+        auto deviceIt = mDevices.find(eventHubId);
+        if (deviceIt == mDevices.end()) {
+            ALOGW("Discarding event for unknown eventHubId %d.", eventHubId);
+        } else if (!deviceIt->second->isIgnored()) {
+            InputDevice* device = deviceIt->second.get();
+            const ftl::Flags<InputDeviceClass> classes = device->getClasses();
+            hasExternalStylus |= classes.test(InputDeviceClass::EXTERNAL_STYLUS);
+
+            size_t groupIndex;
+            if (auto it = groupIndexByDevice.find(device); it != groupIndexByDevice.end()) {
+                groupIndex = it->second;
+            } else if (classes.test(InputDeviceClass::KEYBOARD) && keyboardGroupIndex) {
+                groupIndex = *keyboardGroupIndex;
+            } else {
+                groupIndex = groups.size();
+                groups.emplace_back();
+                if (classes.test(InputDeviceClass::KEYBOARD)) {
+                    keyboardGroupIndex = groupIndex;
+                }
+            }
+            groupIndexByDevice.emplace(device, groupIndex);
+            groups[groupIndex].batches.emplace_back(device, rawEvent, batchSize);
+        }
+        rawEvent += batchSize;
+    }
+
+    // External styluses fuse their state into other devices, so the devices are not independent.
+    // Process them in the order they were received, as in the sequential path.
+    if (groups.size() < 2 || hasExternalStylus) {
+        std::list<NotifyArgs> out;
+        for (const RawEvent* rawEvent = rawEvents; rawEvent < rawEvents + count;) {
+            size_t batchSize = 1;
+            while (rawEvent + batchSize < rawEvents + count &&
+                   rawEvent[batchSize].deviceId == rawEvent->deviceId) {
+                batchSize += 1;
+            }
+            out += processEventsForDeviceLocked(rawEvent->deviceId, rawEvent, batchSize);
+            rawEvent += batchSize;
+        }
+        return out;
+    }
+
+    if (debugRawEvents()) {
+        ALOGD("Processing %zu events from %zu device groups in parallel", count, groups.size());
+    }
+
+    std::vector<std::function<void()>> tasks;
+    tasks.reserve(groups.size());
+    for (DeviceGroup& group : groups) {
+        tasks.emplace_back([&group]() {
+            for (const auto& [device, batchEvents, batchSize] : group.batches) {
+                group.out += device->process(batchEvents, batchSize);
+            }
+        });
+    }
+    mProcessingDevicesInParallel = true;
+    mDeviceProcessingPool->runAll(tasks);
+    mProcessingDevicesInParallel = false;
+
+    std::vector<std::list<NotifyArgs>> outputs;
+    outputs.reserve(groups.size());
+    for (DeviceGroup& group : groups) {
+        outputs.push_back(std::move(group.out));
+    }
+    return mergeByEventTime(outputs);
+}
+
 InputDevice* InputReader::findInputDeviceLocked(int32_t deviceId) const {
     auto deviceIt =
             std::find_if(mDevices.begin(), mDevices.end(), [deviceId](const auto& devicePair) {
@@ -996,62 +1147,81 @@ void InputReader::monitor() {
 InputReader::ContextImpl::ContextImpl(InputReader* reader)
       : mReader(reader), mIdGenerator(IdGenerator::Source::INPUT_READER) {}
 
+std::unique_lock<std::mutex> InputReader::ContextImpl::lockIfProcessingInParallel() {
+    if (mReader->mProcessingDevicesInParallel) {
+        return std::unique_lock(mReader->mContextLock);
+    }
+    return {};
+}
+
 void InputReader::ContextImpl::updateGlobalMetaState() {
     // lock is already held by the input loop
+    auto lock = lockIfProcessingInParallel();
     mReader->updateGlobalMetaStateLocked();
 }
 
 int32_t InputReader::ContextImpl::getGlobalMetaState() {
     // lock is already held by the input loop
+    auto lock = lockIfProcessingInParallel();
     return mReader->getGlobalMetaStateLocked();
 }
 
 void InputReader::ContextImpl::updateLedMetaState(int32_t metaState) {
     // lock is already held by the input loop
+    auto lock = lockIfProcessingInParallel();
     mReader->updateLedMetaStateLocked(metaState);
 }
 
 int32_t InputReader::ContextImpl::getLedMetaState() {
     // lock is already held by the input loop
+    auto lock = lockIfProcessingInParallel();
     return mReader->getLedMetaStateLocked();
 }
 
 void InputReader::ContextImpl::setPreventingTouchpadTaps(bool prevent) {
     // lock is already held by the input loop
+    auto lock = lockIfProcessingInParallel();
     mReader->mPreventingTouchpadTaps = prevent;
 }
 
 bool InputReader::ContextImpl::isPreventingTouchpadTaps() {
     // lock is already held by the input loop
+    auto lock = lockIfProcessingInParallel();
     return mReader->mPreventingTouchpadTaps;
 }
 
 void InputReader::ContextImpl::setLastKeyDownTimestamp(nsecs_t when) {
+    auto lock = lockIfProcessingInParallel();
     mReader->mLastKeyDownTimestamp = when;
 }
 
 nsecs_t InputReader::ContextImpl::getLastKeyDownTimestamp() {
+    auto lock = lockIfProcessingInParallel();
     return mReader->mLastKeyDownTimestamp;
 }
 
 void InputReader::ContextImpl::disableVirtualKeysUntil(nsecs_t time) {
     // lock is already held by the input loop
+    auto lock = lockIfProcessingInParallel();
     mReader->disableVirtualKeysUntilLocked(time);
 }
 
 bool InputReader::ContextImpl::shouldDropVirtualKey(nsecs_t now, int32_t keyCode,
                                                     int32_t scanCode) {
     // lock is already held by the input loop
+    auto lock = lockIfProcessingInParallel();
     return mReader->shouldDropVirtualKeyLocked(now, keyCode, scanCode);
 }
 
 void InputReader::ContextImpl::requestTimeoutAtTime(nsecs_t when) {
     // lock is already held by the input loop
+    auto lock = lockIfProcessingInParallel();
     mReader->requestTimeoutAtTimeLocked(when);
 }
 
 int32_t InputReader::ContextImpl::bumpGeneration() {
     // lock is already held by the input loop
+    auto lock = lockIfProcessingInParallel();
     return mReader->bumpGenerationLocked();
 }
 
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "InputThread.h"
+
+namespace android {
+
+/**
+ * A small, fixed-size pool of threads that InputReader uses to process the events of independent
+ * input devices concurrently.
+ *
+ * The pool only supports running a batch of tasks to completion: runAll() hands the tasks to the
+ * workers, participates in draining them on the calling thread, and returns once every task has
+ * finished. Tasks must not call back into runAll().
+ */
+class DeviceProcessingPool {
+public:
+    explicit DeviceProcessingPool(size_t workerCount);
+    ~DeviceProcessingPool();
+
+    DeviceProcessingPool(const DeviceProcessingPool&) = delete;
+    DeviceProcessingPool& operator=(const DeviceProcessingPool&) = delete;
+
+    // Run all of the provided tasks, returning when every one of them has completed.
+    void runAll(std::vector<std::function<void()>>& tasks);
+
+    size_t getWorkerCount() const { return mWorkers.size(); }
+
+private:
+    std::mutex mLock;
+    std::condition_variable mTasksAvailable;
+    std::condition_variable mTasksFinished;
+
+    std::vector<std::function<void()>>* mTasks GUARDED_BY(mLock){nullptr};
+    size_t mNextTask GUARDED_BY(mLock){0};
+    size_t mRemainingTasks GUARDED_BY(mLock){0};
+    bool mExiting GUARDED_BY(mLock){false};
+
+    std::vector<std::unique_ptr<InputThread>> mWorkers;
+
+    void workerLoop();
+    // Runs tasks until there are none left to claim. Must be called with the lock held; the lock
+    // is released while each task runs.
+    void drainTasksLocked(std::unique_lock<std::mutex>& lock) REQUIRES(mLock);
+};
+
+} // namespace android
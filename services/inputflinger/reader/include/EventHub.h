@@ -22,6 +22,7 @@
 #include <functional>
 #include <map>
 #include <ostream>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -264,6 +265,9 @@ public:
         FIRST_SYNTHETIC_EVENT = DEVICE_ADDED,
     };
 
+    // The number of events that getEvents() can return at most when no buffer is provided.
+    static constexpr size_t EVENT_BUFFER_SIZE = 256;
+
     virtual ftl::Flags<InputDeviceClass> getDeviceClasses(int32_t deviceId) const = 0;
 
     virtual InputDeviceIdentifier getDeviceIdentifier(int32_t deviceId) const = 0;
@@ -310,9 +314,20 @@ public:
      * The timeout is advisory only.  If the device is asleep, it will not wake just to
      * service the timeout.
      *
+     * The events are written to the caller-provided buffer, which is not resized. Events that do
+     * not fit are kept by the EventHub and returned by the next call, so callers that keep reusing
+     * the same buffer do not need to allocate for every call.
+     *
      * Returns the number of events obtained, or 0 if the timeout expired.
      */
-    virtual std::vector<RawEvent> getEvents(int timeoutMillis) = 0;
+    virtual size_t getEvents(int timeoutMillis, std::span<RawEvent> outEvents) = 0;
+
+    // Convenience wrapper around getEvents that allocates a buffer of EVENT_BUFFER_SIZE events.
+    std::vector<RawEvent> getEvents(int timeoutMillis) {
+        std::vector<RawEvent> events(EVENT_BUFFER_SIZE);
+        events.resize(getEvents(timeoutMillis, events));
+        return events;
+    }
     virtual std::vector<TouchVideoFrame> getVideoFrames(int32_t deviceId) = 0;
     virtual base::Result<std::pair<InputDeviceSensorType, int32_t>> mapSensor(
             int32_t deviceId, int32_t absCode) const = 0;
@@ -567,7 +582,8 @@ public:
     bool markSupportedKeyCodes(int32_t deviceId, const std::vector<int32_t>& keyCodes,
                                uint8_t* outFlags) const override final;
 
-    std::vector<RawEvent> getEvents(int timeoutMillis) override final;
+    using EventHubInterface::getEvents;
+    size_t getEvents(int timeoutMillis, std::span<RawEvent> outEvents) override final;
     std::vector<TouchVideoFrame> getVideoFrames(int32_t deviceId) override final;
 
     bool hasScanCode(int32_t deviceId, int32_t scanCode) const override final;
@@ -696,6 +712,18 @@ private:
         status_t mapLed(int32_t led, int32_t* outScanCode) const;
         void setLedStateLocked(int32_t led, bool on);
 
+        // Events read from the fd in one batch that have not been returned by getEvents yet. The
+        // buffer is reused for every read, and is only refilled once it has been fully consumed so
+        // that the order of the events is preserved.
+        std::vector<struct input_event> readBuffer;
+        size_t readBufferHead;  // index of the next event to return
+        size_t readBufferCount; // number of valid events in the buffer
+        nsecs_t readBufferReadTime;
+        bool hasBufferedEvents() const { return readBufferHead < readBufferCount; }
+        // Read as many events as are available, up to the capacity of the read buffer.
+        // Returns the number of bytes read, or a negative value on error, like read(2).
+        ssize_t fillReadBuffer();
+
         bool currentFrameDropped;
         void trackInputEvent(const struct input_event& event);
         void readDeviceState();
@@ -20,10 +20,13 @@
 #include <utils/Condition.h>
 #include <utils/Mutex.h>
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 
+#include "DeviceProcessingPool.h"
 #include "EventHub.h"
 #include "InputListener.h"
 #include "InputReaderBase.h"
@@ -158,6 +161,11 @@ protected:
                 REQUIRES(mLock) override;
         nsecs_t getLastKeyDownTimestamp() REQUIRES(mReader->mLock) REQUIRES(mLock) override;
         KeyboardClassifier& getKeyboardClassifier() override;
+
+    private:
+        // When devices are being processed in parallel, the calls that touch state shared between
+        // devices must be serialized. Returns an unlocked lock otherwise.
+        std::unique_lock<std::mutex> lockIfProcessingInParallel();
     } mContext;
 
     friend class ContextImpl;
@@ -181,6 +189,18 @@ private:
     // Classifier for keyboard/keyboard-like devices
     std::unique_ptr<KeyboardClassifier> mKeyboardClassifier;
 
+    // Workers used to process the events of independent devices concurrently. Only created when
+    // parallel device processing is enabled.
+    std::unique_ptr<DeviceProcessingPool> mDeviceProcessingPool;
+
+    // Set while the device processing pool is running. Guards the state that the ContextImpl
+    // exposes to the devices, since the reader lock cannot be held by the worker threads.
+    std::atomic<bool> mProcessingDevicesInParallel{false};
+    std::mutex mContextLock;
+
+    // Reused for every call to EventHub::getEvents. Only accessed from the reader thread.
+    std::vector<RawEvent> mEventBuffer;
+
     // As various events are generated inside InputReader, they are stored inside this list. The
     // list can only be accessed with the lock, so the events inside it are well-ordered.
     // Once the reader is done working, these events will be swapped into a temporary storage and
@@ -217,6 +237,8 @@ private:
     [[nodiscard]] std::list<NotifyArgs> processEventsForDeviceLocked(int32_t eventHubId,
                                                                      const RawEvent* rawEvents,
                                                                      size_t count) REQUIRES(mLock);
+    [[nodiscard]] std::list<NotifyArgs> processEventsForDevicesInParallelLocked(
+            const RawEvent* rawEvents, size_t count) REQUIRES(mLock);
     [[nodiscard]] std::list<NotifyArgs> timeoutExpiredLocked(nsecs_t when) REQUIRES(mLock);
 
     void handleConfigurationChangedLocked(nsecs_t when) REQUIRES(mLock);
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../dispatcher/BackgroundLatencyProcessor.h"
+
+#include <binder/Binder.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android::inputdispatcher {
+
+namespace {
+
+using ::testing::HasSubstr;
+
+constexpr ui::LogicalDisplayId DISPLAY_ID = ui::LogicalDisplayId::DEFAULT;
+constexpr ui::LogicalDisplayId SECOND_DISPLAY_ID{42};
+
+InputEventTimeline createTimeline(nsecs_t eventTime, ui::LogicalDisplayId displayId) {
+    InputEventTimeline timeline(/*isDown=*/false, eventTime, /*readTime=*/eventTime + 1, displayId,
+                                /*vendorId=*/0x18d1, /*productId=*/0x4ee7,
+                                /*sources=*/{InputDeviceUsageSource::TOUCHSCREEN});
+    ConnectionTimeline connectionTimeline(/*deliveryTime=*/eventTime + 2,
+                                          /*consumeTime=*/eventTime + 3,
+                                          /*finishTime=*/eventTime + 4);
+    std::array<nsecs_t, GraphicsTimeline::SIZE> graphicsTimeline;
+    graphicsTimeline[GraphicsTimeline::GPU_COMPLETED_TIME] = eventTime + 5;
+    graphicsTimeline[GraphicsTimeline::PRESENT_TIME] = eventTime + 6;
+    connectionTimeline.setGraphicsTimeline(std::move(graphicsTimeline));
+    timeline.connectionTimelines.emplace(sp<BBinder>::make(), std::move(connectionTimeline));
+    return timeline;
+}
+
+class RecordingProcessor : public InputEventTimelineProcessor {
+public:
+    void processTimeline(const InputEventTimeline& timeline) override {
+        std::scoped_lock lock(mLock);
+        mThreadIds.push_back(std::this_thread::get_id());
+        mTimelines.push_back(timeline);
+    }
+
+    std::vector<InputEventTimeline> getTimelines() {
+        std::scoped_lock lock(mLock);
+        return mTimelines;
+    }
+
+    std::vector<std::thread::id> getThreadIds() {
+        std::scoped_lock lock(mLock);
+        return mThreadIds;
+    }
+
+private:
+    std::mutex mLock;
+    std::vector<InputEventTimeline> mTimelines;
+    std::vector<std::thread::id> mThreadIds;
+};
+
+} // namespace
+
+TEST(BackgroundLatencyProcessorTest, ForwardsTimelinesInOrderOnAnotherThread) {
+    RecordingProcessor recordingProcessor;
+    BackgroundLatencyProcessor processor(recordingProcessor);
+
+    const InputEventTimeline first = createTimeline(/*eventTime=*/10, DISPLAY_ID);
+    const InputEventTimeline second = createTimeline(/*eventTime=*/20, SECOND_DISPLAY_ID);
+    processor.processTimeline(first);
+    processor.processTimeline(second);
+    processor.flush();
+
+    const std::vector<InputEventTimeline> timelines = recordingProcessor.getTimelines();
+    ASSERT_EQ(2u, timelines.size());
+    EXPECT_EQ(first, timelines[0]);
+    EXPECT_EQ(second, timelines[1]);
+    for (const std::thread::id& threadId : recordingProcessor.getThreadIds()) {
+        EXPECT_NE(std::this_thread::get_id(), threadId);
+    }
+}
+
+TEST(BackgroundLatencyProcessorTest, DumpContainsPerDisplayAndPerDeviceLatencies) {
+    RecordingProcessor recordingProcessor;
+    BackgroundLatencyProcessor processor(recordingProcessor);
+
+    processor.processTimeline(createTimeline(/*eventTime=*/10, DISPLAY_ID));
+    processor.processTimeline(createTimeline(/*eventTime=*/20, SECOND_DISPLAY_ID));
+    processor.flush();
+
+    const std::string dump = processor.dump("");
+    EXPECT_THAT(dump, HasSubstr("mProcessedTimelines = 2"));
+    EXPECT_THAT(dump, HasSubstr("Display " + DISPLAY_ID.toString() + ":"));
+    EXPECT_THAT(dump, HasSubstr("Display " + SECOND_DISPLAY_ID.toString() + ":"));
+    EXPECT_THAT(dump, HasSubstr("Device 18d1:4ee7:"));
+    EXPECT_THAT(dump, HasSubstr("END_TO_END: count=2"));
+}
+
+TEST(BackgroundLatencyProcessorTest, QueuedTimelinesAreProcessedOnDestruction) {
+    RecordingProcessor recordingProcessor;
+    {
+        BackgroundLatencyProcessor processor(recordingProcessor);
+        processor.processTimeline(createTimeline(/*eventTime=*/10, DISPLAY_ID));
+    }
+    EXPECT_EQ(1u, recordingProcessor.getTimelines().size());
+}
+
+} // namespace android::inputdispatcher
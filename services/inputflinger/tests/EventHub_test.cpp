@@ -22,6 +22,7 @@
 #include <inttypes.h>
 #include <linux/uinput.h>
 #include <log/log.h>
+#include <array>
 #include <chrono>
 
 #define TAG "EventHub_test"
@@ -218,6 +219,35 @@ TEST_F(EventHubTest, InputEvent_TimestampIsMonotonic) {
     }
 }
 
+/**
+ * Events that do not fit into the caller's buffer are kept by the EventHub and returned, in
+ * order, by the following calls.
+ */
+TEST_F(EventHubTest, InputEvent_SmallBufferReturnsRemainingEventsOnNextCall) {
+    ASSERT_NO_FATAL_FAILURE(mKeyboard->pressAndReleaseHomeKey());
+
+    std::vector<RawEvent> events;
+    std::array<RawEvent, 1> buffer;
+    while (events.size() < 4) {
+        const size_t count = mEventHub->getEvents(/*timeoutMillis=*/2000, buffer);
+        ASSERT_EQ(1U, count) << "Expected one event per call, received " << events.size()
+                             << " events so far";
+        events.push_back(buffer[0]);
+    }
+
+    ASSERT_EQ(EV_KEY, events[0].type);
+    ASSERT_EQ(KEY_HOME, events[0].code);
+    ASSERT_EQ(1, events[0].value);
+    ASSERT_EQ(EV_SYN, events[1].type);
+    ASSERT_EQ(EV_KEY, events[2].type);
+    ASSERT_EQ(KEY_HOME, events[2].code);
+    ASSERT_EQ(0, events[2].value);
+    ASSERT_EQ(EV_SYN, events[3].type);
+    for (const RawEvent& event : events) {
+        ASSERT_EQ(mDeviceId, event.deviceId);
+    }
+}
+
 // --- BitArrayTest ---
 class BitArrayTest : public testing::Test {
 protected:
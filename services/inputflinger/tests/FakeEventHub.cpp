@@ -16,6 +16,8 @@
 
 #include "FakeEventHub.h"
 
+#include <algorithm>
+
 #include <android-base/thread_annotations.h>
 #include <gtest/gtest.h>
 #include <linux/input-event-codes.h>
@@ -359,14 +361,15 @@ void FakeEventHub::setExcludedDevices(const std::vector<std::string>& devices) {
     mExcludedDevices = devices;
 }
 
-std::vector<RawEvent> FakeEventHub::getEvents(int) {
+size_t FakeEventHub::getEvents(int, std::span<RawEvent> outEvents) {
     std::scoped_lock lock(mLock);
 
-    std::vector<RawEvent> buffer;
-    std::swap(buffer, mEvents);
+    const size_t count = std::min(mEvents.size(), outEvents.size());
+    std::copy_n(mEvents.begin(), count, outEvents.begin());
+    mEvents.erase(mEvents.begin(), mEvents.begin() + count);
 
     mEventsCondition.notify_all();
-    return buffer;
+    return count;
 }
 
 std::vector<TouchVideoFrame> FakeEventHub::getVideoFrames(int32_t deviceId) {
@@ -1260,6 +1260,93 @@ TEST_F(InputReaderTest, GetLastUsedInputDeviceId) {
     ASSERT_EQ(SECOND_DEVICE_ID, mReader->getLastUsedInputDeviceId());
 }
 
+class InputReaderParallelDeviceProcessingTest : public InputReaderTest {
+protected:
+    void SetUp() override {
+        input_flags::parallel_input_reader_device_processing(true);
+        InputReaderTest::SetUp();
+    }
+
+    void TearDown() override {
+        InputReaderTest::TearDown();
+        input_flags::parallel_input_reader_device_processing(false);
+    }
+};
+
+TEST_F(InputReaderParallelDeviceProcessingTest, EventsFromDifferentDevicesAreMergedByEventTime) {
+    constexpr int32_t FIRST_DEVICE_ID = END_RESERVED_ID + 1000;
+    constexpr int32_t SECOND_DEVICE_ID = FIRST_DEVICE_ID + 1;
+    FakeInputMapper& firstMapper =
+            addDeviceWithFakeInputMapper(FIRST_DEVICE_ID, FIRST_DEVICE_ID, "first",
+                                         InputDeviceClass::TOUCHPAD, AINPUT_SOURCE_TOUCHPAD,
+                                         /*configuration=*/nullptr);
+    FakeInputMapper& secondMapper =
+            addDeviceWithFakeInputMapper(SECOND_DEVICE_ID, SECOND_DEVICE_ID, "second",
+                                         InputDeviceClass::TOUCH_MT, AINPUT_SOURCE_STYLUS,
+                                         /*configuration=*/nullptr);
+
+    firstMapper.setProcessResult({MotionArgsBuilder(AMOTION_EVENT_ACTION_DOWN,
+                                                    AINPUT_SOURCE_TOUCHPAD)
+                                          .deviceId(FIRST_DEVICE_ID)
+                                          .eventTime(ARBITRARY_TIME + 20)
+                                          .pointer(PointerBuilder(/*id=*/0, ToolType::FINGER))
+                                          .build()});
+    secondMapper.setProcessResult(
+            {MotionArgsBuilder(AMOTION_EVENT_ACTION_DOWN, AINPUT_SOURCE_STYLUS)
+                     .deviceId(SECOND_DEVICE_ID)
+                     .eventTime(ARBITRARY_TIME + 10)
+                     .pointer(PointerBuilder(/*id=*/0, ToolType::STYLUS))
+                     .build()});
+
+    // The first device's events are read first, but the second device's event happened earlier.
+    mFakeEventHub->enqueueEvent(ARBITRARY_TIME, ARBITRARY_TIME, FIRST_DEVICE_ID, 0, 0, 0);
+    mFakeEventHub->enqueueEvent(ARBITRARY_TIME, ARBITRARY_TIME, SECOND_DEVICE_ID, 0, 0, 0);
+    mReader->loopOnce();
+
+    ASSERT_NO_FATAL_FAILURE(firstMapper.assertProcessWasCalled());
+    ASSERT_NO_FATAL_FAILURE(secondMapper.assertProcessWasCalled());
+    mFakeListener->assertNotifyMotionWasCalled(
+            AllOf(WithDeviceId(SECOND_DEVICE_ID), WithEventTime(ARBITRARY_TIME + 10)));
+    mFakeListener->assertNotifyMotionWasCalled(
+            AllOf(WithDeviceId(FIRST_DEVICE_ID), WithEventTime(ARBITRARY_TIME + 20)));
+}
+
+TEST_F(InputReaderParallelDeviceProcessingTest, EventsWithSameTimeKeepTheOrderTheyWereRead) {
+    constexpr int32_t FIRST_DEVICE_ID = END_RESERVED_ID + 1000;
+    constexpr int32_t SECOND_DEVICE_ID = FIRST_DEVICE_ID + 1;
+    FakeInputMapper& firstMapper =
+            addDeviceWithFakeInputMapper(FIRST_DEVICE_ID, FIRST_DEVICE_ID, "first",
+                                         InputDeviceClass::TOUCHPAD, AINPUT_SOURCE_TOUCHPAD,
+                                         /*configuration=*/nullptr);
+    FakeInputMapper& secondMapper =
+            addDeviceWithFakeInputMapper(SECOND_DEVICE_ID, SECOND_DEVICE_ID, "second",
+                                         InputDeviceClass::TOUCH_MT, AINPUT_SOURCE_STYLUS,
+                                         /*configuration=*/nullptr);
+
+    firstMapper.setProcessResult({MotionArgsBuilder(AMOTION_EVENT_ACTION_DOWN,
+                                                    AINPUT_SOURCE_TOUCHPAD)
+                                          .deviceId(FIRST_DEVICE_ID)
+                                          .eventTime(ARBITRARY_TIME)
+                                          .pointer(PointerBuilder(/*id=*/0, ToolType::FINGER))
+                                          .build()});
+    secondMapper.setProcessResult(
+            {MotionArgsBuilder(AMOTION_EVENT_ACTION_DOWN, AINPUT_SOURCE_STYLUS)
+                     .deviceId(SECOND_DEVICE_ID)
+                     .eventTime(ARBITRARY_TIME)
+                     .pointer(PointerBuilder(/*id=*/0, ToolType::STYLUS))
+                     .build()});
+
+    // Repeat the loop to catch any dependence on the order in which the workers finish.
+    for (int i = 0; i < 20; i++) {
+        mFakeEventHub->enqueueEvent(ARBITRARY_TIME, ARBITRARY_TIME, SECOND_DEVICE_ID, 0, 0, 0);
+        mFakeEventHub->enqueueEvent(ARBITRARY_TIME, ARBITRARY_TIME, FIRST_DEVICE_ID, 0, 0, 0);
+        mReader->loopOnce();
+
+        mFakeListener->assertNotifyMotionWasCalled(WithDeviceId(SECOND_DEVICE_ID));
+        mFakeListener->assertNotifyMotionWasCalled(WithDeviceId(FIRST_DEVICE_ID));
+    }
+}
+
 class FakeVibratorInputMapper : public FakeInputMapper {
 public:
     FakeVibratorInputMapper(InputDeviceContext& deviceContext,
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../dispatcher/LatencyHistogram.h"
+
+#include <gtest/gtest.h>
+
+namespace android::inputdispatcher {
+
+namespace {
+
+constexpr nsecs_t MS = 1'000'000;
+
+// The histogram only guarantees an upper bound within one bucket, which is about 19% wide.
+void expectPercentileNear(const LatencyHistogram& histogram, float percentile, nsecs_t expected) {
+    const nsecs_t actual = histogram.getPercentile(percentile);
+    EXPECT_GE(actual, expected) << "p" << percentile;
+    EXPECT_LE(actual, expected * 1.2) << "p" << percentile;
+}
+
+} // namespace
+
+TEST(LatencyHistogramTest, EmptyHistogramReportsZero) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(0u, histogram.count());
+    EXPECT_EQ(0, histogram.getPercentile(50));
+}
+
+TEST(LatencyHistogramTest, SingleSample) {
+    LatencyHistogram histogram;
+    histogram.record(16 * MS);
+    EXPECT_EQ(1u, histogram.count());
+    expectPercentileNear(histogram, 0, 16 * MS);
+    expectPercentileNear(histogram, 50, 16 * MS);
+    expectPercentileNear(histogram, 100, 16 * MS);
+}
+
+TEST(LatencyHistogramTest, Percentiles) {
+    LatencyHistogram histogram;
+    for (nsecs_t latency = 1; latency <= 100; latency++) {
+        histogram.record(latency * MS);
+    }
+    EXPECT_EQ(100u, histogram.count());
+    expectPercentileNear(histogram, 50, 50 * MS);
+    expectPercentileNear(histogram, 90, 90 * MS);
+    expectPercentileNear(histogram, 99, 99 * MS);
+}
+
+TEST(LatencyHistogramTest, OutOfRangeLatenciesAreClamped) {
+    LatencyHistogram histogram;
+    histogram.record(-5 * MS);
+    histogram.record(0);
+    EXPECT_LE(histogram.getPercentile(100), 1 * MS);
+
+    histogram.record(3600'000 * MS);
+    histogram.record(3600'000 * MS);
+    histogram.record(3600'000 * MS);
+    EXPECT_GT(histogram.getPercentile(99), 1000 * MS);
+}
+
+} // namespace android::inputdispatcher
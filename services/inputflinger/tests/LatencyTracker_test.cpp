@@ -35,6 +35,7 @@ namespace android::inputdispatcher {
 namespace {
 
 constexpr DeviceId DEVICE_ID = 100;
+constexpr ui::LogicalDisplayId DISPLAY_ID = ui::LogicalDisplayId::DEFAULT;
 
 static InputDeviceInfo generateTestDeviceInfo(uint16_t vendorId, uint16_t productId,
                                               DeviceId deviceId) {
@@ -64,6 +65,7 @@ InputEventTimeline getTestTimeline() {
             /*isDown=*/true,
             /*eventTime=*/2,
             /*readTime=*/3,
+            DISPLAY_ID,
             /*vendorId=*/0,
             /*productId=*/0,
             /*sources=*/{InputDeviceUsageSource::UNKNOWN});
@@ -117,7 +119,7 @@ void LatencyTrackerTest::triggerEventReporting(nsecs_t lastEventTime) {
     const nsecs_t triggerEventTime =
             lastEventTime + std::chrono::nanoseconds(ANR_TIMEOUT).count() + 1;
     mTracker->trackListener(/*inputEventId=*/1, /*isDown=*/true, triggerEventTime,
-                            /*readTime=*/3, DEVICE_ID,
+                            /*readTime=*/3, DEVICE_ID, DISPLAY_ID,
                             /*sources=*/{InputDeviceUsageSource::UNKNOWN});
 }
 
@@ -168,10 +170,12 @@ void LatencyTrackerTest::assertReceivedTimelines(const std::vector<InputEventTim
  */
 TEST_F(LatencyTrackerTest, TrackListener_DoesNotTriggerReporting) {
     mTracker->trackListener(/*inputEventId=*/1, /*isDown=*/false, /*eventTime=*/2,
-                            /*readTime=*/3, DEVICE_ID, {InputDeviceUsageSource::UNKNOWN});
+                            /*readTime=*/3, DEVICE_ID, DISPLAY_ID,
+                            {InputDeviceUsageSource::UNKNOWN});
     triggerEventReporting(/*eventTime=*/2);
     assertReceivedTimeline(InputEventTimeline{/*isDown=*/false, /*eventTime=*/2,
-                                              /*readTime=*/3, /*vendorId=*/0, /*productID=*/0,
+                                              /*readTime=*/3, DISPLAY_ID, /*vendorId=*/0,
+                                              /*productID=*/0,
                                               /*sources=*/{InputDeviceUsageSource::UNKNOWN}});
 }
 
@@ -204,7 +208,7 @@ TEST_F(LatencyTrackerTest, TrackAllParameters_ReportsFullTimeline) {
     const auto& [connectionToken, expectedCT] = *expected.connectionTimelines.begin();
 
     mTracker->trackListener(inputEventId, expected.isDown, expected.eventTime, expected.readTime,
-                            DEVICE_ID, {InputDeviceUsageSource::UNKNOWN});
+                            DEVICE_ID, DISPLAY_ID, {InputDeviceUsageSource::UNKNOWN});
     mTracker->trackFinishedEvent(inputEventId, connectionToken, expectedCT.deliveryTime,
                                  expectedCT.consumeTime, expectedCT.finishTime);
     mTracker->trackGraphicsLatency(inputEventId, connectionToken, expectedCT.graphicsTimeline);
@@ -225,9 +229,9 @@ TEST_F(LatencyTrackerTest, WhenDuplicateEventsAreReported_DoesNotCrash) {
     // In the following 2 calls to trackListener, the inputEventId's are the same, but event times
     // are different.
     mTracker->trackListener(inputEventId, isDown, /*eventTime=*/1, readTime, DEVICE_ID,
-                            {InputDeviceUsageSource::UNKNOWN});
+                            DISPLAY_ID, {InputDeviceUsageSource::UNKNOWN});
     mTracker->trackListener(inputEventId, isDown, /*eventTime=*/2, readTime, DEVICE_ID,
-                            {InputDeviceUsageSource::UNKNOWN});
+                            DISPLAY_ID, {InputDeviceUsageSource::UNKNOWN});
 
     triggerEventReporting(/*eventTime=*/2);
     // Since we sent duplicate input events, the tracker should just delete all of them, because it
@@ -241,6 +245,7 @@ TEST_F(LatencyTrackerTest, MultipleEvents_AreReportedConsistently) {
             /*isDown*/ true,
             /*eventTime*/ 2,
             /*readTime*/ 3,
+            DISPLAY_ID,
             /*vendorId=*/0,
             /*productId=*/0,
             /*sources=*/{InputDeviceUsageSource::UNKNOWN});
@@ -258,6 +263,7 @@ TEST_F(LatencyTrackerTest, MultipleEvents_AreReportedConsistently) {
             /*isDown=*/false,
             /*eventTime=*/20,
             /*readTime=*/30,
+            DISPLAY_ID,
             /*vendorId=*/0,
             /*productId=*/0,
             /*sources=*/{InputDeviceUsageSource::UNKNOWN});
@@ -273,10 +279,12 @@ TEST_F(LatencyTrackerTest, MultipleEvents_AreReportedConsistently) {
 
     // Start processing first event
     mTracker->trackListener(inputEventId1, timeline1.isDown, timeline1.eventTime,
-                            timeline1.readTime, DEVICE_ID, {InputDeviceUsageSource::UNKNOWN});
+                            timeline1.readTime, DEVICE_ID, DISPLAY_ID,
+                            {InputDeviceUsageSource::UNKNOWN});
     // Start processing second event
     mTracker->trackListener(inputEventId2, timeline2.isDown, timeline2.eventTime,
-                            timeline2.readTime, DEVICE_ID, {InputDeviceUsageSource::UNKNOWN});
+                            timeline2.readTime, DEVICE_ID, DISPLAY_ID,
+                            {InputDeviceUsageSource::UNKNOWN});
     mTracker->trackFinishedEvent(inputEventId1, connection1, connectionTimeline1.deliveryTime,
                                  connectionTimeline1.consumeTime, connectionTimeline1.finishTime);
 
@@ -302,11 +310,12 @@ TEST_F(LatencyTrackerTest, IncompleteEvents_AreHandledConsistently) {
 
     for (size_t i = 1; i <= 100; i++) {
         mTracker->trackListener(/*inputEventId=*/i, timeline.isDown, timeline.eventTime,
-                                timeline.readTime, /*deviceId=*/DEVICE_ID,
+                                timeline.readTime, /*deviceId=*/DEVICE_ID, DISPLAY_ID,
                                 /*sources=*/{InputDeviceUsageSource::UNKNOWN});
         expectedTimelines.push_back(InputEventTimeline{timeline.isDown, timeline.eventTime,
-                                                       timeline.readTime, timeline.vendorId,
-                                                       timeline.productId, timeline.sources});
+                                                       timeline.readTime, timeline.displayId,
+                                                       timeline.vendorId, timeline.productId,
+                                                       timeline.sources});
     }
     // Now, complete the first event that was sent.
     mTracker->trackFinishedEvent(/*inputEventId=*/1, token, expectedCT.deliveryTime,
@@ -333,11 +342,12 @@ TEST_F(LatencyTrackerTest, EventsAreTracked_WhenTrackListenerIsCalledFirst) {
     mTracker->trackGraphicsLatency(inputEventId, connection1, expectedCT.graphicsTimeline);
 
     mTracker->trackListener(inputEventId, expected.isDown, expected.eventTime, expected.readTime,
-                            DEVICE_ID, {InputDeviceUsageSource::UNKNOWN});
+                            DEVICE_ID, DISPLAY_ID, {InputDeviceUsageSource::UNKNOWN});
     triggerEventReporting(expected.eventTime);
     assertReceivedTimeline(InputEventTimeline{expected.isDown, expected.eventTime,
-                                              expected.readTime, expected.vendorId,
-                                              expected.productId, expected.sources});
+                                              expected.readTime, expected.displayId,
+                                              expected.vendorId, expected.productId,
+                                              expected.sources});
 }
 
 /**
@@ -348,7 +358,7 @@ TEST_F(LatencyTrackerTest, EventsAreTracked_WhenTrackListenerIsCalledFirst) {
 TEST_F(LatencyTrackerTest, TrackListenerCheck_DeviceInfoFieldsInputEventTimeline) {
     constexpr int32_t inputEventId = 1;
     InputEventTimeline timeline(
-            /*isDown*/ true, /*eventTime*/ 2, /*readTime*/ 3,
+            /*isDown*/ true, /*eventTime*/ 2, /*readTime*/ 3, DISPLAY_ID,
             /*vendorId=*/50, /*productId=*/60,
             /*sources=*/
             {InputDeviceUsageSource::TOUCHSCREEN, InputDeviceUsageSource::STYLUS_DIRECT});
@@ -359,7 +369,7 @@ TEST_F(LatencyTrackerTest, TrackListenerCheck_DeviceInfoFieldsInputEventTimeline
 
     mTracker->setInputDevices({deviceInfo1, deviceInfo2});
     mTracker->trackListener(inputEventId, timeline.isDown, timeline.eventTime, timeline.readTime,
-                            DEVICE_ID,
+                            DEVICE_ID, DISPLAY_ID,
                             {InputDeviceUsageSource::TOUCHSCREEN,
                              InputDeviceUsageSource::STYLUS_DIRECT});
     triggerEventReporting(timeline.eventTime);
@@ -69,10 +69,11 @@ extern "C" int LLVMFuzzerTestOneInput(uint8_t* data, size_t size) {
                     nsecs_t eventTime = fdp.ConsumeIntegral<nsecs_t>();
                     nsecs_t readTime = fdp.ConsumeIntegral<nsecs_t>();
                     const DeviceId deviceId = fdp.ConsumeIntegral<int32_t>();
+                    const ui::LogicalDisplayId displayId{fdp.ConsumeIntegral<int32_t>()};
                     std::set<InputDeviceUsageSource> sources = {
                             fdp.ConsumeEnum<InputDeviceUsageSource>()};
                     tracker.trackListener(inputEventId, isDown, eventTime, readTime, deviceId,
-                                          sources);
+                                          displayId, sources);
                 },
                 [&]() -> void {
                     int32_t inputEventId = fdp.ConsumeIntegral<int32_t>();
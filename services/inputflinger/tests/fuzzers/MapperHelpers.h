@@ -15,6 +15,7 @@
  */
 #pragma once
 
+#include <algorithm>
 #include <map>
 #include <memory>
 
@@ -143,13 +144,13 @@ public:
         return mFdp->ConsumeIntegral<status_t>();
     }
     void setExcludedDevices(const std::vector<std::string>& devices) override {}
-    std::vector<RawEvent> getEvents(int timeoutMillis) override {
-        std::vector<RawEvent> events;
-        const size_t count = mFdp->ConsumeIntegralInRange<size_t>(0, kMaxSize);
+    size_t getEvents(int timeoutMillis, std::span<RawEvent> outEvents) override {
+        const size_t count = mFdp->ConsumeIntegralInRange<size_t>(
+                0, std::min<size_t>(kMaxSize, outEvents.size()));
         for (size_t i = 0; i < count; ++i) {
-            events.push_back(getFuzzedRawEvent(*mFdp));
+            outEvents[i] = getFuzzedRawEvent(*mFdp);
         }
-        return events;
+        return count;
     }
     std::vector<TouchVideoFrame> getVideoFrames(int32_t deviceId) override { return mVideoFrames; }
 
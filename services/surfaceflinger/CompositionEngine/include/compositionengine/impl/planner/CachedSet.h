@@ -65,15 +65,17 @@ public:
     size_t getLayerCount() const { return mLayers.size(); }
     const Layer& getFirstLayer() const { return mLayers[0]; }
     const Rect& getBounds() const { return mBounds; }
-    Rect getTextureBounds() const {
-        return mTexture ? mTexture->get()->getBuffer()->getBounds() : Rect::INVALID_RECT;
-    }
+    // The area of the output covered by the texture, which is the whole output unless the texture
+    // is downsized.
+    Rect getTextureBounds() const { return mTexture ? mTextureBounds : Rect::INVALID_RECT; }
     const Region& getVisibleRegion() const { return mVisibleRegion; }
     size_t getAge() const { return mAge; }
     std::shared_ptr<renderengine::ExternalTexture> getBuffer() const {
         return mTexture ? mTexture->get() : nullptr;
     }
     const sp<Fence>& getDrawFence() const { return mDrawFence; }
+    // The time at which the last render started, to time it once the draw fence signals
+    nsecs_t getRenderStartTime() const { return mRenderStartTime; }
     const ProjectionSpace& getOutputSpace() const { return mOutputSpace; }
     ui::Dataspace getOutputDataspace() const { return mOutputDataspace; }
     const std::vector<Layer>& getConstituentLayers() const { return mLayers; }
@@ -166,7 +168,9 @@ private:
     // TODO(b/190411067): This is a shared pointer only because CachedSets are copied into different
     // containers in the Flattener. Logically this should have unique ownership otherwise.
     std::shared_ptr<TexturePool::AutoTexture> mTexture;
+    Rect mTextureBounds;
     sp<Fence> mDrawFence;
+    nsecs_t mRenderStartTime = 0;
     ProjectionSpace mOutputSpace;
     ui::Dataspace mOutputDataspace;
     ui::Transform::RotationFlags mOrientation = ui::Transform::ROT_0;
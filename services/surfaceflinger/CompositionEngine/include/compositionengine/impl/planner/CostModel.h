@@ -0,0 +1,80 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <ui/Rect.h>
+#include <ui/GraphicTypes.h>
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace android::compositionengine::impl::planner {
+
+class LayerState;
+
+// Estimates how long the GPU takes to draw a set of layers, from the work each of them requires.
+// The estimate is a weighted sum of the features below. The weights start from rough defaults, and
+// are refined from the render times of the cached sets that RenderEngine draws.
+class CostModel {
+public:
+    enum Feature : size_t {
+        // Pixels sampled from the layers' buffers, in megapixels
+        PixelsRead,
+        // Pixels written to the output buffer, in megapixels
+        PixelsWritten,
+        // Pixels of layers blurring what's behind them, in megapixels
+        BlurredPixels,
+        // Pixels of layers with rounded corners, in megapixels
+        RoundedCornerPixels,
+        // Pixels of layers in another dataspace than the output, in megapixels
+        ConvertedPixels,
+        // Number of layers, for the fixed cost of each of them
+        Layers,
+        kFeatureCount,
+    };
+    using Features = std::array<float, kFeatureCount>;
+
+    // Returns the features of drawing the layers into a buffer that covers the given bounds.
+    static Features getFeatures(const std::vector<const LayerState*>& layers, const Rect& bounds,
+                                ui::Dataspace outputDataspace);
+
+    std::chrono::nanoseconds predict(const Features& features) const;
+
+    // Refines the weights with the time it actually took to draw layers with the given features.
+    void addSample(const Features& features, std::chrono::nanoseconds duration);
+
+    void dump(std::string& result) const;
+
+private:
+    // Nanoseconds per unit of each feature
+    Features mWeights = {
+            250'000.f,   // PixelsRead
+            250'000.f,   // PixelsWritten
+            2'000'000.f, // BlurredPixels
+            100'000.f,   // RoundedCornerPixels
+            150'000.f,   // ConvertedPixels
+            20'000.f,    // Layers
+    };
+
+    size_t mSampleCount = 0;
+    // Exponential moving average of the relative error of the predictions
+    float mAverageError = 0.f;
+};
+
+} // namespace android::compositionengine::impl::planner
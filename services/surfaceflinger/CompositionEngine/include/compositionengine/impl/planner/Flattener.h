@@ -18,6 +18,7 @@
 
 #include <compositionengine/Output.h>
 #include <compositionengine/impl/planner/CachedSet.h>
+#include <compositionengine/impl/planner/CostModel.h>
 #include <compositionengine/impl/planner/LayerState.h>
 
 #include <chrono>
@@ -93,6 +94,9 @@ public:
     static constexpr int kNumLayersFpsConsideration = 1;
     // Frames/Second threshold below which these CachedSets may be considered inactive.
     static constexpr float kFpsActiveThreshold = 1.f;
+    // Number of frames over which the cost of rendering a cached set is expected to be paid back
+    // when choosing which run to flatten.
+    static constexpr int64_t kRenderCostAmortizationFrames = 60;
 
     Flattener(renderengine::RenderEngine& renderEngine, const Tunables& tunables);
 
@@ -225,7 +229,28 @@ private:
 
     std::vector<Run> findCandidateRuns(std::chrono::steady_clock::time_point now) const;
 
-    std::optional<Run> findBestRun(std::vector<Run>& runs) const;
+    // The expected costs and savings of flattening a Run, as estimated by the cost model.
+    struct RunEvaluation {
+        std::string firstLayerName;
+        size_t layerCount = 0;
+        // GPU time to render the cached set
+        std::chrono::nanoseconds renderCost{0};
+        // GPU or display time saved by composing the cached set instead of its layers
+        std::chrono::nanoseconds savingsPerFrame{0};
+        bool chosen = false;
+
+        std::chrono::nanoseconds getScore() const {
+            return savingsPerFrame - renderCost / kRenderCostAmortizationFrames;
+        }
+    };
+
+    RunEvaluation evaluateRun(const Run& run) const;
+
+    // Picks the run with the best score. Ties go to the earliest run.
+    std::optional<Run> findBestRun(std::vector<Run>& runs);
+
+    // Feeds the time the cached set took to render back into the cost model.
+    void recordRenderTime(const CachedSet& cachedSet);
 
     void buildCachedSets(std::chrono::steady_clock::time_point now);
 
@@ -234,6 +259,12 @@ private:
 
     TexturePool mTexturePool;
 
+    CostModel mCostModel;
+    // The dataspace of the output the cached sets were last rendered for
+    ui::Dataspace mOutputDataspace = ui::Dataspace::UNKNOWN;
+    // The runs considered the last time a cached set was built, for dumpsys
+    std::vector<RunEvaluation> mLastRunEvaluations;
+
 protected:
     // mNewCachedSet must be destroyed before mTexturePool is.
     std::optional<CachedSet> mNewCachedSet;
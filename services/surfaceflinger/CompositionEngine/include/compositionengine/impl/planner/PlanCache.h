@@ -0,0 +1,125 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <compositionengine/impl/planner/LayerState.h>
+#include <compositionengine/impl/planner/Predictor.h>
+
+#include <android-base/thread_annotations.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace android::compositionengine::impl::planner {
+
+// Keeps the plans the Predictor has learned in a file, so that they survive SurfaceFlinger
+// restarts. Plans are keyed by the hash of their layer stack, and the least recently used ones are
+// evicted once the cache is full.
+//
+// The file is only read on the first lookup, so that it doesn't delay startup. A file that is
+// corrupted, truncated, of another format version or written by another build is ignored, since
+// layer stack hashes are only stable within a build.
+//
+// Periodic saves write the file on a background thread, so that the composition thread never waits
+// on storage.
+//
+// One cache is shared by the planners of all displays, which may run on different threads, so it is
+// thread-safe.
+class PlanCache {
+public:
+    static constexpr size_t kDefaultCapacity = 128;
+    // Writing is rate limited, since it wears the storage
+    static constexpr std::chrono::seconds kMinSaveInterval = std::chrono::seconds(30);
+
+    PlanCache(std::string path, std::string buildId, size_t capacity = kDefaultCapacity);
+    // Finishes the pending background write, if any.
+    ~PlanCache();
+
+    // Returns the plan cached for the layer stack, and marks it as the most recently used.
+    std::optional<Plan> get(NonBufferHash hash) const;
+
+    // Caches the plan for the layer stack, evicting the least recently used plan if needed.
+    void put(NonBufferHash hash, const Plan& plan);
+
+    void erase(NonBufferHash hash);
+
+    size_t size() const;
+
+    // Writes the cache to its file if it changed since it was last written, waiting for the write.
+    // Returns whether the file is up-to-date.
+    bool save();
+
+    // Saves the cache in the background if it changed and it wasn't written in the last
+    // kMinSaveInterval. A failed write is retried on the next call after the interval.
+    void saveIfNeeded(std::chrono::steady_clock::time_point now);
+
+    // Waits for the background write started by saveIfNeeded, if any.
+    void waitForPendingSave();
+
+    void dump(std::string& result) const;
+
+private:
+    struct Entry {
+        NonBufferHash hash;
+        Plan plan;
+    };
+
+    void loadIfNeeded() const REQUIRES(mMutex);
+    bool load() const REQUIRES(mMutex);
+    std::string serialize() const REQUIRES(mMutex);
+    bool write(const std::string& data) const;
+    void queueWrite(std::string data);
+    void runWriter();
+
+    const std::string mPath;
+    const std::string mBuildId;
+    const size_t mCapacity;
+
+    mutable std::mutex mMutex;
+
+    // Most recently used first
+    mutable std::list<Entry> mEntries GUARDED_BY(mMutex);
+    mutable std::unordered_map<NonBufferHash, std::list<Entry>::iterator> mEntriesByHash
+            GUARDED_BY(mMutex);
+    mutable bool mLoaded GUARDED_BY(mMutex) = false;
+
+    bool mDirty GUARDED_BY(mMutex) = false;
+    std::optional<std::chrono::steady_clock::time_point> mLastSaveTime GUARDED_BY(mMutex);
+
+    mutable size_t mHitCount GUARDED_BY(mMutex) = 0;
+    mutable size_t mMissCount GUARDED_BY(mMutex) = 0;
+    mutable bool mFileRejected GUARDED_BY(mMutex) = false;
+
+    std::mutex mWriterMutex;
+    std::condition_variable mWriterCondition;
+    // The latest serialized cache that is waiting to be written
+    std::optional<std::string> mPendingWrite GUARDED_BY(mWriterMutex);
+    bool mWriting GUARDED_BY(mWriterMutex) = false;
+    bool mWriterDone GUARDED_BY(mWriterMutex) = false;
+    std::atomic<bool> mWriteFailed = false;
+    // Started by the first background write
+    std::thread mWriterThread;
+};
+
+} // namespace android::compositionengine::impl::planner
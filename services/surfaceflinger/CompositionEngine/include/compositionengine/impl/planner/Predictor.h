@@ -20,8 +20,13 @@
 
 #include <compositionengine/impl/planner/LayerState.h>
 
+#include <chrono>
+#include <memory>
+
 namespace android::compositionengine::impl::planner {
 
+class PlanCache;
+
 class LayerStack {
 public:
     LayerStack(const std::vector<const LayerState*>& layers) : mLayers(copyLayers(layers)) {}
@@ -223,6 +228,9 @@ private:
 
 class Predictor {
 public:
+    Predictor();
+    ~Predictor();
+
     struct PredictedPlan {
         NonBufferHash hash;
         Plan plan;
@@ -249,6 +257,11 @@ public:
     void recordResult(std::optional<PredictedPlan> predictedPlan, NonBufferHash flattenedHash,
                       const std::vector<const LayerState*>&, bool hasSkippedLayers, Plan result);
 
+    // Keeps the plans that are learned in the given cache, and predicts them for layer stacks that
+    // haven't been seen since SurfaceFlinger started. The cache may be shared with other displays.
+    void setPlanCache(std::shared_ptr<PlanCache>);
+    void savePlanCache(std::chrono::steady_clock::time_point now);
+
     void dump(std::string&) const;
 
     void compareLayerStacks(NonBufferHash leftHash, NonBufferHash rightHash, std::string&) const;
@@ -264,7 +277,11 @@ private:
     std::optional<NonBufferHash> getApproximateMatch(
             const std::vector<const LayerState*>& layers) const;
 
+    bool hasPrediction(NonBufferHash) const;
+    void addCandidate(NonBufferHash, const std::vector<const LayerState*>& layers, Plan result);
     void promoteIfCandidate(NonBufferHash);
+    void recordCachedResult(PredictedPlan, const std::vector<const LayerState*>& layers,
+                            Plan result);
     void recordPredictedResult(PredictedPlan, const std::vector<const LayerState*>& layers,
                                Plan result);
     bool findSimilarPrediction(const std::vector<const LayerState*>& layers, Plan result);
@@ -306,6 +323,8 @@ private:
 
     std::vector<ApproximateStack> mApproximateStacks;
 
+    std::shared_ptr<PlanCache> mPlanCache;
+
     mutable size_t mExactHitCount = 0;
     mutable size_t mApproximateHitCount = 0;
     mutable size_t mMissCount = 0;
@@ -23,6 +23,7 @@
 
 #include <renderengine/ExternalTexture.h>
 #include <chrono>
+#include <optional>
 #include "android-base/macros.h"
 
 namespace android::compositionengine::impl::planner {
@@ -31,8 +32,13 @@ namespace android::compositionengine::impl::planner {
 // While it is possible to define a texture pool supporting variable-sized textures to save on
 // memory, it is a simpler implementation to only manage screen-sized textures. The texture pool is
 // unbounded - there are a minimum number of textures preallocated. Under heavy system load, new
-// textures may be allocated, but only a maximum number of retained once those textures are no
-// longer necessary.
+// textures may be allocated, but only a target number of them are retained once those textures
+// are no longer necessary. The target follows the demand from the Flattener: it grows up to a high
+// watermark whenever the pool runs dry, and decays down to a low watermark over time while the
+// pool never does.
+// Cached sets much smaller than the screen may instead borrow a downsized texture, which is
+// allocated to their size. A few of those are pooled as well, and reused for cached sets of the
+// same size.
 class TexturePool {
 public:
     // RAII class helping with managing textures from the texture pool
@@ -41,10 +47,14 @@ public:
     class AutoTexture {
     public:
         AutoTexture(TexturePool& texturePool,
-                    std::shared_ptr<renderengine::ExternalTexture> texture, const sp<Fence>& fence)
-              : mTexturePool(texturePool), mTexture(texture), mFence(fence) {}
+                    std::shared_ptr<renderengine::ExternalTexture> texture, const sp<Fence>& fence,
+                    bool downsized = false)
+              : mTexturePool(texturePool),
+                mTexture(texture),
+                mFence(fence),
+                mDownsized(downsized) {}
 
-        ~AutoTexture() { mTexturePool.returnTexture(std::move(mTexture), mFence); }
+        ~AutoTexture() { mTexturePool.returnTexture(std::move(mTexture), mFence, mDownsized); }
 
         sp<Fence> getReadyFence() { return mFence; }
 
@@ -57,10 +67,14 @@ public:
         // Gets a pointer to the underlying external texture
         const std::shared_ptr<renderengine::ExternalTexture>& get() const { return mTexture; }
 
+        // Whether the texture was borrowed with borrowDownsizedTexture
+        bool isDownsized() const { return mDownsized; }
+
     private:
         TexturePool& mTexturePool;
         std::shared_ptr<renderengine::ExternalTexture> mTexture;
         sp<Fence> mFence;
+        const bool mDownsized;
     };
 
     TexturePool(renderengine::RenderEngine& renderEngine)
@@ -79,6 +93,18 @@ public:
     // to the pool.
     std::shared_ptr<AutoTexture> borrowTexture();
 
+    // Returns whether content of the given size is small enough to be rendered into a downsized
+    // texture instead of a screen-sized one.
+    bool shouldDownsize(ui::Size size) const;
+
+    // Borrows a texture of the given size, reusing a pooled one of the same size if possible.
+    std::shared_ptr<AutoTexture> borrowDownsizedTexture(ui::Size size);
+
+    // Notifies the pool that a frame went by, so that it can give back the textures it no longer
+    // needs when the demand drops. The demand decays with the time elapsed since the last call, so
+    // a display that was idle for a while gives back its textures on its next frame.
+    void onFrame(std::chrono::steady_clock::time_point now);
+
     // Enables or disables the pool. When the pool is disabled, no buffers will
     // be held by the pool. This is useful when the active display changes.
     void setEnabled(bool enable);
@@ -87,8 +113,18 @@ public:
 
 protected:
     // Proteted visibility so that they can be used for testing
+    // Number of textures preallocated when the pool is (re)allocated
     const static constexpr size_t kMinPoolSize = 3;
+    // Bounds for the number of textures retained by the pool
     const static constexpr size_t kMaxPoolSize = 4;
+    const static constexpr size_t kLowWatermark = 1;
+    // Time without the pool running dry after which the pool retains one texture less
+    const static constexpr std::chrono::steady_clock::duration kShrinkAfter =
+            std::chrono::seconds(2);
+    // Content covering at most this fraction of the screen is rendered into a downsized texture
+    const static constexpr int64_t kDownsizeAreaRatio = 4;
+    // Number of downsized textures retained by the pool
+    const static constexpr size_t kMaxDownsizedPoolSize = 2;
 
     struct Entry {
         std::shared_ptr<renderengine::ExternalTexture> texture;
@@ -96,12 +132,27 @@ protected:
     };
 
     std::deque<Entry> mPool;
+    // Most recently returned first
+    std::deque<Entry> mDownsizedPool;
+    size_t mTargetPoolSize = kMinPoolSize;
+    // When the pool last ran dry or shrunk, once a frame went by
+    std::optional<std::chrono::steady_clock::time_point> mLastResizeTime;
+    bool mStarved = false;
+
+    // Statistics
+    size_t mBorrowedCount = 0;
+    size_t mDownsizedBorrowedCount = 0;
+    size_t mDownsizedBytesInUse = 0;
+    size_t mHitCount = 0;
+    size_t mMissCount = 0;
+    size_t mDownsizedHitCount = 0;
+    size_t mDownsizedMissCount = 0;
 
 private:
-    std::shared_ptr<renderengine::ExternalTexture> genTexture();
+    std::shared_ptr<renderengine::ExternalTexture> genTexture(ui::Size size);
     // Returns a previously borrowed texture to the pool.
     void returnTexture(std::shared_ptr<renderengine::ExternalTexture>&& texture,
-                       const sp<Fence>& fence);
+                       const sp<Fence>& fence, bool downsized);
     void allocatePool();
     renderengine::RenderEngine& mRenderEngine;
     ui::Size mSize;
@@ -262,7 +262,20 @@ void CachedSet::render(renderengine::RenderEngine& renderEngine, TexturePool& te
         layerSettings.emplace_back(highlight);
     }
 
-    auto texture = texturePool.borrowTexture();
+    // A cached set much smaller than the display is rendered into a texture of its own size, with
+    // its bounds at the origin. Its bounds are in display space, so this only applies when the
+    // framebuffer matches the display and isn't rotated.
+    const ui::Size boundsSize(mBounds.getWidth(), mBounds.getHeight());
+    const bool downsize = orientation == ui::Transform::ROT_0 &&
+            outputState.framebufferSpace.getBoundsAsRect() ==
+                    outputState.displaySpace.getBoundsAsRect() &&
+            texturePool.shouldDownsize(boundsSize);
+    if (downsize) {
+        displaySettings.physicalDisplay.offsetBy(-mBounds.left, -mBounds.top);
+    }
+
+    auto texture = downsize ? texturePool.borrowDownsizedTexture(boundsSize)
+                            : texturePool.borrowTexture();
     LOG_ALWAYS_FATAL_IF(texture->get()->getBuffer()->initCheck() != OK);
 
     base::unique_fd bufferFence;
@@ -274,6 +287,7 @@ void CachedSet::render(renderengine::RenderEngine& renderEngine, TexturePool& te
         bufferFence.reset(texture->getReadyFence()->dup());
     }
 
+    const nsecs_t renderStartTime = systemTime();
     auto fenceResult = renderEngine
                                .drawLayers(displaySettings, layerSettings, texture->get(),
                                            std::move(bufferFence))
@@ -281,9 +295,11 @@ void CachedSet::render(renderengine::RenderEngine& renderEngine, TexturePool& te
 
     if (fenceStatus(fenceResult) == NO_ERROR) {
         mDrawFence = std::move(fenceResult).value_or(Fence::NO_FENCE);
+        mRenderStartTime = renderStartTime;
         mOutputSpace = outputState.framebufferSpace;
         mTexture = texture;
         mTexture->setReadyFence(mDrawFence);
+        mTextureBounds = downsize ? mBounds : mTexture->get()->getBuffer()->getBounds();
         mOutputSpace.setOrientation(outputState.framebufferSpace.getOrientation());
         mOutputDataspace = outputDataspace;
         mOrientation = orientation;
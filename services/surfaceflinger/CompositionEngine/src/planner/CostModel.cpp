@@ -0,0 +1,137 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "Planner"
+// #define LOG_NDEBUG 0
+
+#include <android-base/stringprintf.h>
+#include <compositionengine/LayerFE.h>
+#include <compositionengine/OutputLayer.h>
+#include <compositionengine/impl/planner/CostModel.h>
+#include <compositionengine/impl/planner/LayerState.h>
+#include <utils/Log.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace android::compositionengine::impl::planner {
+
+namespace {
+
+// How much a single sample moves the weights towards explaining it
+constexpr float kLearningRate = 0.5f;
+// Weight of the latest sample in the average error
+constexpr float kErrorSmoothing = 0.1f;
+
+float megapixels(const Rect& rect) {
+    return static_cast<float>(rect.width()) * static_cast<float>(rect.height()) / 1'000'000.f;
+}
+
+const char* featureName(CostModel::Feature feature) {
+    switch (feature) {
+        case CostModel::PixelsRead:
+            return "read";
+        case CostModel::PixelsWritten:
+            return "written";
+        case CostModel::BlurredPixels:
+            return "blurred";
+        case CostModel::RoundedCornerPixels:
+            return "rounded corners";
+        case CostModel::ConvertedPixels:
+            return "converted";
+        case CostModel::Layers:
+            return "layers";
+        case CostModel::kFeatureCount:
+            break;
+    }
+    return "unknown";
+}
+
+} // namespace
+
+CostModel::Features CostModel::getFeatures(const std::vector<const LayerState*>& layers,
+                                           const Rect& bounds, ui::Dataspace outputDataspace) {
+    Features features{};
+    for (const LayerState* layer : layers) {
+        const float pixels = megapixels(layer->getDisplayFrame());
+        features[PixelsRead] += pixels;
+        if (layer->hasBlurBehind()) {
+            features[BlurredPixels] += pixels;
+        }
+        if (layer->getOutputLayer()->getLayerFE().hasRoundedCorners()) {
+            features[RoundedCornerPixels] += pixels;
+        }
+        if (outputDataspace != ui::Dataspace::UNKNOWN &&
+            layer->getDataspace() != ui::Dataspace::UNKNOWN &&
+            layer->getDataspace() != outputDataspace) {
+            features[ConvertedPixels] += pixels;
+        }
+        features[Layers] += 1.f;
+    }
+    features[PixelsWritten] = megapixels(bounds);
+    return features;
+}
+
+std::chrono::nanoseconds CostModel::predict(const Features& features) const {
+    float cost = 0.f;
+    for (size_t i = 0; i < kFeatureCount; i++) {
+        cost += mWeights[i] * features[i];
+    }
+    return std::chrono::nanoseconds(static_cast<int64_t>(cost));
+}
+
+void CostModel::addSample(const Features& features, std::chrono::nanoseconds duration) {
+    float squaredNorm = 0.f;
+    for (const float feature : features) {
+        squaredNorm += feature * feature;
+    }
+    if (squaredNorm == 0.f || duration.count() <= 0) {
+        return;
+    }
+
+    const float actual = static_cast<float>(duration.count());
+    const float predicted = static_cast<float>(predict(features).count());
+    const float error = actual - predicted;
+
+    // Normalized least mean squares: each weight moves in proportion to how much its feature
+    // contributed, so that features absent from the sample keep their weights.
+    for (size_t i = 0; i < kFeatureCount; i++) {
+        mWeights[i] =
+                std::max(0.f, mWeights[i] + kLearningRate * error * features[i] / squaredNorm);
+    }
+
+    const float relativeError = std::abs(error) / actual;
+    mAverageError = mSampleCount == 0
+            ? relativeError
+            : (1.f - kErrorSmoothing) * mAverageError + kErrorSmoothing * relativeError;
+    mSampleCount++;
+
+    ALOGV("[%s] Rendered in %.3fms, predicted %.3fms", __func__, actual / 1e6f, predicted / 1e6f);
+}
+
+void CostModel::dump(std::string& result) const {
+    base::StringAppendF(&result, "  Cost model: %zu samples, average error %.1f%%\n", mSampleCount,
+                        100.f * mAverageError);
+    result.append("    Weights (us per megapixel or per layer):");
+    for (size_t i = 0; i < kFeatureCount; i++) {
+        base::StringAppendF(&result, " %s %.1f", featureName(static_cast<Feature>(i)),
+                            mWeights[i] / 1000.f);
+    }
+    result.append("\n");
+}
+
+} // namespace android::compositionengine::impl::planner
@@ -114,6 +114,9 @@ void Flattener::renderCachedSets(
         std::optional<std::chrono::steady_clock::time_point> renderDeadline,
         bool deviceHandlesColorTransform) {
     ATRACE_CALL();
+    const auto now = std::chrono::steady_clock::now();
+    mTexturePool.onFrame(now);
+    mOutputDataspace = outputState.dataspace;
 
     if (!mNewCachedSet) {
         return;
@@ -125,8 +128,6 @@ void Flattener::renderCachedSets(
         return;
     }
 
-    const auto now = std::chrono::steady_clock::now();
-
     // If we have a render deadline, and the flattener is configured to skip rendering if we don't
     // have enough time, then we skip rendering the cached set if we think that we'll steal too much
     // time from the next frame.
@@ -208,6 +209,22 @@ void Flattener::dump(std::string& result) const {
 
     dumpLayers(result);
 
+    base::StringAppendF(&result, "\n\n");
+    mCostModel.dump(result);
+    base::StringAppendF(&result, "    Last run selection (%zu candidates):\n",
+                        mLastRunEvaluations.size());
+    for (const RunEvaluation& evaluation : mLastRunEvaluations) {
+        const auto toMs = [](std::chrono::nanoseconds duration) {
+            return static_cast<float>(duration.count()) / 1e6f;
+        };
+        base::StringAppendF(&result,
+                            "    %c %s (%zu layers): render %.3fms, saves %.3fms/frame, score "
+                            "%.3fms\n",
+                            evaluation.chosen ? '*' : ' ', evaluation.firstLayerName.c_str(),
+                            evaluation.layerCount, toMs(evaluation.renderCost),
+                            toMs(evaluation.savingsPerFrame), toMs(evaluation.getScore()));
+    }
+
     base::StringAppendF(&result, "\n");
     mTexturePool.dump(result);
 }
@@ -317,6 +334,7 @@ bool Flattener::mergeWithCachedSets(const std::vector<const LayerState*>& layers
                 mNewCachedSet = std::nullopt;
             } else if (mNewCachedSet->hasReadyBuffer()) {
                 ALOGV("[%s] Found ready buffer", __func__);
+                recordRenderTime(*mNewCachedSet);
                 size_t skipCount = mNewCachedSet->getLayerCount();
                 while (skipCount != 0) {
                     auto* peekThroughLayer = mNewCachedSet->getHolePunchLayer();
@@ -484,13 +502,91 @@ std::vector<Flattener::Run> Flattener::findCandidateRuns(time_point now) const {
     return runs;
 }
 
-std::optional<Flattener::Run> Flattener::findBestRun(std::vector<Flattener::Run>& runs) const {
+Flattener::RunEvaluation Flattener::evaluateRun(const Run& run) const {
+    std::vector<const LayerState*> layers;
+    Region coveredRegion;
+    bool hasClientComposition = false;
+    for (auto currentSet = run.getStart(); layers.size() < run.getLayerLength(); ++currentSet) {
+        for (const CachedSet::Layer& layer : currentSet->getConstituentLayers()) {
+            layers.push_back(layer.getState());
+            hasClientComposition |= layer.getState()->getCompositionType() ==
+                    aidl::android::hardware::graphics::composer3::Composition::CLIENT;
+        }
+        coveredRegion.orSelf(currentSet->getBounds());
+    }
+    const Rect bounds = coveredRegion.getBounds();
+
+    const CostModel::Features renderFeatures =
+            CostModel::getFeatures(layers, bounds, mOutputDataspace);
+
+    // Each frame, the layers of the run are composed instead of the cached set. With client
+    // composition, the GPU does all of the work that rendering the cached set does, minus writing
+    // the buffer. Otherwise, the display still has to read each layer.
+    CostModel::Features composedFeatures = renderFeatures;
+    composedFeatures[CostModel::PixelsWritten] = 0.f;
+    if (!hasClientComposition) {
+        composedFeatures[CostModel::BlurredPixels] = 0.f;
+        composedFeatures[CostModel::RoundedCornerPixels] = 0.f;
+        composedFeatures[CostModel::ConvertedPixels] = 0.f;
+    }
+    CostModel::Features flattenedFeatures{};
+    flattenedFeatures[CostModel::PixelsRead] = renderFeatures[CostModel::PixelsWritten];
+    flattenedFeatures[CostModel::Layers] = 1.f;
+
+    std::chrono::nanoseconds savingsPerFrame =
+            mCostModel.predict(composedFeatures) - mCostModel.predict(flattenedFeatures);
+
+    // A hole punch lets the layer behind the run skip client composition of its rounded corners.
+    if (mTunables.mEnableHolePunch && run.getHolePunchCandidate() &&
+        run.getHolePunchCandidate()->requiresHolePunch()) {
+        const CachedSet* holePunchCandidate = run.getHolePunchCandidate();
+        CostModel::Features holePunchFeatures =
+                CostModel::getFeatures({holePunchCandidate->getFirstLayer().getState()},
+                                       holePunchCandidate->getBounds(), mOutputDataspace);
+        holePunchFeatures[CostModel::PixelsWritten] = 0.f;
+        savingsPerFrame += mCostModel.predict(holePunchFeatures);
+    }
+
+    return RunEvaluation{
+            .firstLayerName = run.getStart()->getFirstLayer().getName(),
+            .layerCount = run.getLayerLength(),
+            .renderCost = mCostModel.predict(renderFeatures),
+            .savingsPerFrame = savingsPerFrame,
+    };
+}
+
+std::optional<Flattener::Run> Flattener::findBestRun(std::vector<Flattener::Run>& runs) {
     if (runs.empty()) {
         return std::nullopt;
     }
 
-    // TODO (b/181192467): Choose the best run, instead of just the first.
-    return runs[0];
+    mLastRunEvaluations.clear();
+
+    size_t bestIndex = 0;
+    for (size_t i = 0; i < runs.size(); i++) {
+        mLastRunEvaluations.push_back(evaluateRun(runs[i]));
+        if (mLastRunEvaluations[i].getScore() > mLastRunEvaluations[bestIndex].getScore()) {
+            bestIndex = i;
+        }
+    }
+
+    mLastRunEvaluations[bestIndex].chosen = true;
+    return runs[bestIndex];
+}
+
+void Flattener::recordRenderTime(const CachedSet& cachedSet) {
+    const nsecs_t signalTime = cachedSet.getDrawFence()->getSignalTime();
+    if (signalTime == Fence::SIGNAL_TIME_INVALID || signalTime == Fence::SIGNAL_TIME_PENDING ||
+        signalTime <= cachedSet.getRenderStartTime()) {
+        return;
+    }
+
+    std::vector<const LayerState*> layers;
+    for (const CachedSet::Layer& layer : cachedSet.getConstituentLayers()) {
+        layers.push_back(layer.getState());
+    }
+    mCostModel.addSample(CostModel::getFeatures(layers, cachedSet.getBounds(), mOutputDataspace),
+                         std::chrono::nanoseconds(signalTime - cachedSet.getRenderStartTime()));
 }
 
 void Flattener::buildCachedSets(time_point now) {
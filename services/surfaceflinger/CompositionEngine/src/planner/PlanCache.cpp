@@ -0,0 +1,408 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "Planner"
+// #define LOG_NDEBUG 0
+
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
+#include <compositionengine/impl/planner/PlanCache.h>
+#include <pthread.h>
+#include <utils/Log.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+namespace android::compositionengine::impl::planner {
+
+namespace {
+
+// The file starts with a header of kMagic, kVersion and the checksum of the rest of the file,
+// which holds the build ID and the entries, most recently used first:
+//
+//   uint32_t buildIdLength, char buildId[buildIdLength]
+//   uint32_t entryCount
+//   entryCount times: uint64_t hash, uint16_t planLength, char plan[planLength]
+//
+// Plans are stored in the one character per layer form of to_string(Plan).
+constexpr uint32_t kMagic = 0x43504653; // "SFPC"
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 3 * sizeof(uint32_t);
+
+// FNV-1a
+uint32_t checksum(const char* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+template <typename T>
+void append(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Reads values from a buffer, failing instead of reading past its end
+class Reader {
+public:
+    explicit Reader(const std::string& data) : mData(data) {}
+
+    template <typename T>
+    bool read(T* value) {
+        if (mData.size() - mOffset < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(value, mData.data() + mOffset, sizeof(T));
+        mOffset += sizeof(T);
+        return true;
+    }
+
+    bool readString(size_t length, std::string* value) {
+        if (mData.size() - mOffset < length) {
+            return false;
+        }
+        value->assign(mData, mOffset, length);
+        mOffset += length;
+        return true;
+    }
+
+    bool atEnd() const { return mOffset == mData.size(); }
+
+private:
+    const std::string& mData;
+    size_t mOffset = 0;
+};
+
+} // namespace
+
+PlanCache::PlanCache(std::string path, std::string buildId, size_t capacity)
+      : mPath(std::move(path)), mBuildId(std::move(buildId)), mCapacity(capacity) {}
+
+PlanCache::~PlanCache() {
+    {
+        std::scoped_lock lock(mWriterMutex);
+        mWriterDone = true;
+        mWriterCondition.notify_all();
+    }
+    if (mWriterThread.joinable()) {
+        mWriterThread.join();
+    }
+}
+
+std::optional<Plan> PlanCache::get(NonBufferHash hash) const {
+    std::scoped_lock lock(mMutex);
+    loadIfNeeded();
+
+    const auto entry = mEntriesByHash.find(hash);
+    if (entry == mEntriesByHash.end()) {
+        ++mMissCount;
+        return std::nullopt;
+    }
+
+    ++mHitCount;
+    mEntries.splice(mEntries.begin(), mEntries, entry->second);
+    return entry->second->plan;
+}
+
+void PlanCache::put(NonBufferHash hash, const Plan& plan) {
+    std::scoped_lock lock(mMutex);
+    loadIfNeeded();
+
+    if (const auto entry = mEntriesByHash.find(hash); entry != mEntriesByHash.end()) {
+        mEntries.splice(mEntries.begin(), mEntries, entry->second);
+        if (entry->second->plan == plan) {
+            return;
+        }
+        entry->second->plan = plan;
+        mDirty = true;
+        return;
+    }
+
+    if (mCapacity == 0) {
+        return;
+    }
+
+    if (mEntries.size() == mCapacity) {
+        ALOGV("[%s] Evicting %zx", __func__, mEntries.back().hash);
+        mEntriesByHash.erase(mEntries.back().hash);
+        mEntries.pop_back();
+    }
+
+    mEntries.push_front({hash, plan});
+    mEntriesByHash.emplace(hash, mEntries.begin());
+    mDirty = true;
+}
+
+void PlanCache::erase(NonBufferHash hash) {
+    std::scoped_lock lock(mMutex);
+    loadIfNeeded();
+
+    if (const auto entry = mEntriesByHash.find(hash); entry != mEntriesByHash.end()) {
+        mEntries.erase(entry->second);
+        mEntriesByHash.erase(entry);
+        mDirty = true;
+    }
+}
+
+size_t PlanCache::size() const {
+    std::scoped_lock lock(mMutex);
+    loadIfNeeded();
+    return mEntries.size();
+}
+
+bool PlanCache::save() {
+    std::scoped_lock lock(mMutex);
+    loadIfNeeded();
+    // Don't race the background writer for the temporary file. It never takes mMutex.
+    waitForPendingSave();
+    if (mWriteFailed.exchange(false)) {
+        mDirty = true;
+    }
+    if (!mDirty) {
+        return true;
+    }
+
+    if (!write(serialize())) {
+        return false;
+    }
+    mDirty = false;
+    return true;
+}
+
+void PlanCache::saveIfNeeded(std::chrono::steady_clock::time_point now) {
+    std::scoped_lock lock(mMutex);
+    if (mWriteFailed.exchange(false)) {
+        mDirty = true;
+    }
+    if (!mDirty || (mLastSaveTime && now - *mLastSaveTime < kMinSaveInterval)) {
+        return;
+    }
+
+    // Don't retry a failing write every frame
+    mLastSaveTime = now;
+    // Serializing a few hundred plans is cheap, unlike writing them out
+    queueWrite(serialize());
+    mDirty = false;
+}
+
+void PlanCache::waitForPendingSave() {
+    std::unique_lock lock(mWriterMutex);
+    base::ScopedLockAssertion assumeLock(mWriterMutex);
+    mWriterCondition.wait(lock, [this]() REQUIRES(mWriterMutex) {
+        return !mPendingWrite && !mWriting;
+    });
+}
+
+bool PlanCache::write(const std::string& data) const {
+    // A cache that is being destroyed may still be writing when the next one for the same path
+    // starts, so the temporary file is shared by all caches.
+    static std::mutex sWriteMutex;
+    std::scoped_lock lock(sWriteMutex);
+
+    // Write to a temporary file first, so that the cache is never left half written
+    const std::string tempPath = mPath + ".tmp";
+    if (!base::WriteStringToFile(data, tempPath)) {
+        ALOGW("[%s] Failed to write %s: %s", __func__, tempPath.c_str(), strerror(errno));
+        return false;
+    }
+    if (std::rename(tempPath.c_str(), mPath.c_str()) != 0) {
+        ALOGW("[%s] Failed to rename %s: %s", __func__, tempPath.c_str(), strerror(errno));
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    ALOGV("[%s] Saved %zu bytes of plans to %s", __func__, data.size(), mPath.c_str());
+    return true;
+}
+
+void PlanCache::queueWrite(std::string data) {
+    std::scoped_lock lock(mWriterMutex);
+    // A write that hasn't started yet is stale, so replace it
+    mPendingWrite = std::move(data);
+    if (!mWriterThread.joinable()) {
+        mWriterThread = std::thread(&PlanCache::runWriter, this);
+        pthread_setname_np(mWriterThread.native_handle(), "PlanCacheWriter");
+    }
+    mWriterCondition.notify_all();
+}
+
+void PlanCache::runWriter() {
+    std::unique_lock lock(mWriterMutex);
+    base::ScopedLockAssertion assumeLock(mWriterMutex);
+    while (true) {
+        mWriterCondition.wait(lock, [this]() REQUIRES(mWriterMutex) {
+            return mPendingWrite || mWriterDone;
+        });
+        // Finish the pending write before exiting, so that the latest plans aren't lost
+        if (!mPendingWrite) {
+            return;
+        }
+
+        const std::string data = std::move(*mPendingWrite);
+        mPendingWrite.reset();
+        mWriting = true;
+        lock.unlock();
+        const bool written = write(data);
+        lock.lock();
+        mWriting = false;
+        if (!written) {
+            mWriteFailed = true;
+        }
+        mWriterCondition.notify_all();
+    }
+}
+
+void PlanCache::dump(std::string& result) const {
+    std::scoped_lock lock(mMutex);
+    base::StringAppendF(&result, "Plan cache (%s):\n", mPath.c_str());
+    if (!mLoaded) {
+        result.append("  Not loaded yet\n");
+        return;
+    }
+    if (mFileRejected) {
+        result.append("  Ignored an invalid or stale file\n");
+    }
+    const size_t lookups = mHitCount + mMissCount;
+    base::StringAppendF(&result, "  %zu/%zu plans, hit rate %.2f%% (%zu/%zu)%s\n", mEntries.size(),
+                        mCapacity, lookups == 0 ? 0.f : 100.f * mHitCount / lookups, mHitCount,
+                        lookups, mDirty ? ", unsaved changes" : "");
+}
+
+void PlanCache::loadIfNeeded() const {
+    if (mLoaded) {
+        return;
+    }
+    mLoaded = true;
+
+    if (!load()) {
+        mEntries.clear();
+        mEntriesByHash.clear();
+    }
+}
+
+bool PlanCache::load() const {
+    std::string data;
+    if (!base::ReadFileToString(mPath, &data)) {
+        ALOGV("[%s] No plans found in %s", __func__, mPath.c_str());
+        return false;
+    }
+
+    const auto reject = [&](const char* reason) REQUIRES(mMutex) {
+        ALOGW("[%s] Ignoring %s: %s", __func__, mPath.c_str(), reason);
+        mFileRejected = true;
+        return false;
+    };
+
+    Reader header(data);
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint32_t expectedChecksum = 0;
+    if (!header.read(&magic) || !header.read(&version) || !header.read(&expectedChecksum)) {
+        return reject("truncated header");
+    }
+    if (magic != kMagic) {
+        return reject("not a plan cache");
+    }
+    if (version != kVersion) {
+        return reject("unsupported version");
+    }
+
+    const std::string body = data.substr(kHeaderSize);
+    if (checksum(body.data(), body.size()) != expectedChecksum) {
+        return reject("checksum mismatch");
+    }
+
+    Reader reader(body);
+    uint32_t buildIdLength = 0;
+    std::string buildId;
+    if (!reader.read(&buildIdLength) || !reader.readString(buildIdLength, &buildId)) {
+        return reject("truncated build ID");
+    }
+    if (buildId != mBuildId) {
+        // Layer stack hashes may have changed along with the build
+        return reject("written by another build");
+    }
+
+    uint32_t entryCount = 0;
+    if (!reader.read(&entryCount)) {
+        return reject("truncated entry count");
+    }
+
+    for (uint32_t i = 0; i < entryCount; i++) {
+        uint64_t hash = 0;
+        uint16_t planLength = 0;
+        std::string planString;
+        if (!reader.read(&hash) || !reader.read(&planLength) ||
+            !reader.readString(planLength, &planString)) {
+            return reject("truncated entry");
+        }
+
+        std::optional<Plan> plan = Plan::fromString(planString);
+        if (!plan) {
+            return reject("invalid plan");
+        }
+
+        // Entries past the capacity are the least recently used ones
+        if (mEntries.size() == mCapacity || mEntriesByHash.count(hash) != 0) {
+            continue;
+        }
+        mEntries.push_back({static_cast<NonBufferHash>(hash), std::move(*plan)});
+        mEntriesByHash.emplace(hash, std::prev(mEntries.end()));
+    }
+
+    if (!reader.atEnd()) {
+        return reject("trailing data");
+    }
+
+    ALOGV("[%s] Loaded %zu plans from %s", __func__, mEntries.size(), mPath.c_str());
+    return true;
+}
+
+std::string PlanCache::serialize() const {
+    std::string body;
+    append(body, static_cast<uint32_t>(mBuildId.size()));
+    body.append(mBuildId);
+
+    uint32_t entryCount = 0;
+    std::string entries;
+    for (const Entry& entry : mEntries) {
+        const std::string plan = to_string(entry.plan);
+        if (plan.size() > std::numeric_limits<uint16_t>::max()) {
+            continue;
+        }
+        append(entries, static_cast<uint64_t>(entry.hash));
+        append(entries, static_cast<uint16_t>(plan.size()));
+        entries.append(plan);
+        ++entryCount;
+    }
+    append(body, entryCount);
+    body.append(entries);
+
+    std::string data;
+    data.reserve(kHeaderSize + body.size());
+    append(data, kMagic);
+    append(data, kVersion);
+    append(data, checksum(body.data(), body.size()));
+    data.append(body);
+    return data;
+}
+
+} // namespace android::compositionengine::impl::planner
@@ -23,10 +23,13 @@
 #include <android-base/properties.h>
 #include <compositionengine/LayerFECompositionState.h>
 #include <compositionengine/impl/OutputLayerCompositionState.h>
+#include <compositionengine/impl/planner/PlanCache.h>
 #include <compositionengine/impl/planner/Planner.h>
 
 #include <utils/Trace.h>
 #include <chrono>
+#include <memory>
+#include <mutex>
 
 namespace android::compositionengine::impl::planner {
 
@@ -68,6 +71,31 @@ Flattener::Tunables buildFlattenerTuneables() {
     };
 }
 
+// Every display has its own Planner, but they all share one cache, since they would otherwise
+// overwrite each other's plans in the file.
+std::shared_ptr<PlanCache> getPlanCache() {
+    static std::mutex mutex;
+    static std::weak_ptr<PlanCache> sharedCache;
+
+    std::scoped_lock lock(mutex);
+    if (auto cache = sharedCache.lock()) {
+        return cache;
+    }
+
+    const std::string path = base::GetProperty(std::string("debug.sf.planner_plan_cache_path"), "");
+    if (path.empty()) {
+        return nullptr;
+    }
+
+    const auto capacity =
+            base::GetUintProperty<size_t>(std::string("debug.sf.planner_plan_cache_size"),
+                                          PlanCache::kDefaultCapacity);
+    auto cache = std::make_shared<PlanCache>(path, base::GetProperty("ro.build.fingerprint", ""),
+                                             capacity);
+    sharedCache = cache;
+    return cache;
+}
+
 } // namespace
 
 Planner::Planner(renderengine::RenderEngine& renderEngine)
@@ -75,6 +103,9 @@ Planner::Planner(renderengine::RenderEngine& renderEngine)
                    buildFlattenerTuneables()) {
     mPredictorEnabled =
             base::GetBoolProperty(std::string("debug.sf.enable_planner_prediction"), false);
+    if (mPredictorEnabled) {
+        mPredictor.setPlanCache(getPlanCache());
+    }
 }
 
 void Planner::setDisplaySize(ui::Size size) {
@@ -199,6 +230,7 @@ void Planner::reportFinalPlan(
 
     mPredictor.recordResult(mPredictedPlan, mFlattenedHash, mCurrentLayers, hasSkippedLayers,
                             finalPlan);
+    mPredictor.savePlanCache(std::chrono::steady_clock::now());
 }
 
 void Planner::renderCachedSets(const OutputCompositionState& outputState,
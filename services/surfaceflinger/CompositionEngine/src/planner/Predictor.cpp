@@ -19,6 +19,7 @@
 #undef LOG_TAG
 #define LOG_TAG "Planner"
 
+#include <compositionengine/impl/planner/PlanCache.h>
 #include <compositionengine/impl/planner/Predictor.h>
 
 namespace android::compositionengine::impl::planner {
@@ -118,6 +119,10 @@ std::optional<Plan> Plan::fromString(const std::string& string) {
                 plan.addLayerType(aidl::android::hardware::graphics::composer3::Composition::
                                           DISPLAY_DECORATION);
                 continue;
+            case 'R':
+                plan.addLayerType(aidl::android::hardware::graphics::composer3::Composition::
+                                          REFRESH_RATE_INDICATOR);
+                continue;
             default:
                 return std::nullopt;
         }
@@ -169,6 +174,10 @@ void Prediction::dump(std::string& result) const {
     result.append("]");
 }
 
+Predictor::Predictor() = default;
+
+Predictor::~Predictor() = default;
+
 std::optional<Predictor::PredictedPlan> Predictor::getPredictedPlan(
         const std::vector<const LayerState*>& layers, NonBufferHash hash) const {
     // First check for an exact match
@@ -213,9 +222,16 @@ void Predictor::recordResult(std::optional<PredictedPlan> predictedPlan,
     }
 
     ALOGV("[%s] Adding novel candidate %zx", __func__, flattenedHash);
-    mCandidates.emplace_front(flattenedHash, Prediction(layers, result));
-    if (mCandidates.size() > MAX_CANDIDATES) {
-        mCandidates.pop_back();
+    addCandidate(flattenedHash, layers, std::move(result));
+}
+
+void Predictor::setPlanCache(std::shared_ptr<PlanCache> planCache) {
+    mPlanCache = std::move(planCache);
+}
+
+void Predictor::savePlanCache(std::chrono::steady_clock::time_point now) {
+    if (mPlanCache) {
+        mPlanCache->saveIfNeeded(now);
     }
 }
 
@@ -231,6 +247,11 @@ void Predictor::dump(std::string& result) const {
     base::StringAppendF(&result, "  Misses: %zd\n\n", mMissCount);
 
     dumpPredictionsByFrequency(result);
+
+    if (mPlanCache) {
+        result.append("\n");
+        mPlanCache->dump(result);
+    }
 }
 
 void Predictor::compareLayerStacks(NonBufferHash leftHash, NonBufferHash rightHash,
@@ -320,7 +341,8 @@ std::optional<Plan> Predictor::getExactMatch(NonBufferHash hash) const {
     }
 
     if (match == nullptr) {
-        return std::nullopt;
+        // Fall back to the plans learned before SurfaceFlinger restarted
+        return mPlanCache ? mPlanCache->get(hash) : std::nullopt;
     }
 
     if (match->getMissCount(Prediction::Type::Exact) != 0) {
@@ -375,6 +397,18 @@ std::optional<NonBufferHash> Predictor::getApproximateMatch(
     return hash;
 }
 
+bool Predictor::hasPrediction(NonBufferHash hash) const {
+    return mPredictions.count(hash) != 0 || getCandidateEntryByHash(hash) != mCandidates.cend();
+}
+
+void Predictor::addCandidate(NonBufferHash hash, const std::vector<const LayerState*>& layers,
+                             Plan result) {
+    mCandidates.emplace_front(hash, Prediction(layers, std::move(result)));
+    if (mCandidates.size() > MAX_CANDIDATES) {
+        mCandidates.pop_back();
+    }
+}
+
 void Predictor::promoteIfCandidate(NonBufferHash predictionHash) {
     // Return if the candidate has already been promoted
     if (mPredictions.count(predictionHash) != 0) {
@@ -387,12 +421,42 @@ void Predictor::promoteIfCandidate(NonBufferHash predictionHash) {
     ALOGE_IF(candidateEntry == mCandidates.end(), "Expected to find candidate");
 
     mSimilarStacks[candidateEntry->prediction.getPlan()].push_back(predictionHash);
+    if (mPlanCache) {
+        mPlanCache->put(predictionHash, candidateEntry->prediction.getPlan());
+    }
     mPredictions.emplace(predictionHash, std::move(candidateEntry->prediction));
     mCandidates.erase(candidateEntry);
 }
 
+void Predictor::recordCachedResult(PredictedPlan predictedPlan,
+                                   const std::vector<const LayerState*>& layers, Plan result) {
+    if (predictedPlan.plan != result) {
+        ALOGV("[%s] Cached plan for %zx missed, expected %s, found %s", __func__,
+              predictedPlan.hash, to_string(predictedPlan.plan).c_str(),
+              to_string(result).c_str());
+        ++mMissCount;
+        mPlanCache->erase(predictedPlan.hash);
+        addCandidate(predictedPlan.hash, layers, std::move(result));
+        return;
+    }
+
+    // The plan was already confirmed before the restart, so promote it straight away
+    ALOGV("[%s] Cached plan for %zx hit", __func__, predictedPlan.hash);
+    ++mExactHitCount;
+    Prediction prediction(layers, result);
+    prediction.recordHit(Prediction::Type::Exact);
+    mSimilarStacks[result].push_back(predictedPlan.hash);
+    mPredictions.emplace(predictedPlan.hash, std::move(prediction));
+    mPlanCache->put(predictedPlan.hash, result);
+}
+
 void Predictor::recordPredictedResult(PredictedPlan predictedPlan,
                                       const std::vector<const LayerState*>& layers, Plan result) {
+    if (!hasPrediction(predictedPlan.hash)) {
+        recordCachedResult(std::move(predictedPlan), layers, std::move(result));
+        return;
+    }
+
     Prediction& prediction = getPrediction(predictedPlan.hash);
     if (prediction.getPlan() != result) {
         ALOGV("[%s] %s prediction missed, expected %s, found %s", __func__,
@@ -400,6 +464,9 @@ void Predictor::recordPredictedResult(PredictedPlan predictedPlan,
               to_string(result).c_str());
         prediction.recordMiss(predictedPlan.type);
         ++mMissCount;
+        if (mPlanCache && predictedPlan.type == Prediction::Type::Exact) {
+            mPlanCache->erase(predictedPlan.hash);
+        }
         return;
     }
 
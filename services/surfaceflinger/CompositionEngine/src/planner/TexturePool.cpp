@@ -25,12 +25,38 @@
 
 namespace android::compositionengine::impl::planner {
 
+namespace {
+
+// Textures are allocated as RGBA_8888
+size_t textureBytes(int64_t width, int64_t height) {
+    return static_cast<size_t>(width * height * 4);
+}
+
+float toMiB(size_t bytes) {
+    return static_cast<float>(bytes) / (1024.f * 1024.f);
+}
+
+size_t textureBytes(const renderengine::ExternalTexture& texture) {
+    return textureBytes(texture.getBuffer()->getWidth(), texture.getBuffer()->getHeight());
+}
+
+float hitRate(size_t hits, size_t misses) {
+    const size_t borrows = hits + misses;
+    return borrows == 0 ? 0.f : 100.f * static_cast<float>(hits) / static_cast<float>(borrows);
+}
+
+} // namespace
+
 void TexturePool::allocatePool() {
     mPool.clear();
+    mDownsizedPool.clear();
+    mTargetPoolSize = kMinPoolSize;
+    mLastResizeTime.reset();
+    mStarved = false;
     if (mEnabled && mSize.isValid()) {
         mPool.resize(kMinPoolSize);
         std::generate_n(mPool.begin(), kMinPoolSize, [&]() {
-            return Entry{genTexture(), nullptr};
+            return Entry{genTexture(mSize), nullptr};
         });
     }
 }
@@ -44,17 +70,92 @@ void TexturePool::setDisplaySize(ui::Size size) {
 }
 
 std::shared_ptr<TexturePool::AutoTexture> TexturePool::borrowTexture() {
+    mBorrowedCount++;
     if (mPool.empty()) {
-        return std::make_shared<AutoTexture>(*this, genTexture(), nullptr);
+        // The pool ran dry, so retain more textures from now on.
+        mMissCount++;
+        mTargetPoolSize = std::min(mTargetPoolSize + 1, kMaxPoolSize);
+        mStarved = true;
+        return std::make_shared<AutoTexture>(*this, genTexture(mSize), nullptr);
     }
 
+    mHitCount++;
     const auto entry = mPool.front();
     mPool.pop_front();
     return std::make_shared<AutoTexture>(*this, entry.texture, entry.fence);
 }
 
+bool TexturePool::shouldDownsize(ui::Size size) const {
+    if (!mSize.isValid() || !size.isValid()) {
+        return false;
+    }
+    const int64_t area = static_cast<int64_t>(size.width) * size.height;
+    const int64_t displayArea = static_cast<int64_t>(mSize.width) * mSize.height;
+    return area * kDownsizeAreaRatio <= displayArea;
+}
+
+std::shared_ptr<TexturePool::AutoTexture> TexturePool::borrowDownsizedTexture(ui::Size size) {
+    mDownsizedBorrowedCount++;
+    mDownsizedBytesInUse += textureBytes(size.width, size.height);
+
+    // Cached sets tend to be re-rendered with the same bounds, so only reuse an exact match, which
+    // the cached set covers entirely.
+    const auto it = std::find_if(mDownsizedPool.begin(), mDownsizedPool.end(), [&](const Entry& e) {
+        return static_cast<int32_t>(e.texture->getBuffer()->getWidth()) == size.width &&
+                static_cast<int32_t>(e.texture->getBuffer()->getHeight()) == size.height;
+    });
+    if (it == mDownsizedPool.end()) {
+        mDownsizedMissCount++;
+        return std::make_shared<AutoTexture>(*this, genTexture(size), nullptr, /*downsized=*/true);
+    }
+
+    mDownsizedHitCount++;
+    const auto entry = *it;
+    mDownsizedPool.erase(it);
+    return std::make_shared<AutoTexture>(*this, entry.texture, entry.fence, /*downsized=*/true);
+}
+
+void TexturePool::onFrame(std::chrono::steady_clock::time_point now) {
+    if (!mLastResizeTime || mStarved) {
+        mLastResizeTime = now;
+        mStarved = false;
+        return;
+    }
+
+    const auto elapsedSteps = (now - *mLastResizeTime) / kShrinkAfter;
+    if (elapsedSteps <= 0) {
+        return;
+    }
+    *mLastResizeTime += elapsedSteps * kShrinkAfter;
+    const auto steps = static_cast<size_t>(elapsedSteps);
+
+    mTargetPoolSize = std::max(mTargetPoolSize - std::min(steps, mTargetPoolSize), kLowWatermark);
+    while (mPool.size() > mTargetPoolSize) {
+        ALOGV("Deallocating texture from Planner's pool - demand dropped (target size [%zu])",
+              mTargetPoolSize);
+        mPool.pop_back();
+    }
+    // Downsized textures that were not reused for a while go as well, least recently used first.
+    for (size_t i = 0; i < steps && !mDownsizedPool.empty(); i++) {
+        mDownsizedPool.pop_back();
+    }
+}
+
 void TexturePool::returnTexture(std::shared_ptr<renderengine::ExternalTexture>&& texture,
-                                const sp<Fence>& fence) {
+                                const sp<Fence>& fence, bool downsized) {
+    if (downsized) {
+        mDownsizedBorrowedCount--;
+        mDownsizedBytesInUse -= textureBytes(*texture);
+        if (mEnabled) {
+            mDownsizedPool.push_front({std::move(texture), fence});
+            if (mDownsizedPool.size() > kMaxDownsizedPoolSize) {
+                mDownsizedPool.pop_back();
+            }
+        }
+        return;
+    }
+    mBorrowedCount--;
+
     // Drop the texture on the floor if the pool is not enabled
     if (!mEnabled) {
         return;
@@ -70,23 +171,23 @@ void TexturePool::returnTexture(std::shared_ptr<renderengine::ExternalTexture>&&
         return;
     }
 
-    // Also ensure the pool does not grow beyond a maximum size.
-    if (mPool.size() == kMaxPoolSize) {
-        ALOGD("Deallocating texture from Planner's pool - max size [%" PRIu64 "] reached",
-              static_cast<uint64_t>(kMaxPoolSize));
+    // Also ensure the pool does not grow beyond its target size.
+    if (mPool.size() >= mTargetPoolSize) {
+        ALOGD("Deallocating texture from Planner's pool - target size [%zu] reached",
+              mTargetPoolSize);
         return;
     }
 
     mPool.push_back({std::move(texture), fence});
 }
 
-std::shared_ptr<renderengine::ExternalTexture> TexturePool::genTexture() {
-    LOG_ALWAYS_FATAL_IF(!mSize.isValid(), "Attempted to generate texture with invalid size");
+std::shared_ptr<renderengine::ExternalTexture> TexturePool::genTexture(ui::Size size) {
+    LOG_ALWAYS_FATAL_IF(!size.isValid(), "Attempted to generate texture with invalid size");
     return std::make_shared<
             renderengine::impl::
                     ExternalTexture>(sp<GraphicBuffer>::
-                                             make(static_cast<uint32_t>(mSize.getWidth()),
-                                                  static_cast<uint32_t>(mSize.getHeight()),
+                                             make(static_cast<uint32_t>(size.getWidth()),
+                                                  static_cast<uint32_t>(size.getHeight()),
                                                   HAL_PIXEL_FORMAT_RGBA_8888, 1U,
                                                   static_cast<uint64_t>(
                                                           GraphicBuffer::USAGE_HW_RENDER |
@@ -107,6 +208,42 @@ void TexturePool::dump(std::string& out) const {
     base::StringAppendF(&out,
                         "TexturePool (%s) has %zu buffers of size [%" PRId32 ", %" PRId32 "]\n",
                         mEnabled ? "enabled" : "disabled", mPool.size(), mSize.width, mSize.height);
+    const auto sinceResize = mLastResizeTime
+            ? std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::steady_clock::now() - *mLastResizeTime)
+                      .count()
+            : 0;
+    base::StringAppendF(&out,
+                        "    Target size: %zu (watermarks [%zu, %zu]), %" PRId64
+                        " ms since last resized\n",
+                        mTargetPoolSize, kLowWatermark, kMaxPoolSize,
+                        static_cast<int64_t>(sinceResize));
+
+    const size_t displayBytes = textureBytes(mSize.width, mSize.height);
+    size_t downsizedPoolBytes = 0;
+    for (const Entry& entry : mDownsizedPool) {
+        downsizedPoolBytes += textureBytes(*entry.texture);
+    }
+    base::StringAppendF(&out,
+                        "    Memory: %.2f MiB pooled (%zu downsized, %.2f MiB), %.2f MiB borrowed "
+                        "(%zu screen-sized, %zu downsized, %.2f MiB)\n",
+                        toMiB(mPool.size() * displayBytes + downsizedPoolBytes),
+                        mDownsizedPool.size(), toMiB(downsizedPoolBytes),
+                        toMiB(mBorrowedCount * displayBytes + mDownsizedBytesInUse),
+                        mBorrowedCount, mDownsizedBorrowedCount, toMiB(mDownsizedBytesInUse));
+    // Compared to screen-sized textures for the cached sets currently using downsized ones.
+    const size_t screenSizedBytes = mDownsizedBorrowedCount * displayBytes;
+    base::StringAppendF(&out, "    Downsizing currently saves %.2f MiB\n",
+                        toMiB(screenSizedBytes > mDownsizedBytesInUse
+                                      ? screenSizedBytes - mDownsizedBytesInUse
+                                      : 0));
+
+    base::StringAppendF(&out,
+                        "    Borrows: %zu hits, %zu misses (%.1f%% hit rate), downsized: %zu "
+                        "hits, %zu misses (%.1f%% hit rate)\n",
+                        mHitCount, mMissCount, hitRate(mHitCount, mMissCount),
+                        mDownsizedHitCount, mDownsizedMissCount,
+                        hitRate(mDownsizedHitCount, mDownsizedMissCount));
 }
 
 } // namespace android::compositionengine::impl::planner
\ No newline at end of file
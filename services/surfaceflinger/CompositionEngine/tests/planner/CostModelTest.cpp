@@ -0,0 +1,162 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "CostModelTest"
+
+#include <compositionengine/impl/planner/CostModel.h>
+#include <compositionengine/impl/planner/LayerState.h>
+#include <compositionengine/mock/LayerFE.h>
+#include <compositionengine/mock/OutputLayer.h>
+#include <gtest/gtest.h>
+#include <log/log.h>
+
+#include <random>
+
+namespace android::compositionengine::impl::planner {
+namespace {
+
+using namespace std::chrono_literals;
+
+using testing::Return;
+using testing::ReturnRef;
+
+struct TestLayer {
+    TestLayer(const Rect& displayFrame, ui::Dataspace dataspace, bool hasRoundedCorners,
+              int backgroundBlurRadius) {
+        outputLayerCompositionState.displayFrame = displayFrame;
+        outputLayerCompositionState.dataspace = dataspace;
+        layerFECompositionState.backgroundBlurRadius = backgroundBlurRadius;
+
+        EXPECT_CALL(outputLayer, getLayerFE()).WillRepeatedly(ReturnRef(*layerFE));
+        EXPECT_CALL(outputLayer, getState()).WillRepeatedly(ReturnRef(outputLayerCompositionState));
+        EXPECT_CALL(*layerFE, getSequence()).WillRepeatedly(Return(1));
+        EXPECT_CALL(*layerFE, getDebugName()).WillRepeatedly(Return("testLayer"));
+        EXPECT_CALL(*layerFE, getCompositionState())
+                .WillRepeatedly(Return(&layerFECompositionState));
+        EXPECT_CALL(*layerFE, hasRoundedCorners()).WillRepeatedly(Return(hasRoundedCorners));
+
+        layerState = std::make_unique<LayerState>(&outputLayer);
+    }
+
+    mock::OutputLayer outputLayer;
+    impl::OutputLayerCompositionState outputLayerCompositionState;
+    // LayerFE inherits from RefBase and must be held by an sp<>
+    sp<mock::LayerFE> layerFE = sp<mock::LayerFE>::make();
+    LayerFECompositionState layerFECompositionState;
+    std::unique_ptr<LayerState> layerState;
+};
+
+TEST(CostModelTest, getFeatures) {
+    TestLayer blurredLayer(Rect(0, 0, 1000, 1000), ui::Dataspace::DISPLAY_P3,
+                           /*hasRoundedCorners=*/true, /*backgroundBlurRadius=*/10);
+    TestLayer plainLayer(Rect(0, 0, 500, 1000), ui::Dataspace::SRGB,
+                         /*hasRoundedCorners=*/false, /*backgroundBlurRadius=*/0);
+
+    const CostModel::Features features =
+            CostModel::getFeatures({blurredLayer.layerState.get(), plainLayer.layerState.get()},
+                                   Rect(0, 0, 1000, 1000), ui::Dataspace::SRGB);
+
+    EXPECT_FLOAT_EQ(1.5f, features[CostModel::PixelsRead]);
+    EXPECT_FLOAT_EQ(1.f, features[CostModel::PixelsWritten]);
+    EXPECT_FLOAT_EQ(1.f, features[CostModel::BlurredPixels]);
+    EXPECT_FLOAT_EQ(1.f, features[CostModel::RoundedCornerPixels]);
+    EXPECT_FLOAT_EQ(1.f, features[CostModel::ConvertedPixels]);
+    EXPECT_FLOAT_EQ(2.f, features[CostModel::Layers]);
+}
+
+TEST(CostModelTest, predictsMoreForMoreWork) {
+    CostModel model;
+    CostModel::Features small{};
+    small[CostModel::PixelsRead] = 1.f;
+    small[CostModel::PixelsWritten] = 1.f;
+    small[CostModel::Layers] = 2.f;
+
+    CostModel::Features blurred = small;
+    blurred[CostModel::BlurredPixels] = 1.f;
+
+    EXPECT_GT(model.predict(small), 0ns);
+    EXPECT_GT(model.predict(blurred), model.predict(small));
+}
+
+TEST(CostModelTest, ignoresEmptySamples) {
+    CostModel model;
+    CostModel::Features features{};
+    features[CostModel::PixelsRead] = 1.f;
+    const auto prediction = model.predict(features);
+
+    model.addSample(CostModel::Features{}, 10ms);
+    model.addSample(features, 0ns);
+
+    EXPECT_EQ(prediction, model.predict(features));
+}
+
+// Renders of cached sets on a device whose GPU is slower than the defaults assume, and much
+// slower at blurring.
+TEST(CostModelTest, learnsRenderTimes) {
+    const CostModel::Features kDeviceWeights = {400'000.f, 300'000.f, 3'500'000.f,
+                                                250'000.f, 100'000.f, 40'000.f};
+    std::mt19937 generator(0);
+    const auto generateFeatures = [&] {
+        std::uniform_real_distribution<float> read(0.5f, 6.f);
+        std::uniform_real_distribution<float> written(0.5f, 2.7f);
+        std::uniform_real_distribution<float> effect(0.f, 1.f);
+        std::bernoulli_distribution hasEffect(0.5);
+        std::uniform_int_distribution<int> layers(2, 8);
+
+        CostModel::Features features{};
+        features[CostModel::PixelsRead] = read(generator);
+        features[CostModel::PixelsWritten] = written(generator);
+        features[CostModel::BlurredPixels] = hasEffect(generator) ? 2.f * effect(generator) : 0.f;
+        features[CostModel::RoundedCornerPixels] = hasEffect(generator) ? effect(generator) : 0.f;
+        features[CostModel::ConvertedPixels] = hasEffect(generator) ? effect(generator) : 0.f;
+        features[CostModel::Layers] = static_cast<float>(layers(generator));
+        return features;
+    };
+    const auto renderTime = [&](const CostModel::Features& features) {
+        float time = 0.f;
+        for (size_t i = 0; i < CostModel::kFeatureCount; i++) {
+            time += kDeviceWeights[i] * features[i];
+        }
+        return std::chrono::nanoseconds(static_cast<int64_t>(time));
+    };
+    const auto averageError = [&](const CostModel& model) {
+        constexpr int kSamples = 100;
+        float error = 0.f;
+        for (int i = 0; i < kSamples; i++) {
+            const auto features = generateFeatures();
+            const auto actual = static_cast<float>(renderTime(features).count());
+            error += std::abs(static_cast<float>(model.predict(features).count()) - actual) /
+                    actual;
+        }
+        return error / kSamples;
+    };
+
+    CostModel model;
+    const float initialError = averageError(model);
+    for (int i = 0; i < 400; i++) {
+        const auto features = generateFeatures();
+        model.addSample(features, renderTime(features));
+    }
+    const float learnedError = averageError(model);
+
+    ALOGD("Average error went from %.1f%% to %.1f%%", 100.f * initialError, 100.f * learnedError);
+    EXPECT_LT(learnedError, 0.1f);
+    EXPECT_LT(learnedError, initialError / 2);
+}
+
+} // namespace
+} // namespace android::compositionengine::impl::planner
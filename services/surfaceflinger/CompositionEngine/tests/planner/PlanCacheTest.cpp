@@ -0,0 +1,290 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "PlanCacheTest"
+
+#include <android-base/file.h>
+#include <compositionengine/impl/planner/PlanCache.h>
+#include <gtest/gtest.h>
+
+#include <aidl/android/hardware/graphics/composer3/Composition.h>
+#include <sys/stat.h>
+
+#include <thread>
+
+using aidl::android::hardware::graphics::composer3::Composition;
+
+namespace android::compositionengine::impl::planner {
+namespace {
+
+const std::string kBuildId = "build/1";
+
+Plan makePlan(const std::string& layerTypes) {
+    return *Plan::fromString(layerTypes);
+}
+
+class PlanCacheTest : public testing::Test {
+protected:
+    std::string path() const { return mDir.path + std::string("/plans"); }
+
+    // Writes a cache of three plans, "CD" being the least recently used.
+    void writeCache() {
+        PlanCache cache(path(), kBuildId);
+        cache.put(1, makePlan("CD"));
+        cache.put(2, makePlan("DDS"));
+        cache.put(3, makePlan("DDDA"));
+        ASSERT_TRUE(cache.save());
+    }
+
+    std::string readFile() const {
+        std::string data;
+        EXPECT_TRUE(base::ReadFileToString(path(), &data));
+        return data;
+    }
+
+    void writeFile(const std::string& data) const {
+        ASSERT_TRUE(base::WriteStringToFile(data, path()));
+    }
+
+    TemporaryDir mDir;
+};
+
+TEST_F(PlanCacheTest, isEmptyWithoutFile) {
+    PlanCache cache(path(), kBuildId);
+    EXPECT_EQ(0u, cache.size());
+    EXPECT_FALSE(cache.get(1));
+}
+
+TEST_F(PlanCacheTest, loadsSavedPlans) {
+    writeCache();
+
+    PlanCache cache(path(), kBuildId);
+    EXPECT_EQ(3u, cache.size());
+    EXPECT_EQ(makePlan("CD"), cache.get(1));
+    EXPECT_EQ(makePlan("DDS"), cache.get(2));
+    EXPECT_EQ(makePlan("DDDA"), cache.get(3));
+    EXPECT_FALSE(cache.get(4));
+}
+
+TEST_F(PlanCacheTest, evictsLeastRecentlyUsed) {
+    PlanCache cache(path(), kBuildId, /*capacity=*/2);
+    cache.put(1, makePlan("D"));
+    cache.put(2, makePlan("C"));
+    // Using the first plan makes the second one the least recently used.
+    EXPECT_TRUE(cache.get(1));
+    cache.put(3, makePlan("S"));
+
+    EXPECT_EQ(2u, cache.size());
+    EXPECT_TRUE(cache.get(1));
+    EXPECT_FALSE(cache.get(2));
+    EXPECT_TRUE(cache.get(3));
+}
+
+TEST_F(PlanCacheTest, keepsMostRecentlyUsedWhenLoadingIntoSmallerCache) {
+    writeCache();
+
+    PlanCache cache(path(), kBuildId, /*capacity=*/2);
+    EXPECT_EQ(2u, cache.size());
+    EXPECT_FALSE(cache.get(1));
+    EXPECT_TRUE(cache.get(2));
+    EXPECT_TRUE(cache.get(3));
+}
+
+TEST_F(PlanCacheTest, erasesPlans) {
+    writeCache();
+    {
+        PlanCache cache(path(), kBuildId);
+        cache.erase(2);
+        ASSERT_TRUE(cache.save());
+    }
+
+    PlanCache cache(path(), kBuildId);
+    EXPECT_EQ(2u, cache.size());
+    EXPECT_FALSE(cache.get(2));
+}
+
+TEST_F(PlanCacheTest, savesAtMostOncePerInterval) {
+    const auto now = std::chrono::steady_clock::now();
+    PlanCache cache(path(), kBuildId);
+    cache.put(1, makePlan("D"));
+    cache.saveIfNeeded(now);
+    cache.waitForPendingSave();
+    EXPECT_EQ(1u, PlanCache(path(), kBuildId).size());
+
+    cache.put(2, makePlan("C"));
+    cache.saveIfNeeded(now + PlanCache::kMinSaveInterval / 2);
+    cache.waitForPendingSave();
+    EXPECT_EQ(1u, PlanCache(path(), kBuildId).size());
+
+    cache.saveIfNeeded(now + PlanCache::kMinSaveInterval);
+    cache.waitForPendingSave();
+    EXPECT_EQ(2u, PlanCache(path(), kBuildId).size());
+}
+
+TEST_F(PlanCacheTest, finishesBackgroundSaveWhenDestroyed) {
+    {
+        PlanCache cache(path(), kBuildId);
+        cache.put(1, makePlan("D"));
+        cache.saveIfNeeded(std::chrono::steady_clock::now());
+    }
+
+    EXPECT_EQ(1u, PlanCache(path(), kBuildId).size());
+}
+
+TEST_F(PlanCacheTest, retriesFailedBackgroundSave) {
+    const std::string directory = mDir.path + std::string("/plans.d");
+    const std::string path = directory + "/plans";
+    const auto now = std::chrono::steady_clock::now();
+    PlanCache cache(path, kBuildId);
+    cache.put(1, makePlan("D"));
+    cache.saveIfNeeded(now);
+    cache.waitForPendingSave();
+    EXPECT_EQ(0u, PlanCache(path, kBuildId).size());
+
+    ASSERT_EQ(0, mkdir(directory.c_str(), 0700));
+    cache.saveIfNeeded(now + PlanCache::kMinSaveInterval);
+    cache.waitForPendingSave();
+    EXPECT_EQ(1u, PlanCache(path, kBuildId).size());
+}
+
+TEST_F(PlanCacheTest, isSharedBetweenThreads) {
+    PlanCache cache(path(), kBuildId);
+    const auto putPlans = [&cache](NonBufferHash firstHash) {
+        for (NonBufferHash hash = firstHash; hash < firstHash + 50; hash++) {
+            cache.put(hash, makePlan("DC"));
+            EXPECT_EQ(makePlan("DC"), cache.get(hash));
+        }
+    };
+    std::thread thread(putPlans, 0);
+    putPlans(50);
+    thread.join();
+
+    EXPECT_EQ(100u, cache.size());
+    ASSERT_TRUE(cache.save());
+    EXPECT_EQ(100u, PlanCache(path(), kBuildId).size());
+}
+
+TEST_F(PlanCacheTest, cachesWithTheSamePathDontTearTheFile) {
+    PlanCache cacheOne(path(), kBuildId);
+    PlanCache cacheTwo(path(), kBuildId);
+    cacheTwo.put(2, makePlan("DDS"));
+    const auto savePlans = [](PlanCache& cache) {
+        for (int i = 0; i < 20; i++) {
+            cache.put(1, makePlan(i % 2 ? "CD" : "DC"));
+            EXPECT_TRUE(cache.save());
+        }
+    };
+    std::thread thread(savePlans, std::ref(cacheOne));
+    savePlans(cacheTwo);
+    thread.join();
+
+    // Either cache may have written last, but the file is whole.
+    PlanCache cache(path(), kBuildId);
+    const size_t size = cache.size();
+    EXPECT_TRUE(size == 1u || size == 2u) << size;
+    std::string dump;
+    cache.dump(dump);
+    EXPECT_EQ(std::string::npos, dump.find("Ignored"));
+}
+
+TEST_F(PlanCacheTest, ignoresFileFromAnotherBuild) {
+    writeCache();
+
+    PlanCache cache(path(), "build/2");
+    EXPECT_EQ(0u, cache.size());
+    EXPECT_FALSE(cache.get(1));
+}
+
+TEST_F(PlanCacheTest, ignoresFileOfAnotherVersion) {
+    writeCache();
+    std::string data = readFile();
+    // The version follows the magic number
+    data[sizeof(uint32_t)]++;
+    writeFile(data);
+
+    PlanCache cache(path(), kBuildId);
+    EXPECT_EQ(0u, cache.size());
+}
+
+TEST_F(PlanCacheTest, ignoresCorruptedFile) {
+    writeCache();
+    const std::string data = readFile();
+
+    for (size_t i = 0; i < data.size(); i++) {
+        std::string corrupted = data;
+        corrupted[i] ^= 0x40;
+        writeFile(corrupted);
+
+        PlanCache cache(path(), kBuildId);
+        EXPECT_EQ(0u, cache.size()) << "with byte " << i << " corrupted";
+    }
+}
+
+TEST_F(PlanCacheTest, ignoresTruncatedFile) {
+    writeCache();
+    const std::string data = readFile();
+
+    for (size_t size = 0; size < data.size(); size++) {
+        writeFile(data.substr(0, size));
+
+        PlanCache cache(path(), kBuildId);
+        EXPECT_EQ(0u, cache.size()) << "with " << size << " bytes left";
+    }
+}
+
+TEST_F(PlanCacheTest, ignoresTrailingData) {
+    writeCache();
+    writeFile(readFile() + "D");
+
+    PlanCache cache(path(), kBuildId);
+    EXPECT_EQ(0u, cache.size());
+}
+
+TEST_F(PlanCacheTest, replacesIgnoredFile) {
+    writeFile("not a plan cache");
+    {
+        PlanCache cache(path(), kBuildId);
+        EXPECT_EQ(0u, cache.size());
+        cache.put(1, makePlan("D"));
+        ASSERT_TRUE(cache.save());
+    }
+
+    PlanCache cache(path(), kBuildId);
+    EXPECT_EQ(makePlan("D"), cache.get(1));
+}
+
+TEST_F(PlanCacheTest, roundTripsAllCompositionTypes) {
+    Plan plan;
+    plan.addLayerType(Composition::CLIENT);
+    plan.addLayerType(Composition::DEVICE);
+    plan.addLayerType(Composition::SOLID_COLOR);
+    plan.addLayerType(Composition::CURSOR);
+    plan.addLayerType(Composition::SIDEBAND);
+    plan.addLayerType(Composition::DISPLAY_DECORATION);
+    plan.addLayerType(Composition::REFRESH_RATE_INDICATOR);
+    {
+        PlanCache cache(path(), kBuildId);
+        cache.put(1, plan);
+        ASSERT_TRUE(cache.save());
+    }
+
+    PlanCache cache(path(), kBuildId);
+    EXPECT_EQ(plan, cache.get(1));
+}
+
+} // namespace
+} // namespace android::compositionengine::impl::planner
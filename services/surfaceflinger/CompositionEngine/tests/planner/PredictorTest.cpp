@@ -21,6 +21,8 @@
 #include <common/include/common/test/FlagUtils.h>
 #include "com_android_graphics_surfaceflinger_flags.h"
 
+#include <android-base/file.h>
+#include <compositionengine/impl/planner/PlanCache.h>
 #include <compositionengine/impl/planner/Predictor.h>
 #include <compositionengine/mock/LayerFE.h>
 #include <compositionengine/mock/OutputLayer.h>
@@ -571,5 +573,48 @@ TEST_F(PredictorTest, recordMissedPlan_skipsApproximateMatch) {
     EXPECT_FALSE(predictedPlanTwo);
 }
 
+TEST_F(PredictorTest, getPredictedPlan_usesPlansCachedBeforeRestart) {
+    mock::OutputLayer outputLayerOne;
+    sp<mock::LayerFE> layerFEOne = sp<mock::LayerFE>::make();
+    OutputLayerCompositionState outputLayerCompositionStateOne;
+    LayerFECompositionState layerFECompositionStateOne;
+    layerFECompositionStateOne.compositionType = Composition::DEVICE;
+    setupMocksForLayer(outputLayerOne, *layerFEOne, outputLayerCompositionStateOne,
+                       layerFECompositionStateOne);
+    LayerState layerStateOne(&outputLayerOne);
+
+    Plan plan;
+    plan.addLayerType(Composition::DEVICE);
+
+    TemporaryDir dir;
+    const std::string path = dir.path + std::string("/plans");
+    const NonBufferHash hash = getNonBufferHash({&layerStateOne});
+    {
+        Predictor predictor;
+        predictor.setPlanCache(std::make_unique<PlanCache>(path, "build"));
+
+        // A plan is only cached once it has been predicted correctly.
+        predictor.recordResult(std::nullopt, hash, {&layerStateOne}, false, plan);
+        auto predictedPlan = predictor.getPredictedPlan({}, hash);
+        ASSERT_TRUE(predictedPlan);
+        predictor.recordResult(predictedPlan, hash, {&layerStateOne}, false, plan);
+        predictor.savePlanCache(std::chrono::steady_clock::now());
+    }
+
+    Predictor predictor;
+    predictor.setPlanCache(std::make_unique<PlanCache>(path, "build"));
+    auto predictedPlan = predictor.getPredictedPlan({}, hash);
+    Predictor::PredictedPlan expectedPlan{hash, plan, Prediction::Type::Exact};
+    EXPECT_EQ(expectedPlan, predictedPlan);
+
+    // A cached plan that turns out to be wrong is replaced by the actual one.
+    Plan planTwo;
+    planTwo.addLayerType(Composition::CLIENT);
+    predictor.recordResult(predictedPlan, hash, {&layerStateOne}, false, planTwo);
+    predictedPlan = predictor.getPredictedPlan({}, hash);
+    Predictor::PredictedPlan expectedPlanTwo{hash, planTwo, Prediction::Type::Exact};
+    EXPECT_EQ(expectedPlanTwo, predictedPlan);
+}
+
 } // namespace
 } // namespace android::compositionengine::impl::planner
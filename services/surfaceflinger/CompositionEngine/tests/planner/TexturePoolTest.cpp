@@ -27,6 +27,7 @@ namespace {
 
 const ui::Size kDisplaySize(1, 1);
 const ui::Size kDisplaySizeTwo(2, 2);
+const ui::Size kLargeDisplaySize(100, 200);
 
 class TestableTexturePool : public TexturePool {
 public:
@@ -34,7 +35,14 @@ public:
 
     size_t getMinPoolSize() const { return kMinPoolSize; }
     size_t getMaxPoolSize() const { return kMaxPoolSize; }
+    size_t getLowWatermark() const { return kLowWatermark; }
+    std::chrono::steady_clock::duration getShrinkAfter() const { return kShrinkAfter; }
     size_t getPoolSize() const { return mPool.size(); }
+    size_t getHitCount() const { return mHitCount; }
+    size_t getMissCount() const { return mMissCount; }
+    size_t getDownsizedBytesInUse() const { return mDownsizedBytesInUse; }
+    size_t getDownsizedPoolSize() const { return mDownsizedPool.size(); }
+    size_t getMaxDownsizedPoolSize() const { return kMaxDownsizedPoolSize; }
 };
 
 struct TexturePoolTest : public testing::Test {
@@ -170,5 +178,158 @@ TEST_F(TexturePoolTest, reallocatesWhenReEnabled) {
     EXPECT_EQ(mTexturePool.getPoolSize(), mTexturePool.getMinPoolSize());
 }
 
+TEST_F(TexturePoolTest, shrinksOverTimeWithoutDemand) {
+    const auto start = std::chrono::steady_clock::now();
+    mTexturePool.onFrame(start);
+    mTexturePool.onFrame(start + mTexturePool.getShrinkAfter() - std::chrono::milliseconds(1));
+    EXPECT_EQ(mTexturePool.getMinPoolSize(), mTexturePool.getPoolSize());
+
+    mTexturePool.onFrame(start + mTexturePool.getShrinkAfter());
+    EXPECT_EQ(mTexturePool.getMinPoolSize() - 1, mTexturePool.getPoolSize());
+}
+
+TEST_F(TexturePoolTest, shrinksAfterIdlePeriod) {
+    // No frame goes by while the display is idle, so the pool catches up on the next one.
+    const auto start = std::chrono::steady_clock::now();
+    mTexturePool.onFrame(start);
+    mTexturePool.onFrame(start + mTexturePool.getMinPoolSize() * mTexturePool.getShrinkAfter());
+
+    EXPECT_EQ(mTexturePool.getLowWatermark(), mTexturePool.getPoolSize());
+}
+
+TEST_F(TexturePoolTest, growsAgainWhenStarved) {
+    const auto start = std::chrono::steady_clock::now();
+    mTexturePool.onFrame(start);
+    mTexturePool.onFrame(start + mTexturePool.getMinPoolSize() * mTexturePool.getShrinkAfter());
+    ASSERT_EQ(mTexturePool.getLowWatermark(), mTexturePool.getPoolSize());
+
+    std::vector<std::shared_ptr<TexturePool::AutoTexture>> textures;
+    for (size_t i = 0; i < mTexturePool.getMaxPoolSize(); i++) {
+        textures.emplace_back(mTexturePool.borrowTexture());
+    }
+    textures.clear();
+
+    EXPECT_EQ(mTexturePool.getMaxPoolSize(), mTexturePool.getPoolSize());
+}
+
+TEST_F(TexturePoolTest, downsizesSmallContent) {
+    mTexturePool.setDisplaySize(kLargeDisplaySize);
+
+    EXPECT_TRUE(mTexturePool.shouldDownsize(ui::Size(50, 100)));
+    EXPECT_TRUE(mTexturePool.shouldDownsize(ui::Size(10, 10)));
+    EXPECT_FALSE(mTexturePool.shouldDownsize(ui::Size(51, 100)));
+    EXPECT_FALSE(mTexturePool.shouldDownsize(kLargeDisplaySize));
+    EXPECT_FALSE(mTexturePool.shouldDownsize(ui::Size(0, 0)));
+}
+
+TEST_F(TexturePoolTest, reusesDownsizedTexturesOfTheSameSize) {
+    mTexturePool.setDisplaySize(kLargeDisplaySize);
+    const size_t poolSize = mTexturePool.getPoolSize();
+
+    auto texture = mTexturePool.borrowDownsizedTexture(ui::Size(10, 20));
+    EXPECT_TRUE(texture->isDownsized());
+    EXPECT_EQ(10u, texture->get()->getBuffer()->getWidth());
+    EXPECT_EQ(20u, texture->get()->getBuffer()->getHeight());
+    EXPECT_EQ(poolSize, mTexturePool.getPoolSize());
+    EXPECT_EQ(10u * 20u * 4u, mTexturePool.getDownsizedBytesInUse());
+
+    const sp<GraphicBuffer> buffer = texture->get()->getBuffer();
+    texture.reset();
+    EXPECT_EQ(poolSize, mTexturePool.getPoolSize());
+    EXPECT_EQ(1u, mTexturePool.getDownsizedPoolSize());
+    EXPECT_EQ(0u, mTexturePool.getDownsizedBytesInUse());
+
+    // Another size gets a texture of its own.
+    auto otherTexture = mTexturePool.borrowDownsizedTexture(ui::Size(20, 10));
+    EXPECT_NE(buffer, otherTexture->get()->getBuffer());
+    EXPECT_EQ(1u, mTexturePool.getDownsizedPoolSize());
+
+    texture = mTexturePool.borrowDownsizedTexture(ui::Size(10, 20));
+    EXPECT_EQ(buffer, texture->get()->getBuffer());
+    EXPECT_EQ(0u, mTexturePool.getDownsizedPoolSize());
+}
+
+TEST_F(TexturePoolTest, boundsDownsizedPoolAndFreesItWithoutDemand) {
+    mTexturePool.setDisplaySize(kLargeDisplaySize);
+
+    std::vector<std::shared_ptr<TexturePool::AutoTexture>> textures;
+    for (int32_t i = 1; i <= static_cast<int32_t>(mTexturePool.getMaxDownsizedPoolSize()) + 1;
+         i++) {
+        textures.emplace_back(mTexturePool.borrowDownsizedTexture(ui::Size(i, i)));
+    }
+    textures.clear();
+    EXPECT_EQ(mTexturePool.getMaxDownsizedPoolSize(), mTexturePool.getDownsizedPoolSize());
+
+    const auto start = std::chrono::steady_clock::now();
+    mTexturePool.onFrame(start);
+    mTexturePool.onFrame(start +
+                         mTexturePool.getMaxDownsizedPoolSize() * mTexturePool.getShrinkAfter());
+    EXPECT_EQ(0u, mTexturePool.getDownsizedPoolSize());
+}
+
+// Replays the texture demand of the Flattener: cached sets are re-rendered one at a time while
+// the screen is mostly static, all at once during heavy flattening, and not at all once the
+// screen is idle. The textures of the new cached sets are borrowed before the old ones are
+// returned.
+TEST_F(TexturePoolTest, followsDemandTrace) {
+    struct Phase {
+        const char* name;
+        size_t frames;
+        size_t rendersPerFrame;
+    };
+    constexpr size_t kCachedSets = 3;
+    const Phase kTrace[] = {
+            {"steady", 240, 1},
+            {"heavy", 120, kCachedSets},
+            {"steady", 240, 1},
+            {"idle", 600, 0},
+    };
+
+    std::deque<std::shared_ptr<TexturePool::AutoTexture>> cachedSets;
+    for (size_t i = 0; i < kCachedSets; i++) {
+        cachedSets.emplace_back(mTexturePool.borrowTexture());
+    }
+
+    size_t pooledTextureFrames = 0;
+    size_t fixedPoolTextureFrames = 0;
+    auto now = std::chrono::steady_clock::now();
+    for (const Phase& phase : kTrace) {
+        const size_t hits = mTexturePool.getHitCount();
+        const size_t misses = mTexturePool.getMissCount();
+        for (size_t frame = 0; frame < phase.frames; frame++) {
+            now += std::chrono::microseconds(16'667);
+            mTexturePool.onFrame(now);
+            for (size_t i = 0; i < phase.rendersPerFrame; i++) {
+                cachedSets.emplace_back(mTexturePool.borrowTexture());
+            }
+            for (size_t i = 0; i < phase.rendersPerFrame; i++) {
+                cachedSets.pop_front();
+            }
+            pooledTextureFrames += mTexturePool.getPoolSize();
+            // A pool retaining up to kMaxPoolSize textures would keep all the spares it ever had.
+            fixedPoolTextureFrames += mTexturePool.getMaxPoolSize();
+        }
+
+        const size_t borrows =
+                mTexturePool.getHitCount() + mTexturePool.getMissCount() - hits - misses;
+        const float hitRate = borrows == 0
+                ? 100.f
+                : 100.f * static_cast<float>(mTexturePool.getHitCount() - hits) /
+                        static_cast<float>(borrows);
+        ALOGD("%s: %zu borrows, %.1f%% hit rate, %zu textures pooled", phase.name, borrows,
+              hitRate, mTexturePool.getPoolSize());
+        if (phase.rendersPerFrame > 0) {
+            // The pool only runs dry while adapting to a change in demand.
+            EXPECT_LE(mTexturePool.getMissCount() - misses, mTexturePool.getMaxPoolSize());
+        }
+    }
+
+    ALOGD("Pooled %zu texture-frames, %zu fewer than a fixed pool", pooledTextureFrames,
+          fixedPoolTextureFrames - pooledTextureFrames);
+    EXPECT_EQ(mTexturePool.getLowWatermark(), mTexturePool.getPoolSize());
+    EXPECT_LT(pooledTextureFrames, fixedPoolTextureFrames / 2);
+    EXPECT_GT(mTexturePool.getHitCount(), 10 * mTexturePool.getMissCount());
+}
+
 } // namespace
 } // namespace android::compositionengine::impl::planner
@@ -25,8 +25,10 @@
 #include <utils/Log.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cinttypes>
+#include <new>
 #include <numeric>
 #include <unordered_set>
 
@@ -817,11 +819,35 @@ void SurfaceFrame::trace(int64_t displayFrameToken, nsecs_t monoBootOffset) cons
     traceActuals(displayFrameToken, monoBootOffset);
 }
 
+void TokenManager::generateTokensForPredictions(std::span<const TimelineItem> predictions,
+                                                std::span<int64_t> outTokens) {
+    LOG_ALWAYS_FATAL_IF(outTokens.size() < predictions.size(), "%s: %zu tokens for %zu predictions",
+                        __func__, outTokens.size(), predictions.size());
+    for (size_t i = 0; i < predictions.size(); i++) {
+        outTokens[i] = generateTokenForPredictions(TimelineItem(predictions[i]));
+    }
+}
+
 namespace impl {
 
 int64_t TokenManager::generateTokenForPredictions(TimelineItem&& predictions) {
     ATRACE_CALL();
     std::scoped_lock lock(mMutex);
+    return generateTokenLocked(predictions);
+}
+
+void TokenManager::generateTokensForPredictions(std::span<const TimelineItem> predictions,
+                                                std::span<int64_t> outTokens) {
+    ATRACE_CALL();
+    LOG_ALWAYS_FATAL_IF(outTokens.size() < predictions.size(), "%s: %zu tokens for %zu predictions",
+                        __func__, outTokens.size(), predictions.size());
+    std::scoped_lock lock(mMutex);
+    for (size_t i = 0; i < predictions.size(); i++) {
+        outTokens[i] = generateTokenLocked(predictions[i]);
+    }
+}
+
+int64_t TokenManager::generateTokenLocked(const TimelineItem& predictions) {
     while (mPredictions.size() >= kMaxTokens) {
         mPredictions.erase(mPredictions.begin());
     }
@@ -839,17 +865,124 @@ std::optional<TimelineItem> TokenManager::getPredictionsForToken(int64_t token)
     return {};
 }
 
+// A free list of SurfaceFrame allocations, so that the steady state of creating a SurfaceFrame for
+// every buffer, and dropping it once its DisplayFrame leaves the ring, does not go through the
+// allocator. SurfaceFrames are created on binder threads and released on any thread, hence the
+// lock, which is only held to push or pop a block.
+class FrameTimeline::SurfaceFramePool {
+public:
+    template <typename T>
+    class Allocator {
+    public:
+        using value_type = T;
+
+        explicit Allocator(std::shared_ptr<SurfaceFramePool> pool) : mPool(std::move(pool)) {}
+        template <typename U>
+        Allocator(const Allocator<U>& other) : mPool(other.mPool) {}
+
+        T* allocate(size_t n) { return static_cast<T*>(mPool->allocate(n * sizeof(T))); }
+        void deallocate(T* p, size_t n) { mPool->deallocate(p, n * sizeof(T)); }
+
+        template <typename U>
+        bool operator==(const Allocator<U>& other) const {
+            return mPool == other.mPool;
+        }
+        template <typename U>
+        bool operator!=(const Allocator<U>& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        template <typename U>
+        friend class Allocator;
+
+        std::shared_ptr<SurfaceFramePool> mPool;
+    };
+
+    SurfaceFramePool() { mFreeBlocks.reserve(kMaxFreeBlocks); }
+
+    ~SurfaceFramePool() {
+        for (void* block : mFreeBlocks) {
+            ::operator delete(block);
+        }
+    }
+
+    // std::allocate_shared places the SurfaceFrame and its control block in a single allocation,
+    // so all the blocks have the same size. Any other size is passed through to the allocator.
+    void* allocate(size_t size) {
+        {
+            std::scoped_lock lock(mMutex);
+            if (mBlockSize == 0) {
+                mBlockSize = size;
+            }
+            if (size == mBlockSize && !mFreeBlocks.empty()) {
+                void* block = mFreeBlocks.back();
+                mFreeBlocks.pop_back();
+                return block;
+            }
+        }
+        return ::operator new(size);
+    }
+
+    void deallocate(void* block, size_t size) {
+        {
+            std::scoped_lock lock(mMutex);
+            if (size == mBlockSize && mFreeBlocks.size() < kMaxFreeBlocks) {
+                mFreeBlocks.push_back(block);
+                return;
+            }
+        }
+        ::operator delete(block);
+    }
+
+private:
+    // Enough for a full ring of DisplayFrames with a few SurfaceFrames each. Beyond that, blocks
+    // go back to the allocator rather than being held forever after a burst.
+    static constexpr size_t kMaxFreeBlocks = kDefaultMaxDisplayFrames * 4;
+
+    std::mutex mMutex;
+    size_t mBlockSize GUARDED_BY(mMutex) = 0;
+    std::vector<void*> mFreeBlocks GUARDED_BY(mMutex);
+};
+
+static_assert(alignof(SurfaceFrame) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+
+void FrameTimeline::DisplayFrameRing::setCapacity(size_t capacity) {
+    mFrames.clear();
+    // The current display frame is always finalized, even if no frames are to be kept.
+    mFrames.resize(std::max(capacity, size_t{1}));
+    mBegin = 0;
+    mSize = 0;
+}
+
+std::shared_ptr<FrameTimeline::DisplayFrame> FrameTimeline::DisplayFrameRing::push(
+        std::shared_ptr<DisplayFrame> displayFrame) {
+    const size_t capacity = mFrames.size();
+    if (mSize < capacity) {
+        mFrames[(mBegin + mSize++) % capacity] = std::move(displayFrame);
+        return nullptr;
+    }
+    std::shared_ptr<DisplayFrame> oldest = std::move(mFrames[mBegin]);
+    mFrames[mBegin] = std::move(displayFrame);
+    mBegin = (mBegin + 1) % capacity;
+    return oldest;
+}
+
 FrameTimeline::FrameTimeline(std::shared_ptr<TimeStats> timeStats, pid_t surfaceFlingerPid,
                              JankClassificationThresholds thresholds, bool useBootTimeClock)
-      : mUseBootTimeClock(useBootTimeClock),
+      : mDisplayFrames(kDefaultMaxDisplayFrames),
+        mUseBootTimeClock(useBootTimeClock),
         mMaxDisplayFrames(kDefaultMaxDisplayFrames),
         mTimeStats(std::move(timeStats)),
         mSurfaceFlingerPid(surfaceFlingerPid),
-        mJankClassificationThresholds(thresholds) {
+        mJankClassificationThresholds(thresholds),
+        mSurfaceFramePool(std::make_shared<SurfaceFramePool>()) {
     mCurrentDisplayFrame =
             std::make_shared<DisplayFrame>(mTimeStats, thresholds, &mTraceCookieCounter);
 }
 
+FrameTimeline::~FrameTimeline() = default;
+
 void FrameTimeline::onBootFinished() {
     perfetto::TracingInitArgs args;
     args.backends = perfetto::kSystemBackend;
@@ -867,27 +1000,30 @@ std::shared_ptr<SurfaceFrame> FrameTimeline::createSurfaceFrameForToken(
         const FrameTimelineInfo& frameTimelineInfo, pid_t ownerPid, uid_t ownerUid, int32_t layerId,
         std::string layerName, std::string debugName, bool isBuffer, GameMode gameMode) {
     ATRACE_CALL();
+    const SurfaceFramePool::Allocator<SurfaceFrame> allocator(mSurfaceFramePool);
     if (frameTimelineInfo.vsyncId == FrameTimelineInfo::INVALID_VSYNC_ID) {
-        return std::make_shared<SurfaceFrame>(frameTimelineInfo, ownerPid, ownerUid, layerId,
-                                              std::move(layerName), std::move(debugName),
-                                              PredictionState::None, TimelineItem(), mTimeStats,
-                                              mJankClassificationThresholds, &mTraceCookieCounter,
-                                              isBuffer, gameMode);
+        return std::allocate_shared<SurfaceFrame>(allocator, frameTimelineInfo, ownerPid, ownerUid,
+                                                  layerId, std::move(layerName),
+                                                  std::move(debugName), PredictionState::None,
+                                                  TimelineItem(), mTimeStats,
+                                                  mJankClassificationThresholds,
+                                                  &mTraceCookieCounter, isBuffer, gameMode);
     }
     std::optional<TimelineItem> predictions =
             mTokenManager.getPredictionsForToken(frameTimelineInfo.vsyncId);
     if (predictions) {
-        return std::make_shared<SurfaceFrame>(frameTimelineInfo, ownerPid, ownerUid, layerId,
-                                              std::move(layerName), std::move(debugName),
-                                              PredictionState::Valid, std::move(*predictions),
-                                              mTimeStats, mJankClassificationThresholds,
-                                              &mTraceCookieCounter, isBuffer, gameMode);
-    }
-    return std::make_shared<SurfaceFrame>(frameTimelineInfo, ownerPid, ownerUid, layerId,
-                                          std::move(layerName), std::move(debugName),
-                                          PredictionState::Expired, TimelineItem(), mTimeStats,
-                                          mJankClassificationThresholds, &mTraceCookieCounter,
-                                          isBuffer, gameMode);
+        return std::allocate_shared<SurfaceFrame>(allocator, frameTimelineInfo, ownerPid, ownerUid,
+                                                  layerId, std::move(layerName),
+                                                  std::move(debugName), PredictionState::Valid,
+                                                  std::move(*predictions), mTimeStats,
+                                                  mJankClassificationThresholds,
+                                                  &mTraceCookieCounter, isBuffer, gameMode);
+    }
+    return std::allocate_shared<SurfaceFrame>(allocator, frameTimelineInfo, ownerPid, ownerUid,
+                                              layerId, std::move(layerName), std::move(debugName),
+                                              PredictionState::Expired, TimelineItem(), mTimeStats,
+                                              mJankClassificationThresholds, &mTraceCookieCounter,
+                                              isBuffer, gameMode);
 }
 
 FrameTimeline::DisplayFrame::DisplayFrame(std::shared_ptr<TimeStats> timeStats,
@@ -931,15 +1067,29 @@ void FrameTimeline::onCommitNotComposited() {
     ATRACE_CALL();
     std::scoped_lock lock(mMutex);
     mCurrentDisplayFrame->onCommitNotComposited();
-    mCurrentDisplayFrame.reset();
-    mCurrentDisplayFrame = std::make_shared<DisplayFrame>(mTimeStats, mJankClassificationThresholds,
-                                                          &mTraceCookieCounter);
+    mCurrentDisplayFrame = recycleDisplayFrame(std::move(mCurrentDisplayFrame));
 }
 
 void FrameTimeline::DisplayFrame::addSurfaceFrame(std::shared_ptr<SurfaceFrame> surfaceFrame) {
     mSurfaceFrames.push_back(surfaceFrame);
 }
 
+void FrameTimeline::DisplayFrame::reset() {
+    mToken = FrameTimelineInfo::INVALID_VSYNC_ID;
+    mSurfaceFlingerPredictions = TimelineItem();
+    mSurfaceFlingerActuals = TimelineItem();
+    mSurfaceFrames.clear();
+    mPredictionState = PredictionState::None;
+    mJankType = JankType::None;
+    mJankSeverityType = JankSeverityType::None;
+    mGpuFence = FenceTime::NO_FENCE;
+    mFramePresentMetadata = FramePresentMetadata::UnknownPresent;
+    mFrameReadyMetadata = FrameReadyMetadata::UnknownFinish;
+    mFrameStartMetadata = FrameStartMetadata::UnknownStart;
+    mRefreshRate = Fps();
+    mRenderRate = Fps();
+}
+
 void FrameTimeline::DisplayFrame::onSfWakeUp(int64_t token, Fps refreshRate, Fps renderRate,
                                              std::optional<TimelineItem> predictions,
                                              nsecs_t wakeUpTime) {
@@ -1411,14 +1561,21 @@ void FrameTimeline::flushPendingPresentFences() {
 }
 
 void FrameTimeline::finalizeCurrentDisplayFrame() {
-    while (mDisplayFrames.size() >= mMaxDisplayFrames) {
-        // We maintain only a fixed number of frames' data. Pop older frames
-        mDisplayFrames.pop_front();
+    // We maintain only a fixed number of frames' data. The oldest frame, once pushed out, becomes
+    // the next current frame.
+    auto oldestDisplayFrame = mDisplayFrames.push(std::move(mCurrentDisplayFrame));
+    mCurrentDisplayFrame = recycleDisplayFrame(std::move(oldestDisplayFrame));
+}
+
+std::shared_ptr<FrameTimeline::DisplayFrame> FrameTimeline::recycleDisplayFrame(
+        std::shared_ptr<DisplayFrame> displayFrame) {
+    // A DisplayFrame still waiting on its present fence, or held by a test, can't be reused.
+    if (displayFrame && displayFrame.use_count() == 1) {
+        displayFrame->reset();
+        return displayFrame;
     }
-    mDisplayFrames.push_back(mCurrentDisplayFrame);
-    mCurrentDisplayFrame.reset();
-    mCurrentDisplayFrame = std::make_shared<DisplayFrame>(mTimeStats, mJankClassificationThresholds,
-                                                          &mTraceCookieCounter);
+    return std::make_shared<DisplayFrame>(mTimeStats, mJankClassificationThresholds,
+                                          &mTraceCookieCounter);
 }
 
 nsecs_t FrameTimeline::DisplayFrame::getBaseTime() const {
@@ -1524,7 +1681,7 @@ void FrameTimeline::setMaxDisplayFrames(uint32_t size) {
     std::scoped_lock lock(mMutex);
 
     // The size can either increase or decrease, clear everything, to be consistent
-    mDisplayFrames.clear();
+    mDisplayFrames.setCapacity(size);
     mPendingPresentFences.clear();
     mMaxDisplayFrames = size;
 }
@@ -18,11 +18,12 @@
 
 #include <atomic>
 #include <chrono>
-#include <deque>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <span>
 #include <string>
+#include <vector>
 
 #include <gui/ISurfaceComposer.h>
 #include <gui/JankInfo.h>
@@ -121,6 +122,11 @@ public:
     // destroys it later.
     virtual int64_t generateTokenForPredictions(TimelineItem&& prediction) = 0;
 
+    // Generates consecutive tokens for a batch of predictions, writing the token for
+    // predictions[i] to outTokens[i]. outTokens must be at least as long as predictions.
+    virtual void generateTokensForPredictions(std::span<const TimelineItem> predictions,
+                                              std::span<int64_t> outTokens);
+
     // Returns the stored predictions for a given token, if the predictions haven't expired.
     virtual std::optional<TimelineItem> getPredictionsForToken(int64_t token) const = 0;
 };
@@ -350,6 +356,8 @@ public:
     ~TokenManager() = default;
 
     int64_t generateTokenForPredictions(TimelineItem&& predictions) override;
+    void generateTokensForPredictions(std::span<const TimelineItem> predictions,
+                                      std::span<int64_t> outTokens) override;
     std::optional<TimelineItem> getPredictionsForToken(int64_t token) const override;
 
 private:
@@ -357,6 +365,7 @@ private:
     friend class android::frametimeline::FrameTimelineTest;
 
     void flushTokens(nsecs_t flushTime) REQUIRES(mMutex);
+    int64_t generateTokenLocked(const TimelineItem& predictions) REQUIRES(mMutex);
 
     std::map<int64_t, TimelineItem> mPredictions GUARDED_BY(mMutex);
     int64_t mCurrentToken GUARDED_BY(mMutex);
@@ -400,6 +409,9 @@ public:
         void onCommitNotComposited();
         // Adds the provided SurfaceFrame to the current display frame.
         void addSurfaceFrame(std::shared_ptr<SurfaceFrame> surfaceFrame);
+        // Returns the DisplayFrame to its initial state, so that it can be reused for another
+        // vsync. The storage for the SurfaceFrames is kept.
+        void reset();
 
         void setPredictions(PredictionState predictionState, TimelineItem predictions);
         void setActualStartTime(nsecs_t actualStartTime);
@@ -472,7 +484,7 @@ public:
 
     FrameTimeline(std::shared_ptr<TimeStats> timeStats, pid_t surfaceFlingerPid,
                   JankClassificationThresholds thresholds = {}, bool useBootTimeClock = true);
-    ~FrameTimeline() = default;
+    ~FrameTimeline();
 
     frametimeline::TokenManager* getTokenManager() override { return &mTokenManager; }
     std::shared_ptr<SurfaceFrame> createSurfaceFrameForToken(
@@ -504,11 +516,40 @@ private:
     void flushPendingPresentFences() REQUIRES(mMutex);
     std::optional<size_t> getFirstSignalFenceIndex() const REQUIRES(mMutex);
     void finalizeCurrentDisplayFrame() REQUIRES(mMutex);
+    // Returns a DisplayFrame to be the next mCurrentDisplayFrame, reusing the given one if nothing
+    // else holds on to it.
+    std::shared_ptr<DisplayFrame> recycleDisplayFrame(std::shared_ptr<DisplayFrame> displayFrame)
+            REQUIRES(mMutex);
     void dumpAll(std::string& result);
     void dumpJank(std::string& result);
 
-    // Sliding window of display frames. TODO(b/168072834): compare perf with fixed size array
-    std::deque<std::shared_ptr<DisplayFrame>> mDisplayFrames GUARDED_BY(mMutex);
+    // Fixed size ring of the most recent display frames, oldest first.
+    class DisplayFrameRing {
+    public:
+        explicit DisplayFrameRing(size_t capacity) { setCapacity(capacity); }
+
+        // Drops all the display frames and makes room for the given number of them.
+        void setCapacity(size_t capacity);
+
+        size_t size() const { return mSize; }
+        bool empty() const { return mSize == 0; }
+
+        const std::shared_ptr<DisplayFrame>& operator[](size_t index) const {
+            return mFrames[(mBegin + index) % mFrames.size()];
+        }
+
+        // Appends the display frame, and returns the oldest one if the ring was full.
+        std::shared_ptr<DisplayFrame> push(std::shared_ptr<DisplayFrame> displayFrame);
+
+    private:
+        std::vector<std::shared_ptr<DisplayFrame>> mFrames;
+        size_t mBegin = 0;
+        size_t mSize = 0;
+    };
+
+    class SurfaceFramePool;
+
+    DisplayFrameRing mDisplayFrames GUARDED_BY(mMutex);
     std::vector<std::pair<std::shared_ptr<FenceTime>, std::shared_ptr<DisplayFrame>>>
             mPendingPresentFences GUARDED_BY(mMutex);
     std::shared_ptr<DisplayFrame> mCurrentDisplayFrame GUARDED_BY(mMutex);
@@ -522,6 +563,9 @@ private:
     nsecs_t mPreviousActualPresentTime = 0;
     nsecs_t mPreviousPredictionPresentTime = 0;
     const JankClassificationThresholds mJankClassificationThresholds;
+    // Recycles the storage of SurfaceFrames. Shared with the SurfaceFrames themselves, as Layers
+    // may hold on to them for longer than FrameTimeline lives.
+    const std::shared_ptr<SurfaceFramePool> mSurfaceFramePool;
     static constexpr uint32_t kDefaultMaxDisplayFrames = 64;
     // The initial container size for the vector<SurfaceFrames> inside display frame. Although
     // this number doesn't represent any bounds on the number of surface frames that can go in a
@@ -236,10 +236,16 @@ Layer::~Layer() {
     // one of the layers, in this case the original layer, needs to handle the deletion. The
     // original layer and the clone should be removed at the same time so there shouldn't be any
     // issue with the clone layer trying to use the texture.
-    if (mBufferInfo.mBuffer != nullptr) {
-        callReleaseBufferCallback(mDrawingState.releaseBufferListener,
-                                  mBufferInfo.mBuffer->getBuffer(), mBufferInfo.mFrameNumber,
-                                  mBufferInfo.mFence);
+    //
+    // The buffer is released right away rather than batched with the other releases of the frame,
+    // as a layer can be destroyed after the callbacks for the frame went out.
+    if (mBufferInfo.mBuffer != nullptr && mDrawingState.releaseBufferListener) {
+        mDrawingState.releaseBufferListener
+                ->onReleaseBuffer({mBufferInfo.mBuffer->getBuffer()->getId(),
+                                   mBufferInfo.mFrameNumber},
+                                  mBufferInfo.mFence ? mBufferInfo.mFence : Fence::NO_FENCE,
+                                  mFlinger->getMaxAcquiredBufferCountForCurrentRefreshRate(
+                                          mOwnerUid));
     }
     const int32_t layerId = getSequence();
     mFlinger->mTimeStats->onDestroy(layerId);
@@ -2824,9 +2830,11 @@ void Layer::callReleaseBufferCallback(const sp<ITransactionCompletedListener>& l
     ATRACE_FORMAT_INSTANT("callReleaseBufferCallback %s - %" PRIu64, getDebugName(), framenumber);
     uint32_t currentMaxAcquiredBufferCount =
             mFlinger->getMaxAcquiredBufferCountForCurrentRefreshRate(mOwnerUid);
-    listener->onReleaseBuffer({buffer->getId(), framenumber},
-                              releaseFence ? releaseFence : Fence::NO_FENCE,
-                              currentMaxAcquiredBufferCount);
+    mFlinger->getTransactionCallbackInvoker()
+            .addReleasedBuffer(listener,
+                               {{buffer->getId(), framenumber},
+                                releaseFence ? releaseFence : Fence::NO_FENCE,
+                                currentMaxAcquiredBufferCount});
 }
 
 sp<CallbackHandle> Layer::findCallbackHandle() {
@@ -24,9 +24,12 @@
 #include <sched.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <cstdint>
 #include <optional>
+#include <span>
 #include <type_traits>
 #include <utility>
 
@@ -37,6 +40,8 @@
 #include <cutils/compiler.h>
 #include <cutils/sched_policy.h>
 
+#include <ftl/small_map.h>
+
 #include <gui/DisplayEventReceiver.h>
 #include <gui/SchedulingPolicy.h>
 
@@ -82,8 +87,9 @@ std::string toString(VSyncRequest request) {
 }
 
 std::string toString(const EventThreadConnection& connection) {
-    return StringPrintf("Connection{%p, %s}", &connection,
-                        toString(connection.vsyncRequest).c_str());
+    return StringPrintf("Connection{%p, %s%s}", &connection,
+                        toString(connection.vsyncRequest).c_str(),
+                        connection.vsyncBroadcastEnabled ? ", broadcast" : "");
 }
 
 std::string toString(const DisplayEventReceiver::Event& event) {
@@ -244,6 +250,25 @@ binder::Status EventThreadConnection::getSchedulingPolicy(gui::SchedulingPolicy*
     return gui::getSchedulingPolicy(outPolicy);
 }
 
+binder::Status EventThreadConnection::getVsyncBroadcastChannel(
+        gui::VsyncBroadcastChannel* outChannel) {
+    ATRACE_CALL();
+    if (!mEventRegistration.test(gui::ISurfaceComposer::EventRegistration::vsyncBroadcast)) {
+        return binder::Status::fromStatusT(INVALID_OPERATION);
+    }
+    return binder::Status::fromStatusT(
+            mEventThread->getVsyncBroadcastChannel(sp<EventThreadConnection>::fromExisting(this),
+                                                   outChannel));
+}
+
+binder::Status EventThreadConnection::enableVsyncBroadcast() {
+    if (!mEventRegistration.test(gui::ISurfaceComposer::EventRegistration::vsyncBroadcast)) {
+        return binder::Status::fromStatusT(INVALID_OPERATION);
+    }
+    mEventThread->enableVsyncBroadcast(sp<EventThreadConnection>::fromExisting(this));
+    return binder::Status::ok();
+}
+
 status_t EventThreadConnection::postEvent(const DisplayEventReceiver::Event& event) {
     constexpr auto toStatus = [](ssize_t size) {
         return size < 0 ? status_t(size) : status_t(NO_ERROR);
@@ -358,6 +383,27 @@ void EventThread::removeDisplayEventConnectionLocked(const wp<EventThreadConnect
             mDisplayEventConnections.cend(), connection);
     if (it != mDisplayEventConnections.cend()) {
         mDisplayEventConnections.erase(it);
+        removeUnusedVsyncBroadcastChannelsLocked();
+    }
+}
+
+void EventThread::removeUnusedVsyncBroadcastChannelsLocked() {
+    FrameIntervals unusedFrameIntervals;
+    for (const auto& [frameInterval, channel] : mVsyncBroadcastChannels) {
+        const bool used = std::any_of(mDisplayEventConnections.begin(),
+                                      mDisplayEventConnections.end(),
+                                      [frameInterval = frameInterval](const auto& ptr) {
+                                          const auto connection = ptr.promote();
+                                          return connection &&
+                                                  connection->vsyncBroadcastFrameInterval ==
+                                                  frameInterval;
+                                      });
+        if (!used) {
+            unusedFrameIntervals.push_back(frameInterval);
+        }
+    }
+    for (const nsecs_t frameInterval : unusedFrameIntervals) {
+        mVsyncBroadcastChannels.erase(frameInterval);
     }
 }
 
@@ -410,6 +456,39 @@ VsyncEventData EventThread::getLatestVsyncEventData(const sp<EventThreadConnecti
     return vsyncEventData;
 }
 
+status_t EventThread::getVsyncBroadcastChannel(const sp<EventThreadConnection>& connection,
+                                               gui::VsyncBroadcastChannel* outChannel) {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    const nsecs_t frameInterval = mCallback.getVsyncPeriod(connection->mOwnerUid).ns();
+    auto it = mVsyncBroadcastChannels.find(frameInterval);
+    if (it == mVsyncBroadcastChannels.end()) {
+        auto channel =
+                std::make_unique<gui::VsyncBroadcastChannel>(gui::VsyncBroadcastChannel::Publisher);
+        if (const status_t status = channel->initCheck(); status != NO_ERROR) {
+            return status;
+        }
+        it = mVsyncBroadcastChannels.try_emplace(frameInterval, std::move(channel)).first;
+    }
+
+    if (const status_t status = it->second->addReceiver(outChannel); status != NO_ERROR) {
+        return status;
+    }
+    // The connection has to enable broadcasts again, now that it listens on another channel.
+    const auto previousFrameInterval =
+            std::exchange(connection->vsyncBroadcastFrameInterval, frameInterval);
+    connection->vsyncBroadcastEnabled = false;
+    if (previousFrameInterval && *previousFrameInterval != frameInterval) {
+        removeUnusedVsyncBroadcastChannelsLocked();
+    }
+    return NO_ERROR;
+}
+
+void EventThread::enableVsyncBroadcast(const sp<EventThreadConnection>& connection) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    connection->vsyncBroadcastEnabled = connection->vsyncBroadcastFrameInterval.has_value();
+}
+
 void EventThread::enableSyntheticVsync(bool enable) {
     std::lock_guard<std::mutex> lock(mMutex);
     if (!mVSyncState || mVSyncState->synthetic == enable) {
@@ -474,8 +553,10 @@ void EventThread::onHdcpLevelsChanged(PhysicalDisplayId displayId, int32_t conne
 
 void EventThread::threadMain(std::unique_lock<std::mutex>& lock) {
     DisplayEventConsumers consumers;
+    FrameIntervals unusableBroadcasts;
 
     while (mState != State::Quit) {
+        bool connectionsRemoved = false;
         std::optional<DisplayEventReceiver::Event> event;
 
         // Determine next event to dispatch.
@@ -505,6 +586,17 @@ void EventThread::threadMain(std::unique_lock<std::mutex>& lock) {
             if (const auto connection = it->promote()) {
                 if (event && shouldConsumeEvent(*event, connection)) {
                     consumers.push_back(connection);
+                } else if (event && event->header.type == DisplayEventReceiver::DISPLAY_EVENT_VSYNC &&
+                           connection->vsyncBroadcastEnabled &&
+                           connection->vsyncRequest != VSyncRequest::None) {
+                    // The connection is waiting for a later vsync, but may not have read the one
+                    // last published for it yet, so publishing this one on its channel could
+                    // deliver it early.
+                    const nsecs_t frameInterval = *connection->vsyncBroadcastFrameInterval;
+                    if (std::find(unusableBroadcasts.begin(), unusableBroadcasts.end(),
+                                  frameInterval) == unusableBroadcasts.end()) {
+                        unusableBroadcasts.push_back(frameInterval);
+                    }
                 }
 
                 vsyncRequested |= connection->vsyncRequest != VSyncRequest::None;
@@ -512,13 +604,18 @@ void EventThread::threadMain(std::unique_lock<std::mutex>& lock) {
                 ++it;
             } else {
                 it = mDisplayEventConnections.erase(it);
+                connectionsRemoved = true;
             }
         }
+        if (connectionsRemoved) {
+            removeUnusedVsyncBroadcastChannelsLocked();
+        }
 
         if (!consumers.empty()) {
-            dispatchEvent(*event, consumers);
+            dispatchEvent(*event, consumers, unusableBroadcasts);
             consumers.clear();
         }
+        unusableBroadcasts.clear();
 
         if (mVSyncState && vsyncRequested) {
             mState = mVSyncState->synthetic ? State::SyntheticVSync : State::VSync;
@@ -632,19 +729,11 @@ bool EventThread::shouldConsumeEvent(const DisplayEventReceiver::Event& event,
     }
 }
 
-int64_t EventThread::generateToken(nsecs_t timestamp, nsecs_t deadlineTimestamp,
-                                   nsecs_t expectedPresentationTime) const {
-    if (mTokenManager != nullptr) {
-        return mTokenManager->generateTokenForPredictions(
-                {timestamp, deadlineTimestamp, expectedPresentationTime});
-    }
-    return FrameTimelineInfo::INVALID_VSYNC_ID;
-}
-
 void EventThread::generateFrameTimeline(VsyncEventData& outVsyncEventData, nsecs_t frameInterval,
                                         nsecs_t timestamp,
                                         nsecs_t preferredExpectedPresentationTime,
                                         nsecs_t preferredDeadlineTimestamp) const {
+    std::array<frametimeline::TimelineItem, VsyncEventData::kFrameTimelinesCapacity> predictions;
     uint32_t currentIndex = 0;
     // Add 1 to ensure the preferredFrameTimelineIndex entry (when multiplier == 0) is included.
     for (int64_t multiplier = -VsyncEventData::kFrameTimelinesCapacity + 1;
@@ -676,9 +765,10 @@ void EventThread::generateFrameTimeline(VsyncEventData& outVsyncEventData, nsecs
         }
 
         outVsyncEventData.frameTimelines[currentIndex] =
-                {.vsyncId = generateToken(timestamp, deadlineTimestamp, expectedPresentationTime),
+                {.vsyncId = FrameTimelineInfo::INVALID_VSYNC_ID,
                  .deadlineTimestamp = deadlineTimestamp,
                  .expectedPresentationTime = expectedPresentationTime};
+        predictions[currentIndex] = {timestamp, deadlineTimestamp, expectedPresentationTime};
         currentIndex++;
     }
 
@@ -688,26 +778,58 @@ void EventThread::generateFrameTimeline(VsyncEventData& outVsyncEventData, nsecs
               __func__, preferredExpectedPresentationTime, frameInterval,
               static_cast<int64_t>(scheduler::VsyncConfig::kEarlyLatchMaxThreshold.count()));
         outVsyncEventData.frameTimelines[currentIndex] =
-                {.vsyncId = generateToken(timestamp, preferredDeadlineTimestamp,
-                                          preferredExpectedPresentationTime),
+                {.vsyncId = FrameTimelineInfo::INVALID_VSYNC_ID,
                  .deadlineTimestamp = preferredDeadlineTimestamp,
                  .expectedPresentationTime = preferredExpectedPresentationTime};
+        predictions[currentIndex] = {timestamp, preferredDeadlineTimestamp,
+                                     preferredExpectedPresentationTime};
         currentIndex++;
     }
 
     outVsyncEventData.frameTimelinesLength = currentIndex;
+
+    if (mTokenManager == nullptr) {
+        return;
+    }
+
+    // Mint the tokens for all frame timelines at once, so the TokenManager lock is taken once.
+    std::array<int64_t, VsyncEventData::kFrameTimelinesCapacity> tokens;
+    mTokenManager->generateTokensForPredictions(std::span(predictions).first(currentIndex), tokens);
+    for (uint32_t i = 0; i < currentIndex; i++) {
+        outVsyncEventData.frameTimelines[i].vsyncId = tokens[i];
+    }
 }
 
 void EventThread::dispatchEvent(const DisplayEventReceiver::Event& event,
-                                const DisplayEventConsumers& consumers) {
+                                const DisplayEventConsumers& consumers,
+                                const FrameIntervals& unusableBroadcasts) {
+    // Consumers with the same frame interval are given the same frame timelines, so generate them
+    // (and the tokens identifying them) once per distinct interval rather than once per consumer.
+    ftl::SmallMap<nsecs_t, VsyncEventData, 2> vsyncDataByFrameInterval;
+    // Vsync events to publish on broadcast channels, by frame interval.
+    ftl::SmallMap<nsecs_t, DisplayEventReceiver::Event, 2> broadcasts;
+
     for (const auto& consumer : consumers) {
         DisplayEventReceiver::Event copy = event;
         if (event.header.type == DisplayEventReceiver::DISPLAY_EVENT_VSYNC) {
-            const Period frameInterval = mCallback.getVsyncPeriod(consumer->mOwnerUid);
-            copy.vsync.vsyncData.frameInterval = frameInterval.ns();
-            generateFrameTimeline(copy.vsync.vsyncData, frameInterval.ns(), copy.header.timestamp,
-                                  event.vsync.vsyncData.preferredExpectedPresentationTime(),
-                                  event.vsync.vsyncData.preferredDeadlineTimestamp());
+            const nsecs_t frameInterval = mCallback.getVsyncPeriod(consumer->mOwnerUid).ns();
+            if (const auto vsyncData = vsyncDataByFrameInterval.get(frameInterval)) {
+                copy.vsync.vsyncData = vsyncData->get();
+            } else {
+                copy.vsync.vsyncData.frameInterval = frameInterval;
+                generateFrameTimeline(copy.vsync.vsyncData, frameInterval, copy.header.timestamp,
+                                      event.vsync.vsyncData.preferredExpectedPresentationTime(),
+                                      event.vsync.vsyncData.preferredDeadlineTimestamp());
+                vsyncDataByFrameInterval.try_emplace(frameInterval, copy.vsync.vsyncData);
+            }
+
+            if (consumer->vsyncBroadcastEnabled &&
+                consumer->vsyncBroadcastFrameInterval == frameInterval &&
+                std::find(unusableBroadcasts.begin(), unusableBroadcasts.end(), frameInterval) ==
+                        unusableBroadcasts.end()) {
+                broadcasts.try_emplace(frameInterval, copy);
+                continue;
+            }
         }
         switch (consumer->postEvent(copy)) {
             case NO_ERROR:
@@ -724,6 +846,12 @@ void EventThread::dispatchEvent(const DisplayEventReceiver::Event& event,
                 removeDisplayEventConnectionLocked(consumer);
         }
     }
+    // Publishing wakes up all the receivers of a channel at once, however many consume the event.
+    for (const auto& [frameInterval, broadcast] : broadcasts) {
+        if (const auto channel = mVsyncBroadcastChannels.get(frameInterval)) {
+            channel->get()->publish(broadcast);
+        }
+    }
     if (event.header.type == DisplayEventReceiver::DISPLAY_EVENT_VSYNC &&
         FlagManager::getInstance().vrr_config()) {
         mCallback.onExpectedPresentTimePosted(
@@ -754,6 +882,9 @@ void EventThread::dump(std::string& result) const {
         StringAppendF(&result, "    %s\n", toString(event).c_str());
     }
 
+    StringAppendF(&result, "  vsync broadcast channels (count=%zu)\n",
+                  mVsyncBroadcastChannels.size());
+
     StringAppendF(&result, "  connections (count=%zu):\n", mDisplayEventConnections.size());
     for (const auto& ptr : mDisplayEventConnections) {
         if (const auto connection = ptr.promote()) {
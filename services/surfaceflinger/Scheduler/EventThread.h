@@ -18,8 +18,11 @@
 
 #include <android-base/thread_annotations.h>
 #include <android/gui/BnDisplayEventConnection.h>
+#include <ftl/small_map.h>
+#include <ftl/small_vector.h>
 #include <gui/DisplayEventReceiver.h>
 #include <private/gui/BitTube.h>
+#include <private/gui/VsyncBroadcastChannel.h>
 #include <sys/types.h>
 #include <utils/Errors.h>
 
@@ -79,8 +82,15 @@ public:
     binder::Status requestNextVsync() override; // asynchronous
     binder::Status getLatestVsyncEventData(ParcelableVsyncEventData* outVsyncEventData) override;
     binder::Status getSchedulingPolicy(gui::SchedulingPolicy* outPolicy) override;
+    binder::Status getVsyncBroadcastChannel(gui::VsyncBroadcastChannel* outChannel) override;
+    binder::Status enableVsyncBroadcast() override;
 
     VSyncRequest vsyncRequest = VSyncRequest::None;
+
+    // Frame interval of the broadcast channel handed out to this connection, if any, and whether
+    // vsync events may be delivered through that channel.
+    std::optional<nsecs_t> vsyncBroadcastFrameInterval;
+    bool vsyncBroadcastEnabled = false;
     const uid_t mOwnerUid;
     const EventRegistrationFlags mEventRegistration;
 
@@ -130,6 +140,12 @@ public:
     virtual VsyncEventData getLatestVsyncEventData(const sp<EventThreadConnection>& connection,
                                                    nsecs_t now) const = 0;
 
+    // Returns the channel broadcasting vsync events at the connection's frame interval.
+    virtual status_t getVsyncBroadcastChannel(const sp<EventThreadConnection>& connection,
+                                              gui::VsyncBroadcastChannel* outChannel) = 0;
+    // Delivers vsync events to the connection through its broadcast channel when possible.
+    virtual void enableVsyncBroadcast(const sp<EventThreadConnection>& connection) = 0;
+
     virtual void onNewVsyncSchedule(std::shared_ptr<scheduler::VsyncSchedule>) = 0;
 
     virtual void onHdcpLevelsChanged(PhysicalDisplayId displayId, int32_t connectedLevel,
@@ -162,6 +178,9 @@ public:
     void requestNextVsync(const sp<EventThreadConnection>& connection) override;
     VsyncEventData getLatestVsyncEventData(const sp<EventThreadConnection>& connection,
                                            nsecs_t now) const override;
+    status_t getVsyncBroadcastChannel(const sp<EventThreadConnection>& connection,
+                                      gui::VsyncBroadcastChannel* outChannel) override;
+    void enableVsyncBroadcast(const sp<EventThreadConnection>& connection) override;
 
     void enableSyntheticVsync(bool) override;
 
@@ -188,21 +207,25 @@ private:
     friend EventThreadTest;
 
     using DisplayEventConsumers = std::vector<sp<EventThreadConnection>>;
+    using FrameIntervals = ftl::SmallVector<nsecs_t, 2>;
 
     void threadMain(std::unique_lock<std::mutex>& lock) REQUIRES(mMutex);
 
     bool shouldConsumeEvent(const DisplayEventReceiver::Event& event,
                             const sp<EventThreadConnection>& connection) const REQUIRES(mMutex);
+    // Vsync events are not broadcast at the frame intervals in unusableBroadcasts, since connections
+    // that do not consume the event are listening on those channels.
     void dispatchEvent(const DisplayEventReceiver::Event& event,
-                       const DisplayEventConsumers& consumers) REQUIRES(mMutex);
+                       const DisplayEventConsumers& consumers,
+                       const FrameIntervals& unusableBroadcasts) REQUIRES(mMutex);
 
     void removeDisplayEventConnectionLocked(const wp<EventThreadConnection>& connection)
             REQUIRES(mMutex);
+    // Removes the broadcast channels that no connection listens on anymore.
+    void removeUnusedVsyncBroadcastChannelsLocked() REQUIRES(mMutex);
 
     void onVsync(nsecs_t vsyncTime, nsecs_t wakeupTime, nsecs_t readyTime);
 
-    int64_t generateToken(nsecs_t timestamp, nsecs_t deadlineTimestamp,
-                          nsecs_t expectedPresentationTime) const;
     void generateFrameTimeline(VsyncEventData& outVsyncEventData, nsecs_t frameInterval,
                                nsecs_t timestamp, nsecs_t preferredExpectedPresentationTime,
                                nsecs_t preferredDeadlineTimestamp) const;
@@ -232,6 +255,10 @@ private:
     std::vector<wp<EventThreadConnection>> mDisplayEventConnections GUARDED_BY(mMutex);
     std::deque<DisplayEventReceiver::Event> mPendingEvents GUARDED_BY(mMutex);
 
+    // Channels broadcasting vsync events to connections that opted in, by frame interval.
+    ftl::SmallMap<nsecs_t, std::unique_ptr<gui::VsyncBroadcastChannel>, 2> mVsyncBroadcastChannels
+            GUARDED_BY(mMutex);
+
     // VSYNC state of connected display.
     struct VSyncState {
         explicit VSyncState(PhysicalDisplayId displayId) : displayId(displayId) {}
@@ -33,6 +33,7 @@
 #include <ftl/match.h>
 #include <ftl/unit.h>
 #include <gui/TraceUtils.h>
+#include <math/HashCombine.h>
 #include <scheduler/Fps.h>
 #include <scheduler/FrameRateMode.h>
 #include <utils/Trace.h>
@@ -475,6 +476,160 @@ float RefreshRateSelector::calculateLayerScoreLocked(const LayerRequirement& lay
             kNonExactMatchingPenalty;
 }
 
+void RefreshRateSelector::scoreLayerLocked(const LayerRequirement& layer,
+                                           const LayerScoringContext& context,
+                                           ScoredLayer& out) const {
+    using namespace fps_approx_ops;
+
+    const auto& activeMode = *getActiveModeLocked().modePtr;
+    const Policy* policy = getCurrentPolicyLocked();
+
+    out.layer = layer;
+    out.scores.assign(mAppRequestFrameRates.size(), LayerScore{});
+    out.heuristicExpired = false;
+
+    ALOGV("Calculating score for %s (%s, weight %.2f, desired %.2f, category %s) ",
+          layer.name.c_str(), ftl::enum_string(layer.vote).c_str(), layer.weight,
+          layer.desiredRefreshRate.getValue(),
+          ftl::enum_string(layer.frameRateCategory).c_str());
+    if (layer.isNoVote() || layer.frameRateCategory == FrameRateCategory::NoPreference ||
+        layer.vote == LayerVoteType::Min) {
+        ALOGV("%s scoring skipped due to vote", formatLayerInfo(layer, layer.weight).c_str());
+        return;
+    }
+
+    const auto weight = layer.weight;
+
+    for (size_t i = 0; i < mAppRequestFrameRates.size(); i++) {
+        const auto& [fps, modePtr] = mAppRequestFrameRates[i];
+        LayerScore& score = out.scores[i];
+        const bool isSeamlessSwitch = modePtr->getGroup() == activeMode.getGroup();
+
+        if (layer.seamlessness == Seamlessness::OnlySeamless && !isSeamlessSwitch) {
+            ALOGV("%s ignores %s to avoid non-seamless switch. Current mode = %s",
+                  formatLayerInfo(layer, weight).c_str(), to_string(*modePtr).c_str(),
+                  to_string(activeMode).c_str());
+            continue;
+        }
+
+        if (layer.seamlessness == Seamlessness::SeamedAndSeamless && !isSeamlessSwitch &&
+            !layer.focused) {
+            ALOGV("%s ignores %s because it's not focused and the switch is going to be seamed."
+                  " Current mode = %s",
+                  formatLayerInfo(layer, weight).c_str(), to_string(*modePtr).c_str(),
+                  to_string(activeMode).c_str());
+            continue;
+        }
+
+        if (context.smoothSwitchOnly && modePtr->getId() != context.activeModeId) {
+            ALOGV("%s ignores %s because it's non-VRR and smooth switch only."
+                  " Current mode = %s",
+                  formatLayerInfo(layer, weight).c_str(), to_string(*modePtr).c_str(),
+                  to_string(activeMode).c_str());
+            continue;
+        }
+
+        // Layers with default seamlessness vote for the current mode group if
+        // there are layers with seamlessness=SeamedAndSeamless and for the default
+        // mode group otherwise. In second case, if the current mode group is different
+        // from the default, this means a layer with seamlessness=SeamedAndSeamless has just
+        // disappeared.
+        const bool isInPolicyForDefault = modePtr->getGroup() == context.anchorGroup;
+        if (layer.seamlessness == Seamlessness::Default && !isInPolicyForDefault) {
+            ALOGV("%s ignores %s. Current mode = %s", formatLayerInfo(layer, weight).c_str(),
+                  to_string(*modePtr).c_str(), to_string(activeMode).c_str());
+            continue;
+        }
+
+        const bool inPrimaryPhysicalRange =
+                policy->primaryRanges.physical.includes(modePtr->getPeakFps());
+        const bool inPrimaryRenderRange = policy->primaryRanges.render.includes(fps);
+        if (((policy->primaryRangeIsSingleRate() && !inPrimaryPhysicalRange) ||
+             !inPrimaryRenderRange) &&
+            !(layer.focused &&
+              (layer.vote == LayerVoteType::ExplicitDefault ||
+               layer.vote == LayerVoteType::ExplicitExact))) {
+            // Only focused layers with ExplicitDefault frame rate settings are allowed to score
+            // refresh rates outside the primary range.
+            continue;
+        }
+
+        float layerScore;
+        if (layer.vote == LayerVoteType::Heuristic && context.heuristicIdle && fps > 60_Hz) {
+            // Time for heuristic layer to keep using high refresh rate has expired
+            out.heuristicExpired = true;
+            ALOGV("%s expired to keep using %s", formatLayerInfo(layer, weight).c_str(),
+                  to_string(fps).c_str());
+            continue;
+        } else {
+            layerScore =
+                calculateLayerScoreLocked(layer, fps, isSeamlessSwitch);
+        }
+        const float weightedLayerScore = weight * layerScore;
+
+        // Layer with fixed source has a special consideration which depends on the
+        // mConfig.frameRateMultipleThreshold. We don't want these layers to score
+        // refresh rates above the threshold, but we also don't want to favor the lower
+        // ones by having a greater number of layers scoring them. Instead, we calculate
+        // the score independently for these layers and later decide which
+        // refresh rates to add it. For example, desired 24 fps with 120 Hz threshold should not
+        // score 120 Hz, but desired 60 fps should contribute to the score.
+        const bool fixedSourceLayer = [](LayerVoteType vote) {
+            switch (vote) {
+                case LayerVoteType::ExplicitExactOrMultiple:
+                case LayerVoteType::Heuristic:
+                    return true;
+                case LayerVoteType::NoVote:
+                case LayerVoteType::Min:
+                case LayerVoteType::Max:
+                case LayerVoteType::ExplicitDefault:
+                case LayerVoteType::ExplicitExact:
+                case LayerVoteType::ExplicitGte:
+                case LayerVoteType::ExplicitCategory:
+                    return false;
+            }
+        }(layer.vote);
+        const bool layerBelowThreshold = mConfig.frameRateMultipleThreshold != 0 &&
+                layer.desiredRefreshRate <
+                        Fps::fromValue(mConfig.frameRateMultipleThreshold / 2);
+        if (fixedSourceLayer && layerBelowThreshold) {
+            const bool modeAboveThreshold =
+                    modePtr->getPeakFps() >= Fps::fromValue(mConfig.frameRateMultipleThreshold);
+            if (modeAboveThreshold) {
+                ALOGV("%s gives %s (%s(%s)) fixed source (above threshold) score of %.4f",
+                      formatLayerInfo(layer, weight).c_str(), to_string(fps).c_str(),
+                      to_string(modePtr->getPeakFps()).c_str(),
+                      to_string(modePtr->getVsyncRate()).c_str(), layerScore);
+                score = {LayerScoreKind::FixedSourceAboveThreshold, weightedLayerScore};
+            } else {
+                ALOGV("%s gives %s (%s(%s)) fixed source (below threshold) score of %.4f",
+                      formatLayerInfo(layer, weight).c_str(), to_string(fps).c_str(),
+                      to_string(modePtr->getPeakFps()).c_str(),
+                      to_string(modePtr->getVsyncRate()).c_str(), layerScore);
+                score = {LayerScoreKind::FixedSourceBelowThreshold, weightedLayerScore};
+            }
+        } else {
+            ALOGV("%s gives %s (%s(%s)) score of %.4f", formatLayerInfo(layer, weight).c_str(),
+                  to_string(fps).c_str(), to_string(modePtr->getPeakFps()).c_str(),
+                  to_string(modePtr->getVsyncRate()).c_str(), layerScore);
+            score = {LayerScoreKind::Overall, weightedLayerScore};
+        }
+    }
+}
+
+size_t RefreshRateSelector::GetRankedFrameRatesCache::hashOf(
+        const std::vector<LayerRequirement>& layers, GlobalSignals signals) {
+    size_t hash = hashCombine(signals.touch, signals.idle, signals.powerOnImminent,
+                              signals.heuristicIdle);
+    for (const auto& layer : layers) {
+        // The desired refresh rate is compared approximately, so it is not part of the hash.
+        hashCombineSingleHashed(hash,
+                                hashCombine(layer.name, layer.vote, layer.seamlessness,
+                                            layer.weight, layer.focused, layer.frameRateCategory));
+    }
+    return hash;
+}
+
 auto RefreshRateSelector::getRankedFrameRates(const std::vector<LayerRequirement>& layers,
                                               GlobalSignals signals, Fps pacesetterFps) const
         -> RankedFrameRates {
@@ -706,131 +861,42 @@ auto RefreshRateSelector::getRankedFrameRatesLocked(const std::vector<LayerRequi
         scores.emplace_back(RefreshRateScore{it, 0.0f});
     }
 
-    for (const auto& layer : layers) {
-        ALOGV("Calculating score for %s (%s, weight %.2f, desired %.2f, category %s) ",
-              layer.name.c_str(), ftl::enum_string(layer.vote).c_str(), layer.weight,
-              layer.desiredRefreshRate.getValue(),
-              ftl::enum_string(layer.frameRateCategory).c_str());
-        if (layer.isNoVote() || layer.frameRateCategory == FrameRateCategory::NoPreference ||
-            layer.vote == LayerVoteType::Min) {
-            ALOGV("%s scoring skipped due to vote", formatLayerInfo(layer, layer.weight).c_str());
-            continue;
-        }
-
-        const auto weight = layer.weight;
-
-        for (auto& [mode, overallScore, fixedRateBelowThresholdLayersScore] : scores) {
-            const auto& [fps, modePtr] = mode;
-            const bool isSeamlessSwitch = modePtr->getGroup() == activeMode.getGroup();
-
-            if (layer.seamlessness == Seamlessness::OnlySeamless && !isSeamlessSwitch) {
-                ALOGV("%s ignores %s to avoid non-seamless switch. Current mode = %s",
-                      formatLayerInfo(layer, weight).c_str(), to_string(*modePtr).c_str(),
-                      to_string(activeMode).c_str());
-                continue;
-            }
-
-            if (layer.seamlessness == Seamlessness::SeamedAndSeamless && !isSeamlessSwitch &&
-                !layer.focused) {
-                ALOGV("%s ignores %s because it's not focused and the switch is going to be seamed."
-                      " Current mode = %s",
-                      formatLayerInfo(layer, weight).c_str(), to_string(*modePtr).c_str(),
-                      to_string(activeMode).c_str());
-                continue;
-            }
-
-            if (smoothSwitchOnly && modePtr->getId() != activeModeId) {
-                ALOGV("%s ignores %s because it's non-VRR and smooth switch only."
-                      " Current mode = %s",
-                      formatLayerInfo(layer, weight).c_str(), to_string(*modePtr).c_str(),
-                      to_string(activeMode).c_str());
-                continue;
-            }
-
-            // Layers with default seamlessness vote for the current mode group if
-            // there are layers with seamlessness=SeamedAndSeamless and for the default
-            // mode group otherwise. In second case, if the current mode group is different
-            // from the default, this means a layer with seamlessness=SeamedAndSeamless has just
-            // disappeared.
-            const bool isInPolicyForDefault = modePtr->getGroup() == anchorGroup;
-            if (layer.seamlessness == Seamlessness::Default && !isInPolicyForDefault) {
-                ALOGV("%s ignores %s. Current mode = %s", formatLayerInfo(layer, weight).c_str(),
-                      to_string(*modePtr).c_str(), to_string(activeMode).c_str());
-                continue;
-            }
+    // Only score the layers whose requirements changed since the last call, and add up the scores
+    // of all layers in the same order as if they had all been scored again.
+    const LayerScoringContext context{.activeModeId = activeModeId,
+                                      .anchorGroup = anchorGroup,
+                                      .smoothSwitchOnly = smoothSwitchOnly,
+                                      .heuristicIdle = signals.heuristicIdle};
+    if (!mLayerScoresCache || mLayerScoresCache->context != context) {
+        mLayerScoresCache = LayerScoresCache{.context = context};
+    }
+    auto& scoredLayers = mLayerScoresCache->layers;
+    scoredLayers.resize(layers.size());
 
-            const bool inPrimaryPhysicalRange =
-                    policy->primaryRanges.physical.includes(modePtr->getPeakFps());
-            const bool inPrimaryRenderRange = policy->primaryRanges.render.includes(fps);
-            if (((policy->primaryRangeIsSingleRate() && !inPrimaryPhysicalRange) ||
-                 !inPrimaryRenderRange) &&
-                !(layer.focused &&
-                  (layer.vote == LayerVoteType::ExplicitDefault ||
-                   layer.vote == LayerVoteType::ExplicitExact))) {
-                // Only focused layers with ExplicitDefault frame rate settings are allowed to score
-                // refresh rates outside the primary range.
-                continue;
-            }
+    for (size_t i = 0; i < layers.size(); i++) {
+        ScoredLayer& scoredLayer = scoredLayers[i];
+        if (!scoredLayer.isScoreOf(layers[i])) {
+            scoreLayerLocked(layers[i], context, scoredLayer);
+        }
+        if (scoredLayer.heuristicExpired) {
+            localIsIdle = true;
+        }
 
-            float layerScore;
-            if (layer.vote == LayerVoteType::Heuristic && signals.heuristicIdle && fps > 60_Hz) {
-                // Time for heuristic layer to keep using high refresh rate has expired
-                localIsIdle = true;
-                ALOGV("%s expired to keep using %s", formatLayerInfo(layer, weight).c_str(),
-                      to_string(fps).c_str());
-                continue;
-            } else {
-                layerScore =
-                    calculateLayerScoreLocked(layer, fps, isSeamlessSwitch);
-            }
-            const float weightedLayerScore = weight * layerScore;
-
-            // Layer with fixed source has a special consideration which depends on the
-            // mConfig.frameRateMultipleThreshold. We don't want these layers to score
-            // refresh rates above the threshold, but we also don't want to favor the lower
-            // ones by having a greater number of layers scoring them. Instead, we calculate
-            // the score independently for these layers and later decide which
-            // refresh rates to add it. For example, desired 24 fps with 120 Hz threshold should not
-            // score 120 Hz, but desired 60 fps should contribute to the score.
-            const bool fixedSourceLayer = [](LayerVoteType vote) {
-                switch (vote) {
-                    case LayerVoteType::ExplicitExactOrMultiple:
-                    case LayerVoteType::Heuristic:
-                        return true;
-                    case LayerVoteType::NoVote:
-                    case LayerVoteType::Min:
-                    case LayerVoteType::Max:
-                    case LayerVoteType::ExplicitDefault:
-                    case LayerVoteType::ExplicitExact:
-                    case LayerVoteType::ExplicitGte:
-                    case LayerVoteType::ExplicitCategory:
-                        return false;
-                }
-            }(layer.vote);
-            const bool layerBelowThreshold = mConfig.frameRateMultipleThreshold != 0 &&
-                    layer.desiredRefreshRate <
-                            Fps::fromValue(mConfig.frameRateMultipleThreshold / 2);
-            if (fixedSourceLayer && layerBelowThreshold) {
-                const bool modeAboveThreshold =
-                        modePtr->getPeakFps() >= Fps::fromValue(mConfig.frameRateMultipleThreshold);
-                if (modeAboveThreshold) {
-                    ALOGV("%s gives %s (%s(%s)) fixed source (above threshold) score of %.4f",
-                          formatLayerInfo(layer, weight).c_str(), to_string(fps).c_str(),
-                          to_string(modePtr->getPeakFps()).c_str(),
-                          to_string(modePtr->getVsyncRate()).c_str(), layerScore);
-                    fixedRateBelowThresholdLayersScore.modeAboveThreshold += weightedLayerScore;
-                } else {
-                    ALOGV("%s gives %s (%s(%s)) fixed source (below threshold) score of %.4f",
-                          formatLayerInfo(layer, weight).c_str(), to_string(fps).c_str(),
-                          to_string(modePtr->getPeakFps()).c_str(),
-                          to_string(modePtr->getVsyncRate()).c_str(), layerScore);
-                    fixedRateBelowThresholdLayersScore.modeBelowThreshold += weightedLayerScore;
-                }
-            } else {
-                ALOGV("%s gives %s (%s(%s)) score of %.4f", formatLayerInfo(layer, weight).c_str(),
-                      to_string(fps).c_str(), to_string(modePtr->getPeakFps()).c_str(),
-                      to_string(modePtr->getVsyncRate()).c_str(), layerScore);
-                overallScore += weightedLayerScore;
+        for (size_t j = 0; j < scores.size(); j++) {
+            auto& [_, overallScore, fixedRateBelowThresholdLayersScore] = scores[j];
+            const auto [kind, weightedScore] = scoredLayer.scores[j];
+            switch (kind) {
+                case LayerScoreKind::None:
+                    break;
+                case LayerScoreKind::Overall:
+                    overallScore += weightedScore;
+                    break;
+                case LayerScoreKind::FixedSourceBelowThreshold:
+                    fixedRateBelowThresholdLayersScore.modeBelowThreshold += weightedScore;
+                    break;
+                case LayerScoreKind::FixedSourceAboveThreshold:
+                    fixedRateBelowThresholdLayersScore.modeAboveThreshold += weightedScore;
+                    break;
             }
         }
     }
@@ -1288,6 +1354,11 @@ auto RefreshRateSelector::rankFrameRates(std::optional<int> anchorGroupOpt,
     return rankFrameRates(kNoAnchorGroup, refreshRateOrder, preferredDisplayModeOpt);
 }
 
+void RefreshRateSelector::clearRankingCachesLocked() {
+    mGetRankedFrameRatesCache.reset();
+    mLayerScoresCache.reset();
+}
+
 FrameRateMode RefreshRateSelector::getActiveMode() const {
     std::lock_guard lock(mLock);
     return getActiveModeLocked();
@@ -1302,7 +1373,7 @@ void RefreshRateSelector::setActiveMode(DisplayModeId modeId, Fps renderFrameRat
 
     // Invalidate the cached invocation to getRankedFrameRates. This forces
     // the refresh rate to be recomputed on the next call to getRankedFrameRates.
-    mGetRankedFrameRatesCache.reset();
+    clearRankingCachesLocked();
 
     const auto activeModeOpt = mDisplayModes.get(modeId);
     LOG_ALWAYS_FATAL_IF(!activeModeOpt);
@@ -1343,7 +1414,7 @@ void RefreshRateSelector::updateDisplayModes(DisplayModes modes, DisplayModeId a
 
     // Invalidate the cached invocation to getRankedFrameRates. This forces
     // the refresh rate to be recomputed on the next call to getRankedFrameRates.
-    mGetRankedFrameRatesCache.reset();
+    clearRankingCachesLocked();
 
     mDisplayModes = std::move(modes);
     const auto activeModeOpt = mDisplayModes.get(activeModeId);
@@ -1443,7 +1514,7 @@ auto RefreshRateSelector::setPolicy(const PolicyVariant& policy) -> SetPolicyRes
             return SetPolicyResult::Invalid;
         }
 
-        mGetRankedFrameRatesCache.reset();
+        clearRankingCachesLocked();
 
         const auto& idleScreenConfigOpt = getCurrentPolicyLocked()->idleScreenConfigOpt;
         if (idleScreenConfigOpt != oldPolicy.idleScreenConfigOpt) {
@@ -443,6 +443,55 @@ private:
                                                GlobalSignals signals, Fps pacesetterFps) const
             REQUIRES(mLock);
 
+    // How a layer's score for a frame rate mode adds up to the score of that mode.
+    enum class LayerScoreKind : uint8_t {
+        None,
+        Overall,
+        FixedSourceBelowThreshold,
+        FixedSourceAboveThreshold,
+    };
+
+    struct LayerScore {
+        LayerScoreKind kind = LayerScoreKind::None;
+        float weightedScore = 0.f;
+    };
+
+    // The scores a layer gives to each of mAppRequestFrameRates.
+    struct ScoredLayer {
+        LayerRequirement layer;
+        std::vector<LayerScore> scores;
+        // Whether the layer stopped scoring high refresh rates because of heuristicIdle.
+        bool heuristicExpired = false;
+
+        // Unlike LayerRequirement::operator==, requires the exact same desired refresh rate, since
+        // the scores are reused as is.
+        bool isScoreOf(const LayerRequirement& other) const {
+            return !scores.empty() && layer == other &&
+                    layer.desiredRefreshRate.getValue() == other.desiredRefreshRate.getValue();
+        }
+    };
+
+    // Everything besides the layer itself that the scores of a layer depend on, other than the
+    // policy and display modes, whose changes clear mLayerScoresCache.
+    struct LayerScoringContext {
+        DisplayModeId activeModeId;
+        int anchorGroup;
+        bool smoothSwitchOnly;
+        bool heuristicIdle;
+
+        bool operator==(const LayerScoringContext& other) const {
+            return activeModeId == other.activeModeId && anchorGroup == other.anchorGroup &&
+                    smoothSwitchOnly == other.smoothSwitchOnly &&
+                    heuristicIdle == other.heuristicIdle;
+        }
+        bool operator!=(const LayerScoringContext& other) const { return !(*this == other); }
+    };
+
+    void scoreLayerLocked(const LayerRequirement&, const LayerScoringContext&, ScoredLayer&) const
+            REQUIRES(mLock);
+
+    void clearRankingCachesLocked() REQUIRES(mLock);
+
     // Returns number of display frames and remainder when dividing the layer refresh period by
     // display refresh period.
     std::pair<nsecs_t, nsecs_t> getDisplayFrames(nsecs_t layerPeriod, nsecs_t displayPeriod) const;
@@ -572,13 +621,27 @@ private:
 
         RankedFrameRates result;
 
+        // Only hashes the inputs that matches() compares exactly, so that inputs that match
+        // always have the same hash.
+        size_t hash = hashOf(layers, signals);
+
+        static size_t hashOf(const std::vector<LayerRequirement>&, GlobalSignals);
+
         bool matches(const GetRankedFrameRatesCache& other) const {
-            return layers == other.layers && signals == other.signals &&
+            return hash == other.hash && layers == other.layers && signals == other.signals &&
                     isApproxEqual(pacesetterFps, other.pacesetterFps);
         }
     };
     mutable std::optional<GetRankedFrameRatesCache> mGetRankedFrameRatesCache GUARDED_BY(mLock);
 
+    // The scores of the layers passed to the last getRankedFrameRatesLocked that scored layers, so
+    // that only the layers whose requirements changed since are scored again.
+    struct LayerScoresCache {
+        LayerScoringContext context;
+        std::vector<ScoredLayer> layers;
+    };
+    mutable std::optional<LayerScoresCache> mLayerScoresCache GUARDED_BY(mLock);
+
     // Declare mIdleTimer last to ensure its thread joins before the mutex/callbacks are destroyed.
     std::mutex mIdleTimerCallbacksMutex;
     std::optional<IdleTimerCallbacks> mIdleTimerCallbacks GUARDED_BY(mIdleTimerCallbacksMutex);
@@ -16,6 +16,7 @@
 
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
+#include <algorithm>
 #include <vector>
 
 #include <android-base/stringprintf.h>
@@ -297,6 +298,22 @@ void VSyncDispatchTimerQueue::cancelTimer() {
     mTimeKeeper->alarmCancel();
 }
 
+void VSyncDispatchTimerQueue::queueWakeup(
+        const std::shared_ptr<VSyncDispatchTimerQueueEntry>& callback) {
+    const auto wakeupTime = callback->wakeupTime();
+    if (!wakeupTime) {
+        return;
+    }
+
+    if (mWakeups.size() >= 2 * mCallbacks.size()) {
+        std::erase_if(mWakeups, [](const Wakeup& wakeup) { return wakeup.isStale(); });
+        std::make_heap(mWakeups.begin(), mWakeups.end(), WakeupIsLater());
+    }
+
+    mWakeups.push_back({*wakeupTime, callback});
+    std::push_heap(mWakeups.begin(), mWakeups.end(), WakeupIsLater());
+}
+
 void VSyncDispatchTimerQueue::setTimer(nsecs_t targetTime, nsecs_t /*now*/) {
     mIntendedWakeupTime = targetTime;
     mTimeKeeper->alarmAt(std::bind(&VSyncDispatchTimerQueue::timerCallback, this),
@@ -311,9 +328,9 @@ void VSyncDispatchTimerQueue::rearmTimer(nsecs_t now) {
 void VSyncDispatchTimerQueue::rearmTimerSkippingUpdateFor(
         nsecs_t now, CallbackMap::const_iterator skipUpdateIt) {
     ATRACE_CALL();
-    std::optional<nsecs_t> min;
-    std::optional<nsecs_t> targetVsync;
-    std::optional<std::string_view> nextWakeupName;
+    // Every armed callback is updated against the latest vsync model, which may move any of their
+    // wakeups, so the heap is rebuilt rather than adjusted.
+    mWakeups.clear();
     for (auto it = mCallbacks.cbegin(); it != mCallbacks.cend(); ++it) {
         auto& callback = it->second;
         if (!callback->wakeupTime() && !callback->hasPendingWorkloadUpdate()) {
@@ -326,16 +343,12 @@ void VSyncDispatchTimerQueue::rearmTimerSkippingUpdateFor(
 
         traceEntry(*callback, now);
 
-        const auto wakeupTime = *callback->wakeupTime();
-        if (!min || *min > wakeupTime) {
-            nextWakeupName = callback->name();
-            min = wakeupTime;
-            targetVsync = callback->targetVsync();
-        }
+        mWakeups.push_back({*callback->wakeupTime(), callback});
     }
+    std::make_heap(mWakeups.begin(), mWakeups.end(), WakeupIsLater());
 
-    if (min && min < mIntendedWakeupTime) {
-        setTimer(*min, now);
+    if (!mWakeups.empty() && mWakeups.front().time < mIntendedWakeupTime) {
+        setTimer(mWakeups.front().time, now);
     } else {
         ATRACE_NAME("cancel timer");
         cancelTimer();
@@ -359,22 +372,23 @@ void VSyncDispatchTimerQueue::timerCallback() {
         }
         auto const now = mTimeKeeper->now();
         mLastTimerCallback = now;
-        for (auto it = mCallbacks.begin(); it != mCallbacks.end(); it++) {
-            auto& callback = it->second;
-            auto const wakeupTime = callback->wakeupTime();
-            if (!wakeupTime) {
+        auto const lagAllowance = std::max(now - mIntendedWakeupTime, static_cast<nsecs_t>(0));
+        while (!mWakeups.empty() &&
+               mWakeups.front().time < mIntendedWakeupTime + mTimerSlack + lagAllowance) {
+            std::pop_heap(mWakeups.begin(), mWakeups.end(), WakeupIsLater());
+            const Wakeup wakeup = std::move(mWakeups.back());
+            mWakeups.pop_back();
+            if (wakeup.isStale()) {
                 continue;
             }
 
+            auto& callback = wakeup.callback;
             traceEntry(*callback, now);
 
             auto const readyTime = callback->readyTime();
-            auto const lagAllowance = std::max(now - mIntendedWakeupTime, static_cast<nsecs_t>(0));
-            if (*wakeupTime < mIntendedWakeupTime + mTimerSlack + lagAllowance) {
-                callback->executing();
-                invocations.emplace_back(Invocation{callback, *callback->lastExecutedVsyncTarget(),
-                                                    *wakeupTime, *readyTime});
-            }
+            callback->executing();
+            invocations.emplace_back(Invocation{callback, *callback->lastExecutedVsyncTarget(),
+                                                wakeup.time, *readyTime});
         }
 
         mIntendedWakeupTime = kInvalidTime;
@@ -407,6 +421,8 @@ void VSyncDispatchTimerQueue::unregisterCallback(CallbackToken token) {
         auto it = mCallbacks.find(token);
         if (it != mCallbacks.end()) {
             entry = it->second;
+            // Leaves its queued wakeups stale.
+            entry->disarm();
             mCallbacks.erase(it->first);
         }
     }
@@ -439,6 +455,7 @@ std::optional<ScheduleResult> VSyncDispatchTimerQueue::scheduleLocked(
     }
 
     const auto result = callback->schedule(scheduleTiming, *mTracker, now);
+    queueWakeup(callback);
 
     if (callback->wakeupTime() < mIntendedWakeupTime - mTimerSlack) {
         rearmTimerSkippingUpdateFor(now, it);
@@ -20,6 +20,7 @@
 #include <mutex>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include <android-base/thread_annotations.h>
 #include <ftl/small_map.h>
@@ -142,7 +143,22 @@ private:
     using CallbackMap =
             ftl::SmallMap<CallbackToken, std::shared_ptr<VSyncDispatchTimerQueueEntry>, 5>;
 
+    // An armed callback, ordered by wakeup time. The callback may since have been rescheduled,
+    // cancelled or unregistered, in which case its wakeup time no longer matches.
+    struct Wakeup {
+        nsecs_t time;
+        std::shared_ptr<VSyncDispatchTimerQueueEntry> callback;
+
+        bool isStale() const { return callback->wakeupTime() != time; }
+    };
+
+    // Orders mWakeups as a min-heap.
+    struct WakeupIsLater {
+        bool operator()(const Wakeup& lhs, const Wakeup& rhs) const { return lhs.time > rhs.time; }
+    };
+
     void timerCallback();
+    void queueWakeup(const std::shared_ptr<VSyncDispatchTimerQueueEntry>&) REQUIRES(mMutex);
     void setTimer(nsecs_t, nsecs_t) REQUIRES(mMutex);
     void rearmTimer(nsecs_t now) REQUIRES(mMutex);
     void rearmTimerSkippingUpdateFor(nsecs_t now, CallbackMap::const_iterator skipUpdate)
@@ -167,6 +183,11 @@ private:
     CallbackMap mCallbacks GUARDED_BY(mMutex);
     nsecs_t mIntendedWakeupTime GUARDED_BY(mMutex) = kInvalidTime;
 
+    // The wakeups of armed callbacks, as a heap ordered by WakeupIsLater. Rescheduling a callback
+    // queues another wakeup, and stale wakeups are skipped as they reach the front. The heap is
+    // rebuilt by every rearm, and whenever stale wakeups outnumber the callbacks.
+    std::vector<Wakeup> mWakeups GUARDED_BY(mMutex);
+
     // For debugging purposes
     nsecs_t mLastTimerCallback GUARDED_BY(mMutex) = kInvalidTime;
     nsecs_t mLastTimerSchedule GUARDED_BY(mMutex) = kInvalidTime;
@@ -67,6 +67,8 @@ VSyncPredictor::VSyncPredictor(std::unique_ptr<Clock> clock, ftl::NonNull<Displa
         kOutlierTolerancePercent(std::min(outlierTolerancePercent, kMaxPercent)),
         mDisplayModePtr(modePtr),
         mNumVsyncsForFrame(numVsyncsPerFrame(mDisplayModePtr)) {
+    mTimestamps.reserve(kHistorySize);
+    mOrdinals.reserve(kHistorySize);
     resetModel();
 }
 
@@ -160,11 +162,20 @@ bool VSyncPredictor::addVsyncTimestamp(nsecs_t timestamp) {
         return false;
     }
 
+    if (!mTimestamps.empty() && timestamp < mTimestamps[mLastTimestampIndex]) {
+        mTimestampsInOrder = false;
+    }
+
     if (mTimestamps.size() != kHistorySize) {
         mTimestamps.push_back(timestamp);
+        mOrdinals.push_back(0);
         mLastTimestampIndex = next(mLastTimestampIndex);
     } else {
         mLastTimestampIndex = next(mLastTimestampIndex);
+        if (mSamplesSinceNormalization) {
+            mRegressionSums.remove(mTimestamps[mLastTimestampIndex] - mOrdinalOrigin,
+                                   mOrdinals[mLastTimestampIndex]);
+        }
         mTimestamps[mLastTimestampIndex] = timestamp;
     }
 
@@ -191,47 +202,53 @@ bool VSyncPredictor::addVsyncTimestamp(nsecs_t timestamp) {
     //
     // intercept = mean(Y) - slope * mean(X)
     //
-    std::vector<nsecs_t> vsyncTS(numSamples);
-    std::vector<nsecs_t> ordinals(numSamples);
-
-    // Normalizing to the oldest timestamp cuts down on error in calculating the intercept.
-    const auto oldestTS = *std::min_element(mTimestamps.begin(), mTimestamps.end());
+    // The sums are maintained as samples come and go, rather than recomputed for every sample.
+    // Each ordinal is snapped once, with the model period at the time, and all of them are snapped
+    // again periodically, which also keeps the timestamps relative to mOrdinalOrigin small.
     auto it = mRateMap.find(idealPeriod());
     auto const currentPeriod = it->second.slope;
 
-    // The mean of the ordinals must be precise for the intercept calculation, so scale them up for
-    // fixed-point arithmetic.
-    constexpr int64_t kScalingFactor = 1000;
-
-    nsecs_t meanTS = 0;
-    nsecs_t meanOrdinal = 0;
-
-    for (size_t i = 0; i < numSamples; i++) {
-        const auto timestamp = mTimestamps[i] - oldestTS;
-        vsyncTS[i] = timestamp;
-        meanTS += timestamp;
-
-        const auto ordinal = currentPeriod == 0
-                ? 0
-                : (vsyncTS[i] + currentPeriod / 2) / currentPeriod * kScalingFactor;
-        ordinals[i] = ordinal;
-        meanOrdinal += ordinal;
+    if (!mTimestampsInOrder || !mSamplesSinceNormalization ||
+        *mSamplesSinceNormalization >= kHistorySize) {
+        normalizeRegressionSums(currentPeriod);
+    } else {
+        const int64_t ordinal = snapToOrdinal(timestamp, currentPeriod);
+        mOrdinals[mLastTimestampIndex] = ordinal;
+        mRegressionSums.add(timestamp - mOrdinalOrigin, ordinal);
+        ++*mSamplesSinceNormalization;
     }
 
-    meanTS /= numSamples;
-    meanOrdinal /= numSamples;
+    // Normalizing to the oldest timestamp cuts down on error in calculating the intercept.
+    const size_t oldestIndex = oldestTimestampIndex();
+    const auto oldestTS = mTimestamps[oldestIndex];
+    const int64_t oldestOrdinal = mOrdinals[oldestIndex];
+    const nsecs_t origin = oldestTS - mOrdinalOrigin;
+    const auto n = static_cast<int64_t>(numSamples);
+    const auto& sums = mRegressionSums;
 
-    for (size_t i = 0; i < numSamples; i++) {
-        vsyncTS[i] -= meanTS;
-        ordinals[i] -= meanOrdinal;
-    }
+    // The mean of the ordinals must be precise for the intercept calculation, so scale them up for
+    // fixed-point arithmetic.
+    constexpr int64_t kScalingFactor = 1000;
 
-    nsecs_t top = 0;
-    nsecs_t bottom = 0;
-    for (size_t i = 0; i < numSamples; i++) {
-        top += vsyncTS[i] * ordinals[i];
-        bottom += ordinals[i] * ordinals[i];
-    }
+    // Sums of X, Y, X^2 and X * Y, with X relative to the oldest ordinal and Y to the oldest
+    // timestamp.
+    const nsecs_t sumTS = sums.timestamps - n * origin;
+    const nsecs_t sumOrdinal = (sums.ordinals - n * oldestOrdinal) * kScalingFactor;
+    const nsecs_t sumOrdinalSquared = (sums.ordinalsSquared - 2 * oldestOrdinal * sums.ordinals +
+                                       n * oldestOrdinal * oldestOrdinal) *
+            kScalingFactor * kScalingFactor;
+    const nsecs_t sumProduct = (sums.products - oldestOrdinal * sums.timestamps -
+                                origin * sums.ordinals + n * origin * oldestOrdinal) *
+            kScalingFactor;
+
+    const nsecs_t meanTS = sumTS / n;
+    const nsecs_t meanOrdinal = sumOrdinal / n;
+
+    // Sigma_i((X_i - mean(X)) * (Y_i - mean(Y))) and Sigma_i((X_i - mean(X))^2), expanded.
+    const nsecs_t top =
+            sumProduct - meanOrdinal * sumTS - meanTS * sumOrdinal + n * meanTS * meanOrdinal;
+    const nsecs_t bottom =
+            sumOrdinalSquared - 2 * meanOrdinal * sumOrdinal + n * meanOrdinal * meanOrdinal;
 
     if (CC_UNLIKELY(bottom == 0)) {
         it->second = {idealPeriod(), 0};
@@ -269,7 +286,7 @@ nsecs_t VSyncPredictor::snapToVsync(nsecs_t timePoint) const {
         return knownTimestamp + numPeriodsOut * idealPeriod();
     }
 
-    auto const oldest = *std::min_element(mTimestamps.begin(), mTimestamps.end());
+    auto const oldest = mTimestamps[oldestTimestampIndex()];
 
     // See b/145667109, the ordinal calculation must take into account the intercept.
     auto const zeroPoint = oldest + intercept;
@@ -553,6 +570,9 @@ void VSyncPredictor::clearTimestamps() {
         mTimestamps.clear();
         mLastTimestampIndex = 0;
     }
+    mOrdinals.clear();
+    mSamplesSinceNormalization.reset();
+    mTimestampsInOrder = true;
 
     mIdealPeriod = Period::fromNs(idealPeriod());
     if (mTimelines.empty()) {
@@ -573,6 +593,37 @@ void VSyncPredictor::clearTimestamps() {
     }
 }
 
+size_t VSyncPredictor::oldestTimestampIndex() const {
+    if (mTimestampsInOrder) {
+        return next(mLastTimestampIndex);
+    }
+    return static_cast<size_t>(std::min_element(mTimestamps.begin(), mTimestamps.end()) -
+                               mTimestamps.begin());
+}
+
+int64_t VSyncPredictor::snapToOrdinal(nsecs_t timestamp, nsecs_t period) const {
+    return period == 0 ? 0 : (timestamp - mOrdinalOrigin + period / 2) / period;
+}
+
+void VSyncPredictor::normalizeRegressionSums(nsecs_t period) {
+    // Walk the ring buffer from the oldest entry, to find out whether it is in order again.
+    mTimestampsInOrder = true;
+    for (size_t i = next(mLastTimestampIndex); i != mLastTimestampIndex; i = next(i)) {
+        if (mTimestamps[next(i)] < mTimestamps[i]) {
+            mTimestampsInOrder = false;
+            break;
+        }
+    }
+
+    mOrdinalOrigin = mTimestamps[oldestTimestampIndex()];
+    mRegressionSums = {};
+    for (size_t i = 0; i < mTimestamps.size(); i++) {
+        mOrdinals[i] = snapToOrdinal(mTimestamps[i], period);
+        mRegressionSums.add(mTimestamps[i] - mOrdinalOrigin, mOrdinals[i]);
+    }
+    mSamplesSinceNormalization = 0;
+}
+
 bool VSyncPredictor::needsMoreSamples() const {
     std::lock_guard lock(mMutex);
     return mTimestamps.size() < kMinimumSamplesForPrediction;
@@ -18,6 +18,7 @@
 
 #include <deque>
 #include <mutex>
+#include <optional>
 #include <unordered_map>
 #include <vector>
 
@@ -117,9 +118,35 @@ private:
         std::optional<VsyncSequence> mLastVsyncSequence;
     };
 
+    // Running sums for the linear regression over mTimestamps, with timestamps relative to
+    // mOrdinalOrigin and ordinals as stored in mOrdinals.
+    struct RegressionSums {
+        int64_t timestamps = 0;
+        int64_t ordinals = 0;
+        int64_t ordinalsSquared = 0;
+        int64_t products = 0;
+
+        void add(nsecs_t timestamp, int64_t ordinal) {
+            timestamps += timestamp;
+            ordinals += ordinal;
+            ordinalsSquared += ordinal * ordinal;
+            products += timestamp * ordinal;
+        }
+
+        void remove(nsecs_t timestamp, int64_t ordinal) {
+            timestamps -= timestamp;
+            ordinals -= ordinal;
+            ordinalsSquared -= ordinal * ordinal;
+            products -= timestamp * ordinal;
+        }
+    };
+
     VSyncPredictor(VSyncPredictor const&) = delete;
     VSyncPredictor& operator=(VSyncPredictor const&) = delete;
     void clearTimestamps() REQUIRES(mMutex);
+    size_t oldestTimestampIndex() const REQUIRES(mMutex);
+    int64_t snapToOrdinal(nsecs_t timestamp, nsecs_t period) const REQUIRES(mMutex);
+    void normalizeRegressionSums(nsecs_t period) REQUIRES(mMutex);
 
     const std::unique_ptr<Clock> mClock;
     const PhysicalDisplayId mId;
@@ -151,6 +178,16 @@ private:
     size_t mLastTimestampIndex GUARDED_BY(mMutex) = 0;
     std::vector<nsecs_t> mTimestamps GUARDED_BY(mMutex);
 
+    // The ordinal of each entry of mTimestamps, snapped with the model period when the entry was
+    // added, or when the sums were last normalized.
+    std::vector<int64_t> mOrdinals GUARDED_BY(mMutex);
+    RegressionSums mRegressionSums GUARDED_BY(mMutex);
+    nsecs_t mOrdinalOrigin GUARDED_BY(mMutex) = 0;
+    // Number of samples added since mRegressionSums were rebuilt, or nullopt if they need to be.
+    std::optional<size_t> mSamplesSinceNormalization GUARDED_BY(mMutex);
+    // Whether mTimestamps, read from the oldest entry, are in increasing order.
+    bool mTimestampsInOrder GUARDED_BY(mMutex) = true;
+
     ftl::NonNull<DisplayModePtr> mDisplayModePtr GUARDED_BY(mMutex);
     int mNumVsyncsForFrame GUARDED_BY(mMutex);
 
@@ -5034,14 +5034,13 @@ TransactionHandler::TransactionReadiness SurfaceFlinger::transactionReadyBufferC
                                             layer->ownerUid.val());
                             ATRACE_FORMAT_INSTANT("callReleaseBufferCallback %s - %" PRIu64,
                                                   layer->name.c_str(), s.bufferData->frameNumber);
-                            s.bufferData->releaseBufferListener
-                                    ->onReleaseBuffer({resolvedState.externalTexture->getBuffer()
-                                                               ->getId(),
-                                                       s.bufferData->frameNumber},
-                                                      s.bufferData->acquireFence
-                                                              ? s.bufferData->acquireFence
-                                                              : Fence::NO_FENCE,
-                                                      currentMaxAcquiredBufferCount);
+                            mTransactionCallbackInvoker.addReleasedBuffer(
+                                    s.bufferData->releaseBufferListener,
+                                    {{resolvedState.externalTexture->getBuffer()->getId(),
+                                      s.bufferData->frameNumber},
+                                     s.bufferData->acquireFence ? s.bufferData->acquireFence
+                                                                : Fence::NO_FENCE,
+                                     currentMaxAcquiredBufferCount});
                         }
 
                         // Delete the entire state at this point and not just release the buffer
@@ -25,7 +25,10 @@
 #include <utils/Timers.h>
 #include <utils/Trace.h>
 
+#include <pthread.h>
+
 #include <algorithm>
+#include <array>
 #include <chrono>
 #include <cmath>
 #include <unordered_map>
@@ -93,11 +96,12 @@ SurfaceflingerStatsLayerInfo_SetFrameRateVote frameRateVoteToProto(
 
 bool TimeStats::populateGlobalAtom(std::vector<uint8_t>* pulledData) {
     std::lock_guard<std::mutex> lock(mMutex);
+    applyEventsLocked();
 
     if (mTimeStats.statsStartLegacy == 0) {
         return false;
     }
-    flushPowerTimeLocked();
+    flushPowerTimeLocked(systemTime());
     SurfaceflingerStatsGlobalInfoWrapper atomList;
     for (const auto& globalSlice : mTimeStats.stats) {
         SurfaceflingerStatsGlobalInfo* atom = atomList.add_atom();
@@ -146,6 +150,7 @@ bool TimeStats::populateGlobalAtom(std::vector<uint8_t>* pulledData) {
 
 bool TimeStats::populateLayerAtom(std::vector<uint8_t>* pulledData) {
     std::lock_guard<std::mutex> lock(mMutex);
+    applyEventsLocked();
 
     std::vector<TimeStatsHelper::TimeStatsLayer*> dumpStats;
     uint32_t numLayers = 0;
@@ -242,10 +247,120 @@ bool TimeStats::populateLayerAtom(std::vector<uint8_t>* pulledData) {
     return atomList.SerializeToArray(pulledData->data(), atomList.ByteSizeLong());
 }
 
+// A single producer, single consumer queue of events. The producer is the thread that owns the log,
+// and the consumer is whichever thread holds TimeStats::mMutex.
+//
+// The log is a list of fixed size chunks, so that threads that rarely record only hold one chunk,
+// while the main thread can absorb the burst of a frame with hundreds of layers until the worker
+// catches up. Past kMaxChunks, the producer applies the events itself before pushing more.
+class TimeStats::EventLog {
+public:
+    static constexpr size_t kChunkCapacity = 512;
+    // About 8 events per layer and frame at 500 layers, for 4 frames.
+    static constexpr size_t kMaxChunks = 32;
+
+    struct Entry {
+        uint64_t sequence = 0;
+        Event event;
+    };
+
+    EventLog() : mHeadChunk(new Chunk), mTailChunk(mHeadChunk) {}
+
+    ~EventLog() {
+        while (mHeadChunk) {
+            delete std::exchange(mHeadChunk, mHeadChunk->next.load(std::memory_order_relaxed));
+        }
+    }
+
+    // Producer side. Once the consumer drained the log, it is no longer full.
+    bool full() const {
+        return mTailChunk->count.load(std::memory_order_relaxed) == kChunkCapacity &&
+                mNumChunks.load(std::memory_order_acquire) == kMaxChunks;
+    }
+
+    // Returns false if the log is full.
+    bool push(uint64_t sequence, Event&& event) {
+        size_t index = mTailChunk->count.load(std::memory_order_relaxed);
+        if (index == kChunkCapacity) {
+            if (mNumChunks.load(std::memory_order_acquire) == kMaxChunks) {
+                return false;
+            }
+            Chunk* chunk = new Chunk;
+            mNumChunks.fetch_add(1, std::memory_order_relaxed);
+            mTailChunk->next.store(chunk, std::memory_order_release);
+            mTailChunk = chunk;
+            index = 0;
+        }
+        Entry& entry = mTailChunk->entries[index];
+        entry.sequence = sequence;
+        entry.event = std::move(event);
+        mTailChunk->count.store(index + 1, std::memory_order_release);
+        mSize.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    size_t size() const { return mSize.load(std::memory_order_relaxed); }
+
+    // The oldest event, if any was pushed, and has a sequence number below the given one.
+    Entry* front(uint64_t sequenceEnd) {
+        if (mHeadIndex == kChunkCapacity) {
+            // The producer moved on to the next chunk once this one was full, if it did at all.
+            Chunk* next = mHeadChunk->next.load(std::memory_order_acquire);
+            if (!next) {
+                return nullptr;
+            }
+            delete std::exchange(mHeadChunk, next);
+            mNumChunks.fetch_sub(1, std::memory_order_release);
+            mHeadIndex = 0;
+        }
+        if (mHeadIndex == mHeadChunk->count.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        Entry& entry = mHeadChunk->entries[mHeadIndex];
+        return entry.sequence < sequenceEnd ? &entry : nullptr;
+    }
+
+    // Must follow a call to front() that returned an entry.
+    void pop() {
+        // Release the layer name and fences now rather than when the chunk is freed.
+        mHeadChunk->entries[mHeadIndex++].event = Event();
+        mSize.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+private:
+    struct Chunk {
+        std::array<Entry, kChunkCapacity> entries;
+        // Entries pushed to this chunk so far.
+        std::atomic<size_t> count = 0;
+        std::atomic<Chunk*> next = nullptr;
+    };
+
+    // Consumer side.
+    Chunk* mHeadChunk;
+    size_t mHeadIndex = 0;
+    // Producer side.
+    Chunk* mTailChunk;
+
+    std::atomic<size_t> mNumChunks = 1;
+    std::atomic<size_t> mSize = 0;
+};
+
+namespace {
+
+using namespace std::chrono_literals;
+
+// While enabled, events are applied at least this often, so that fences are not held for long.
+constexpr auto kApplyEventsPeriod = 100ms;
+
+std::atomic<uint64_t> sNextInstanceId = 1;
+
+} // namespace
+
 TimeStats::TimeStats() : TimeStats(std::nullopt, std::nullopt) {}
 
 TimeStats::TimeStats(std::optional<size_t> maxPulledLayers,
-                     std::optional<size_t> maxPulledHistogramBuckets) {
+                     std::optional<size_t> maxPulledHistogramBuckets)
+      : mInstanceId(sNextInstanceId++) {
     if (maxPulledLayers) {
         mMaxPulledLayers = *maxPulledLayers;
     }
@@ -253,6 +368,115 @@ TimeStats::TimeStats(std::optional<size_t> maxPulledLayers,
     if (maxPulledHistogramBuckets) {
         mMaxPulledHistogramBuckets = *maxPulledHistogramBuckets;
     }
+
+    mWorker = std::thread(&TimeStats::threadMain, this);
+    pthread_setname_np(mWorker.native_handle(), "TimeStats");
+}
+
+TimeStats::~TimeStats() {
+    {
+        std::lock_guard<std::mutex> lock(mWorkerMutex);
+        mStopWorker = true;
+    }
+    mWorkerCondition.notify_one();
+    mWorker.join();
+}
+
+void TimeStats::threadMain() {
+    std::unique_lock<std::mutex> lock(mWorkerMutex);
+    while (!mStopWorker) {
+        if (mEnabled.load()) {
+            mWorkerCondition.wait_for(lock, kApplyEventsPeriod);
+        } else {
+            mWorkerCondition.wait(lock);
+        }
+        if (mStopWorker) break;
+
+        lock.unlock();
+        {
+            ATRACE_NAME("TimeStats::applyEvents");
+            std::lock_guard<std::mutex> statsLock(mMutex);
+            applyEventsLocked();
+        }
+        lock.lock();
+    }
+}
+
+TimeStats::EventLog& TimeStats::getEventLog() {
+    // Threads keep a pointer to their log of the TimeStats they last recorded to, which in practice
+    // is the only one.
+    // The cache shares ownership of the log, so that the log outlives the TimeStats if need be,
+    // and applyEventsLocked() can tell when the thread exited.
+    struct CachedEventLog {
+        uint64_t instanceId = 0;
+        std::shared_ptr<EventLog> log;
+    };
+    thread_local CachedEventLog tCachedEventLog;
+    if (tCachedEventLog.instanceId == mInstanceId) {
+        return *tCachedEventLog.log;
+    }
+
+    std::lock_guard<std::mutex> lock(mEventLogsMutex);
+    const auto threadId = std::this_thread::get_id();
+    auto it = std::find_if(mEventLogs.begin(), mEventLogs.end(),
+                           [threadId](const auto& pair) { return pair.first == threadId; });
+    if (it == mEventLogs.end()) {
+        it = mEventLogs.emplace(mEventLogs.end(), threadId, std::make_shared<EventLog>());
+    }
+    tCachedEventLog = {mInstanceId, it->second};
+    return *it->second;
+}
+
+void TimeStats::queueEvent(Event&& event) {
+    EventLog& log = getEventLog();
+    if (log.full()) {
+        // The worker fell frames behind. Apply the events here rather than dropping any: a lost
+        // destroy would leak its layer record, and lost frame events would skew the stats.
+        ATRACE_NAME("TimeStats::applyEvents (log full)");
+        mFullEventLogs.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mMutex);
+        applyEventsLocked();
+    }
+    // The events of this thread all came before the sequence number that was applied up to, so
+    // its log was drained.
+    const bool pushed =
+            log.push(mNextEventSequence.fetch_add(1, std::memory_order_acq_rel), std::move(event));
+    LOG_ALWAYS_FATAL_IF(!pushed, "TimeStats event log still full after applying its events");
+    if (log.size() == EventLog::kChunkCapacity) {
+        mWorkerCondition.notify_one();
+    }
+}
+
+void TimeStats::applyEventsLocked() {
+    // An event recorded after another one, that had finished recording, gets a higher sequence
+    // number. Reading the next sequence number first makes sure that all such earlier events are
+    // visible, so only events with a lower sequence number are applied, in order. Events still
+    // being recorded by other threads are left for next time.
+    const uint64_t sequenceEnd = mNextEventSequence.load(std::memory_order_acquire);
+
+    std::lock_guard<std::mutex> lock(mEventLogsMutex);
+    while (true) {
+        EventLog* oldestLog = nullptr;
+        EventLog::Entry* oldestEntry = nullptr;
+        for (const auto& [_, log] : mEventLogs) {
+            EventLog::Entry* entry = log->front(sequenceEnd);
+            if (entry && (!oldestEntry || entry->sequence < oldestEntry->sequence)) {
+                oldestLog = log.get();
+                oldestEntry = entry;
+            }
+        }
+        if (!oldestEntry) break;
+
+        std::visit([this](auto& event) { applyLocked(event); }, oldestEntry->event);
+        oldestLog->pop();
+    }
+
+    // A log that only this list refers to belongs to a thread that exited, or that recorded to
+    // another TimeStats since. Once drained, it can go: that thread would have to take
+    // mEventLogsMutex to find it again, and gets a new one instead.
+    std::erase_if(mEventLogs, [](const auto& pair) {
+        return pair.second.use_count() == 1 && pair.second->size() == 0;
+    });
 }
 
 bool TimeStats::onPullAtom(const int atomId, std::vector<uint8_t>* pulledData) {
@@ -308,10 +532,20 @@ std::string TimeStats::miniDump() {
 
     std::string result = "TimeStats miniDump:\n";
     std::lock_guard<std::mutex> lock(mMutex);
+    applyEventsLocked();
     android::base::StringAppendF(&result, "Number of layers currently being tracked is %zu\n",
                                  mTimeStatsTracker.size());
     android::base::StringAppendF(&result, "Number of layers in the stats pool is %zu\n",
                                  mTimeStats.stats.size());
+    {
+        std::lock_guard<std::mutex> eventLogsLock(mEventLogsMutex);
+        android::base::StringAppendF(&result, "Number of event logs is %zu\n",
+                                     mEventLogs.size());
+    }
+    android::base::StringAppendF(&result,
+                                 "Number of times events were applied on a full log is %" PRIu64
+                                 "\n",
+                                 mFullEventLogs.load(std::memory_order_relaxed));
     return result;
 }
 
@@ -320,8 +554,7 @@ void TimeStats::incrementTotalFrames() {
 
     ATRACE_CALL();
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    mTimeStats.totalFramesLegacy++;
+    queueEvent(GlobalCounterEvent{GlobalCounterEvent::Type::TotalFrames});
 }
 
 void TimeStats::incrementMissedFrames() {
@@ -329,8 +562,21 @@ void TimeStats::incrementMissedFrames() {
 
     ATRACE_CALL();
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    mTimeStats.missedFramesLegacy++;
+    queueEvent(GlobalCounterEvent{GlobalCounterEvent::Type::MissedFrames});
+}
+
+void TimeStats::applyLocked(GlobalCounterEvent& event) {
+    switch (event.type) {
+        case GlobalCounterEvent::Type::TotalFrames:
+            mTimeStats.totalFramesLegacy++;
+            break;
+        case GlobalCounterEvent::Type::MissedFrames:
+            mTimeStats.missedFramesLegacy++;
+            break;
+        case GlobalCounterEvent::Type::RefreshRateSwitches:
+            mTimeStats.refreshRateSwitchesLegacy++;
+            break;
+    }
 }
 
 void TimeStats::pushCompositionStrategyState(const TimeStats::ClientCompositionRecord& record) {
@@ -340,7 +586,10 @@ void TimeStats::pushCompositionStrategyState(const TimeStats::ClientCompositionR
 
     ATRACE_CALL();
 
-    std::lock_guard<std::mutex> lock(mMutex);
+    queueEvent(record);
+}
+
+void TimeStats::applyLocked(ClientCompositionRecord& record) {
     if (record.changed) mTimeStats.compositionStrategyChangesLegacy++;
     if (record.hadClientComposition) mTimeStats.clientCompositionFramesLegacy++;
     if (record.reused) mTimeStats.clientCompositionReusedFramesLegacy++;
@@ -353,8 +602,7 @@ void TimeStats::incrementRefreshRateSwitches() {
 
     ATRACE_CALL();
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    mTimeStats.refreshRateSwitchesLegacy++;
+    queueEvent(GlobalCounterEvent{GlobalCounterEvent::Type::RefreshRateSwitches});
 }
 
 static int32_t toMs(nsecs_t nanos) {
@@ -372,33 +620,34 @@ static int32_t msBetween(nsecs_t start, nsecs_t end) {
 void TimeStats::recordFrameDuration(nsecs_t startTime, nsecs_t endTime) {
     if (!mEnabled.load()) return;
 
-    std::lock_guard<std::mutex> lock(mMutex);
+    queueEvent(FrameDurationEvent{startTime, endTime});
+}
+
+void TimeStats::applyLocked(FrameDurationEvent& event) {
     if (mPowerTime.powerMode == PowerMode::ON) {
-        mTimeStats.frameDurationLegacy.insert(msBetween(startTime, endTime));
+        mTimeStats.frameDurationLegacy.insert(msBetween(event.startTime, event.endTime));
     }
 }
 
 void TimeStats::recordRenderEngineDuration(nsecs_t startTime, nsecs_t endTime) {
     if (!mEnabled.load()) return;
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (mGlobalRecord.renderEngineDurations.size() == MAX_NUM_TIME_RECORDS) {
-        ALOGE("RenderEngineTimes are already at its maximum size[%zu]", MAX_NUM_TIME_RECORDS);
-        mGlobalRecord.renderEngineDurations.pop_front();
-    }
-    mGlobalRecord.renderEngineDurations.push_back({startTime, endTime});
+    queueEvent(RenderEngineDuration{startTime, endTime});
 }
 
 void TimeStats::recordRenderEngineDuration(nsecs_t startTime,
                                            const std::shared_ptr<FenceTime>& endTime) {
     if (!mEnabled.load()) return;
 
-    std::lock_guard<std::mutex> lock(mMutex);
+    queueEvent(RenderEngineDuration{startTime, endTime});
+}
+
+void TimeStats::applyLocked(RenderEngineDuration& duration) {
     if (mGlobalRecord.renderEngineDurations.size() == MAX_NUM_TIME_RECORDS) {
         ALOGE("RenderEngineTimes are already at its maximum size[%zu]", MAX_NUM_TIME_RECORDS);
         mGlobalRecord.renderEngineDurations.pop_front();
     }
-    mGlobalRecord.renderEngineDurations.push_back({startTime, endTime});
+    mGlobalRecord.renderEngineDurations.push_back(std::move(duration));
 }
 
 bool TimeStats::recordReadyLocked(int32_t layerId, TimeRecord* timeRecord) {
@@ -572,15 +821,19 @@ void TimeStats::setPostTime(int32_t layerId, uint64_t frameNumber, const std::st
     ALOGV("[%d]-[%" PRIu64 "]-[%s]-PostTime[%" PRId64 "]", layerId, frameNumber, layerName.c_str(),
           postTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!canAddNewAggregatedStats(uid, layerName, gameMode)) {
+    queueEvent(PostTimeEvent{layerId, frameNumber, layerName, uid, postTime, gameMode});
+}
+
+void TimeStats::applyLocked(PostTimeEvent& event) {
+    const int32_t layerId = event.layerId;
+    if (!canAddNewAggregatedStats(event.uid, event.layerName, event.gameMode)) {
         return;
     }
     if (!mTimeStatsTracker.count(layerId) && mTimeStatsTracker.size() < MAX_NUM_LAYER_RECORDS &&
-        layerNameIsValid(layerName)) {
-        mTimeStatsTracker[layerId].uid = uid;
-        mTimeStatsTracker[layerId].layerName = layerName;
-        mTimeStatsTracker[layerId].gameMode = gameMode;
+        layerNameIsValid(event.layerName)) {
+        mTimeStatsTracker[layerId].uid = event.uid;
+        mTimeStatsTracker[layerId].layerName = std::move(event.layerName);
+        mTimeStatsTracker[layerId].gameMode = event.gameMode;
     }
     if (!mTimeStatsTracker.count(layerId)) return;
     LayerRecord& layerRecord = mTimeStatsTracker[layerId];
@@ -596,11 +849,11 @@ void TimeStats::setPostTime(int32_t layerId, uint64_t frameNumber, const std::st
     TimeRecord timeRecord = {
             .frameTime =
                     {
-                            .frameNumber = frameNumber,
-                            .postTime = postTime,
-                            .latchTime = postTime,
-                            .acquireTime = postTime,
-                            .desiredTime = postTime,
+                            .frameNumber = event.frameNumber,
+                            .postTime = event.postTime,
+                            .latchTime = event.postTime,
+                            .acquireTime = event.postTime,
+                            .desiredTime = event.postTime,
                     },
     };
     layerRecord.timeRecords.push_back(timeRecord);
@@ -615,16 +868,7 @@ void TimeStats::setLatchTime(int32_t layerId, uint64_t frameNumber, nsecs_t latc
     ATRACE_CALL();
     ALOGV("[%d]-[%" PRIu64 "]-LatchTime[%" PRId64 "]", layerId, frameNumber, latchTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
-    if (layerRecord.waitData < 0 ||
-        layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
-        return;
-    TimeRecord& timeRecord = layerRecord.timeRecords[layerRecord.waitData];
-    if (timeRecord.frameTime.frameNumber == frameNumber) {
-        timeRecord.frameTime.latchTime = latchTime;
-    }
+    queueEvent(LayerTimeEvent{LayerTimeEvent::Type::Latch, layerId, frameNumber, latchTime});
 }
 
 void TimeStats::incrementLatchSkipped(int32_t layerId, LatchSkipReason reason) {
@@ -634,13 +878,9 @@ void TimeStats::incrementLatchSkipped(int32_t layerId, LatchSkipReason reason) {
     ALOGV("[%d]-LatchSkipped-Reason[%d]", layerId,
           static_cast<std::underlying_type<LatchSkipReason>::type>(reason));
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
-
     switch (reason) {
         case LatchSkipReason::LateAcquire:
-            layerRecord.lateAcquireFrames++;
+            queueEvent(LayerCounterEvent{LayerCounterEvent::Type::LatchSkipped, layerId});
             break;
     }
 }
@@ -651,10 +891,21 @@ void TimeStats::incrementBadDesiredPresent(int32_t layerId) {
     ATRACE_CALL();
     ALOGV("[%d]-BadDesiredPresent", layerId);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
-    layerRecord.badDesiredPresentFrames++;
+    queueEvent(LayerCounterEvent{LayerCounterEvent::Type::BadDesiredPresent, layerId});
+}
+
+void TimeStats::applyLocked(LayerCounterEvent& event) {
+    if (!mTimeStatsTracker.count(event.layerId)) return;
+    LayerRecord& layerRecord = mTimeStatsTracker[event.layerId];
+
+    switch (event.type) {
+        case LayerCounterEvent::Type::LatchSkipped:
+            layerRecord.lateAcquireFrames++;
+            break;
+        case LayerCounterEvent::Type::BadDesiredPresent:
+            layerRecord.badDesiredPresentFrames++;
+            break;
+    }
 }
 
 void TimeStats::setDesiredTime(int32_t layerId, uint64_t frameNumber, nsecs_t desiredTime) {
@@ -663,16 +914,7 @@ void TimeStats::setDesiredTime(int32_t layerId, uint64_t frameNumber, nsecs_t de
     ATRACE_CALL();
     ALOGV("[%d]-[%" PRIu64 "]-DesiredTime[%" PRId64 "]", layerId, frameNumber, desiredTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
-    if (layerRecord.waitData < 0 ||
-        layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
-        return;
-    TimeRecord& timeRecord = layerRecord.timeRecords[layerRecord.waitData];
-    if (timeRecord.frameTime.frameNumber == frameNumber) {
-        timeRecord.frameTime.desiredTime = desiredTime;
-    }
+    queueEvent(LayerTimeEvent{LayerTimeEvent::Type::Desired, layerId, frameNumber, desiredTime});
 }
 
 void TimeStats::setAcquireTime(int32_t layerId, uint64_t frameNumber, nsecs_t acquireTime) {
@@ -681,15 +923,28 @@ void TimeStats::setAcquireTime(int32_t layerId, uint64_t frameNumber, nsecs_t ac
     ATRACE_CALL();
     ALOGV("[%d]-[%" PRIu64 "]-AcquireTime[%" PRId64 "]", layerId, frameNumber, acquireTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    queueEvent(LayerTimeEvent{LayerTimeEvent::Type::Acquire, layerId, frameNumber, acquireTime});
+}
+
+void TimeStats::applyLocked(LayerTimeEvent& event) {
+    if (!mTimeStatsTracker.count(event.layerId)) return;
+    LayerRecord& layerRecord = mTimeStatsTracker[event.layerId];
     if (layerRecord.waitData < 0 ||
         layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
         return;
     TimeRecord& timeRecord = layerRecord.timeRecords[layerRecord.waitData];
-    if (timeRecord.frameTime.frameNumber == frameNumber) {
-        timeRecord.frameTime.acquireTime = acquireTime;
+    if (timeRecord.frameTime.frameNumber != event.frameNumber) return;
+
+    switch (event.type) {
+        case LayerTimeEvent::Type::Latch:
+            timeRecord.frameTime.latchTime = event.time;
+            break;
+        case LayerTimeEvent::Type::Desired:
+            timeRecord.frameTime.desiredTime = event.time;
+            break;
+        case LayerTimeEvent::Type::Acquire:
+            timeRecord.frameTime.acquireTime = event.time;
+            break;
     }
 }
 
@@ -701,15 +956,18 @@ void TimeStats::setAcquireFence(int32_t layerId, uint64_t frameNumber,
     ALOGV("[%d]-[%" PRIu64 "]-AcquireFenceTime[%" PRId64 "]", layerId, frameNumber,
           acquireFence->getSignalTime());
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    queueEvent(AcquireFenceEvent{layerId, frameNumber, acquireFence});
+}
+
+void TimeStats::applyLocked(AcquireFenceEvent& event) {
+    if (!mTimeStatsTracker.count(event.layerId)) return;
+    LayerRecord& layerRecord = mTimeStatsTracker[event.layerId];
     if (layerRecord.waitData < 0 ||
         layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
         return;
     TimeRecord& timeRecord = layerRecord.timeRecords[layerRecord.waitData];
-    if (timeRecord.frameTime.frameNumber == frameNumber) {
-        timeRecord.acquireFence = acquireFence;
+    if (timeRecord.frameTime.frameNumber == event.frameNumber) {
+        timeRecord.acquireFence = std::move(event.acquireFence);
     }
 }
 
@@ -721,21 +979,8 @@ void TimeStats::setPresentTime(int32_t layerId, uint64_t frameNumber, nsecs_t pr
     ATRACE_CALL();
     ALOGV("[%d]-[%" PRIu64 "]-PresentTime[%" PRId64 "]", layerId, frameNumber, presentTime);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
-    if (layerRecord.waitData < 0 ||
-        layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
-        return;
-    TimeRecord& timeRecord = layerRecord.timeRecords[layerRecord.waitData];
-    if (timeRecord.frameTime.frameNumber == frameNumber) {
-        timeRecord.frameTime.presentTime = presentTime;
-        timeRecord.ready = true;
-        layerRecord.waitData++;
-    }
-
-    flushAvailableRecordsToStatsLocked(layerId, displayRefreshRate, renderRate, frameRateVote,
-                                       gameMode);
+    queueEvent(PresentEvent{layerId, frameNumber, presentTime, displayRefreshRate, renderRate,
+                            frameRateVote, gameMode});
 }
 
 void TimeStats::setPresentFence(int32_t layerId, uint64_t frameNumber,
@@ -748,21 +993,30 @@ void TimeStats::setPresentFence(int32_t layerId, uint64_t frameNumber,
     ALOGV("[%d]-[%" PRIu64 "]-PresentFenceTime[%" PRId64 "]", layerId, frameNumber,
           presentFence->getSignalTime());
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    queueEvent(PresentEvent{layerId, frameNumber, presentFence, displayRefreshRate, renderRate,
+                            frameRateVote, gameMode});
+}
+
+void TimeStats::applyLocked(PresentEvent& event) {
+    if (!mTimeStatsTracker.count(event.layerId)) return;
+    LayerRecord& layerRecord = mTimeStatsTracker[event.layerId];
     if (layerRecord.waitData < 0 ||
         layerRecord.waitData >= static_cast<int32_t>(layerRecord.timeRecords.size()))
         return;
     TimeRecord& timeRecord = layerRecord.timeRecords[layerRecord.waitData];
-    if (timeRecord.frameTime.frameNumber == frameNumber) {
-        timeRecord.presentFence = presentFence;
+    if (timeRecord.frameTime.frameNumber == event.frameNumber) {
+        if (auto presentTime = std::get_if<nsecs_t>(&event.present)) {
+            timeRecord.frameTime.presentTime = *presentTime;
+        } else {
+            timeRecord.presentFence =
+                    std::move(std::get<std::shared_ptr<FenceTime>>(event.present));
+        }
         timeRecord.ready = true;
         layerRecord.waitData++;
     }
 
-    flushAvailableRecordsToStatsLocked(layerId, displayRefreshRate, renderRate, frameRateVote,
-                                       gameMode);
+    flushAvailableRecordsToStatsLocked(event.layerId, event.displayRefreshRate, event.renderRate,
+                                       event.frameRateVote, event.gameMode);
 }
 
 static const constexpr int32_t kValidJankyReason = JankType::DisplayHAL |
@@ -806,8 +1060,10 @@ void TimeStats::incrementJankyFrames(const JankyFramesInfo& info) {
     if (!mEnabled.load()) return;
 
     ATRACE_CALL();
-    std::lock_guard<std::mutex> lock(mMutex);
+    queueEvent(info);
+}
 
+void TimeStats::applyLocked(JankyFramesInfo& info) {
     // Only update layer stats if we're already tracking the layer in TimeStats.
     // Otherwise, continue tracking the statistic but use a default layer name instead.
     // As an implementation detail, we do this because this method is expected to be
@@ -863,8 +1119,11 @@ void TimeStats::incrementJankyFrames(const JankyFramesInfo& info) {
 void TimeStats::onDestroy(int32_t layerId) {
     ATRACE_CALL();
     ALOGV("[%d]-onDestroy", layerId);
-    std::lock_guard<std::mutex> lock(mMutex);
-    mTimeStatsTracker.erase(layerId);
+    queueEvent(DestroyEvent{layerId});
+}
+
+void TimeStats::applyLocked(DestroyEvent& event) {
+    mTimeStatsTracker.erase(event.layerId);
 }
 
 void TimeStats::removeTimeRecord(int32_t layerId, uint64_t frameNumber) {
@@ -873,12 +1132,15 @@ void TimeStats::removeTimeRecord(int32_t layerId, uint64_t frameNumber) {
     ATRACE_CALL();
     ALOGV("[%d]-[%" PRIu64 "]-removeTimeRecord", layerId, frameNumber);
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (!mTimeStatsTracker.count(layerId)) return;
-    LayerRecord& layerRecord = mTimeStatsTracker[layerId];
+    queueEvent(RemoveTimeRecordEvent{layerId, frameNumber});
+}
+
+void TimeStats::applyLocked(RemoveTimeRecordEvent& event) {
+    if (!mTimeStatsTracker.count(event.layerId)) return;
+    LayerRecord& layerRecord = mTimeStatsTracker[event.layerId];
     size_t removeAt = 0;
     for (const TimeRecord& record : layerRecord.timeRecords) {
-        if (record.frameTime.frameNumber == frameNumber) break;
+        if (record.frameTime.frameNumber == event.frameNumber) break;
         removeAt++;
     }
     if (removeAt == layerRecord.timeRecords.size()) return;
@@ -889,10 +1151,9 @@ void TimeStats::removeTimeRecord(int32_t layerId, uint64_t frameNumber) {
     layerRecord.droppedFrames++;
 }
 
-void TimeStats::flushPowerTimeLocked() {
+void TimeStats::flushPowerTimeLocked(nsecs_t curTime) {
     if (!mEnabled.load()) return;
 
-    nsecs_t curTime = systemTime();
     // elapsedTime is in milliseconds.
     int64_t elapsedTime = (curTime - mPowerTime.prevTime) / 1000000;
 
@@ -912,25 +1173,30 @@ void TimeStats::flushPowerTimeLocked() {
 }
 
 void TimeStats::setPowerMode(PowerMode powerMode) {
+    queueEvent(PowerModeEvent{powerMode, systemTime()});
+}
+
+void TimeStats::applyLocked(PowerModeEvent& event) {
     if (!mEnabled.load()) {
-        std::lock_guard<std::mutex> lock(mMutex);
-        mPowerTime.powerMode = powerMode;
+        mPowerTime.powerMode = event.powerMode;
         return;
     }
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (powerMode == mPowerTime.powerMode) return;
+    if (event.powerMode == mPowerTime.powerMode) return;
 
-    flushPowerTimeLocked();
-    mPowerTime.powerMode = powerMode;
+    flushPowerTimeLocked(event.time);
+    mPowerTime.powerMode = event.powerMode;
 }
 
 void TimeStats::recordRefreshRate(uint32_t fps, nsecs_t duration) {
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (mTimeStats.refreshRateStatsLegacy.count(fps)) {
-        mTimeStats.refreshRateStatsLegacy[fps] += duration;
+    queueEvent(RefreshRateEvent{fps, duration});
+}
+
+void TimeStats::applyLocked(RefreshRateEvent& event) {
+    if (mTimeStats.refreshRateStatsLegacy.count(event.fps)) {
+        mTimeStats.refreshRateStatsLegacy[event.fps] += event.duration;
     } else {
-        mTimeStats.refreshRateStatsLegacy.insert({fps, duration});
+        mTimeStats.refreshRateStatsLegacy.insert({event.fps, event.duration});
     }
 }
 
@@ -993,7 +1259,11 @@ void TimeStats::setPresentFenceGlobal(const std::shared_ptr<FenceTime>& presentF
     if (!mEnabled.load()) return;
 
     ATRACE_CALL();
-    std::lock_guard<std::mutex> lock(mMutex);
+    queueEvent(PresentFenceGlobalEvent{presentFence});
+}
+
+void TimeStats::applyLocked(PresentFenceGlobalEvent& event) {
+    std::shared_ptr<FenceTime>& presentFence = event.presentFence;
     if (presentFence == nullptr || !presentFence->isValid()) {
         mGlobalRecord.prevPresentTime = 0;
         return;
@@ -1015,7 +1285,7 @@ void TimeStats::setPresentFenceGlobal(const std::shared_ptr<FenceTime>& presentF
         mGlobalRecord.presentFences.pop_front();
     }
 
-    mGlobalRecord.presentFences.emplace_back(presentFence);
+    mGlobalRecord.presentFences.emplace_back(std::move(presentFence));
     flushAvailableGlobalRecordsToStatsLocked();
 }
 
@@ -1024,11 +1294,20 @@ void TimeStats::enable() {
 
     ATRACE_CALL();
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    mEnabled.store(true);
-    mTimeStats.statsStartLegacy = static_cast<int64_t>(std::time(0));
-    mPowerTime.prevTime = systemTime();
-    ALOGD("Enabled");
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        applyEventsLocked();
+        mEnabled.store(true);
+        mTimeStats.statsStartLegacy = static_cast<int64_t>(std::time(0));
+        mPowerTime.prevTime = systemTime();
+        ALOGD("Enabled");
+    }
+    {
+        // Synchronize with the worker, so that it can't miss the wakeup while it is going to sleep
+        // for as long as TimeStats is disabled.
+        std::lock_guard<std::mutex> lock(mWorkerMutex);
+    }
+    mWorkerCondition.notify_one();
 }
 
 void TimeStats::disable() {
@@ -1037,7 +1316,8 @@ void TimeStats::disable() {
     ATRACE_CALL();
 
     std::lock_guard<std::mutex> lock(mMutex);
-    flushPowerTimeLocked();
+    applyEventsLocked();
+    flushPowerTimeLocked(systemTime());
     mEnabled.store(false);
     mTimeStats.statsEndLegacy = static_cast<int64_t>(std::time(0));
     ALOGD("Disabled");
@@ -1045,6 +1325,7 @@ void TimeStats::disable() {
 
 void TimeStats::clearAll() {
     std::lock_guard<std::mutex> lock(mMutex);
+    applyEventsLocked();
     mTimeStats.stats.clear();
     clearGlobalLocked();
     clearLayersLocked();
@@ -1096,13 +1377,14 @@ void TimeStats::dump(bool asProto, std::optional<uint32_t> maxLayers, std::strin
     ATRACE_CALL();
 
     std::lock_guard<std::mutex> lock(mMutex);
+    applyEventsLocked();
     if (mTimeStats.statsStartLegacy == 0) {
         return;
     }
 
     mTimeStats.statsEndLegacy = static_cast<int64_t>(std::time(0));
 
-    flushPowerTimeLocked();
+    flushPowerTimeLocked(systemTime());
 
     if (asProto) {
         ALOGD("Dumping TimeStats as proto");
@@ -1111,6 +1393,8 @@ void TimeStats::dump(bool asProto, std::optional<uint32_t> maxLayers, std::strin
     } else {
         ALOGD("Dumping TimeStats as text");
         result.append(mTimeStats.toString(maxLayers));
+        android::base::StringAppendF(&result, "fullEventLogs = %" PRIu64 "\n",
+                                     mFullEventLogs.load(std::memory_order_relaxed));
         result.append("\n");
     }
 }
@@ -16,12 +16,19 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <deque>
+#include <memory>
 #include <mutex>
 #include <optional>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <utility>
 #include <variant>
+#include <vector>
 
 #include <android/hardware/graphics/composer/2.4/IComposerClient.h>
 #include <gui/JankInfo.h>
@@ -241,6 +248,7 @@ public:
     // For testing only for injecting custom dependencies.
     TimeStats(std::optional<size_t> maxPulledLayers,
               std::optional<size_t> maxPulledHistogramBuckets);
+    ~TimeStats() override;
 
     bool onPullAtom(const int atomId, std::vector<uint8_t>* pulledData) override;
     void parseArgs(bool asProto, const Vector<String16>& args, std::string& result) override;
@@ -289,13 +297,120 @@ public:
     static const size_t MAX_NUM_TIME_RECORDS = 64;
 
 private:
+    // The calls that record stats do not take mMutex. Instead, they queue an event on a log owned
+    // by the calling thread, and the events are applied in the order they were recorded by whoever
+    // next holds mMutex: the worker thread, or a pull or dump that needs up to date stats.
+    struct PostTimeEvent {
+        int32_t layerId;
+        uint64_t frameNumber;
+        std::string layerName;
+        uid_t uid;
+        nsecs_t postTime;
+        GameMode gameMode;
+    };
+
+    struct LayerTimeEvent {
+        enum class Type { Latch, Desired, Acquire };
+
+        Type type;
+        int32_t layerId;
+        uint64_t frameNumber;
+        nsecs_t time;
+    };
+
+    struct AcquireFenceEvent {
+        int32_t layerId;
+        uint64_t frameNumber;
+        std::shared_ptr<FenceTime> acquireFence;
+    };
+
+    struct PresentEvent {
+        int32_t layerId;
+        uint64_t frameNumber;
+        std::variant<nsecs_t, std::shared_ptr<FenceTime>> present;
+        Fps displayRefreshRate;
+        std::optional<Fps> renderRate;
+        SetFrameRateVote frameRateVote;
+        GameMode gameMode;
+    };
+
+    struct LayerCounterEvent {
+        enum class Type { LatchSkipped, BadDesiredPresent };
+
+        Type type;
+        int32_t layerId;
+    };
+
+    struct DestroyEvent {
+        int32_t layerId;
+    };
+
+    struct RemoveTimeRecordEvent {
+        int32_t layerId;
+        uint64_t frameNumber;
+    };
+
+    struct GlobalCounterEvent {
+        enum class Type { TotalFrames, MissedFrames, RefreshRateSwitches };
+
+        Type type;
+    };
+
+    struct FrameDurationEvent {
+        nsecs_t startTime;
+        nsecs_t endTime;
+    };
+
+    struct PowerModeEvent {
+        PowerMode powerMode;
+        nsecs_t time;
+    };
+
+    struct RefreshRateEvent {
+        uint32_t fps;
+        nsecs_t duration;
+    };
+
+    struct PresentFenceGlobalEvent {
+        std::shared_ptr<FenceTime> presentFence;
+    };
+
+    using Event = std::variant<PostTimeEvent, LayerTimeEvent, AcquireFenceEvent, PresentEvent,
+                               LayerCounterEvent, DestroyEvent, RemoveTimeRecordEvent,
+                               JankyFramesInfo, GlobalCounterEvent, ClientCompositionRecord,
+                               FrameDurationEvent, RenderEngineDuration, PowerModeEvent,
+                               RefreshRateEvent, PresentFenceGlobalEvent>;
+
+    class EventLog;
+
+    void queueEvent(Event&&);
+    EventLog& getEventLog();
+    // Applies the events queued by all threads, ordered by when they were recorded.
+    void applyEventsLocked();
+    void applyLocked(PostTimeEvent&);
+    void applyLocked(LayerTimeEvent&);
+    void applyLocked(AcquireFenceEvent&);
+    void applyLocked(PresentEvent&);
+    void applyLocked(LayerCounterEvent&);
+    void applyLocked(DestroyEvent&);
+    void applyLocked(RemoveTimeRecordEvent&);
+    void applyLocked(JankyFramesInfo&);
+    void applyLocked(GlobalCounterEvent&);
+    void applyLocked(ClientCompositionRecord&);
+    void applyLocked(FrameDurationEvent&);
+    void applyLocked(RenderEngineDuration&);
+    void applyLocked(PowerModeEvent&);
+    void applyLocked(RefreshRateEvent&);
+    void applyLocked(PresentFenceGlobalEvent&);
+    void threadMain();
+
     bool populateGlobalAtom(std::vector<uint8_t>* pulledData);
     bool populateLayerAtom(std::vector<uint8_t>* pulledData);
     bool recordReadyLocked(int32_t layerId, TimeRecord* timeRecord);
     void flushAvailableRecordsToStatsLocked(int32_t layerId, Fps displayRefreshRate,
                                             std::optional<Fps> renderRate, SetFrameRateVote,
                                             GameMode);
-    void flushPowerTimeLocked();
+    void flushPowerTimeLocked(nsecs_t now);
     void flushAvailableGlobalRecordsToStatsLocked();
     bool canAddNewAggregatedStats(uid_t uid, const std::string& layerName, GameMode);
 
@@ -322,6 +437,21 @@ private:
     static const size_t MAX_NUM_PULLED_LAYERS = MAX_NUM_LAYER_STATS;
     size_t mMaxPulledLayers = MAX_NUM_PULLED_LAYERS;
     size_t mMaxPulledHistogramBuckets = 6;
+
+    // Identifies this instance in the per-thread cache of EventLogs.
+    const uint64_t mInstanceId;
+    // Orders the events across EventLogs.
+    std::atomic<uint64_t> mNextEventSequence = 0;
+    std::mutex mEventLogsMutex;
+    std::vector<std::pair<std::thread::id, std::shared_ptr<EventLog>>> mEventLogs;
+    // Times a thread found its EventLog full, and applied the events itself.
+    std::atomic<uint64_t> mFullEventLogs = 0;
+
+    // The worker applies the events periodically while enabled, or when an EventLog grows.
+    std::mutex mWorkerMutex;
+    std::condition_variable mWorkerCondition;
+    bool mStopWorker = false;
+    std::thread mWorker;
 };
 
 } // namespace impl
@@ -18,86 +18,134 @@
 
 #include <android-base/file.h>
 #include <android-base/stringprintf.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/wire_format_lite.h>
 
 #include <log/log.h>
 #include <utils/Errors.h>
 #include <utils/Timers.h>
 #include <utils/Trace.h>
+#include <algorithm>
 #include <chrono>
+#include <deque>
 #include <fstream>
-#include <queue>
+#include <memory>
+#include <string_view>
+#include <vector>
 
 namespace android {
 
 class SurfaceFlinger;
 
+/*
+ * Keeps the most recent serialized entries, up to a size in bytes.
+ *
+ * Entries are serialized straight into blocks of an arena instead of one string each. Blocks are
+ * recycled once all their entries have been evicted, so a full buffer does not allocate. The
+ * serialized entries are written out as they are, without parsing them back into protos.
+ */
 template <typename FileProto, typename EntryProto>
 class TransactionRingBuffer {
 public:
+    struct Entry {
+        // Serialized EntryProto, owned by the buffer until the entry is evicted.
+        std::string_view bytes;
+        int64_t vsyncId;
+        nsecs_t timestamp;
+    };
+
     size_t size() const { return mSizeInBytes; }
     size_t used() const { return mUsedInBytes; }
-    size_t frameCount() const { return mStorage.size(); }
+    size_t frameCount() const { return mEntries.size(); }
     void setSize(size_t newSize) { mSizeInBytes = newSize; }
-    const std::string& front() const { return mStorage.front(); }
-    const std::string& back() const { return mStorage.back(); }
+    const Entry& front() const { return mEntries.front(); }
+    const Entry& back() const { return mEntries.back(); }
+
+    template <typename Visitor>
+    void forEachEntry(Visitor&& visitor) const {
+        for (const Entry& entry : mEntries) {
+            visitor(entry);
+        }
+    }
 
     void reset() {
         // use the swap trick to make sure memory is released
-        std::deque<std::string>().swap(mStorage);
+        std::deque<Entry>().swap(mEntries);
+        std::deque<Block>().swap(mBlocks);
+        std::vector<Block>().swap(mFreeBlocks);
         mUsedInBytes = 0U;
     }
 
     void writeToProto(FileProto& fileProto) const {
-        fileProto.mutable_entry()->Reserve(static_cast<int>(mStorage.size()) +
+        fileProto.mutable_entry()->Reserve(static_cast<int>(mEntries.size()) +
                                            fileProto.entry().size());
-        for (const std::string& entry : mStorage) {
+        for (const Entry& entry : mEntries) {
             EntryProto* entryProto = fileProto.add_entry();
-            entryProto->ParseFromString(entry);
+            entryProto->ParseFromArray(entry.bytes.data(), static_cast<int>(entry.bytes.size()));
+        }
+    }
+
+    // Appends the entries to |output| as the repeated entry field of a serialized FileProto. The
+    // result parses to the same proto as writeToProto followed by SerializeToString would.
+    void appendToString(std::string& output) const {
+        using google::protobuf::internal::WireFormatLite;
+        output.reserve(output.size() + mUsedInBytes + mEntries.size() * kMaxEntryHeaderSize);
+        google::protobuf::io::StringOutputStream stream(&output);
+        google::protobuf::io::CodedOutputStream coded(&stream);
+        const uint32_t tag = WireFormatLite::MakeTag(FileProto::kEntryFieldNumber,
+                                                     WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+        for (const Entry& entry : mEntries) {
+            coded.WriteTag(tag);
+            coded.WriteVarint32(static_cast<uint32_t>(entry.bytes.size()));
+            coded.WriteRaw(entry.bytes.data(), static_cast<int>(entry.bytes.size()));
         }
     }
 
     status_t appendToStream(FileProto& fileProto, std::ofstream& out) {
         ATRACE_CALL();
-        writeToProto(fileProto);
         std::string output;
         if (!fileProto.SerializeToString(&output)) {
             ALOGE("Could not serialize proto.");
             return UNKNOWN_ERROR;
         }
+        appendToString(output);
 
         out << output;
         return NO_ERROR;
     }
 
-    std::vector<std::string> emplace(std::string&& serializedProto) {
-        std::vector<std::string> replacedEntries;
-        size_t protoSize = static_cast<size_t>(serializedProto.size());
+    // Serializes the proto into the buffer and returns the stored entry, or nullptr if the proto
+    // is larger than the whole buffer. The oldest entries are evicted to make room, and each one
+    // is passed to |onEvicted| before its storage is reused.
+    template <typename OnEvicted>
+    const Entry* emplace(const EntryProto& proto, OnEvicted&& onEvicted) {
+        const size_t protoSize = proto.ByteSizeLong();
         while (mUsedInBytes + protoSize > mSizeInBytes) {
-            if (mStorage.empty()) {
-                return {};
+            if (mEntries.empty()) {
+                return nullptr;
             }
-            mUsedInBytes -= static_cast<size_t>(mStorage.front().size());
-            replacedEntries.emplace_back(mStorage.front());
-            mStorage.pop_front();
+            onEvicted(mEntries.front());
+            popFront();
         }
+
+        char* data = allocate(protoSize);
+        proto.SerializeWithCachedSizesToArray(reinterpret_cast<uint8_t*>(data));
         mUsedInBytes += protoSize;
-        mStorage.emplace_back(serializedProto);
-        return replacedEntries;
+        return &mEntries.emplace_back(Entry{.bytes = std::string_view(data, protoSize),
+                                            .vsyncId = proto.vsync_id(),
+                                            .timestamp = proto.elapsed_realtime_nanos()});
     }
 
-    std::vector<std::string> emplace(EntryProto&& proto) {
-        std::string serializedProto;
-        proto.SerializeToString(&serializedProto);
-        return emplace(std::move(serializedProto));
+    const Entry* emplace(const EntryProto& proto) {
+        return emplace(proto, [](const Entry&) {});
     }
 
     void dump(std::string& result) const {
         std::chrono::milliseconds duration(0);
         if (frameCount() > 0) {
-            EntryProto entry;
-            entry.ParseFromString(mStorage.front());
             duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-                    std::chrono::nanoseconds(systemTime() - entry.elapsed_realtime_nanos()));
+                    std::chrono::nanoseconds(systemTime() - mEntries.front().timestamp));
         }
         const int64_t durationCount = duration.count();
         base::StringAppendF(&result,
@@ -107,9 +155,63 @@ public:
     }
 
 private:
+    // Entries larger than a block get a block of their own, which is not recycled.
+    static constexpr size_t kBlockSize = 64 * 1024;
+    // Entries are evicted in the order they were added, so blocks free up one at a time and a
+    // couple of spares are enough to avoid allocating in steady state.
+    static constexpr size_t kMaxFreeBlocks = 2;
+    // One byte of tag and up to five bytes of length per entry.
+    static constexpr size_t kMaxEntryHeaderSize = 6;
+
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t capacity = 0;
+        size_t used = 0;
+        size_t entryCount = 0;
+    };
+
+    char* allocate(size_t size) {
+        if (mBlocks.empty() || mBlocks.back().capacity - mBlocks.back().used < size) {
+            mBlocks.push_back(takeBlock(size));
+        }
+        Block& block = mBlocks.back();
+        char* data = block.data.get() + block.used;
+        block.used += size;
+        block.entryCount++;
+        return data;
+    }
+
+    Block takeBlock(size_t minSize) {
+        if (minSize <= kBlockSize && !mFreeBlocks.empty()) {
+            Block block = std::move(mFreeBlocks.back());
+            mFreeBlocks.pop_back();
+            return block;
+        }
+        const size_t capacity = std::max(minSize, kBlockSize);
+        return Block{.data = std::unique_ptr<char[]>(new char[capacity]), .capacity = capacity};
+    }
+
+    void popFront() {
+        mUsedInBytes -= mEntries.front().bytes.size();
+        mEntries.pop_front();
+
+        // Entries are stored in the order they were added, so the evicted entry was in the
+        // oldest block.
+        Block& block = mBlocks.front();
+        if (--block.entryCount == 0) {
+            if (block.capacity == kBlockSize && mFreeBlocks.size() < kMaxFreeBlocks) {
+                block.used = 0;
+                mFreeBlocks.push_back(std::move(block));
+            }
+            mBlocks.pop_front();
+        }
+    }
+
     size_t mUsedInBytes = 0U;
     size_t mSizeInBytes = 0U;
-    std::deque<std::string> mStorage;
+    std::deque<Entry> mEntries;
+    std::deque<Block> mBlocks;
+    std::vector<Block> mFreeBlocks;
 };
 
 } // namespace android
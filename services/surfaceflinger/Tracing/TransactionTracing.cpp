@@ -86,23 +86,51 @@ void TransactionTracing::onFlush(TransactionTracing::Mode mode) {
 
 void TransactionTracing::writeRingBufferToPerfetto(TransactionTracing::Mode mode) {
     // Write the ring buffer (starting state + following sequence of transactions) to perfetto
-    // tracing sessions with the specified mode.
-    const auto fileProto = writeToProto();
+    // tracing sessions with the specified mode. The entries are already serialized, so they are
+    // copied out in one go under the lock, and written to perfetto without holding it, so that
+    // committing transactions doesn't wait on tracing I/O.
+    struct EntryBytes {
+        size_t offset;
+        size_t size;
+        nsecs_t timestamp;
+    };
+    std::string startingStateBytes;
+    nsecs_t startingTimestamp;
+    std::string entriesBytes;
+    std::vector<EntryBytes> entries;
+    {
+        std::scoped_lock lock(mTraceLock);
+        if (const auto startingStateProto = createStartingStateProtoLocked()) {
+            startingStateProto->SerializeToString(&startingStateBytes);
+        }
+        startingTimestamp = mStartingTimestamp;
+        entriesBytes.reserve(mBuffer.used());
+        entries.reserve(mBuffer.frameCount());
+        mBuffer.forEachEntry([&](const auto& entry) {
+            entries.push_back({entriesBytes.size(), entry.bytes.size(), entry.timestamp});
+            entriesBytes.append(entry.bytes);
+        });
+    }
 
     TransactionDataSource::Trace([&](TransactionDataSource::TraceContext context) {
         // Write packets only to tracing sessions with specified mode
         if (context.GetCustomTlsState()->mMode != mode) {
             return;
         }
-        for (const auto& entryProto : fileProto.entry()) {
-            const auto entryBytes = entryProto.SerializeAsString();
-
+        const auto writePacket = [&](std::string_view entryBytes, nsecs_t timestamp) {
             auto packet = context.NewTracePacket();
-            packet->set_timestamp(static_cast<uint64_t>(entryProto.elapsed_realtime_nanos()));
+            packet->set_timestamp(static_cast<uint64_t>(timestamp));
             packet->set_timestamp_clock_id(perfetto::protos::pbzero::BUILTIN_CLOCK_MONOTONIC);
 
             auto* transactionsProto = packet->set_surfaceflinger_transactions();
             transactionsProto->AppendRawProtoBytes(entryBytes.data(), entryBytes.size());
+        };
+        if (!startingStateBytes.empty()) {
+            writePacket(startingStateBytes, startingTimestamp);
+        }
+        const std::string_view allEntriesBytes(entriesBytes);
+        for (const auto& entry : entries) {
+            writePacket(allEntriesBytes.substr(entry.offset, entry.size), entry.timestamp);
         }
         {
             // TODO (b/162206162): remove empty packet when perfetto bug is fixed.
@@ -113,12 +141,17 @@ void TransactionTracing::writeRingBufferToPerfetto(TransactionTracing::Mode mode
 }
 
 status_t TransactionTracing::writeToFile(const std::string& filename) {
-    auto fileProto = writeToProto();
-
     std::string output;
-    if (!fileProto.SerializeToString(&output)) {
-        ALOGE("Could not serialize proto.");
-        return UNKNOWN_ERROR;
+    {
+        std::scoped_lock lock(mTraceLock);
+        perfetto::protos::TransactionTraceFile fileProto = createTraceFileProto();
+        addStartingStateLocked(fileProto);
+        if (!fileProto.SerializeToString(&output)) {
+            ALOGE("Could not serialize proto.");
+            return UNKNOWN_ERROR;
+        }
+        // The entries follow the starting state in the repeated entry field.
+        mBuffer.appendToString(output);
     }
 
     // -rw-r--r--
@@ -134,12 +167,16 @@ status_t TransactionTracing::writeToFile(const std::string& filename) {
 perfetto::protos::TransactionTraceFile TransactionTracing::writeToProto() {
     std::scoped_lock<std::mutex> lock(mTraceLock);
     perfetto::protos::TransactionTraceFile fileProto = createTraceFileProto();
-    const auto startingStateProto = createStartingStateProtoLocked();
+    addStartingStateLocked(fileProto);
+    mBuffer.writeToProto(fileProto);
+    return fileProto;
+}
+
+void TransactionTracing::addStartingStateLocked(perfetto::protos::TransactionTraceFile& fileProto) {
+    auto startingStateProto = createStartingStateProtoLocked();
     if (startingStateProto) {
         *fileProto.add_entry() = std::move(*startingStateProto);
     }
-    mBuffer.writeToProto(fileProto);
-    return fileProto;
 }
 
 void TransactionTracing::setBufferSize(size_t bufferSizeInBytes) {
@@ -229,7 +266,7 @@ void TransactionTracing::loop() {
 void TransactionTracing::addEntry(const std::vector<CommittedUpdates>& committedUpdates,
                                   const std::vector<uint32_t>& destroyedLayers) {
     std::scoped_lock lock(mTraceLock);
-    std::vector<std::string> removedEntries;
+    std::vector<perfetto::protos::TransactionTraceEntry> removedEntries;
     perfetto::protos::TransactionTraceEntry entryProto;
 
     while (auto incomingTransaction = mTransactionQueue.pop()) {
@@ -280,8 +317,21 @@ void TransactionTracing::addEntry(const std::vector<CommittedUpdates>& committed
             }
         }
 
-        std::string serializedProto;
-        entryProto.SerializeToString(&serializedProto);
+        // Evicted entries are parsed before their storage is reused for the new entry.
+        const auto* entry = mBuffer.emplace(entryProto, [&](const auto& removedEntry) {
+            const std::string_view bytes = removedEntry.bytes;
+            removedEntries.emplace_back().ParseFromArray(bytes.data(),
+                                                         static_cast<int>(bytes.size()));
+        });
+        std::string oversizedEntry;
+        std::string_view entryBytes;
+        if (entry) {
+            entryBytes = entry->bytes;
+        } else {
+            // Too large to keep in the buffer, but still traced in active mode.
+            entryProto.SerializeToString(&oversizedEntry);
+            entryBytes = oversizedEntry;
+        }
 
         TransactionDataSource::Trace([&](TransactionDataSource::TraceContext context) {
             // In "active" mode write each committed transaction to perfetto.
@@ -295,7 +345,7 @@ void TransactionTracing::addEntry(const std::vector<CommittedUpdates>& committed
                 packet->set_timestamp(static_cast<uint64_t>(entryProto.elapsed_realtime_nanos()));
                 packet->set_timestamp_clock_id(perfetto::protos::pbzero::BUILTIN_CLOCK_MONOTONIC);
                 auto* transactions = packet->set_surfaceflinger_transactions();
-                transactions->AppendRawProtoBytes(serializedProto.data(), serializedProto.size());
+                transactions->AppendRawProtoBytes(entryBytes.data(), entryBytes.size());
             }
             {
                 // TODO (b/162206162): remove empty packet when perfetto bug is fixed.
@@ -304,19 +354,11 @@ void TransactionTracing::addEntry(const std::vector<CommittedUpdates>& committed
             }
         });
 
-        std::vector<std::string> entries = mBuffer.emplace(std::move(serializedProto));
-        removedEntries.reserve(removedEntries.size() + entries.size());
-        removedEntries.insert(removedEntries.end(), std::make_move_iterator(entries.begin()),
-                              std::make_move_iterator(entries.end()));
-
         entryProto.Clear();
     }
 
-    perfetto::protos::TransactionTraceEntry removedEntryProto;
-    for (const std::string& removedEntry : removedEntries) {
-        removedEntryProto.ParseFromString(removedEntry);
+    for (const perfetto::protos::TransactionTraceEntry& removedEntryProto : removedEntries) {
         updateStartingStateLocked(removedEntryProto);
-        removedEntryProto.Clear();
     }
     mTransactionsAddedToBufferCv.notify_one();
 }
@@ -337,12 +379,9 @@ void TransactionTracing::flush() {
     base::ScopedLockAssertion assumeLocked(mTraceLock);
     mTransactionsAddedToBufferCv.wait_for(lock, std::chrono::milliseconds(100),
                                           [&]() REQUIRES(mTraceLock) {
-                                              perfetto::protos::TransactionTraceEntry entry;
-                                              if (mBuffer.used() > 0) {
-                                                  entry.ParseFromString(mBuffer.back());
-                                              }
                                               return mBuffer.used() > 0 &&
-                                                      entry.vsync_id() >= mLastUpdatedVsyncId;
+                                                      mBuffer.back().vsyncId >=
+                                                      mLastUpdatedVsyncId;
                                           });
 }
 
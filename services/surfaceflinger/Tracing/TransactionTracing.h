@@ -204,6 +204,7 @@ private:
 
     void writeRingBufferToPerfetto(TransactionTracing::Mode mode);
     perfetto::protos::TransactionTraceFile createTraceFileProto() const;
+    void addStartingStateLocked(perfetto::protos::TransactionTraceFile&) REQUIRES(mTraceLock);
     void loop();
     void addEntry(const std::vector<CommittedUpdates>& committedTransactions,
                   const std::vector<uint32_t>& removedLayers) EXCLUDES(mTraceLock);
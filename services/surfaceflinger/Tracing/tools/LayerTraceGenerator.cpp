@@ -23,10 +23,15 @@
 #include <log/log.h>
 #include <renderengine/ExternalTexture.h>
 #include <utils/String16.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <filesystem>
 #include <fstream>
 #include <ios>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 #include "FrontEnd/LayerCreationArgs.h"
 #include "FrontEnd/RequestedLayerState.h"
@@ -46,51 +51,90 @@ public:
     ScopedTraceDisabler() { TransactionTraceWriter::getInstance().disable(); }
     ~ScopedTraceDisabler() { TransactionTraceWriter::getInstance().enable(); }
 };
-} // namespace
 
-bool LayerTraceGenerator::generate(const perfetto::protos::TransactionTraceFile& traceFile,
-                                   std::uint32_t traceFlags, LayerTracing& layerTracing,
-                                   bool onlyLastEntry) {
-    // We are generating the layers trace by replaying back a set of transactions. If the
-    // transactions have unexpected states, we may generate a transaction trace to debug
-    // the unexpected state. This is silly. So we disable it by poking the
-    // TransactionTraceWriter. This is really a hack since we should manage our depenecies a
-    // little better.
-    ScopedTraceDisabler fatalErrorTraceDisabler;
+// Segments are not shorter than this, so that rebuilding their checkpoint does not outweigh
+// generating them.
+constexpr int kMinSegmentEntries = 256;
+// Each thread gets a few segments, since later segments take longer to rebuild their checkpoint.
+constexpr size_t kSegmentsPerThread = 4;
+// Entries replayed before a segment starts, without writing their snapshots, so that the snapshot
+// builder state does not depend on where the segment starts.
+constexpr int kWarmUpEntries = 8;
 
-    if (traceFile.entry_size() == 0) {
-        ALOGD("Trace file is empty");
-        return false;
+// Replays transaction trace entries through the front end.
+class FrontEndReplayer {
+public:
+    FrontEndReplayer() : mParser(std::make_unique<TransactionProtoParser::FlingerDataMapper>()) {
+        char value[PROPERTY_VALUE_MAX];
+        property_get("ro.surface_flinger.supports_background_blur", value, "0");
+        mSupportsBlur = atoi(value);
     }
 
-    TransactionProtoParser parser(std::make_unique<TransactionProtoParser::FlingerDataMapper>());
+    // Applies the entry to the layer lifecycle only, to rebuild the state at a later entry.
+    void skip(const perfetto::protos::TransactionTraceEntry& entry) {
+        apply(entry);
+        mLifecycleManager.commitChanges();
+    }
 
-    // frontend
-    frontend::LayerLifecycleManager lifecycleManager;
-    frontend::LayerHierarchyBuilder hierarchyBuilder;
-    frontend::LayerSnapshotBuilder snapshotBuilder;
-    ui::DisplayMap<ui::LayerStack, frontend::DisplayInfo> displayInfos;
+    // Applies the entry and updates the snapshots. Returns the layers snapshot if requested.
+    std::optional<perfetto::protos::LayersSnapshotProto> replay(
+            const perfetto::protos::TransactionTraceEntry& entry, std::uint32_t traceFlags,
+            bool generateSnapshot) {
+        apply(entry);
 
-    ShadowSettings globalShadowSettings{.ambientColor = {1, 1, 1, 1}};
-    char value[PROPERTY_VALUE_MAX];
-    property_get("ro.surface_flinger.supports_background_blur", value, "0");
-    bool supportsBlur = atoi(value);
+        // update hierarchy
+        mHierarchyBuilder.update(mLifecycleManager);
 
-    ALOGD("Generating %d transactions...", traceFile.entry_size());
-    for (int i = 0; i < traceFile.entry_size(); i++) {
-        // parse proto
-        perfetto::protos::TransactionTraceEntry entry = traceFile.entry(i);
-        ALOGV("    Entry %04d/%04d for time=%" PRId64 " vsyncid=%" PRId64
-              " layers +%d -%d handles -%d transactions=%d",
-              i, traceFile.entry_size(), entry.elapsed_realtime_nanos(), entry.vsync_id(),
-              entry.added_layers_size(), entry.destroyed_layers_size(),
-              entry.destroyed_layer_handles_size(), entry.transactions_size());
+        // update snapshots
+        frontend::LayerSnapshotBuilder::Args args{.root = mHierarchyBuilder.getHierarchy(),
+                                                  .layerLifecycleManager = mLifecycleManager,
+                                                  .displays = mDisplayInfos,
+                                                  .displayChanges = mDisplayChanged,
+                                                  .globalShadowSettings = mGlobalShadowSettings,
+                                                  .supportsBlur = mSupportsBlur,
+                                                  .forceFullDamage = false,
+                                                  .supportedLayerGenericMetadata = {},
+                                                  .genericLayerMetadataKeyMap = {}};
+        mSnapshotBuilder.update(args);
+        mDisplayChanged = false;
+
+        bool visibleRegionsDirty = mLifecycleManager.getGlobalChanges().any(
+                frontend::RequestedLayerState::Changes::VisibleRegion |
+                frontend::RequestedLayerState::Changes::Hierarchy |
+                frontend::RequestedLayerState::Changes::Visibility);
+
+        ALOGV("    layers:%04zu snapshots:%04zu changes:%s", mLifecycleManager.getLayers().size(),
+              mSnapshotBuilder.getSnapshots().size(),
+              mLifecycleManager.getGlobalChanges().string().c_str());
+
+        mLifecycleManager.commitChanges();
+
+        if (!generateSnapshot) {
+            return std::nullopt;
+        }
+
+        perfetto::protos::LayersSnapshotProto snapshotProto{};
+        snapshotProto.set_vsync_id(entry.vsync_id());
+        snapshotProto.set_elapsed_realtime_nanos(entry.elapsed_realtime_nanos());
+        snapshotProto.set_where(visibleRegionsDirty ? "visibleRegionsDirty" : "bufferLatched");
+        *snapshotProto.mutable_layers() =
+                LayerProtoFromSnapshotGenerator(mSnapshotBuilder, mDisplayInfos, {}, traceFlags)
+                        .generate(mHierarchyBuilder.getHierarchy());
+        if ((traceFlags & LayerTracing::TRACE_COMPOSITION) == 0) {
+            snapshotProto.set_excludes_composition_state(true);
+        }
+        *snapshotProto.mutable_displays() =
+                LayerProtoHelper::writeDisplayInfoToProto(mDisplayInfos);
+        return snapshotProto;
+    }
 
+private:
+    void apply(const perfetto::protos::TransactionTraceEntry& entry) {
         std::vector<std::unique_ptr<frontend::RequestedLayerState>> addedLayers;
         addedLayers.reserve((size_t)entry.added_layers_size());
         for (int j = 0; j < entry.added_layers_size(); j++) {
             LayerCreationArgs args;
-            parser.fromProto(entry.added_layers(j), args);
+            mParser.fromProto(entry.added_layers(j), args);
             ALOGV("       %s", args.getDebugString().c_str());
             addedLayers.emplace_back(std::make_unique<frontend::RequestedLayerState>(args));
         }
@@ -99,7 +143,7 @@ bool LayerTraceGenerator::generate(const perfetto::protos::TransactionTraceFile&
         transactions.reserve((size_t)entry.transactions_size());
         for (int j = 0; j < entry.transactions_size(); j++) {
             // apply transactions
-            TransactionState transaction = parser.fromProto(entry.transactions(j));
+            TransactionState transaction = mParser.fromProto(entry.transactions(j));
             for (auto& resolvedComposerState : transaction.states) {
                 if (resolvedComposerState.state.what & layer_state_t::eInputInfoChanged) {
                     if (!resolvedComposerState.state.windowInfoHandle->getInfo()->inputConfig.test(
@@ -124,62 +168,180 @@ bool LayerTraceGenerator::generate(const perfetto::protos::TransactionTraceFile&
             destroyedHandles.push_back({entry.destroyed_layer_handles(j), ""});
         }
 
-        bool displayChanged = entry.displays_changed();
-        if (displayChanged) {
-            parser.fromProto(entry.displays(), displayInfos);
+        // Display changes are kept until the next snapshot update, in case the entry is skipped.
+        if (entry.displays_changed()) {
+            mParser.fromProto(entry.displays(), mDisplayInfos);
+            mDisplayChanged = true;
         }
 
         // apply updates
-        lifecycleManager.addLayers(std::move(addedLayers));
-        lifecycleManager.applyTransactions(transactions, /*ignoreUnknownHandles=*/true);
-        lifecycleManager.onHandlesDestroyed(destroyedHandles, /*ignoreUnknownHandles=*/true);
+        mLifecycleManager.addLayers(std::move(addedLayers));
+        mLifecycleManager.applyTransactions(transactions, /*ignoreUnknownHandles=*/true);
+        mLifecycleManager.onHandlesDestroyed(destroyedHandles, /*ignoreUnknownHandles=*/true);
+    }
 
-        // update hierarchy
-        hierarchyBuilder.update(lifecycleManager);
+    TransactionProtoParser mParser;
 
-        // update snapshots
-        frontend::LayerSnapshotBuilder::Args args{.root = hierarchyBuilder.getHierarchy(),
-                                                  .layerLifecycleManager = lifecycleManager,
-                                                  .displays = displayInfos,
-                                                  .displayChanges = displayChanged,
-                                                  .globalShadowSettings = globalShadowSettings,
-                                                  .supportsBlur = supportsBlur,
-                                                  .forceFullDamage = false,
-                                                  .supportedLayerGenericMetadata = {},
-                                                  .genericLayerMetadataKeyMap = {}};
-        snapshotBuilder.update(args);
+    // frontend
+    frontend::LayerLifecycleManager mLifecycleManager;
+    frontend::LayerHierarchyBuilder mHierarchyBuilder;
+    frontend::LayerSnapshotBuilder mSnapshotBuilder;
+    ui::DisplayMap<ui::LayerStack, frontend::DisplayInfo> mDisplayInfos;
+    bool mDisplayChanged = false;
 
-        bool visibleRegionsDirty = lifecycleManager.getGlobalChanges().any(
-                frontend::RequestedLayerState::Changes::VisibleRegion |
-                frontend::RequestedLayerState::Changes::Hierarchy |
-                frontend::RequestedLayerState::Changes::Visibility);
+    ShadowSettings mGlobalShadowSettings{.ambientColor = {1, 1, 1, 1}};
+    bool mSupportsBlur = false;
+};
+
+void logEntry(const perfetto::protos::TransactionTraceFile& traceFile, int index) {
+    const perfetto::protos::TransactionTraceEntry& entry = traceFile.entry(index);
+    ALOGV("    Entry %04d/%04d for time=%" PRId64 " vsyncid=%" PRId64
+          " layers +%d -%d handles -%d transactions=%d",
+          index, traceFile.entry_size(), entry.elapsed_realtime_nanos(), entry.vsync_id(),
+          entry.added_layers_size(), entry.destroyed_layers_size(),
+          entry.destroyed_layer_handles_size(), entry.transactions_size());
+}
+} // namespace
+
+double LayerTraceGenerator::Stats::transactionsPerSecond() const {
+    const double seconds = std::chrono::duration<double>(duration).count();
+    return seconds > 0 ? static_cast<double>(transactions) / seconds : 0;
+}
+
+bool LayerTraceGenerator::generate(const perfetto::protos::TransactionTraceFile& traceFile,
+                                   std::uint32_t traceFlags, LayerTracing& layerTracing,
+                                   bool onlyLastEntry, size_t threadCount) {
+    // We are generating the layers trace by replaying back a set of transactions. If the
+    // transactions have unexpected states, we may generate a transaction trace to debug
+    // the unexpected state. This is silly. So we disable it by poking the
+    // TransactionTraceWriter. This is really a hack since we should manage our depenecies a
+    // little better.
+    ScopedTraceDisabler fatalErrorTraceDisabler;
+
+    if (traceFile.entry_size() == 0) {
+        ALOGD("Trace file is empty");
+        return false;
+    }
+
+    mStats = {};
+    const auto start = std::chrono::steady_clock::now();
+
+    // Only the last segment would be written if only the last entry is needed, so there is no
+    // point in splitting the trace.
+    const bool parallel = threadCount > 1 && !onlyLastEntry &&
+            traceFile.entry_size() >= 2 * kMinSegmentEntries;
+    const bool generated = parallel
+            ? generateInParallel(traceFile, traceFlags, layerTracing, threadCount)
+            : generateSerially(traceFile, traceFlags, layerTracing, onlyLastEntry);
+
+    mStats.entries = static_cast<size_t>(traceFile.entry_size());
+    for (const auto& entry : traceFile.entry()) {
+        mStats.transactions += static_cast<size_t>(entry.transactions_size());
+    }
+    mStats.duration = std::chrono::steady_clock::now() - start;
+    ALOGD("End of generating trace file (%zu transactions, %.0f transactions/s)",
+          mStats.transactions, mStats.transactionsPerSecond());
+    return generated;
+}
+
+bool LayerTraceGenerator::generateSerially(const perfetto::protos::TransactionTraceFile& traceFile,
+                                           std::uint32_t traceFlags, LayerTracing& layerTracing,
+                                           bool onlyLastEntry) {
+    FrontEndReplayer replayer;
 
-        ALOGV("    layers:%04zu snapshots:%04zu changes:%s", lifecycleManager.getLayers().size(),
-              snapshotBuilder.getSnapshots().size(),
-              lifecycleManager.getGlobalChanges().string().c_str());
-
-        lifecycleManager.commitChanges();
-
-        auto layersProto =
-                LayerProtoFromSnapshotGenerator(snapshotBuilder, displayInfos, {}, traceFlags)
-                        .generate(hierarchyBuilder.getHierarchy());
-        auto displayProtos = LayerProtoHelper::writeDisplayInfoToProto(displayInfos);
-        if (!onlyLastEntry || (i == traceFile.entry_size() - 1)) {
-            perfetto::protos::LayersSnapshotProto snapshotProto{};
-            snapshotProto.set_vsync_id(entry.vsync_id());
-            snapshotProto.set_elapsed_realtime_nanos(entry.elapsed_realtime_nanos());
-            snapshotProto.set_where(visibleRegionsDirty ? "visibleRegionsDirty" : "bufferLatched");
-            *snapshotProto.mutable_layers() = std::move(layersProto);
-            if ((traceFlags & LayerTracing::TRACE_COMPOSITION) == 0) {
-                snapshotProto.set_excludes_composition_state(true);
+    ALOGD("Generating %d transactions...", traceFile.entry_size());
+    for (int i = 0; i < traceFile.entry_size(); i++) {
+        logEntry(traceFile, i);
+        const bool generateSnapshot = !onlyLastEntry || (i == traceFile.entry_size() - 1);
+        auto snapshotProto = replayer.replay(traceFile.entry(i), traceFlags, generateSnapshot);
+        if (snapshotProto) {
+            layerTracing.addProtoSnapshotToOstream(std::move(*snapshotProto),
+                                                   LayerTracing::Mode::MODE_GENERATED);
+        }
+    }
+    return true;
+}
+
+bool LayerTraceGenerator::generateInParallel(
+        const perfetto::protos::TransactionTraceFile& traceFile, std::uint32_t traceFlags,
+        LayerTracing& layerTracing, size_t threadCount) {
+    const int entryCount = traceFile.entry_size();
+    const int segmentCount = std::min(static_cast<int>(threadCount * kSegmentsPerThread),
+                                      entryCount / kMinSegmentEntries);
+    threadCount = std::min(threadCount, static_cast<size_t>(segmentCount));
+    ALOGD("Generating %d transactions in %d segments on %zu threads...", entryCount, segmentCount,
+          threadCount);
+
+    struct Segment {
+        int begin;
+        int end;
+        std::vector<perfetto::protos::LayersSnapshotProto> snapshots;
+        bool done = false;
+    };
+    std::vector<Segment> segments;
+    segments.reserve(static_cast<size_t>(segmentCount));
+    for (int i = 0; i < segmentCount; i++) {
+        segments.push_back({.begin = entryCount * i / segmentCount,
+                            .end = entryCount * (i + 1) / segmentCount});
+    }
+
+    std::mutex mutex;
+    std::condition_variable segmentDone;
+    std::atomic<size_t> nextSegment{0};
+
+    // Segments are handed out in order, so that the ones written first are done first.
+    const auto work = [&] {
+        for (size_t index = nextSegment++; index < segments.size(); index = nextSegment++) {
+            Segment& segment = segments[index];
+            const int warmUpBegin = std::max(0, segment.begin - kWarmUpEntries);
+
+            FrontEndReplayer replayer;
+            for (int i = 0; i < warmUpBegin; i++) {
+                replayer.skip(traceFile.entry(i));
+            }
+            for (int i = warmUpBegin; i < segment.begin; i++) {
+                replayer.replay(traceFile.entry(i), traceFlags, /*generateSnapshot=*/false);
+            }
+
+            std::vector<perfetto::protos::LayersSnapshotProto> snapshots;
+            snapshots.reserve(static_cast<size_t>(segment.end - segment.begin));
+            for (int i = segment.begin; i < segment.end; i++) {
+                logEntry(traceFile, i);
+                auto snapshotProto =
+                        replayer.replay(traceFile.entry(i), traceFlags, /*generateSnapshot=*/true);
+                snapshots.push_back(std::move(*snapshotProto));
             }
-            *snapshotProto.mutable_displays() = std::move(displayProtos);
 
+            std::scoped_lock lock(mutex);
+            segment.snapshots = std::move(snapshots);
+            segment.done = true;
+            segmentDone.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        threads.emplace_back(work);
+    }
+
+    // Write the segments in order as they are done, and release them.
+    for (Segment& segment : segments) {
+        std::vector<perfetto::protos::LayersSnapshotProto> snapshots;
+        {
+            std::unique_lock lock(mutex);
+            segmentDone.wait(lock, [&] { return segment.done; });
+            snapshots = std::move(segment.snapshots);
+        }
+        for (auto& snapshotProto : snapshots) {
             layerTracing.addProtoSnapshotToOstream(std::move(snapshotProto),
                                                    LayerTracing::Mode::MODE_GENERATED);
         }
     }
-    ALOGD("End of generating trace file");
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
     return true;
 }
 
@@ -18,6 +18,8 @@
 
 #include <Tracing/TransactionTracing.h>
 
+#include <chrono>
+#include <cstddef>
 #include <functional>
 #include <optional>
 #include <ostream>
@@ -29,7 +31,32 @@ class LayerTracing;
 
 class LayerTraceGenerator {
 public:
+    struct Stats {
+        size_t entries = 0;
+        size_t transactions = 0;
+        std::chrono::nanoseconds duration{0};
+
+        double transactionsPerSecond() const;
+    };
+
+    // With more than one thread, the trace is split into segments that are generated in parallel.
+    // Each segment starts from a checkpoint of the front end state, which is rebuilt by applying
+    // the preceding transactions without generating snapshots for them. The layers snapshots are
+    // written to |layerTracing| in order.
     bool generate(const perfetto::protos::TransactionTraceFile&, std::uint32_t traceFlags,
-                  LayerTracing& layerTracing, bool onlyLastEntry = false);
+                  LayerTracing& layerTracing, bool onlyLastEntry = false,
+                  size_t threadCount = 1);
+
+    // Stats of the last generated trace.
+    const Stats& getStats() const { return mStats; }
+
+private:
+    bool generateSerially(const perfetto::protos::TransactionTraceFile&, std::uint32_t traceFlags,
+                          LayerTracing& layerTracing, bool onlyLastEntry);
+    bool generateInParallel(const perfetto::protos::TransactionTraceFile&,
+                            std::uint32_t traceFlags, LayerTracing& layerTracing,
+                            size_t threadCount);
+
+    Stats mStats;
 };
 } // namespace android
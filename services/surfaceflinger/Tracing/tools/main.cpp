@@ -17,9 +17,15 @@
 #undef LOG_TAG
 #define LOG_TAG "LayerTraceGenerator"
 
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include <Tracing/LayerTracing.h>
 #include "LayerTraceGenerator.h"
@@ -27,14 +33,31 @@
 using namespace android;
 
 int main(int argc, char** argv) {
-    if (argc > 4) {
+    bool validArgs = true;
+    std::vector<const char*> paths;
+    bool generateLastEntryOnly = false;
+    size_t threadCount = 1;
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg(argv[i]);
+        if (arg == "--last-entry-only") {
+            generateLastEntryOnly = true;
+        } else if (arg.starts_with("--threads=")) {
+            threadCount = std::strtoul(argv[i] + std::strlen("--threads="), nullptr, 10);
+        } else if (!arg.starts_with("--")) {
+            paths.push_back(argv[i]);
+        } else {
+            validArgs = false;
+        }
+    }
+    if (!validArgs || paths.size() > 2 || threadCount == 0) {
         std::cout << "Usage: " << argv[0]
-                  << " [transaction-trace-path] [output-layers-trace-path] [--last-entry-only]\n";
+                  << " [transaction-trace-path] [output-layers-trace-path] [--last-entry-only]"
+                     " [--threads=N]\n";
         return -1;
     }
 
     const char* transactionTracePath =
-            (argc > 1) ? argv[1] : "/data/misc/wmtrace/transactions_trace.winscope";
+            !paths.empty() ? paths[0] : "/data/misc/wmtrace/transactions_trace.winscope";
     std::cout << "Parsing " << transactionTracePath << "\n";
     std::fstream input(transactionTracePath, std::ios::in | std::ios::binary);
     if (!input) {
@@ -49,25 +72,30 @@ int main(int argc, char** argv) {
     }
 
     const auto* outputLayersTracePath =
-            (argc == 3) ? argv[2] : "/data/misc/wmtrace/layers_trace.winscope";
+            paths.size() > 1 ? paths[1] : "/data/misc/wmtrace/layers_trace.winscope";
     auto outStream = std::ofstream{outputLayersTracePath, std::ios::binary | std::ios::out};
 
     auto layerTracing = LayerTracing{outStream};
 
-    const bool generateLastEntryOnly =
-            argc >= 4 && std::string_view(argv[3]) == "--last-entry-only";
-
     auto traceFlags = LayerTracing::Flag::TRACE_INPUT | LayerTracing::Flag::TRACE_BUFFERS;
 
     ALOGD("Generating %s...", outputLayersTracePath);
     std::cout << "Generating " << outputLayersTracePath << "\n";
 
-    if (!LayerTraceGenerator().generate(transactionTraceFile, traceFlags, layerTracing,
-                                        generateLastEntryOnly)) {
+    LayerTraceGenerator generator;
+    if (!generator.generate(transactionTraceFile, traceFlags, layerTracing, generateLastEntryOnly,
+                            threadCount)) {
         std::cout << "Error: Failed to generate layers trace " << outputLayersTracePath << "\n";
         return -1;
     }
 
+    const auto& stats = generator.getStats();
+    std::cout << "Replayed " << stats.entries << " entries (" << stats.transactions
+              << " transactions) in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(stats.duration).count()
+              << "ms on " << threadCount << " thread(s): " << std::fixed << std::setprecision(0)
+              << stats.transactionsPerSecond() << " transactions/s\n";
+
     // Set output file permissions (-rw-r--r--)
     outStream.close();
     const mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
@@ -161,10 +161,39 @@ void TransactionCallbackInvoker::addPresentFence(sp<Fence> presentFence) {
     mPresentFence = std::move(presentFence);
 }
 
+void TransactionCallbackInvoker::addReleasedBuffer(
+        const sp<ITransactionCompletedListener>& listener, ReleasedBufferStats releasedBuffer) {
+    mReleasedBuffers[IInterface::asBinder(listener)].push_back(std::move(releasedBuffer));
+}
+
 void TransactionCallbackInvoker::sendCallbacks(bool onCommitOnly) {
+    BackgroundExecutor::Callbacks callbacks;
+
+    // Release callbacks go first, so that a client never hears about a transaction completing
+    // before the buffers it replaced are released.
+    for (auto& [listener, releasedBuffers] : mReleasedBuffers) {
+        if (!listener->isBinderAlive()) {
+            continue;
+        }
+        if (releasedBuffers.size() == 1) {
+            const ReleasedBufferStats& releasedBuffer = releasedBuffers.front();
+            callbacks.emplace_back([listener = listener, releasedBuffer]() {
+                interface_cast<ITransactionCompletedListener>(listener)
+                        ->onReleaseBuffer(releasedBuffer.callbackId, releasedBuffer.releaseFence,
+                                          releasedBuffer.currentMaxAcquiredBufferCount);
+            });
+        } else {
+            callbacks.emplace_back(
+                    [listener = listener, releasedBuffers = std::move(releasedBuffers)]() {
+                        interface_cast<ITransactionCompletedListener>(listener)->onReleaseBuffers(
+                                releasedBuffers);
+                    });
+        }
+    }
+    mReleasedBuffers.clear();
+
     // For each listener
     auto completedTransactionsItr = mCompletedTransactions.begin();
-    BackgroundExecutor::Callbacks callbacks;
     while (completedTransactionsItr != mCompletedTransactions.end()) {
         auto& [listener, transactionStatsDeque] = *completedTransactionsItr;
         ListenerStats listenerStats;
@@ -80,6 +80,10 @@ public:
     status_t addCallbackHandle(const sp<CallbackHandle>& handle,
                                const std::vector<JankData>& jankData);
 
+    // Queues a buffer release for the listener. The releases of each listener are sent together,
+    // in a single binder call, the next time callbacks are sent.
+    void addReleasedBuffer(const sp<ITransactionCompletedListener>& listener,
+                           ReleasedBufferStats releasedBuffer);
 
 private:
     status_t findOrCreateTransactionStats(const sp<IBinder>& listener,
@@ -89,6 +93,9 @@ private:
     std::unordered_map<sp<IBinder>, std::deque<TransactionStats>, IListenerHash>
         mCompletedTransactions;
 
+    std::unordered_map<sp<IBinder>, std::vector<ReleasedBufferStats>, IListenerHash>
+            mReleasedBuffers;
+
     sp<Fence> mPresentFence;
 };
 
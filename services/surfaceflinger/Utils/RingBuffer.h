@@ -18,6 +18,8 @@
 
 #include <stddef.h>
 #include <array>
+#include <iterator>
+#include <type_traits>
 
 namespace android::utils {
 
@@ -26,7 +28,65 @@ class RingBuffer {
     RingBuffer(const RingBuffer&) = delete;
     void operator=(const RingBuffer&) = delete;
 
+    // Iterates from the oldest to the newest element.
+    template <class Ring, class Value>
+    class Iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = std::remove_const_t<Value>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value*;
+        using reference = Value&;
+
+        Iterator() = default;
+        Iterator(Ring* ring, difference_type index) : mRing(ring), mIndex(index) {}
+
+        reference operator*() const { return (*mRing)[static_cast<size_t>(mIndex)]; }
+        pointer operator->() const { return &**this; }
+        reference operator[](difference_type n) const { return *(*this + n); }
+
+        Iterator& operator++() { return *this += 1; }
+        Iterator& operator--() { return *this -= 1; }
+
+        Iterator operator++(int) {
+            Iterator it = *this;
+            ++*this;
+            return it;
+        }
+
+        Iterator operator--(int) {
+            Iterator it = *this;
+            --*this;
+            return it;
+        }
+
+        Iterator& operator+=(difference_type n) {
+            mIndex += n;
+            return *this;
+        }
+
+        Iterator& operator-=(difference_type n) { return *this += -n; }
+
+        Iterator operator+(difference_type n) const { return Iterator(*this) += n; }
+        Iterator operator-(difference_type n) const { return Iterator(*this) -= n; }
+        difference_type operator-(const Iterator& other) const { return mIndex - other.mIndex; }
+
+        bool operator==(const Iterator& other) const { return mIndex == other.mIndex; }
+        bool operator!=(const Iterator& other) const { return mIndex != other.mIndex; }
+        bool operator<(const Iterator& other) const { return mIndex < other.mIndex; }
+        bool operator>(const Iterator& other) const { return mIndex > other.mIndex; }
+        bool operator<=(const Iterator& other) const { return mIndex <= other.mIndex; }
+        bool operator>=(const Iterator& other) const { return mIndex >= other.mIndex; }
+
+    private:
+        Ring* mRing = nullptr;
+        difference_type mIndex = 0;
+    };
+
 public:
+    using iterator = Iterator<RingBuffer, T>;
+    using const_iterator = Iterator<const RingBuffer, const T>;
+
     RingBuffer() = default;
     ~RingBuffer() = default;
 
@@ -34,6 +94,8 @@ public:
 
     size_t size() const { return mCount; }
 
+    bool empty() const { return mCount == 0; }
+
     T& next() {
         mHead = static_cast<size_t>(mHead + 1) % SIZE;
         if (mCount < SIZE) {
@@ -46,6 +108,10 @@ public:
 
     T& back() { return (*this)[size() - 1]; }
 
+    const T& front() const { return (*this)[0]; }
+
+    const T& back() const { return (*this)[size() - 1]; }
+
     T& operator[](size_t index) {
         return mBuffer[(static_cast<size_t>(mHead + 1) + index) % mCount];
     }
@@ -54,6 +120,11 @@ public:
         return mBuffer[(static_cast<size_t>(mHead + 1) + index) % mCount];
     }
 
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, static_cast<std::ptrdiff_t>(mCount)); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, static_cast<std::ptrdiff_t>(mCount)); }
+
     void clear() {
         mCount = 0;
         mHead = -1;
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <gmock/gmock.h>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "FrameTimeline.h"
+#include "Scheduler/EventThread.h"
+#include "mock/MockVSyncDispatch.h"
+#include "mock/MockVSyncTracker.h"
+
+using namespace std::chrono_literals;
+
+using testing::_;
+using testing::NiceMock;
+using testing::Return;
+
+namespace android {
+
+namespace {
+
+constexpr PhysicalDisplayId DISPLAY_ID = PhysicalDisplayId::fromPort(111u);
+constexpr nsecs_t VSYNC_PERIOD = 16'666'667;
+constexpr std::chrono::nanoseconds READY_DURATION = 3ms;
+
+// Blocks until every connection has received the vsync event being dispatched.
+class VsyncLatch {
+public:
+    void arm(size_t count) {
+        std::scoped_lock lock(mMutex);
+        mRemaining = count;
+    }
+
+    void countDown() {
+        std::scoped_lock lock(mMutex);
+        if (--mRemaining == 0) {
+            mCondition.notify_one();
+        }
+    }
+
+    void wait() {
+        std::unique_lock lock(mMutex);
+        mCondition.wait(lock, [this] { return mRemaining == 0; });
+    }
+
+private:
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    size_t mRemaining = 0;
+};
+
+class CountingConnection : public EventThreadConnection {
+public:
+    CountingConnection(impl::EventThread* eventThread, uid_t ownerUid, VsyncLatch& latch)
+          : EventThreadConnection(eventThread, ownerUid), mLatch(latch) {}
+
+    status_t postEvent(const DisplayEventReceiver::Event& event) override {
+        if (event.header.type == DisplayEventReceiver::DISPLAY_EVENT_VSYNC) {
+            benchmark::DoNotOptimize(event.vsync.vsyncData);
+            mLatch.countDown();
+        }
+        return NO_ERROR;
+    }
+
+private:
+    VsyncLatch& mLatch;
+};
+
+} // namespace
+
+/**
+ * Drives an EventThread through the callback it registers with VSyncDispatch, which is what the
+ * timer thread invokes on device. Connections are spread round-robin over a number of distinct
+ * frame intervals, as apps with frame rate overrides would be.
+ */
+class EventThreadBenchmark : public IEventThreadCallback {
+public:
+    EventThreadBenchmark(size_t connectionCount, int64_t frameIntervalCount)
+          : mFrameIntervalCount(frameIntervalCount) {
+        auto dispatch = std::make_shared<NiceMock<mock::VSyncDispatch>>();
+        ON_CALL(*dispatch, registerCallback(_, _))
+                .WillByDefault([this](scheduler::VSyncDispatch::Callback callback, std::string) {
+                    mVsyncCallback = std::move(callback);
+                    return scheduler::VSyncDispatch::CallbackToken(0);
+                });
+        ON_CALL(*dispatch, schedule(_, _)).WillByDefault(Return(scheduler::ScheduleResult{}));
+        ON_CALL(*dispatch, update(_, _)).WillByDefault(Return(scheduler::ScheduleResult{}));
+
+        auto vsyncSchedule = std::shared_ptr<scheduler::VsyncSchedule>(
+                new scheduler::VsyncSchedule(DISPLAY_ID,
+                                             std::make_shared<NiceMock<mock::VSyncTracker>>(),
+                                             std::move(dispatch), nullptr));
+        mThread = std::make_unique<impl::EventThread>("EventThreadBenchmark",
+                                                      std::move(vsyncSchedule), &mTokenManager,
+                                                      *this, 0ns, READY_DURATION);
+        mThread->onHotplugReceived(DISPLAY_ID, true);
+
+        for (size_t i = 0; i < connectionCount; i++) {
+            const auto connection =
+                    sp<CountingConnection>::make(mThread.get(), static_cast<uid_t>(i), mLatch);
+            mThread->setVsyncRate(1, connection);
+            mConnections.push_back(connection);
+        }
+    }
+
+    void dispatchVsync() {
+        mLatch.arm(mConnections.size());
+        mWakeupTime += VSYNC_PERIOD;
+        mVsyncCallback(mWakeupTime + VSYNC_PERIOD, mWakeupTime,
+                       mWakeupTime + VSYNC_PERIOD - READY_DURATION.count());
+        mLatch.wait();
+    }
+
+    // IEventThreadCallback overrides
+    bool throttleVsync(TimePoint, uid_t) override { return false; }
+    Period getVsyncPeriod(uid_t uid) override {
+        return Period::fromNs(VSYNC_PERIOD * (1 + static_cast<int64_t>(uid) % mFrameIntervalCount));
+    }
+    void resync() override {}
+    void onExpectedPresentTimePosted(TimePoint) override {}
+
+private:
+    const int64_t mFrameIntervalCount;
+    nsecs_t mWakeupTime = 0;
+    VsyncLatch mLatch;
+    scheduler::VSyncDispatch::Callback mVsyncCallback;
+    frametimeline::impl::TokenManager mTokenManager;
+    std::unique_ptr<impl::EventThread> mThread;
+    std::vector<sp<CountingConnection>> mConnections;
+};
+
+namespace {
+
+// Arguments: number of connections, and number of distinct frame intervals among them.
+void benchmarkDispatchVsync(benchmark::State& state) {
+    EventThreadBenchmark eventThread(static_cast<size_t>(state.range(0)), state.range(1));
+
+    for (auto _ : state) {
+        eventThread.dispatchVsync();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+} // namespace
+
+BENCHMARK(benchmarkDispatchVsync)
+        ->ArgNames({"connections", "intervals"})
+        ->ArgsProduct({{1, 8, 32, 128}, {1, 3}});
+
+} // namespace android
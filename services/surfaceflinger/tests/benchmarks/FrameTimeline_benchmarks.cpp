@@ -0,0 +1,83 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <gmock/gmock.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "FrameTimeline.h"
+#include "mock/MockTimeStats.h"
+
+using testing::NiceMock;
+
+namespace android::frametimeline {
+
+namespace {
+
+constexpr nsecs_t VSYNC_PERIOD = 16'666'667;
+constexpr pid_t SURFACE_FLINGER_PID = 666;
+constexpr Fps REFRESH_RATE = 60_Hz;
+
+// Arguments: layer count. Every vsync, each layer queues a buffer that is latched and presented,
+// as in the FrameTimelineTest workloads. Measures what the main thread spends in FrameTimeline.
+void benchmarkPresentFrames(benchmark::State& state) {
+    const auto layerCount = static_cast<int32_t>(state.range(0));
+    impl::FrameTimeline frameTimeline(std::make_shared<NiceMock<mock::TimeStats>>(),
+                                      SURFACE_FLINGER_PID);
+    auto* tokenManager = frameTimeline.getTokenManager();
+
+    std::vector<std::string> layerNames;
+    for (int32_t i = 0; i < layerCount; i++) {
+        layerNames.push_back("layer" + std::to_string(i));
+    }
+
+    nsecs_t vsync = VSYNC_PERIOD;
+    for (auto _ : state) {
+        const int64_t appToken = tokenManager->generateTokenForPredictions(
+                {vsync - VSYNC_PERIOD, vsync - VSYNC_PERIOD / 2, vsync});
+        const int64_t sfToken = tokenManager->generateTokenForPredictions(
+                {vsync - VSYNC_PERIOD / 2, vsync - VSYNC_PERIOD / 4, vsync});
+
+        FrameTimelineInfo info;
+        info.vsyncId = appToken;
+        for (int32_t i = 0; i < layerCount; i++) {
+            const auto& layerName = layerNames[static_cast<size_t>(i)];
+            auto surfaceFrame =
+                    frameTimeline.createSurfaceFrameForToken(info, SURFACE_FLINGER_PID, 0, i,
+                                                             layerName, layerName,
+                                                             /*isBuffer*/ true,
+                                                             GameMode::Unsupported);
+            surfaceFrame->setActualQueueTime(vsync - VSYNC_PERIOD / 2);
+            surfaceFrame->setAcquireFenceTime(vsync - VSYNC_PERIOD / 2);
+            surfaceFrame->setPresentState(SurfaceFrame::PresentState::Presented);
+            frameTimeline.addSurfaceFrame(std::move(surfaceFrame));
+        }
+
+        frameTimeline.setSfWakeUp(sfToken, vsync - VSYNC_PERIOD / 2, REFRESH_RATE, REFRESH_RATE);
+        frameTimeline.setSfPresent(vsync - VSYNC_PERIOD / 4, std::make_shared<FenceTime>(vsync));
+        vsync += VSYNC_PERIOD;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * layerCount);
+}
+
+} // namespace
+
+BENCHMARK(benchmarkPresentFrames)->ArgNames({"layers"})->Arg(1)->Arg(10)->Arg(50);
+
+} // namespace android::frametimeline
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <vector>
+
+#include "Scheduler/RefreshRateSelector.h"
+#include "mock/DisplayHardware/MockDisplayMode.h"
+
+namespace android::scheduler {
+
+namespace {
+
+using LayerRequirement = RefreshRateSelector::LayerRequirement;
+using LayerVoteType = RefreshRateSelector::LayerVoteType;
+
+constexpr std::array<Fps, 5> kContentFrameRates = {24_Hz, 30_Hz, 48_Hz, 60_Hz, 90_Hz};
+
+// Modes from 30Hz up, in steps of 5Hz, like on a panel that supports many refresh rates.
+DisplayModes makeDisplayModes(int count) {
+    DisplayModes modes;
+    for (int i = 0; i < count; i++) {
+        const DisplayModeId modeId(i);
+        const Fps refreshRate = Fps::fromValue(30.f + 5.f * static_cast<float>(i));
+        modes.try_emplace(modeId, mock::createDisplayMode(modeId, refreshRate));
+    }
+    return modes;
+}
+
+// A mix of the votes scored in RefreshRateSelectorTest, from layers drawing at common content
+// frame rates.
+std::vector<LayerRequirement> makeLayers(int count) {
+    constexpr std::array<LayerVoteType, 4> kVotes = {LayerVoteType::Heuristic,
+                                                     LayerVoteType::ExplicitDefault,
+                                                     LayerVoteType::ExplicitExactOrMultiple,
+                                                     LayerVoteType::Max};
+    std::vector<LayerRequirement> layers;
+    layers.reserve(static_cast<size_t>(count));
+    for (int i = 0; i < count; i++) {
+        layers.push_back({.name = "layer" + std::to_string(i),
+                          .vote = kVotes[static_cast<size_t>(i) % kVotes.size()],
+                          .desiredRefreshRate =
+                                  kContentFrameRates[static_cast<size_t>(i) %
+                                                     kContentFrameRates.size()],
+                          .weight = 1.f / static_cast<float>(1 + i % 3),
+                          .focused = i == 0});
+    }
+    return layers;
+}
+
+// Moves the layer on to the next content frame rate, so that it always votes differently.
+void changeDesiredRefreshRate(LayerRequirement& layer) {
+    const auto it =
+            std::find_if(kContentFrameRates.begin(), kContentFrameRates.end(),
+                         [&](Fps fps) { return isApproxEqual(fps, layer.desiredRefreshRate); });
+    const size_t index = static_cast<size_t>(it - kContentFrameRates.begin());
+    layer.desiredRefreshRate = kContentFrameRates[(index + 1) % kContentFrameRates.size()];
+}
+
+enum class Change { None, OneLayer, AllLayers };
+
+// Arguments: layer count, mode count, and which layers change between frames.
+void benchmarkGetRankedFrameRates(benchmark::State& state) {
+    const auto layerCount = static_cast<int>(state.range(0));
+    const auto modeCount = static_cast<int>(state.range(1));
+    const auto change = static_cast<Change>(state.range(2));
+
+    RefreshRateSelector selector(makeDisplayModes(modeCount), DisplayModeId(0));
+    std::vector<LayerRequirement> layers = makeLayers(layerCount);
+
+    size_t iteration = 0;
+    for (auto _ : state) {
+        iteration++;
+        switch (change) {
+            case Change::None:
+                break;
+            case Change::OneLayer:
+                changeDesiredRefreshRate(layers[iteration % layers.size()]);
+                break;
+            case Change::AllLayers:
+                for (auto& layer : layers) {
+                    changeDesiredRefreshRate(layer);
+                }
+                break;
+        }
+        benchmark::DoNotOptimize(selector.getRankedFrameRates(layers, {}));
+    }
+}
+
+} // namespace
+
+BENCHMARK(benchmarkGetRankedFrameRates)
+        ->ArgNames({"layers", "modes", "change"})
+        ->ArgsProduct({{10, 50, 100}, {20, 40}, {0, 1, 2}});
+
+} // namespace android::scheduler
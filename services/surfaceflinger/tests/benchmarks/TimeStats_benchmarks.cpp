@@ -0,0 +1,107 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <utils/String16.h>
+#include <utils/Vector.h>
+
+#include "TimeStats/TimeStats.h"
+
+namespace android {
+
+namespace {
+
+constexpr Fps REFRESH_RATE = 120_Hz;
+constexpr uid_t UID = 10'000;
+constexpr int ATOM_LAYER_INFO = 10063;
+
+void enable(TimeStats& timeStats) {
+    Vector<String16> args;
+    args.push_back(String16("-enable"));
+    std::string result;
+    timeStats.parseArgs(/*asProto*/ false, args, result);
+}
+
+// Arguments: layer count, and whether statsd pulls the layer stats concurrently. Every iteration is
+// a frame at 120Hz, in which every layer posts a buffer that is latched and presented, as recorded
+// by the main thread.
+void benchmarkRecordFrame(benchmark::State& state) {
+    const auto layerCount = static_cast<int32_t>(state.range(0));
+    const bool pullConcurrently = state.range(1) != 0;
+
+    impl::TimeStats timeStats;
+    enable(timeStats);
+
+    std::vector<std::string> layerNames;
+    for (int32_t i = 0; i < layerCount; i++) {
+        layerNames.push_back("com.example.app#" + std::to_string(i));
+    }
+
+    std::atomic<bool> done = false;
+    std::thread puller;
+    if (pullConcurrently) {
+        puller = std::thread([&] {
+            std::vector<uint8_t> pulledData;
+            while (!done) {
+                timeStats.onPullAtom(ATOM_LAYER_INFO, &pulledData);
+            }
+        });
+    }
+
+    const nsecs_t period = REFRESH_RATE.getPeriodNsecs();
+    nsecs_t vsync = period;
+    uint64_t frameNumber = 1;
+    for (auto _ : state) {
+        for (int32_t layerId = 0; layerId < layerCount; layerId++) {
+            const auto& layerName = layerNames[static_cast<size_t>(layerId)];
+            timeStats.setPostTime(layerId, frameNumber, layerName, UID, vsync - period,
+                                  GameMode::Unsupported);
+            timeStats.setDesiredTime(layerId, frameNumber, vsync - period / 2);
+            timeStats.setAcquireFence(layerId, frameNumber,
+                                      std::make_shared<FenceTime>(vsync - period / 2));
+            timeStats.setLatchTime(layerId, frameNumber, vsync - period / 2);
+            timeStats.setPresentFence(layerId, frameNumber, std::make_shared<FenceTime>(vsync),
+                                      REFRESH_RATE, REFRESH_RATE, {}, GameMode::Unsupported);
+        }
+        timeStats.incrementTotalFrames();
+        timeStats.recordFrameDuration(vsync - period, vsync - period / 4);
+        timeStats.setPresentFenceGlobal(std::make_shared<FenceTime>(vsync));
+
+        vsync += period;
+        frameNumber++;
+    }
+
+    done = true;
+    if (puller.joinable()) {
+        puller.join();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * layerCount);
+}
+
+} // namespace
+
+BENCHMARK(benchmarkRecordFrame)
+        ->ArgNames({"layers", "pull"})
+        ->ArgsProduct({{100, 300, 500}, {0, 1}});
+
+} // namespace android
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <layerproto/LayerProtoHeader.h>
+
+#include "Tracing/TransactionRingBuffer.h"
+
+namespace android {
+
+namespace {
+
+using TraceFile = perfetto::protos::TransactionTraceFile;
+using TraceEntry = perfetto::protos::TransactionTraceEntry;
+using RingBuffer = TransactionRingBuffer<TraceFile, TraceEntry>;
+
+constexpr std::string_view kTransactionTracePrefix = "transactions_trace_";
+
+// The entries of the transaction traces that the layer trace generator is tested with, which are
+// installed next to the benchmark.
+const std::vector<TraceEntry>& getTraceEntries() {
+    static const std::vector<TraceEntry> sEntries = [] {
+        std::vector<TraceEntry> entries;
+        const std::string directory = base::GetExecutableDirectory() + "/testdata/";
+        if (!std::filesystem::is_directory(directory)) {
+            return entries;
+        }
+        for (const auto& file : std::filesystem::directory_iterator(directory)) {
+            if (file.path().filename().string().rfind(kTransactionTracePrefix, 0) != 0) {
+                continue;
+            }
+            std::ifstream input(file.path(), std::ios::in | std::ios::binary);
+            TraceFile trace;
+            if (!trace.ParseFromIstream(&input)) {
+                continue;
+            }
+            entries.insert(entries.end(), trace.entry().begin(), trace.entry().end());
+        }
+        return entries;
+    }();
+    return sEntries;
+}
+
+// Arguments: buffer size in KB. The trace entries are added to the buffer, evicting the oldest
+// ones once it is full, which are parsed to update the starting state as TransactionTracing does.
+void benchmarkAddEntries(benchmark::State& state) {
+    const auto& entries = getTraceEntries();
+    if (entries.empty()) {
+        state.SkipWithError("No transaction traces found");
+        return;
+    }
+
+    RingBuffer buffer;
+    buffer.setSize(static_cast<size_t>(state.range(0)) * 1024);
+    TraceEntry removedEntry;
+    for (auto _ : state) {
+        for (const auto& entry : entries) {
+            benchmark::DoNotOptimize(buffer.emplace(entry, [&](const RingBuffer::Entry& removed) {
+                removedEntry.ParseFromArray(removed.bytes.data(),
+                                            static_cast<int>(removed.bytes.size()));
+            }));
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * entries.size()));
+}
+
+// Arguments: buffer size in KB, and whether the entries are streamed out as they are stored
+// instead of being parsed into the trace file proto first.
+void benchmarkWriteBuffer(benchmark::State& state) {
+    const auto& entries = getTraceEntries();
+    if (entries.empty()) {
+        state.SkipWithError("No transaction traces found");
+        return;
+    }
+
+    RingBuffer buffer;
+    buffer.setSize(static_cast<size_t>(state.range(0)) * 1024);
+    for (const auto& entry : entries) {
+        buffer.emplace(entry);
+    }
+    const bool streaming = state.range(1) != 0;
+
+    for (auto _ : state) {
+        TraceFile fileProto;
+        fileProto.set_version(1);
+        std::string output;
+        if (streaming) {
+            fileProto.SerializeToString(&output);
+            buffer.appendToString(output);
+        } else {
+            buffer.writeToProto(fileProto);
+            fileProto.SerializeToString(&output);
+        }
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * buffer.used()));
+}
+
+} // namespace
+
+BENCHMARK(benchmarkAddEntries)->ArgNames({"kb"})->Arg(512)->Arg(4096);
+BENCHMARK(benchmarkWriteBuffer)->ArgNames({"kb", "streaming"})->ArgsProduct({{512, 4096}, {0, 1}});
+
+} // namespace android
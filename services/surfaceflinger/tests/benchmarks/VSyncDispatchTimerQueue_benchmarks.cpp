@@ -0,0 +1,175 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <scheduler/TimeKeeper.h>
+
+#include "Scheduler/VSyncDispatchTimerQueue.h"
+#include "mock/MockVSyncTracker.h"
+
+using namespace std::chrono_literals;
+
+using testing::_;
+using testing::NiceMock;
+
+namespace android::scheduler {
+
+namespace {
+
+constexpr nsecs_t VSYNC_PERIOD = 16'666'667;
+constexpr nsecs_t TIMER_SLACK = std::chrono::nanoseconds(500us).count();
+constexpr nsecs_t MIN_VSYNC_DISTANCE = std::chrono::nanoseconds(3ms).count();
+
+// Runs alarms when told to, instead of on a timer thread.
+class ManualTimeKeeper : public TimeKeeper {
+public:
+    nsecs_t now() const override { return mNow; }
+
+    void alarmAt(std::function<void()> callback, nsecs_t time) override {
+        mCallback = std::move(callback);
+        mAlarmTime = time;
+    }
+
+    void alarmCancel() override { mCallback = nullptr; }
+
+    void dump(std::string&) const override {}
+
+    void setNow(nsecs_t now) { mNow = now; }
+
+    // Moves the time forward to the alarm and runs it. Returns false if no alarm is set.
+    bool runAlarm() {
+        if (!mCallback) {
+            return false;
+        }
+        mNow = std::max(mNow, mAlarmTime);
+        const auto callback = std::move(mCallback);
+        mCallback = nullptr;
+        callback();
+        return true;
+    }
+
+private:
+    nsecs_t mNow = 0;
+    nsecs_t mAlarmTime = 0;
+    std::function<void()> mCallback;
+};
+
+std::shared_ptr<VSyncTracker> createTracker() {
+    auto tracker = std::make_shared<NiceMock<mock::VSyncTracker>>();
+    ON_CALL(*tracker, nextAnticipatedVSyncTimeFrom(_, _))
+            .WillByDefault([](nsecs_t timePoint, std::optional<nsecs_t>) {
+                return (timePoint + VSYNC_PERIOD - 1) / VSYNC_PERIOD * VSYNC_PERIOD;
+            });
+    ON_CALL(*tracker, currentPeriod()).WillByDefault(testing::Return(VSYNC_PERIOD));
+    return tracker;
+}
+
+// Work durations spread over the frame, so that callbacks wake up at different times like the
+// EventThreads, RegionSampling and app callbacks of a multi-display device.
+nsecs_t workDuration(size_t index, size_t count) {
+    return VSYNC_PERIOD / 8 + static_cast<nsecs_t>(index) * (VSYNC_PERIOD / 2) /
+            static_cast<nsecs_t>(count);
+}
+
+struct Dispatch {
+    explicit Dispatch(size_t count) {
+        auto timeKeeper = std::make_unique<ManualTimeKeeper>();
+        this->timeKeeper = timeKeeper.get();
+        dispatch = std::make_shared<VSyncDispatchTimerQueue>(std::move(timeKeeper),
+                                                             createTracker(), TIMER_SLACK,
+                                                             MIN_VSYNC_DISTANCE);
+        for (size_t i = 0; i < count; i++) {
+            tokens.push_back(dispatch->registerCallback([this](nsecs_t, nsecs_t,
+                                                               nsecs_t) { invocations++; },
+                                                        "callback" + std::to_string(i)));
+        }
+    }
+
+    ~Dispatch() {
+        for (const auto token : tokens) {
+            dispatch->unregisterCallback(token);
+        }
+    }
+
+    ManualTimeKeeper* timeKeeper;
+    std::shared_ptr<VSyncDispatchTimerQueue> dispatch;
+    std::vector<VSyncDispatch::CallbackToken> tokens;
+    size_t invocations = 0;
+};
+
+// Arguments: callback count. Every callback is scheduled for the next vsync, and then dispatched.
+void benchmarkScheduleAndDispatch(benchmark::State& state) {
+    const auto count = static_cast<size_t>(state.range(0));
+    Dispatch dispatch(count);
+
+    nsecs_t vsync = VSYNC_PERIOD;
+    for (auto _ : state) {
+        dispatch.timeKeeper->setNow(vsync - VSYNC_PERIOD);
+        for (size_t i = 0; i < count; i++) {
+            dispatch.dispatch->schedule(dispatch.tokens[i],
+                                        {.workDuration = workDuration(i, count),
+                                         .readyDuration = 0,
+                                         .lastVsync = vsync});
+        }
+        while (dispatch.timeKeeper->runAlarm()) {
+        }
+        vsync += VSYNC_PERIOD;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(dispatch.invocations));
+}
+
+// Arguments: callback count. Callbacks armed for the next vsync are rescheduled one at a time,
+// without being dispatched, as when their work duration changes.
+void benchmarkReschedule(benchmark::State& state) {
+    const auto count = static_cast<size_t>(state.range(0));
+    Dispatch dispatch(count);
+
+    constexpr nsecs_t kVsync = 2 * VSYNC_PERIOD;
+    dispatch.timeKeeper->setNow(kVsync - VSYNC_PERIOD);
+    for (size_t i = 0; i < count; i++) {
+        dispatch.dispatch->schedule(dispatch.tokens[i],
+                                    {.workDuration = workDuration(i, count),
+                                     .readyDuration = 0,
+                                     .lastVsync = kVsync});
+    }
+
+    size_t iteration = 0;
+    for (auto _ : state) {
+        const size_t index = iteration % count;
+        const nsecs_t jitter = (iteration / count) % 2 == 0 ? 100'000 : 0;
+        benchmark::DoNotOptimize(
+                dispatch.dispatch->schedule(dispatch.tokens[index],
+                                            {.workDuration = workDuration(index, count) + jitter,
+                                             .readyDuration = 0,
+                                             .lastVsync = kVsync}));
+        iteration++;
+    }
+}
+
+} // namespace
+
+BENCHMARK(benchmarkScheduleAndDispatch)->ArgNames({"callbacks"})->Arg(10)->Arg(100);
+BENCHMARK(benchmarkReschedule)->ArgNames({"callbacks"})->Arg(10)->Arg(100);
+
+} // namespace android::scheduler
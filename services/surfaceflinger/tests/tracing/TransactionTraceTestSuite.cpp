@@ -19,6 +19,7 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <unordered_map>
 
@@ -240,6 +241,32 @@ TEST_P(TransactionTraceTestSuite, validateEndState) {
     }
 }
 
+TEST_P(TransactionTraceTestSuite, parallelGenerationMatchesSerialGeneration) {
+    const auto traceFlags = LayerTracing::TRACE_INPUT | LayerTracing::TRACE_BUFFERS;
+    const auto generateLayersTrace = [&](size_t threadCount) {
+        std::stringstream stream;
+        {
+            auto layerTracing = LayerTracing{stream};
+            EXPECT_TRUE(LayerTraceGenerator().generate(mTransactionTrace, traceFlags, layerTracing,
+                                                       /*onlyLastEntry=*/false, threadCount));
+        }
+        perfetto::protos::LayersTraceFileProto layersTrace;
+        EXPECT_TRUE(layersTrace.ParseFromIstream(&stream));
+        return layersTrace;
+    };
+
+    const auto serialTrace = generateLayersTrace(/*threadCount=*/1);
+    const auto parallelTrace = generateLayersTrace(/*threadCount=*/4);
+    ASSERT_EQ(serialTrace.entry_size(), mTransactionTrace.entry_size());
+    ASSERT_EQ(parallelTrace.entry_size(), serialTrace.entry_size());
+    for (int i = 0; i < serialTrace.entry_size(); i++) {
+        EXPECT_EQ(parallelTrace.entry(i).SerializeAsString(),
+                  serialTrace.entry(i).SerializeAsString())
+                << "Layers snapshot " << i << " differs, vsync id "
+                << serialTrace.entry(i).vsync_id();
+    }
+}
+
 std::string PrintToStringParamName(const ::testing::TestParamInfo<std::filesystem::path>& info) {
     const auto& prefix = android::TransactionTraceTestSuite::sTransactionTracePrefix;
     const auto& postfix = android::TransactionTraceTestSuite::sTracePostfix;
@@ -24,6 +24,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <log/log.h>
+#include <poll.h>
+#include <private/gui/VsyncBroadcastChannel.h>
 #include <scheduler/VsyncConfig.h>
 #include <utils/Errors.h>
 
@@ -83,7 +85,7 @@ protected:
 
     // IEventThreadCallback overrides
     bool throttleVsync(TimePoint, uid_t) override;
-    Period getVsyncPeriod(uid_t) override;
+    Period getVsyncPeriod(uid_t uid) override;
     void resync() override;
     void onExpectedPresentTimePosted(TimePoint) override;
 
@@ -149,6 +151,7 @@ protected:
 
     static constexpr uid_t mConnectionUid = 443;
     static constexpr uid_t mThrottledConnectionUid = 177;
+    static constexpr uid_t mHalfRateConnectionUid = 288;
 };
 
 EventThreadTest::EventThreadTest() {
@@ -187,8 +190,8 @@ bool EventThreadTest::throttleVsync(android::TimePoint expectedVsyncTimestamp, u
     return (uid == mThrottledConnectionUid);
 }
 
-Period EventThreadTest::getVsyncPeriod(uid_t) {
-    return mVsyncPeriod;
+Period EventThreadTest::getVsyncPeriod(uid_t uid) {
+    return uid == mHalfRateConnectionUid ? mVsyncPeriod * 2 : mVsyncPeriod;
 }
 
 void EventThreadTest::resync() {
@@ -536,6 +539,162 @@ TEST_F(EventThreadTest, getLatestVsyncEventData) {
     }
 }
 
+TEST_F(EventThreadTest, connectionsWithSameFrameIntervalShareFrameTimelines) {
+    setupEventThread();
+
+    ConnectionEventRecorder sameRateConnectionEventRecorder{0};
+    sp<MockEventThreadConnection> sameRateConnection =
+            createConnection(sameRateConnectionEventRecorder);
+    ConnectionEventRecorder halfRateConnectionEventRecorder{0};
+    sp<MockEventThreadConnection> halfRateConnection =
+            createConnection(halfRateConnectionEventRecorder, {}, mHalfRateConnectionUid);
+
+    mThread->requestNextVsync(mConnection);
+    mThread->requestNextVsync(sameRateConnection);
+    mThread->requestNextVsync(halfRateConnection);
+    expectVSyncCallbackScheduleReceived(true);
+
+    onVSyncEvent(123, 456, 789);
+    const auto args = mConnectionEventCallRecorder.waitForCall();
+    const auto sameRateArgs = sameRateConnectionEventRecorder.waitForCall();
+    const auto halfRateArgs = halfRateConnectionEventRecorder.waitForCall();
+    ASSERT_TRUE(args.has_value());
+    ASSERT_TRUE(sameRateArgs.has_value());
+    ASSERT_TRUE(halfRateArgs.has_value());
+
+    const VsyncEventData& vsyncData = std::get<0>(args.value()).vsync.vsyncData;
+    const VsyncEventData& sameRateVsyncData = std::get<0>(sameRateArgs.value()).vsync.vsyncData;
+    const VsyncEventData& halfRateVsyncData = std::get<0>(halfRateArgs.value()).vsync.vsyncData;
+
+    // Connections with the same frame interval are given the very same frame timelines.
+    ASSERT_EQ(vsyncData.frameTimelinesLength, sameRateVsyncData.frameTimelinesLength);
+    EXPECT_EQ(vsyncData.preferredFrameTimelineIndex,
+              sameRateVsyncData.preferredFrameTimelineIndex);
+    for (int i = 0; i < vsyncData.frameTimelinesLength; i++) {
+        EXPECT_EQ(vsyncData.frameTimelines[i].vsyncId, sameRateVsyncData.frameTimelines[i].vsyncId)
+                << "Vsync ID differs for frame timeline " << i;
+        EXPECT_EQ(vsyncData.frameTimelines[i].deadlineTimestamp,
+                  sameRateVsyncData.frameTimelines[i].deadlineTimestamp);
+        EXPECT_EQ(vsyncData.frameTimelines[i].expectedPresentationTime,
+                  sameRateVsyncData.frameTimelines[i].expectedPresentationTime);
+    }
+
+    // A connection with a different frame interval gets its own frame timelines and tokens.
+    EXPECT_EQ(mVsyncPeriod.count() * 2, halfRateVsyncData.frameInterval);
+    for (int i = 0; i < halfRateVsyncData.frameTimelinesLength; i++) {
+        const int64_t vsyncId = halfRateVsyncData.frameTimelines[i].vsyncId;
+        EXPECT_GE(vsyncId, vsyncData.frameTimelinesLength)
+                << "Vsync ID reused for frame timeline " << i;
+        const auto prediction = mTokenManager->getPredictionsForToken(vsyncId);
+        ASSERT_TRUE(prediction.has_value());
+        EXPECT_EQ(halfRateVsyncData.frameTimelines[i].deadlineTimestamp, prediction->endTime);
+    }
+}
+
+TEST_F(EventThreadTest, broadcastVsyncIsPublishedInsteadOfPosted) {
+    setupEventThread();
+
+    ConnectionEventRecorder broadcastConnectionEventRecorder{0};
+    sp<MockEventThreadConnection> broadcastConnection =
+            createConnection(broadcastConnectionEventRecorder,
+                             gui::ISurfaceComposer::EventRegistration::vsyncBroadcast);
+    auto channel = std::make_unique<gui::VsyncBroadcastChannel>();
+    ASSERT_EQ(NO_ERROR, mThread->getVsyncBroadcastChannel(broadcastConnection, channel.get()));
+    mThread->enableVsyncBroadcast(broadcastConnection);
+    gui::VsyncBroadcastReceiver receiver(std::move(channel));
+
+    ConnectionEventRecorder idleConnectionEventRecorder{0};
+    sp<MockEventThreadConnection> idleConnection =
+            createConnection(idleConnectionEventRecorder,
+                             gui::ISurfaceComposer::EventRegistration::vsyncBroadcast);
+    auto idleChannel = std::make_unique<gui::VsyncBroadcastChannel>();
+    ASSERT_EQ(NO_ERROR, mThread->getVsyncBroadcastChannel(idleConnection, idleChannel.get()));
+    mThread->enableVsyncBroadcast(idleConnection);
+    gui::VsyncBroadcastReceiver idleReceiver(std::move(idleChannel));
+
+    mThread->requestNextVsync(mConnection);
+    receiver.requestNextVsync();
+    mThread->requestNextVsync(broadcastConnection);
+    expectVSyncCallbackScheduleReceived(true);
+
+    onVSyncEvent(123, 456, 789);
+    expectVsyncEventReceivedByConnection(123, 1u);
+
+    // The event is published on the channel rather than written to the connection's BitTube.
+    pollfd pfd{.fd = receiver.getFd(), .events = POLLIN};
+    ASSERT_EQ(1, poll(&pfd, 1, 1000));
+    DisplayEventReceiver::Event event;
+    ASSERT_TRUE(receiver.getVsync(&event));
+    EXPECT_EQ(DisplayEventReceiver::DISPLAY_EVENT_VSYNC, event.header.type);
+    EXPECT_EQ(123, event.header.timestamp);
+    EXPECT_FALSE(broadcastConnectionEventRecorder.waitForUnexpectedCall().has_value());
+
+    // Only the receiver that asked for the event is woken up.
+    pfd.fd = idleReceiver.getFd();
+    EXPECT_EQ(0, poll(&pfd, 1, 0));
+    EXPECT_FALSE(idleReceiver.getVsync(&event));
+    EXPECT_FALSE(idleConnectionEventRecorder.waitForUnexpectedCall().has_value());
+}
+
+TEST_F(EventThreadTest, broadcastVsyncFallsBackToPostingWhileAListenerIsThrottled) {
+    setupEventThread();
+
+    ConnectionEventRecorder broadcastConnectionEventRecorder{0};
+    sp<MockEventThreadConnection> broadcastConnection =
+            createConnection(broadcastConnectionEventRecorder,
+                             gui::ISurfaceComposer::EventRegistration::vsyncBroadcast);
+    ConnectionEventRecorder throttledConnectionEventRecorder{0};
+    sp<MockEventThreadConnection> throttledConnection =
+            createConnection(throttledConnectionEventRecorder,
+                             gui::ISurfaceComposer::EventRegistration::vsyncBroadcast,
+                             mThrottledConnectionUid);
+    gui::VsyncBroadcastChannel channel;
+    ASSERT_EQ(NO_ERROR, mThread->getVsyncBroadcastChannel(broadcastConnection, &channel));
+    mThread->enableVsyncBroadcast(broadcastConnection);
+    gui::VsyncBroadcastChannel throttledChannel;
+    ASSERT_EQ(NO_ERROR,
+              mThread->getVsyncBroadcastChannel(throttledConnection, &throttledChannel));
+    mThread->enableVsyncBroadcast(throttledConnection);
+    uint32_t sequence = channel.getSequence();
+
+    mThread->requestNextVsync(broadcastConnection);
+    mThread->requestNextVsync(throttledConnection);
+    expectVSyncCallbackScheduleReceived(true);
+
+    // The throttled connection could read a published event early, so the event is posted instead.
+    onVSyncEvent(123, 456, 789);
+    expectVsyncEventReceivedByConnection("broadcastConnection", broadcastConnectionEventRecorder,
+                                         123, 1u);
+    EXPECT_FALSE(throttledConnectionEventRecorder.waitForUnexpectedCall().has_value());
+    DisplayEventReceiver::Event event;
+    EXPECT_FALSE(channel.read(&sequence, &event));
+}
+
+TEST_F(EventThreadTest, broadcastChannelRemovedWithItsLastConnection) {
+    setupEventThread();
+
+    ConnectionEventRecorder errorConnectionEventRecorder{NO_MEMORY};
+    sp<MockEventThreadConnection> errorConnection =
+            createConnection(errorConnectionEventRecorder,
+                             gui::ISurfaceComposer::EventRegistration::vsyncBroadcast);
+    gui::VsyncBroadcastChannel channel;
+    ASSERT_EQ(NO_ERROR, mThread->getVsyncBroadcastChannel(errorConnection, &channel));
+    mThread->setVsyncRate(1, errorConnection);
+    expectVSyncCallbackScheduleReceived(true);
+
+    std::string dump;
+    mThread->dump(dump);
+    EXPECT_THAT(dump, testing::HasSubstr("vsync broadcast channels (count=1)"));
+
+    // The connection is removed once it fails to receive the event, and its channel with it.
+    onVSyncEvent(123, 456, 789);
+    expectVsyncEventReceivedByConnection("errorConnection", errorConnectionEventRecorder, 123, 1u);
+
+    dump.clear();
+    mThread->dump(dump);
+    EXPECT_THAT(dump, testing::HasSubstr("vsync broadcast channels (count=0)"));
+}
+
 TEST_F(EventThreadTest, setVsyncRateZeroPostsNoVSyncEventsToThatConnection) {
     setupEventThread();
 
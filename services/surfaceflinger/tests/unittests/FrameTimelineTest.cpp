@@ -153,6 +153,11 @@ public:
         return mFrameTimeline->mDisplayFrames[idx];
     }
 
+    const impl::FrameTimeline::DisplayFrame* getCurrentDisplayFrame() {
+        std::lock_guard<std::mutex> lock(mFrameTimeline->mMutex);
+        return mFrameTimeline->mCurrentDisplayFrame.get();
+    }
+
     static bool compareTimelineItems(const TimelineItem& a, const TimelineItem& b) {
         return a.startTime == b.startTime && a.endTime == b.endTime &&
                 a.presentTime == b.presentTime;
@@ -205,6 +210,22 @@ TEST_F(FrameTimelineTest, tokenManagerRemovesStalePredictions) {
     EXPECT_EQ(compareTimelineItems(*predictions, TimelineItem(10, 20, 30)), true);
 }
 
+TEST_F(FrameTimelineTest, tokenManagerGeneratesConsecutiveTokensForBatch) {
+    const int64_t token1 = mTokenManager->generateTokenForPredictions({0, 0, 0});
+    const std::array<TimelineItem, 3> predictions = {TimelineItem(10, 20, 30),
+                                                     TimelineItem(10, 36, 46),
+                                                     TimelineItem(10, 52, 62)};
+    std::array<int64_t, 3> tokens;
+    mTokenManager->generateTokensForPredictions(predictions, tokens);
+
+    for (size_t i = 0; i < predictions.size(); i++) {
+        EXPECT_EQ(token1 + 1 + static_cast<int64_t>(i), tokens[i]);
+        std::optional<TimelineItem> stored = mTokenManager->getPredictionsForToken(tokens[i]);
+        ASSERT_TRUE(stored.has_value());
+        EXPECT_EQ(compareTimelineItems(*stored, predictions[i]), true);
+    }
+}
+
 TEST_F(FrameTimelineTest, createSurfaceFrameForToken_getOwnerPidReturnsCorrectPid) {
     auto surfaceFrame1 =
             mFrameTimeline->createSurfaceFrameForToken({}, sPidOne, sUidOne, sLayerIdOne,
@@ -521,6 +542,36 @@ TEST_F(FrameTimelineTest, setMaxDisplayFramesSetsSizeProperly) {
     EXPECT_EQ(getNumberOfDisplayFrames(), *maxDisplayFrames);
 }
 
+TEST_F(FrameTimelineTest, displayFrameIsRecycledAfterLeavingTheWindow) {
+    auto presentFence = fenceFactory.createFenceTimeForTest(Fence::NO_FENCE);
+    presentFence->signalForTest(2);
+
+    const auto addDisplayFrame = [&] {
+        auto surfaceFrame =
+                mFrameTimeline->createSurfaceFrameForToken({}, sPidOne, sUidOne, sLayerIdOne,
+                                                           sLayerNameOne, sLayerNameOne,
+                                                           /*isBuffer*/ true, sGameMode);
+        int64_t sfToken = mTokenManager->generateTokenForPredictions({22, 26, 30});
+        mFrameTimeline->setSfWakeUp(sfToken, 22, RR_11, RR_11);
+        surfaceFrame->setPresentState(SurfaceFrame::PresentState::Presented);
+        mFrameTimeline->addSurfaceFrame(surfaceFrame);
+        mFrameTimeline->setSfPresent(27, presentFence);
+    };
+
+    for (size_t i = 0; i < *maxDisplayFrames; i++) {
+        addDisplayFrame();
+    }
+    const auto* oldestDisplayFrame = getDisplayFrame(0).get();
+
+    // The oldest DisplayFrame leaves the window and is reused for the next vsync, as new.
+    addDisplayFrame();
+    EXPECT_EQ(getNumberOfDisplayFrames(), *maxDisplayFrames);
+    EXPECT_EQ(getCurrentDisplayFrame(), oldestDisplayFrame);
+    EXPECT_TRUE(getCurrentDisplayFrame()->getSurfaceFrames().empty());
+    EXPECT_EQ(getCurrentDisplayFrame()->getJankType(), JankType::None);
+    EXPECT_TRUE(compareTimelineItems(getCurrentDisplayFrame()->getActuals(), TimelineItem()));
+}
+
 TEST_F(FrameTimelineTest, presentFenceSignaled_invalidSignalTime) {
     Fps refreshRate = RR_11;
 
@@ -3177,6 +3177,27 @@ TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_WritesCache) {
     EXPECT_EQ(cache->result, result);
 }
 
+TEST_P(RefreshRateSelectorTest, getRankedFrameRates_rescoresChangedLayersOnly) {
+    auto selector = createSelector(kModes_30_60_72_90_120, kModeId60);
+
+    std::vector<LayerRequirement> layers = {{.weight = 1.f}, {.weight = 0.5f}, {.weight = 0.2f}};
+    layers[0].vote = LayerVoteType::ExplicitExactOrMultiple;
+    layers[0].desiredRefreshRate = 24_Hz;
+    layers[1].vote = LayerVoteType::Heuristic;
+    layers[1].desiredRefreshRate = 60_Hz;
+    layers[2].vote = LayerVoteType::ExplicitDefault;
+    layers[2].desiredRefreshRate = 30_Hz;
+    selector.getRankedFrameRates(layers);
+
+    // The other layers' scores are reused, which must rank the frame rates exactly as if all
+    // layers had been scored again.
+    layers[1].desiredRefreshRate = 90_Hz;
+    const auto result = selector.getRankedFrameRates(layers);
+
+    auto freshSelector = createSelector(kModes_30_60_72_90_120, kModeId60);
+    EXPECT_EQ(freshSelector.getRankedFrameRates(layers), result);
+}
+
 TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_ExplicitExactTouchBoost) {
     auto selector = createSelector(kModes_60_120, kModeId60);
 
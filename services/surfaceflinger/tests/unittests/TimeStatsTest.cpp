@@ -32,6 +32,7 @@
 
 #include <chrono>
 #include <random>
+#include <thread>
 #include <unordered_set>
 
 #include "libsurfaceflinger_unittest_main.h"
@@ -742,6 +743,60 @@ TEST_F(TimeStatsTest, canInsertMultipleLayersTimeStats) {
     EXPECT_EQ(2, globalProto.stats_size());
 }
 
+TEST_F(TimeStatsTest, canInsertLayerTimeStatsFromMultipleThreads) {
+    EXPECT_TRUE(inputCommand(InputCommand::ENABLE, FMT_STRING).empty());
+
+    // Buffers are posted from another thread than the one they are latched and presented on.
+    const auto postFromOtherThread = [&](uint64_t frameNumber, nsecs_t ts) {
+        std::thread([&] {
+            setTimeStamp(TimeStamp::POST, LAYER_ID_0, frameNumber, ts, {}, kGameMode);
+        }).join();
+    };
+    const TimeStamp sequenceAfterPost[] = {TimeStamp::ACQUIRE, TimeStamp::LATCH,
+                                           TimeStamp::DESIRED, TimeStamp::PRESENT};
+    postFromOtherThread(1, 1000000);
+    insertTimeRecord(sequenceAfterPost, LAYER_ID_0, 1, 2000000);
+    postFromOtherThread(2, 2000000);
+    insertTimeRecord(sequenceAfterPost, LAYER_ID_0, 2, 3000000);
+
+    SFTimeStatsGlobalProto globalProto;
+    ASSERT_TRUE(globalProto.ParseFromString(inputCommand(InputCommand::DUMP_ALL, FMT_PROTO)));
+
+    ASSERT_EQ(1, globalProto.stats_size());
+    const SFTimeStatsLayerProto& layerProto = globalProto.stats(0);
+    EXPECT_EQ(genLayerName(LAYER_ID_0), layerProto.layer_name());
+    EXPECT_EQ(1, layerProto.total_frames());
+}
+
+TEST_F(TimeStatsTest, reclaimsEventLogsOfExitedThreads) {
+    EXPECT_TRUE(inputCommand(InputCommand::ENABLE, FMT_STRING).empty());
+
+    setTimeStamp(TimeStamp::POST, LAYER_ID_0, 1, 1000000, {}, kGameMode);
+    for (uint64_t frameNumber = 2; frameNumber < 10; frameNumber++) {
+        std::thread([&] {
+            setTimeStamp(TimeStamp::POST, LAYER_ID_0, frameNumber, frameNumber * 1000000, {},
+                         kGameMode);
+        }).join();
+    }
+
+    // Only the log of this thread is left once the events are applied.
+    EXPECT_THAT(mTimeStats->miniDump(), HasSubstr("Number of event logs is 1\n"));
+}
+
+TEST_F(TimeStatsTest, neverDropsEventsOnAFullEventLog) {
+    EXPECT_TRUE(inputCommand(InputCommand::ENABLE, FMT_STRING).empty());
+
+    // More events than an event log holds, faster than the worker applies them.
+    for (uint64_t frameNumber = 1; frameNumber <= 20000; frameNumber++) {
+        setTimeStamp(TimeStamp::POST, LAYER_ID_0, frameNumber, frameNumber * 1000000, {},
+                     kGameMode);
+    }
+    ASSERT_NO_FATAL_FAILURE(mTimeStats->onDestroy(LAYER_ID_0));
+
+    EXPECT_THAT(mTimeStats->miniDump(),
+                HasSubstr("Number of layers currently being tracked is 0\n"));
+}
+
 TEST_F(TimeStatsTest, canInsertUnorderedLayerTimeStats) {
     EXPECT_TRUE(inputCommand(InputCommand::ENABLE, FMT_STRING).empty());
 
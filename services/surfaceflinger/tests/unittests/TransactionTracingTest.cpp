@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <android-base/file.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -42,7 +43,8 @@ protected:
     perfetto::protos::TransactionTraceEntry bufferFront() {
         std::scoped_lock<std::mutex> lock(mTracing.mTraceLock);
         perfetto::protos::TransactionTraceEntry entry;
-        entry.ParseFromString(mTracing.mBuffer.front());
+        const std::string_view bytes = mTracing.mBuffer.front().bytes;
+        entry.ParseFromArray(bytes.data(), static_cast<int>(bytes.size()));
         return entry;
     }
 
@@ -260,6 +262,28 @@ TEST_F(TransactionTracingLayerHandlingTest, startingStateSurvivesBufferFlush) {
     EXPECT_TRUE(proto.entry(0).displays_changed());
 }
 
+TEST_F(TransactionTracingLayerHandlingTest, writeToFileMatchesWriteToProto) {
+    // add transactions until the buffer wraps around and there is a starting state
+    while (bufferFront().vsync_id() <= VSYNC_ID_SECOND_LAYER_CHANGE) {
+        queueAndCommitTransaction(++mVsyncId);
+    }
+    TemporaryFile file;
+    ASSERT_EQ(mTracing.writeToFile(file.path), NO_ERROR);
+    std::string output;
+    ASSERT_TRUE(base::ReadFileToString(file.path, &output));
+    perfetto::protos::TransactionTraceFile fileProto;
+    ASSERT_TRUE(fileProto.ParseFromString(output));
+
+    // verify the entries streamed to the file are the same as the parsed ones
+    perfetto::protos::TransactionTraceFile proto = writeToProto();
+    EXPECT_EQ(fileProto.magic_number(), proto.magic_number());
+    EXPECT_EQ(fileProto.version(), proto.version());
+    ASSERT_EQ(fileProto.entry().size(), proto.entry().size());
+    for (int i = 0; i < proto.entry().size(); i++) {
+        EXPECT_EQ(fileProto.entry(i).SerializeAsString(), proto.entry(i).SerializeAsString());
+    }
+}
+
 class TransactionTracingMirrorLayerTest : public TransactionTracingTest {
 protected:
     void SetUp() override {
@@ -30,6 +30,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <algorithm>
+#include <array>
 #include <chrono>
 #include <optional>
 #include <utility>
@@ -506,6 +507,37 @@ TEST_F(VSyncPredictorTest, aPhoneThatHasBeenAroundAWhileCanStillComputePeriod) {
     EXPECT_THAT(intercept, Eq(0));
 }
 
+TEST_F(VSyncPredictorTest, modelIsMaintainedAcrossManyHistoryWindows) {
+    // The model is updated incrementally as samples come and go, so run through enough history
+    // windows to cover several renormalizations, with a repeating +/- 0.5ms jitter.
+    auto constexpr idealPeriod = 16666666;
+    auto constexpr realPeriod = idealPeriod + 1000;
+    constexpr std::array<nsecs_t, 3> kJitter = {500000, -500000, 0};
+    constexpr size_t kNumVsyncs = kHistorySize * 10 + 1;
+    auto const vsync = [&](size_t i) {
+        return static_cast<nsecs_t>(i) * realPeriod + kJitter[i % kJitter.size()];
+    };
+
+    tracker.setDisplayModePtr(displayMode(idealPeriod));
+    for (size_t i = 0; i < kNumVsyncs; i++) {
+        EXPECT_TRUE(tracker.addVsyncTimestamp(vsync(i)));
+    }
+
+    // The model only depends on the samples in the history.
+    VSyncPredictor freshTracker{std::make_unique<ClockWrapper>(mClock), displayMode(idealPeriod),
+                                kHistorySize, kMinimumSamplesForPrediction,
+                                kOutlierTolerancePercent};
+    for (size_t i = kNumVsyncs - kHistorySize; i < kNumVsyncs; i++) {
+        freshTracker.addVsyncTimestamp(vsync(i));
+    }
+
+    auto [slope, intercept] = tracker.getVSyncPredictionModel();
+    auto [freshSlope, freshIntercept] = freshTracker.getVSyncPredictionModel();
+    EXPECT_THAT(slope, IsCloseTo(realPeriod, 100000));
+    EXPECT_EQ(freshSlope, slope);
+    EXPECT_EQ(freshIntercept, intercept);
+}
+
 TEST_F(VSyncPredictorTest, isVSyncInPhase) {
     auto last = mNow;
     auto const bias = 10;